@@ -0,0 +1,42 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include <common/noncopyable.h>
+#include <cstddef>
+
+namespace micro_profiler
+{
+	class calls_collector;
+
+	// Attributes heap allocations to the calls in progress: while a tracker exists, the allocations reported by the
+	// interposed allocation functions are written to the traces of the calling threads (see
+	// calls_collector_thread::on_allocation). Only the threads that have a trace already are tracked, so the tracking
+	// itself never allocates. Only a single tracker can exist at a time.
+	class allocation_tracker : noncopyable
+	{
+	public:
+		explicit allocation_tracker(calls_collector &collector);
+		~allocation_tracker();
+
+		static void on_allocation(std::size_t size) throw();
+	};
+}
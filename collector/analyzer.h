@@ -24,29 +24,60 @@
 #include "shadow_stack.h"
 
 #include <common/noncopyable.h>
+#include <common/protocol.h>
 
 namespace micro_profiler
 {
 	class thread_analyzer
 	{
 	public:
-		typedef statistic_types::nodes_map statistics_t;
+		typedef call_graph<statistic_types::key> statistics_t;
 		typedef statistics_t::const_iterator const_iterator;
-		typedef std::pair<statistics_t::key_type, statistics_t::mapped_type> value_type;
+		typedef statistics_t::value_type value_type;
 
 	public:
-		thread_analyzer(const overhead& overhead_);
+		// Call times histograms of the nodes are collected only if requested (see call_graph).
+		thread_analyzer(const overhead& overhead_, bool call_times = false);
 
 		void clear() throw();
 		size_t size() const throw();
 		const_iterator begin() const throw();
 		const_iterator end() const throw();
+		count_t dropped() const throw();
+
+		// Tells whether the thread has exited and all of its calls have been accepted.
+		bool exited() const throw();
+
+		// The call graph with the statistics accumulated since the previous get_changes() (or since clear()).
+		const statistics_t &graph() const throw();
+
+		// Moves the statistics and the dropped count collected by the other analyzer into this one. The call stack
+		// tracked by the other analyzer is kept intact, so that it can continue accepting calls.
+		void merge(thread_analyzer &from);
+
+		// Puts the call nodes created and the statistics accumulated since the previous call (or since clear()) into
+		// the delta. The statistics and the dropped count are reset, while the nodes are retained to keep their indices.
+		// Only the nodes created or updated since the previous call are visited.
+		void get_changes(call_graph_delta &delta);
+
+		// Makes the next get_changes() report all the retained nodes as created, as for a receiver that has seen none.
+		void rewind_changes() throw();
+
+		// Appends the contention statistics of the locks accumulated since the previous call and resets them.
+		void get_lock_contention(lock_contention &contention);
 
 		void accept_calls(const call_record *calls, size_t count);
+		void accept_calls(const compact_call_record *calls, size_t count, const callee_table &callees);
+		void accept_dropped(count_t count);
+		void accept_exited() throw();
 
 	private:
 		statistics_t _statistics;
 		shadow_stack<statistic_types::key> _stack;
+		compact_decoder _decoder;
+		count_t _dropped;
+		unsigned int _reported_nodes;
+		bool _exited;
 	};
 
 	class analyzer : public calls_collector_i::acceptor, noncopyable
@@ -57,7 +88,7 @@ namespace micro_profiler
 		typedef std::pair<unsigned int, thread_analyzer> value_type;
 
 	public:
-		analyzer(const overhead& overhead_);
+		analyzer(const overhead& overhead_, bool call_times = false);
 
 		void clear() throw();
 		size_t size() const throw();
@@ -65,10 +96,35 @@ namespace micro_profiler
 		const_iterator end() const throw();
 		bool has_data() const throw();
 
+		// Moves data of all the threads of the other analyzer into this one, leaving the other analyzer cleared.
+		void merge(analyzer &from);
+
+		// Puts the IDs of the threads exited into 'exited'. Their analyzers are dropped by the next get_changes() or
+		// clear(), which take the final statistics of the threads.
+		void get_exited(exited_threads &exited) const;
+
+		// Collects changes of all the threads (see thread_analyzer::get_changes()).
+		void get_changes(statistics_delta &delta);
+
+		// Rewinds changes of all the threads (see thread_analyzer::rewind_changes()).
+		void rewind_changes() throw();
+
+		// Collects lock contention of all the threads (see thread_analyzer::get_lock_contention()).
+		void get_lock_contention(lock_contention &contention);
+
 		virtual void accept_calls(unsigned int threadid, const call_record *calls, size_t count) override;
+		virtual void accept_calls(unsigned int threadid, const compact_call_record *calls, size_t count,
+			const callee_table &callees) override;
+		virtual void accept_dropped(unsigned int threadid, count_t count) override;
+		virtual void accept_exited(unsigned int threadid) override;
+
+	private:
+		thread_analyzer &get_thread_analyzer(unsigned int threadid);
+		void drop_exited() throw();
 
 	private:
 		const overhead _overhead;
+		const bool _call_times;
 		thread_analyzers _thread_analyzers;
 	};
 }
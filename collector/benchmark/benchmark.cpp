@@ -0,0 +1,479 @@
+#include <collector/calls_collector_thread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <collector/analyzer.h>
+#include <collector/thread_monitor.h>
+#include <collector/thread_queue_manager.h>
+#include <common/allocator.h>
+#include <common/compiler.h>
+#include <common/module.h>
+#include <common/time.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mt/thread_callbacks.h>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+	#include <collector/sampler.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+	atomic<size_t> g_heap_allocated(0);
+}
+
+void *operator new(size_t length)
+{
+	if (const auto memory = static_cast<size_t *>(malloc(sizeof(max_align_t) + length)))
+	{
+		g_heap_allocated += length;
+		*memory = length;
+		return reinterpret_cast<max_align_t *>(memory) + 1;
+	}
+	throw bad_alloc();
+}
+
+void operator delete(void *memory) throw()
+{
+	if (!memory)
+		return;
+
+	const auto header = reinterpret_cast<size_t *>(static_cast<max_align_t *>(memory) - 1);
+
+	g_heap_allocated -= *header;
+	free(header);
+}
+
+namespace micro_profiler
+{
+	namespace
+	{
+		const auto c_trace_limit = 5000000u;
+		const auto c_hot_calls = 50000000u;
+		const auto c_cold_threads = 256u;
+		const auto c_cold_calls = 20u;
+		const auto c_cold_reads = 100u;
+		const auto c_read_period = chrono::milliseconds(10);
+		const auto c_scaling_calls = 8000000u;
+		const unsigned int c_scaling_producers[] = {	1, 2, 4, 8, 16, 32, 64,	};
+		const unsigned int c_scaling_workers[] = {	1, 2, 4,	};
+		const unsigned int c_idle_threads[] = {	10, 1000, 10000,	};
+		const auto c_idle_reads = 1000u;
+		const void *c_callees[] = {	&c_trace_limit, &c_hot_calls, &c_cold_threads,	};
+		const auto c_tree_fanout = 6u;
+		const auto c_tree_depth = 6u;
+		const auto c_tree_functions = 4096u;
+		const auto c_tree_passes = 50u;
+		const size_t c_analysis_chunk = 4096u;
+		const auto c_workload_depth = 32u;
+		const auto c_workload_passes = 20u;
+		const unsigned int c_sampling_frequencies[] = {	1000, 10000,	};
+
+		class counting_allocator : public allocator
+		{
+		public:
+			counting_allocator()
+				: _allocated(0), _peak(0)
+			{	}
+
+			size_t allocated() const
+			{	return _allocated.load();	}
+
+			size_t peak() const
+			{	return _peak.load();	}
+
+		private:
+			virtual void *allocate(size_t length) override
+			{
+				const auto memory = static_cast<size_t *>(malloc(sizeof(max_align_t) + length));
+				const auto allocated = _allocated += length;
+
+				for (auto peak = _peak.load(); peak < allocated && !_peak.compare_exchange_weak(peak, allocated); )
+				{	}
+				*memory = length;
+				return reinterpret_cast<max_align_t *>(memory) + 1;
+			}
+
+			virtual void deallocate(void *memory) throw() override
+			{
+				const auto header = reinterpret_cast<size_t *>(static_cast<max_align_t *>(memory) - 1);
+
+				_allocated -= *header;
+				free(header);
+			}
+
+		private:
+			atomic<size_t> _allocated, _peak;
+		};
+
+		struct counting_reader
+		{
+			counting_reader(size_t &read_)
+				: read(read_)
+			{	}
+
+			void operator ()(unsigned int, const call_record *, size_t count) const
+			{	read += count;	}
+
+			void operator ()(unsigned int, const compact_call_record *, size_t count, const callee_table &) const
+			{	read += count;	}
+
+			size_t &read;
+		};
+
+		struct analyzing_reader
+		{
+			analyzing_reader(analyzer &a)
+				: _analyzer(a)
+			{	}
+
+			void operator ()(unsigned int id, const call_record *calls, size_t count) const
+			{	_analyzer.accept_calls(id, calls, count);	}
+
+			void operator ()(unsigned int id, const compact_call_record *calls, size_t count,
+				const callee_table &callees) const
+			{	_analyzer.accept_calls(id, calls, count, callees);	}
+
+		private:
+			analyzer &_analyzer;
+		};
+
+		struct counting_acceptor : calls_collector_i::acceptor
+		{
+			counting_acceptor()
+				: read(0)
+			{	}
+
+			virtual void accept_calls(unsigned int, const call_record *, size_t count) override
+			{	read += count;	}
+
+			virtual void accept_calls(unsigned int, const compact_call_record *, size_t count, const callee_table &) override
+			{	read += count;	}
+
+			virtual void accept_dropped(unsigned int, count_t) override
+			{	}
+
+			virtual void accept_exited(unsigned int) override
+			{	}
+
+			size_t read;
+		};
+
+		struct null_thread_callbacks : mt::thread_callbacks
+		{
+			virtual void at_thread_exit(const atexit_t &/*handler*/) override
+			{	}
+		};
+
+		struct configuration
+		{
+			const char *name;
+			size_t min_buffer_size, max_buffer_size;
+		};
+
+		buffering_policy make_policy(const configuration &c)
+		{	return buffering_policy(c_trace_limit, 0.1, 0.01, buffering_policy::block_on_overflow, c.min_buffer_size, c.max_buffer_size);	}
+
+		void call(calls_collector_thread &t, const void **stack_ptr, timestamp_t timestamp)
+		{
+			t.on_enter(stack_ptr, timestamp, &c_trace_limit);
+			t.on_exit(stack_ptr, timestamp + 1);
+		}
+
+		void measure_hot_thread(const configuration &c)
+		{
+			counting_allocator allocator_;
+			calls_collector_thread t(allocator_, make_policy(c), 1);
+			atomic<bool> done(false);
+			size_t read = 0;
+			thread analyzer([&] {
+				const counting_reader reader(read);
+
+				while (!done.load())
+					t.read_collected(reader), this_thread::sleep_for(c_read_period);
+				t.read_collected(reader);
+			});
+			const void *stack[] = {	nullptr, &c_trace_limit,	};
+			stopwatch sw;
+
+			sw();
+			for (auto n = 0u; n != c_hot_calls; n++)
+				call(t, stack + 1, 2 * n);
+			const auto elapsed = sw();
+
+			t.flush();
+			done = true;
+			analyzer.join();
+			printf("%s, hot thread: %.1fns per call (enter/exit pair), peak memory: %uKB, %u records read\n", c.name,
+				1e9 * elapsed / c_hot_calls, static_cast<unsigned>(allocator_.peak() / 1024), static_cast<unsigned>(read));
+		}
+
+		void measure_cold_threads(const configuration &c)
+		{
+			counting_allocator allocator_;
+			vector< unique_ptr<calls_collector_thread> > threads;
+			size_t read = 0;
+			const void *stack[] = {	nullptr, &c_trace_limit,	};
+
+			for (auto i = 0u; i != c_cold_threads; ++i)
+				threads.emplace_back(new calls_collector_thread(allocator_, make_policy(c), i));
+			for (auto r = 0u; r != c_cold_reads; ++r)
+			{
+				for (auto i = threads.begin(); i != threads.end(); ++i)
+				{
+					for (auto n = 0u; n != c_cold_calls; n++)
+						call(**i, stack + 1, 2 * (r * c_cold_calls + n));
+					(*i)->read_collected(counting_reader(read));
+				}
+			}
+			printf("%s, idle threads: %uB per thread\n", c.name,
+				static_cast<unsigned>(allocator_.allocated() / c_cold_threads));
+		}
+
+		void measure_analysis_scaling(unsigned int producers, unsigned int workers)
+		{
+			const auto calls_per_producer = c_scaling_calls / producers;
+			counting_allocator allocator_;
+			null_thread_callbacks callbacks;
+			auto id = 0u;
+			thread_queue_manager<calls_collector_thread> collector(allocator_, buffering_policy(c_trace_limit, 0.1, 0.01,
+				buffering_policy::block_on_overflow, 64, 16384), callbacks, [&id] {	return id++;	});
+			vector< unique_ptr<analyzer> > analyzers;
+			vector<thread> analysis_threads, producer_threads;
+			atomic<bool> done(false);
+			stopwatch sw;
+
+			sw();
+			for (auto w = 0u; w != workers; ++w)
+			{
+				analyzers.emplace_back(new analyzer(overhead(0, 0)));
+				analysis_threads.emplace_back([&collector, &done, &analyzers, w, workers] {
+					const analyzing_reader reader(*analyzers[w]);
+					const auto drop_reader = [] (unsigned int, count_t) {	};
+
+					while (!done.load())
+						collector.read_collected(reader, drop_reader, w, workers), this_thread::sleep_for(c_read_period);
+					collector.read_collected(reader, drop_reader, w, workers);
+				});
+			}
+			for (auto p = 0u; p != producers; ++p)
+			{
+				producer_threads.emplace_back([&collector, calls_per_producer] {
+					auto &t = collector.get_queue();
+					const void *stack[] = {	nullptr, &c_trace_limit, &c_trace_limit,	};
+
+					for (auto n = 0u; n != calls_per_producer; n++)
+					{
+						const auto timestamp = 4 * static_cast<timestamp_t>(n);
+
+						t.on_enter(stack + 2, timestamp, c_callees[n % 3]);
+						call(t, stack + 1, timestamp + 1);
+						t.on_exit(stack + 2, timestamp + 3);
+					}
+					t.flush();
+				});
+			}
+			for (auto i = producer_threads.begin(); i != producer_threads.end(); ++i)
+				i->join();
+			done = true;
+			for (auto i = analysis_threads.begin(); i != analysis_threads.end(); ++i)
+				i->join();
+
+			const auto elapsed = sw();
+
+			printf("analysis scaling, %u producer(s), %u worker(s): %.1fM calls/s\n", producers, workers,
+				2e-6 * calls_per_producer * producers / elapsed);
+		}
+
+		void measure_idle_threads_read(unsigned int idle_threads)
+		{
+			counting_allocator allocator_;
+			null_thread_callbacks callbacks;
+			auto id = 0u;
+			thread_queue_manager<calls_collector_thread> collector(allocator_, buffering_policy(c_trace_limit, 0.1, 0.01,
+				buffering_policy::block_on_overflow, 64, 16384), callbacks, [&id] {	return id++;	});
+			size_t read = 0;
+			const counting_reader reader(read);
+			const auto drop_reader = [] (unsigned int, count_t) {	};
+			const void *stack[] = {	nullptr, &c_trace_limit,	};
+			auto &active = collector.get_queue();
+			double elapsed = 0;
+			stopwatch sw;
+
+			for (auto n = 0u; n != idle_threads; ++n)
+				thread([&collector] {	collector.get_queue();	}).join();
+			for (auto r = 0u; r != c_idle_reads; ++r)
+			{
+				call(active, stack + 1, 2 * r);
+				active.flush();
+				sw();
+				collector.read_collected(reader, drop_reader);
+				elapsed += sw();
+			}
+			printf("idle threads read, 1 active + %u idle thread(s): %.2fus per read (%u records read)\n",
+				idle_threads, 1e6 * elapsed / c_idle_reads, static_cast<unsigned>(read));
+		}
+
+		FORCE_NOINLINE unsigned int workload(unsigned int n)
+		{	return n < 2 ? n : workload(n - 1) + workload(n - 2);	}
+
+		unsigned int workload(calls_collector_thread &t, const void **stack_ptr, unsigned int n)
+		{
+			t.on_enter(stack_ptr, read_tick_counter(), &c_workload_depth);
+
+			const auto result = n < 2 ? n : workload(t, stack_ptr - 1, n - 1) + workload(t, stack_ptr - 1, n - 2);
+
+			t.on_exit(stack_ptr, read_tick_counter());
+			return result;
+		}
+
+		template <typename PassT, typename ReadT>
+		double run_workload(const PassT &pass, const ReadT &read)
+		{
+			double elapsed = 0;
+			stopwatch sw;
+
+			for (auto n = 0u; n != c_workload_passes; ++n)
+			{
+				sw();
+				pass();
+				elapsed += sw();
+				read();
+			}
+			return elapsed;
+		}
+
+		void measure_sampling_overhead()
+		{
+			volatile unsigned int depth = c_workload_depth, sink = 0;
+			const auto bare = run_workload([&] {	sink = workload(depth);	}, [] {	});
+
+			printf("workload, %u passes: %.1fms bare\n", c_workload_passes, 1e3 * bare);
+
+			counting_allocator allocator_;
+			calls_collector_thread t(allocator_, buffering_policy(c_trace_limit, 0.1, 0.01), 1);
+			atomic<bool> done(false);
+			size_t read = 0;
+			thread analyzer([&] {
+				const counting_reader reader(read);
+
+				while (!done.load())
+					t.read_collected(reader), this_thread::sleep_for(c_read_period);
+				t.read_collected(reader);
+			});
+			const void *stack[c_workload_depth + 1] = {	};
+			const auto instrumented = run_workload([&] {
+				sink = workload(t, stack + c_workload_depth, depth);
+			}, [] {	});
+
+			t.flush();
+			done = true;
+			analyzer.join();
+			printf("workload, instrumented: %+.1f%% (%u records)\n", 1e2 * (instrumented / bare - 1),
+				static_cast<unsigned>(read));
+
+#ifdef __linux__
+			null_thread_callbacks callbacks;
+			thread_monitor threads(callbacks);
+
+			for (auto f = begin(c_sampling_frequencies); f != end(c_sampling_frequencies); ++f)
+			{
+				sampler s(threads, module::platform(), *f);
+				counting_acceptor a;
+				const auto sampled = run_workload([&] {	sink = workload(depth);	}, [&] {	s.read_collected(a);	});
+
+				printf("workload, sampled at %uHz: %+.1f%% (%u records, %u samples dropped)\n", *f,
+					1e2 * (sampled / bare - 1), static_cast<unsigned>(a.read), static_cast<unsigned>(s.dropped()));
+			}
+#endif
+		}
+
+		void generate_tree(vector<call_record> &trace, timestamp_t &timestamp, unsigned int &serial, unsigned int depth)
+		{
+			for (auto j = 0u; depth && j != c_tree_fanout; ++j)
+			{
+				const call_record enter = {
+					timestamp++, reinterpret_cast<const void *>(0x10000 + 0x10 * (serial++ % c_tree_functions))
+				};
+
+				trace.push_back(enter);
+				generate_tree(trace, timestamp, serial, depth - 1);
+
+				const call_record exit = {	timestamp++, nullptr	};
+
+				trace.push_back(exit);
+			}
+		}
+
+		void analyze(thread_analyzer &a, const vector<call_record> &trace)
+		{
+			for (size_t i = 0; i < trace.size(); i += c_analysis_chunk)
+				a.accept_calls(trace.data() + i, (min)(c_analysis_chunk, trace.size() - i));
+		}
+
+		void measure_analyzer()
+		{
+			vector<call_record> trace;
+			timestamp_t timestamp = 0;
+			auto serial = 0u;
+
+			generate_tree(trace, timestamp, serial, c_tree_depth);
+
+			const auto heap_before = g_heap_allocated.load();
+			thread_analyzer a((overhead(0, 0)));
+			stopwatch sw;
+
+			sw();
+			analyze(a, trace);
+
+			const auto first_pass = sw();
+			const auto heap = g_heap_allocated.load() - heap_before;
+
+			for (auto n = 0u; n != c_tree_passes; ++n)
+				analyze(a, trace);
+
+			const auto steady = sw();
+
+			printf("analyzer, %u nodes call tree: %.1fns per record (first pass: %.1fns), memory: %uKB\n", serial,
+				1e9 * steady / (c_tree_passes * trace.size()), 1e9 * first_pass / trace.size(),
+				static_cast<unsigned>(heap / 1024));
+		}
+	}
+}
+
+int main()
+{
+	using namespace micro_profiler;
+
+	measure_analyzer();
+	measure_sampling_overhead();
+
+	const configuration c_configurations[] = {
+		{	"fixed 64", 64, 64	},
+		{	"fixed 384", 384, 384	},
+		{	"fixed 4096", 4096, 4096	},
+		{	"fixed 16384", 16384, 16384	},
+		{	"adaptive 64-16384", 64, 16384	},
+	};
+
+	for (auto i = begin(c_configurations); i != end(c_configurations); ++i)
+	{
+		measure_hot_thread(*i);
+		measure_cold_threads(*i);
+	}
+	for (auto w = begin(c_scaling_workers); w != end(c_scaling_workers); ++w)
+	{
+		for (auto p = begin(c_scaling_producers); p != end(c_scaling_producers); ++p)
+			measure_analysis_scaling(*p, *w);
+	}
+	for (auto n = begin(c_idle_threads); n != end(c_idle_threads); ++n)
+		measure_idle_threads_read(*n);
+	return 0;
+}
@@ -22,11 +22,12 @@
 
 #include "types.h"
 
+#include <atomic>
 #include <common/allocator.h>
 #include <common/compiler.h>
+#include <common/noncopyable.h>
 #include <functional>
 #include <mt/event.h>
-#include <mt/mutex.h>
 #include <polyq/circular.h>
 #include <polyq/static_entry.h>
 
@@ -40,6 +41,7 @@ namespace micro_profiler
 
 	public:
 		buffers_queue(allocator &allocator_, const buffering_policy &policy, unsigned int id);
+		~buffers_queue();
 
 		unsigned int get_id() throw();
 
@@ -47,44 +49,98 @@ namespace micro_profiler
 		void push() throw();
 		void flush() throw();
 
+		// Makes sure the next n records pushed get into the same buffer, handing the active one off if necessary.
+		void reserve(unsigned int n) throw();
+
+		// Returns the number of records that can be written starting at current() before the buffer is handed off.
+		unsigned int available() const throw();
+
+		// Accounts n records written starting at current() directly, bypassing push(). n must be below available().
+		void advance(unsigned int n) throw();
+
+		// Tells if the records collected have been discarded on overflow since the last call - the records written next
+		// must not depend on the ones written before.
+		bool discarded() throw();
+
+		// Tells if the queue is waiting for an empty buffer, while handing the active one off - it cannot be written to.
+		bool handing_off() const throw();
+
 		template <typename ReaderT>
 		void read_collected(const ReaderT &reader);
 
+		template <typename ReaderT, typename DropReaderT>
+		void read_collected(const ReaderT &reader, const DropReaderT &drop_reader);
+
+		// Accounts the reads that skipped the queue, since it had nothing handed off, so that the buffers of a thread
+		// gone cold are shrunk on its next read. Must be called from the reader's side.
+		void skip_reads(unsigned int n);
+
 		void set_buffering_policy(const buffering_policy &policy);
 
+		// Gives the memory of a drained queue back, leaving it as much as a newly constructed one would have. Must
+		// only be called when no thread writes to the queue.
+		void trim();
+
+		// Rebinds a trimmed queue to a new thread.
+		void reset(unsigned int id) throw();
+
+		// Makes the queue raise the bits of the mask in the word specified whenever a buffer is handed off.
+		void set_ready_flag(std::atomic<unsigned long long> &word, unsigned long long mask) throw();
+
 	private:
 		struct buffer;
 		class buffer_deleter;
+		class empty_buffers;
 
 		typedef std::unique_ptr<buffer, buffer_deleter> buffer_ptr;
 
+		enum {	adaptation_window = 16 /*reads*/,	};
+
 	private:
-		void create_buffer(buffer_ptr &new_buffer);
-		void start_buffer(buffer_ptr &ready_buffer) throw();
+		buffer *create_buffer();
+		void destroy_buffer(buffer *b) throw();
+		void start_buffer(buffer *new_buffer) throw();
+		unsigned int usable_size(const buffer &b) const throw();
+		void recycle_buffer(buffer *empty_buffer);
+		void adapt_buffer_size(size_t delivered_n);
 		void adjust_empty_buffers(const buffering_policy &policy, size_t base_n);
+		static size_t min_empty(const buffering_policy &policy) throw();
 
 	private:
 		E *_ptr;
 		unsigned int _n_left;
+		count_t _dropped;
+		bool _discarded;
 
 		unsigned int _id;
 		buffer_ptr _active_buffer;
 		polyq::circular_buffer< buffer_ptr, polyq::static_entry<buffer_ptr> > _ready_buffers;
-		buffer_ptr *_empty_buffers_top;
-		size_t _allocated_buffers;
+		std::unique_ptr<empty_buffers> _empty_buffers;
+		size_t _allocated_buffers, _allocated_entries;
+		std::atomic<size_t> _buffer_size; // Capacity of the buffers allocated from now on (entries).
+		unsigned int _window_reads, _window_delivered;
+
+		std::atomic<unsigned long long> *_ready_word;
+		unsigned long long _ready_mask;
 
 		buffering_policy _policy;
-		std::unique_ptr<buffer_ptr[]> _empty_buffers;
+		std::atomic<bool> _drop_on_overflow;
+		std::atomic<bool> _waiting;
 		allocator &_allocator;
 		mt::event _continue;
-		mt::mutex _mtx;
 	};
 
+	// The entries follow the header in the same allocation, since buffers of a queue vary in capacity.
 	template <typename E>
 	struct buffers_queue<E>::buffer
 	{
-		E data[buffering_policy::buffer_size];
+		explicit buffer(unsigned capacity_);
+
+		E *data() throw();
+
+		const unsigned capacity;
 		unsigned size;
+		count_t dropped; // Number of records discarded right before the ones contained in this buffer.
 	};
 
 	template <typename E>
@@ -100,21 +156,48 @@ namespace micro_profiler
 		allocator *_allocator;
 	};
 
+	// A bounded ring of empty buffers. The analyzer is the only producer, while the buffers are taken by the
+	// profilee thread and, occasionally (when trimming excess buffers), by the analyzer itself. Neither side ever
+	// blocks here.
+	template <typename E>
+	class buffers_queue<E>::empty_buffers : noncopyable
+	{
+	public:
+		explicit empty_buffers(size_t capacity);
+		~empty_buffers();
+
+		size_t size() const throw();
+		bool push(buffer *b) throw();
+		buffer *pop() throw();
+
+	private:
+		const size_t _capacity;
+		const std::unique_ptr< std::atomic<buffer *>[] > _buffers;
+		std::atomic<size_t> _head, _tail;
+	};
+
 
 
 	template <typename E>
 	inline buffers_queue<E>::buffers_queue(allocator &allocator_, const buffering_policy &policy, unsigned int id)
-		: _id(id), _ready_buffers(policy.max_buffers()), _allocated_buffers(0), _policy(policy),
-			_empty_buffers(new buffer_ptr[policy.max_buffers()]), _allocator(allocator_)
+		: _dropped(0), _discarded(false), _id(id), _ready_buffers(policy.max_buffers()),
+			_empty_buffers(new empty_buffers(policy.max_buffers())), _allocated_buffers(0), _allocated_entries(0),
+			_buffer_size(policy.initial_buffer_size()), _window_reads(0), _window_delivered(0), _ready_word(nullptr),
+			_ready_mask(0), _policy(policy),
+			_drop_on_overflow(buffering_policy::drop_on_overflow == policy.overflow()), _waiting(false),
+			_allocator(allocator_)
 	{
-		buffer_ptr b;
-
-		_empty_buffers_top = _empty_buffers.get();
-		create_buffer(b);
-		start_buffer(b);
+		start_buffer(create_buffer());
 		adjust_empty_buffers(policy, 0u);
 	}
 
+	template <typename E>
+	inline buffers_queue<E>::~buffers_queue()
+	{
+		while (const auto b = _empty_buffers->pop())
+			destroy_buffer(b);
+	}
+
 	template <typename E>
 	inline unsigned int buffers_queue<E>::get_id() throw()
 	{	return _id;	}
@@ -133,25 +216,72 @@ namespace micro_profiler
 	template <typename E>
 	FORCE_NOINLINE void buffers_queue<E>::flush() throw()
 	{
-		_active_buffer->size = buffering_policy::buffer_size - _n_left;
+		const auto size = static_cast<unsigned int>(_ptr - _active_buffer->data());
+		auto next = _empty_buffers->pop();
+
+		if (!next && _drop_on_overflow.load(std::memory_order_relaxed))
+		{
+			// No empty buffer is available: discard what has been collected and reuse the active buffer.
+			_dropped += size;
+			_discarded = true;
+			_ptr = _active_buffer->data();
+			_n_left = usable_size(*_active_buffer);
+			return;
+		}
+		_active_buffer->size = size;
+		_active_buffer->dropped = _dropped;
+		_dropped = 0;
 		_ready_buffers.produce(std::move(_active_buffer), [] (int) {});
-		for (;; _continue.wait())
+		if (_ready_word)
+			_ready_word->fetch_or(_ready_mask); // Sequentially consistent - pairs with the lowering by the reader.
+		if (!next)
 		{
-			mt::lock_guard<mt::mutex> l(_mtx);
-
-			if (_empty_buffers_top == _empty_buffers.get())
-				continue;
-			start_buffer(*--_empty_buffers_top);
-			break;
+			// The flag is raised before the ring is checked again, and the reader checks the flag after it returns
+			// buffers to the ring - either the buffer returned is seen here, or the reader sees the flag and wakes us.
+			_waiting.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			while (next = _empty_buffers->pop(), !next)
+				_continue.wait();
+			_waiting.store(false, std::memory_order_relaxed);
 		}
+		start_buffer(next);
+	}
+
+	template <typename E>
+	inline void buffers_queue<E>::reserve(unsigned int n) throw()
+	{
+		if (_n_left < n)
+			flush();
 	}
 
+	template <typename E>
+	inline unsigned int buffers_queue<E>::available() const throw()
+	{	return _n_left;	}
+
+	template <typename E>
+	inline void buffers_queue<E>::advance(unsigned int n) throw()
+	{	_ptr += n, _n_left -= n;	}
+
+	template <typename E>
+	inline bool buffers_queue<E>::discarded() throw()
+	{	return _discarded ? _discarded = false, true : false;	}
+
+	template <typename E>
+	inline bool buffers_queue<E>::handing_off() const throw()
+	{	return !_active_buffer;	}
+
 	template <typename E>
 	template <typename ReaderT>
 	inline void buffers_queue<E>::read_collected(const ReaderT &reader)
+	{	read_collected(reader, [] (unsigned int, count_t) {	});	}
+
+	template <typename E>
+	template <typename ReaderT, typename DropReaderT>
+	inline void buffers_queue<E>::read_collected(const ReaderT &reader, const DropReaderT &drop_reader)
 	{
 		auto n = _policy.max_buffers(); // Untested: even under a heavy load, analyzer thread shall be responsible.
 		auto ready_n = 0;
+		auto delivered_n = 0u;
 
 		for (buffer_ptr ready; n-- && _ready_buffers.consume([&ready] (buffer_ptr &b) {
 			std::swap(ready, b);
@@ -161,63 +291,198 @@ namespace micro_profiler
 			return !!n;
 		}); )
 		{
-			reader(_id, ready->data, ready->size);
-			_mtx.lock();
-				const bool notify_continue = _empty_buffers_top == _empty_buffers.get();
-				std::swap(*_empty_buffers_top++, ready);
-			_mtx.unlock();
-			if (notify_continue)
-				_continue.set();
+			if (ready->dropped)
+				drop_reader(_id, ready->dropped);
+			reader(_id, ready->data(), ready->size);
+			recycle_buffer(ready.release());
+			delivered_n++;
 		}
 
-		mt::lock_guard<mt::mutex> l(_mtx);
-		const bool notify_continue = _empty_buffers_top == _empty_buffers.get();
-
+		adapt_buffer_size(delivered_n);
 		adjust_empty_buffers(_policy, static_cast<size_t>(ready_n));
-		if (notify_continue)
+
+		// Pairs with the fence of the producer starting to wait (see flush()).
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (_waiting.load(std::memory_order_relaxed))
 			_continue.set();
 	}
 
+	template <typename E>
+	inline void buffers_queue<E>::skip_reads(unsigned int n)
+	{
+		for (n = (std::min)(n, static_cast<unsigned int>(adaptation_window)); n--; )
+			adapt_buffer_size(0);
+	}
+
 	template <typename E>
 	inline void buffers_queue<E>::set_buffering_policy(const buffering_policy &policy)
 	{
-		mt::lock_guard<mt::mutex> l(_mtx);
+		const auto buffer_size = (std::min)(_buffer_size.load(std::memory_order_relaxed), policy.max_buffer_size());
 
-		adjust_empty_buffers(policy, _allocated_buffers - (_empty_buffers_top - _empty_buffers.get()) - 1 /*active*/);
+		_buffer_size.store((std::max)(buffer_size, policy.min_buffer_size()), std::memory_order_relaxed);
 		_policy = policy;
+		adjust_empty_buffers(policy, _allocated_buffers - _empty_buffers->size() - 1 /*active*/);
+		_drop_on_overflow.store(buffering_policy::drop_on_overflow == policy.overflow(), std::memory_order_relaxed);
+		_continue.set();
+	}
+
+	template <typename E>
+	inline void buffers_queue<E>::trim()
+	{
+		auto keep_n = min_empty(_policy);
+
+		_buffer_size.store(_policy.initial_buffer_size(), std::memory_order_relaxed);
+		_window_reads = _window_delivered = 0;
+		if (_active_buffer->capacity != _buffer_size.load(std::memory_order_relaxed))
+		{
+			destroy_buffer(_active_buffer.release());
+			start_buffer(create_buffer());
+		}
+		for (auto n = _empty_buffers->size(); n--; )
+		{
+			const auto b = _empty_buffers->pop();
+
+			if (!b)
+				break;
+			else if (keep_n)
+				keep_n--, recycle_buffer(b);
+			else
+				destroy_buffer(b);
+		}
+	}
+
+	template <typename E>
+	inline void buffers_queue<E>::reset(unsigned int id) throw()
+	{
+		_id = id;
+		_dropped = 0;
+		_discarded = false;
+		_ptr = _active_buffer->data();
+		_n_left = usable_size(*_active_buffer);
 	}
 
 	template <typename E>
-	inline void buffers_queue<E>::create_buffer(buffer_ptr &new_buffer)
+	inline void buffers_queue<E>::set_ready_flag(std::atomic<unsigned long long> &word, unsigned long long mask) throw()
+	{	_ready_word = &word, _ready_mask = mask;	}
+
+	template <typename E>
+	inline typename buffers_queue<E>::buffer *buffers_queue<E>::create_buffer()
 	{
-		buffer_ptr b(new (_allocator.allocate(sizeof(buffer))) buffer, buffer_deleter(_allocator));
+		const auto capacity = static_cast<unsigned>(_buffer_size.load(std::memory_order_relaxed));
+		const auto b = new (_allocator.allocate(sizeof(buffer) + capacity * sizeof(E))) buffer(capacity);
 
 		++_allocated_buffers;
-		std::swap(new_buffer, b);
+		_allocated_entries += capacity;
+		return b;
+	}
+
+	template <typename E>
+	inline void buffers_queue<E>::destroy_buffer(buffer *b) throw()
+	{
+		--_allocated_buffers;
+		_allocated_entries -= b->capacity;
+		b->~buffer();
+		_allocator.deallocate(b);
+	}
+
+	template <typename E>
+	inline void buffers_queue<E>::start_buffer(buffer *new_buffer) throw()
+	{
+		_active_buffer = buffer_ptr(new_buffer, buffer_deleter(_allocator));
+		_ptr = _active_buffer->data();
+		_n_left = usable_size(*new_buffer);
+	}
+
+	template <typename E>
+	inline unsigned int buffers_queue<E>::usable_size(const buffer &b) const throw()
+	{
+		// A buffer taken before the size was reduced is filled up to the new size only.
+		return (std::min)(b.capacity, static_cast<unsigned>(_buffer_size.load(std::memory_order_relaxed)));
+	}
+
+	template <typename E>
+	inline void buffers_queue<E>::recycle_buffer(buffer *empty_buffer)
+	{
+		const auto buffer_size = _buffer_size.load(std::memory_order_relaxed);
+
+		if (empty_buffer->capacity != buffer_size
+			&& _allocated_entries - empty_buffer->capacity + buffer_size <= _policy.max_entries())
+		{
+			// Buffers of an outdated size are replaced, unless the allocation limit does not allow for it.
+			destroy_buffer(empty_buffer);
+			empty_buffer = create_buffer();
+		}
+		if (!_empty_buffers->push(empty_buffer))
+			destroy_buffer(empty_buffer);
 	}
 
 	template <typename E>
-	inline void buffers_queue<E>::start_buffer(buffer_ptr &new_buffer) throw()
+	inline void buffers_queue<E>::adapt_buffer_size(size_t delivered_n)
 	{
-		std::swap(_active_buffer, new_buffer);
-		_ptr = _active_buffer->data;
-		_n_left = buffering_policy::buffer_size;
+		auto buffer_size = _buffer_size.load(std::memory_order_relaxed);
+
+		_window_reads++, _window_delivered += static_cast<unsigned int>(delivered_n);
+		if (delivered_n > 1)
+		{
+			// More than a buffer is filled per read - the thread is hot, fewer but bigger buffers are preferred.
+			buffer_size = (std::min)(2 * buffer_size, _policy.max_buffer_size());
+			_window_reads = _window_delivered = 0;
+		}
+		else if (_window_reads == adaptation_window)
+		{
+			// Less than a buffer is filled per four reads - the thread is cold, the memory is better given back.
+			if (4 * _window_delivered < adaptation_window)
+				buffer_size = (std::max)(buffer_size / 2, _policy.min_buffer_size());
+			_window_reads = _window_delivered = 0;
+		}
+
+		// The empty buffers are left in place for the profilee to take (taking them away would make it wait or drop
+		// the trace) - the ones of another size are replaced as they come back (see recycle_buffer()).
+		_buffer_size.store(buffer_size, std::memory_order_relaxed);
 	}
 
 	template <typename E>
 	inline void buffers_queue<E>::adjust_empty_buffers(const buffering_policy &policy, size_t base_n)
 	{
-		auto empty_n = static_cast<size_t>(_empty_buffers_top - _empty_buffers.get());
+		auto empty_n = _empty_buffers->size();
 		const auto high_water = policy.max_empty() + base_n;
-		const auto low_water = policy.min_empty() + base_n;
+		const auto low_water = min_empty(policy) + base_n;
 
 		for (; empty_n > high_water; empty_n--)
-			(--_empty_buffers_top)->reset(), --_allocated_buffers;
-		for (; _allocated_buffers < policy.max_buffers() && empty_n < low_water; empty_n++)
-			create_buffer(*_empty_buffers_top++);
+		{
+			const auto b = _empty_buffers->pop();
+
+			if (!b)
+				break;
+			destroy_buffer(b);
+		}
+		for (; _allocated_buffers < policy.max_buffers()
+			&& _allocated_entries + _buffer_size.load(std::memory_order_relaxed) <= policy.max_entries()
+			&& empty_n < low_water; empty_n++)
+		{
+			recycle_buffer(create_buffer());
+		}
+	}
+
+	template <typename E>
+	inline size_t buffers_queue<E>::min_empty(const buffering_policy &policy) throw()
+	{
+		return buffering_policy::drop_on_overflow == policy.overflow()
+			? (std::max<size_t>)(policy.min_empty(), 1u) // Keep a spare buffer for the trace to resume after a drop.
+			: policy.min_empty();
 	}
 
 
+	template <typename E>
+	inline buffers_queue<E>::buffer::buffer(unsigned capacity_)
+		: capacity(capacity_)
+	{	}
+
+	template <typename E>
+	inline E *buffers_queue<E>::buffer::data() throw()
+	{	return reinterpret_cast<E *>(this + 1);	}
+
+
 	template <typename E>
 	inline buffers_queue<E>::buffer_deleter::buffer_deleter()
 		: _allocator(nullptr)
@@ -234,4 +499,43 @@ namespace micro_profiler
 		object->~buffer();
 		_allocator->deallocate(object);
 	}
+
+
+	template <typename E>
+	inline buffers_queue<E>::empty_buffers::empty_buffers(size_t capacity)
+		: _capacity(capacity), _buffers(new std::atomic<buffer *>[capacity]), _head(0), _tail(0)
+	{	}
+
+	template <typename E>
+	inline buffers_queue<E>::empty_buffers::~empty_buffers()
+	{	}
+
+	template <typename E>
+	inline size_t buffers_queue<E>::empty_buffers::size() const throw()
+	{	return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);	}
+
+	template <typename E>
+	inline bool buffers_queue<E>::empty_buffers::push(buffer *b) throw()
+	{
+		const auto tail = _tail.load(std::memory_order_relaxed);
+
+		if (tail - _head.load(std::memory_order_acquire) == _capacity)
+			return false;
+		_buffers[tail % _capacity].store(b, std::memory_order_relaxed);
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	template <typename E>
+	inline typename buffers_queue<E>::buffer *buffers_queue<E>::empty_buffers::pop() throw()
+	{
+		for (auto head = _head.load(std::memory_order_acquire); head != _tail.load(std::memory_order_acquire); )
+		{
+			const auto b = _buffers[head % _capacity].load(std::memory_order_relaxed);
+
+			if (_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+				return b;
+		}
+		return nullptr;
+	}
 }
@@ -26,7 +26,7 @@ namespace micro_profiler
 {
 	class calls_collector;
 
-	overhead calibrate_overhead(calls_collector &collector, size_t trace_limit);
+	overhead calibrate_overhead(calls_collector &collector, size_t trace_limit, const buffering_policy &working_policy);
 
 	void empty_call();
 	void empty_call_instrumented();
@@ -0,0 +1,57 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include <common/types.h>
+#include <string>
+
+namespace mt
+{
+	struct thread_callbacks;
+}
+
+namespace micro_profiler
+{
+	struct allocator;
+
+	// Calibration results valid for a particular processor and collector build - see calibration_key().
+	struct calibration_info
+	{
+		timestamp_t ticks_per_second;
+		timestamp_t inner, outer; // Overhead of the calls instrumented with the compiler hooks.
+		timestamp_t tracking; // Overhead of the calls tracked explicitly - cheap to remeasure for a revalidation.
+	};
+
+	// Identifies the processor model, its microcode revision and the collector build. An empty key is returned if the
+	// processor cannot be identified - no calibration must be cached then.
+	std::string calibration_key(const std::string &collector_path);
+
+	bool load_calibration(calibration_info &info, const std::string &path, const std::string &key);
+	void store_calibration(const std::string &path, const std::string &key, const calibration_info &info);
+
+	// Returns true if the remeasured values are within the tolerance of those cached.
+	bool is_calibration_valid(const calibration_info &cached, timestamp_t ticks_per_second_, timestamp_t tracking);
+
+	// Measures the overhead of a pair of calls_collector::track() calls on a private collector, so that it can be done
+	// from a background thread at any time without affecting the trace collected.
+	timestamp_t measure_tracking_overhead(allocator &allocator_, mt::thread_callbacks &thread_callbacks,
+		size_t iterations);
+}
@@ -0,0 +1,488 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include "primitives.h"
+
+#include <algorithm>
+#include <common/compiler.h>
+#include <common/hash.h>
+#include <iterator>
+#include <vector>
+
+namespace micro_profiler
+{
+	template <typename KeyT>
+	class call_graph;
+
+	template <typename KeyT>
+	class call_graph_level;
+
+	// A node of a call_graph as seen by its readers: the statistics of the function and its callees.
+	template <typename KeyT>
+	class call_graph_entry
+	{
+	public:
+		call_graph_entry(const call_graph<KeyT> &graph, unsigned int index) throw();
+
+		const function_statistics &statistics() const throw();
+		call_graph_level<KeyT> callees() const throw();
+
+		// Puts the call times of the node into the histogram, leaving it intact if they are not collected.
+		void get_call_times(call_times_histogram &to) const;
+
+		// Makes a deep copy of the subtree.
+		operator call_graph_node<KeyT>() const;
+
+	private:
+		const call_graph<KeyT> *_graph;
+		unsigned int _index;
+	};
+
+	// Callees of a call_graph node, presented as a container of (callee, entry) pairs.
+	template <typename KeyT>
+	class call_graph_level
+	{
+	public:
+		typedef std::pair<KeyT, call_graph_entry<KeyT> > value_type;
+		class const_iterator;
+
+	public:
+		call_graph_level(const call_graph<KeyT> &graph, unsigned int parent) throw();
+
+		size_t size() const throw();
+		bool empty() const throw();
+		const_iterator begin() const throw();
+		const_iterator end() const throw();
+
+	private:
+		const call_graph<KeyT> *_graph;
+		unsigned int _parent;
+	};
+
+	template <typename KeyT>
+	class call_graph_level<KeyT>::const_iterator : public std::iterator<std::forward_iterator_tag, const value_type>
+	{
+	public:
+		const_iterator(const call_graph<KeyT> &graph, unsigned int index) throw();
+
+		const value_type &operator *() const throw();
+		const value_type *operator ->() const throw();
+		const_iterator &operator ++() throw();
+
+		bool operator ==(const const_iterator &rhs) const throw();
+		bool operator !=(const const_iterator &rhs) const throw();
+
+	private:
+		void fetch() throw();
+
+	private:
+		const call_graph<KeyT> *_graph;
+		unsigned int _index;
+		value_type _value;
+	};
+
+	// A call tree kept in a single array of nodes. The nodes are addressed by indices, that remain valid until the
+	// graph is cleared, and are looked up by (parent index, callee) in an open-addressing hash table. If requested, the
+	// call times histograms of the nodes (see call_times_scale()) are kept aside, in a single array of buckets. The
+	// nodes marked as updated are listed in the order of marking, so that the changes are found without a full scan.
+	template <typename KeyT>
+	class call_graph
+	{
+	public:
+		typedef call_graph_level<KeyT> level;
+		typedef typename level::const_iterator const_iterator;
+		typedef typename level::value_type value_type;
+
+		enum {	root = 0	};
+
+	public:
+		explicit call_graph(bool call_times = false);
+
+		// Returns an index of the parent's callee node, creating it if necessary.
+		unsigned int callee(unsigned int parent, KeyT callee_);
+		function_statistics &operator [](unsigned int index) throw();
+		const function_statistics &operator [](unsigned int index) const throw();
+
+		// Accounts for the calls of the node taking the time specified each - ignored, unless call times are kept.
+		void add_call_times(unsigned int index, timestamp_t time, count_t calls) throw();
+		void get_call_times(call_times_histogram &to, unsigned int index) const;
+
+		// Zeroes the statistics and the call times of the node.
+		void reset(unsigned int index) throw();
+
+		// Lists the node in updated(), unless it is listed already.
+		void mark_updated(unsigned int index);
+		const std::vector<unsigned int> &updated() const throw();
+
+		// Resets the nodes listed in updated() and empties the list.
+		void reset_updated() throw();
+
+		// Nodes are indexed in order of creation, from the root to node_count() - 1.
+		unsigned int node_count() const throw();
+		unsigned int parent(unsigned int index) const throw();
+		KeyT key(unsigned int index) const throw();
+
+		// Adds statistics of the other graph's nodes to the corresponding nodes of this one.
+		void merge(const call_graph &other);
+		void clear() throw();
+		void swap(call_graph &other) throw();
+
+		// The graph is a container of the root callees.
+		size_t size() const throw();
+		bool empty() const throw();
+		const_iterator begin() const throw();
+		const_iterator end() const throw();
+
+	private:
+		enum {	initial_slots = 64	};
+
+		struct node : function_statistics
+		{
+			node(KeyT callee_ = KeyT(), unsigned int parent_ = root, unsigned int next_sibling_ = 0);
+
+			KeyT callee;
+			unsigned int parent, first_callee, next_sibling, callees_count;
+			bool updated;
+		};
+
+	private:
+		unsigned int insert(size_t slot, unsigned int parent, KeyT callee_);
+		void grow();
+		static size_t hash(unsigned int parent, KeyT callee_) throw();
+
+	private:
+		std::vector<node> _nodes;
+		std::vector<unsigned int> _slots;
+		math::log_linear_scale<timestamp_t> _call_times_scale;
+		std::vector<count_t> _call_times;
+		std::vector<unsigned int> _updated;
+
+	private:
+		friend class call_graph_entry<KeyT>;
+		friend class call_graph_level<KeyT>;
+		friend class call_graph_level<KeyT>::const_iterator;
+	};
+
+
+
+	// call_graph_entry - inline definitions
+	template <typename KeyT>
+	inline call_graph_entry<KeyT>::call_graph_entry(const call_graph<KeyT> &graph, unsigned int index) throw()
+		: _graph(&graph), _index(index)
+	{	}
+
+	template <typename KeyT>
+	inline const function_statistics &call_graph_entry<KeyT>::statistics() const throw()
+	{	return (*_graph)[_index];	}
+
+	template <typename KeyT>
+	inline call_graph_level<KeyT> call_graph_entry<KeyT>::callees() const throw()
+	{	return call_graph_level<KeyT>(*_graph, _index);	}
+
+	template <typename KeyT>
+	inline void call_graph_entry<KeyT>::get_call_times(call_times_histogram &to) const
+	{	_graph->get_call_times(to, _index);	}
+
+	template <typename KeyT>
+	inline call_graph_entry<KeyT>::operator call_graph_node<KeyT>() const
+	{
+		const auto callees_ = callees();
+		call_graph_node<KeyT> result(statistics());
+
+		get_call_times(result.call_times);
+		for (auto i = callees_.begin(); i != callees_.end(); ++i)
+			result.callees.insert(std::make_pair(i->first, static_cast< call_graph_node<KeyT> >(i->second)));
+		return result;
+	}
+
+
+	// call_graph_level - inline definitions
+	template <typename KeyT>
+	inline call_graph_level<KeyT>::call_graph_level(const call_graph<KeyT> &graph, unsigned int parent) throw()
+		: _graph(&graph), _parent(parent)
+	{	}
+
+	template <typename KeyT>
+	inline size_t call_graph_level<KeyT>::size() const throw()
+	{	return _graph->_nodes[_parent].callees_count;	}
+
+	template <typename KeyT>
+	inline bool call_graph_level<KeyT>::empty() const throw()
+	{	return !size();	}
+
+	template <typename KeyT>
+	inline typename call_graph_level<KeyT>::const_iterator call_graph_level<KeyT>::begin() const throw()
+	{	return const_iterator(*_graph, _graph->_nodes[_parent].first_callee);	}
+
+	template <typename KeyT>
+	inline typename call_graph_level<KeyT>::const_iterator call_graph_level<KeyT>::end() const throw()
+	{	return const_iterator(*_graph, 0);	}
+
+
+	// call_graph_level::const_iterator - inline definitions
+	template <typename KeyT>
+	inline call_graph_level<KeyT>::const_iterator::const_iterator(const call_graph<KeyT> &graph, unsigned int index)
+			throw()
+		: _graph(&graph), _index(index), _value(KeyT(), call_graph_entry<KeyT>(graph, index))
+	{	fetch();	}
+
+	template <typename KeyT>
+	inline const typename call_graph_level<KeyT>::value_type &call_graph_level<KeyT>::const_iterator::operator *()
+		const throw()
+	{	return _value;	}
+
+	template <typename KeyT>
+	inline const typename call_graph_level<KeyT>::value_type *call_graph_level<KeyT>::const_iterator::operator ->()
+		const throw()
+	{	return &_value;	}
+
+	template <typename KeyT>
+	inline typename call_graph_level<KeyT>::const_iterator &call_graph_level<KeyT>::const_iterator::operator ++()
+		throw()
+	{
+		_index = _graph->_nodes[_index].next_sibling;
+		fetch();
+		return *this;
+	}
+
+	template <typename KeyT>
+	inline bool call_graph_level<KeyT>::const_iterator::operator ==(const const_iterator &rhs) const throw()
+	{	return _index == rhs._index;	}
+
+	template <typename KeyT>
+	inline bool call_graph_level<KeyT>::const_iterator::operator !=(const const_iterator &rhs) const throw()
+	{	return _index != rhs._index;	}
+
+	template <typename KeyT>
+	inline void call_graph_level<KeyT>::const_iterator::fetch() throw()
+	{
+		_value.first = _graph->_nodes[_index].callee;
+		_value.second = call_graph_entry<KeyT>(*_graph, _index);
+	}
+
+
+	// call_graph - inline definitions
+	template <typename KeyT>
+	inline call_graph<KeyT>::node::node(KeyT callee_, unsigned int parent_, unsigned int next_sibling_)
+		: callee(callee_), parent(parent_), first_callee(0), next_sibling(next_sibling_), callees_count(0),
+			updated(false)
+	{	}
+
+	template <typename KeyT>
+	inline call_graph<KeyT>::call_graph(bool call_times)
+		: _nodes(1), _slots(initial_slots),
+			_call_times_scale(call_times ? call_times_scale() : math::log_linear_scale<timestamp_t>()),
+			_call_times(_call_times_scale.samples())
+	{	}
+
+	template <typename KeyT>
+	FORCE_INLINE unsigned int call_graph<KeyT>::callee(unsigned int parent, KeyT callee_)
+	{
+		const auto mask = _slots.size() - 1;
+
+		for (auto slot = hash(parent, callee_) & mask; ; slot = (slot + 1) & mask)
+		{
+			if (const auto index = _slots[slot])
+			{
+				const auto &n = _nodes[index];
+
+				if (n.parent == parent && n.callee == callee_)
+					return index;
+			}
+			else
+			{
+				return insert(slot, parent, callee_);
+			}
+		}
+	}
+
+	template <typename KeyT>
+	inline function_statistics &call_graph<KeyT>::operator [](unsigned int index) throw()
+	{	return _nodes[index];	}
+
+	template <typename KeyT>
+	inline const function_statistics &call_graph<KeyT>::operator [](unsigned int index) const throw()
+	{	return _nodes[index];	}
+
+	template <typename KeyT>
+	FORCE_INLINE void call_graph<KeyT>::add_call_times(unsigned int index, timestamp_t time, count_t calls) throw()
+	{
+		math::index_t bucket;
+
+		if (_call_times_scale(bucket, time))
+			_call_times[index * _call_times_scale.samples() + bucket] += calls;
+	}
+
+	template <typename KeyT>
+	inline void call_graph<KeyT>::get_call_times(call_times_histogram &to, unsigned int index) const
+	{
+		if (const auto n = _call_times_scale.samples())
+		{
+			const auto buckets = _call_times.begin() + index * n;
+
+			to.set_scale(_call_times_scale);
+			std::copy(buckets, buckets + n, to.begin());
+		}
+	}
+
+	template <typename KeyT>
+	inline void call_graph<KeyT>::reset(unsigned int index) throw()
+	{
+		const auto n = _call_times_scale.samples();
+		const auto buckets = _call_times.begin() + index * n;
+
+		micro_profiler::reset(_nodes[index]);
+		std::fill(buckets, buckets + n, count_t());
+	}
+
+	template <typename KeyT>
+	FORCE_INLINE void call_graph<KeyT>::mark_updated(unsigned int index)
+	{
+		auto &n = _nodes[index];
+
+		if (!n.updated)
+			n.updated = true, _updated.push_back(index);
+	}
+
+	template <typename KeyT>
+	inline const std::vector<unsigned int> &call_graph<KeyT>::updated() const throw()
+	{	return _updated;	}
+
+	template <typename KeyT>
+	inline void call_graph<KeyT>::reset_updated() throw()
+	{
+		for (auto i = _updated.begin(); i != _updated.end(); ++i)
+		{
+			reset(*i);
+			_nodes[*i].updated = false;
+		}
+		_updated.clear();
+	}
+
+	template <typename KeyT>
+	inline unsigned int call_graph<KeyT>::node_count() const throw()
+	{	return static_cast<unsigned int>(_nodes.size());	}
+
+	template <typename KeyT>
+	inline unsigned int call_graph<KeyT>::parent(unsigned int index) const throw()
+	{	return _nodes[index].parent;	}
+
+	template <typename KeyT>
+	inline KeyT call_graph<KeyT>::key(unsigned int index) const throw()
+	{	return _nodes[index].callee;	}
+
+	template <typename KeyT>
+	inline void call_graph<KeyT>::merge(const call_graph &other)
+	{
+		std::vector<unsigned int> mapping(other._nodes.size(), root);
+		const auto buckets = _call_times_scale == other._call_times_scale ? _call_times_scale.samples() : 0u;
+
+		// Parents always precede their callees in the nodes array.
+		for (unsigned int i = 1, count = static_cast<unsigned int>(other._nodes.size()); i != count; ++i)
+		{
+			const auto &n = other._nodes[i];
+			const auto index = mapping[i] = callee(mapping[n.parent], n.callee);
+
+			add(_nodes[index], n);
+			for (auto j = 0u; j != buckets; ++j)
+				_call_times[index * buckets + j] += other._call_times[i * buckets + j];
+			if (n.times_called)
+				mark_updated(index);
+		}
+	}
+
+	template <typename KeyT>
+	inline void call_graph<KeyT>::clear() throw()
+	{
+		_nodes.resize(1);
+		_nodes[root] = node();
+		std::fill(_slots.begin(), _slots.end(), 0u);
+		_call_times.resize(_call_times_scale.samples());
+		std::fill(_call_times.begin(), _call_times.end(), count_t());
+		_updated.clear();
+	}
+
+	template <typename KeyT>
+	inline void call_graph<KeyT>::swap(call_graph &other) throw()
+	{
+		_nodes.swap(other._nodes);
+		_slots.swap(other._slots);
+		std::swap(_call_times_scale, other._call_times_scale);
+		_call_times.swap(other._call_times);
+		_updated.swap(other._updated);
+	}
+
+	template <typename KeyT>
+	inline size_t call_graph<KeyT>::size() const throw()
+	{	return level(*this, root).size();	}
+
+	template <typename KeyT>
+	inline bool call_graph<KeyT>::empty() const throw()
+	{	return level(*this, root).empty();	}
+
+	template <typename KeyT>
+	inline typename call_graph<KeyT>::const_iterator call_graph<KeyT>::begin() const throw()
+	{	return level(*this, root).begin();	}
+
+	template <typename KeyT>
+	inline typename call_graph<KeyT>::const_iterator call_graph<KeyT>::end() const throw()
+	{	return level(*this, root).end();	}
+
+	template <typename KeyT>
+	FORCE_NOINLINE inline unsigned int call_graph<KeyT>::insert(size_t slot, unsigned int parent, KeyT callee_)
+	{
+		if (2 * _nodes.size() > _slots.size())
+			return grow(), callee(parent, callee_);
+
+		const auto index = static_cast<unsigned int>(_nodes.size());
+
+		_nodes.push_back(node(callee_, parent, _nodes[parent].first_callee));
+		_call_times.resize(_call_times.size() + _call_times_scale.samples());
+
+		auto &p = _nodes[parent];
+
+		p.first_callee = index;
+		p.callees_count++;
+		return _slots[slot] = index;
+	}
+
+	template <typename KeyT>
+	inline void call_graph<KeyT>::grow()
+	{
+		std::vector<unsigned int> slots(2 * _slots.size());
+		const auto mask = slots.size() - 1;
+
+		for (unsigned int i = 1, count = static_cast<unsigned int>(_nodes.size()); i != count; ++i)
+		{
+			auto slot = hash(_nodes[i].parent, _nodes[i].callee) & mask;
+
+			while (slots[slot])
+				slot = (slot + 1) & mask;
+			slots[slot] = i;
+		}
+		_slots.swap(slots);
+	}
+
+	template <typename KeyT>
+	inline size_t call_graph<KeyT>::hash(unsigned int parent, KeyT callee_) throw()
+	{	return knuth_hash()(std::make_pair(parent, callee_));	}
+}
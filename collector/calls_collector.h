@@ -21,24 +21,48 @@
 #pragma once
 
 #include "calls_collector_thread.h"
+#include "compact_trace.h"
 #include "thread_queue_manager.h"
 
 namespace micro_profiler
 {
 	class thread_monitor;
 
+#ifdef MP_FAST_CURSOR
+	// The cursor of the calling thread's queue, for the fast trampoline to reach it at a fixed thread pointer offset.
+	extern __thread fast_cursor g_fast_cursor __attribute__((tls_model("initial-exec")));
+#endif
+
 	struct calls_collector_i
 	{
 		struct acceptor;
 
 		virtual ~calls_collector_i() {	}
 		virtual void read_collected(acceptor &a) = 0;
+
+		// Reads traces of the threads with 'threadid % partitions == partition' only. Distinct partitions can be read
+		// concurrently with each other.
+		virtual void read_collected(acceptor &a, unsigned int partition, unsigned int partitions) = 0;
+
 		virtual void flush() = 0;
 	};
 
 	struct calls_collector_i::acceptor
 	{
 		virtual void accept_calls(unsigned int threadid, const call_record *calls, size_t count) = 0;
+
+		// Compact records are only delivered by a collector built with MP_COMPACT_TRACE. The callees table stays
+		// valid and unchanged for the records passed for as long as the thread is alive.
+		virtual void accept_calls(unsigned int threadid, const compact_call_record *calls, size_t count,
+			const callee_table &callees) = 0;
+
+		// Called when 'count' records of the thread were lost due to a buffers overflow. The calls accepted after
+		// this notification do not necessarily match the call stack seen before.
+		virtual void accept_dropped(unsigned int threadid, count_t count) = 0;
+
+		// Called when the thread has exited and all of its trace has been accepted. The calls accepted for the same ID
+		// afterwards, if any, are to be taken for a new thread.
+		virtual void accept_exited(unsigned int threadid) = 0;
 	};
 
 
@@ -49,6 +73,7 @@ namespace micro_profiler
 			mt::thread_callbacks &thread_callbacks);
 
 		virtual void read_collected(acceptor &a) override;
+		virtual void read_collected(acceptor &a, unsigned int partition, unsigned int partitions) override;
 		virtual void flush() override;
 
 		static void CC_(fastcall) on_enter(calls_collector *instance, const void **stack_ptr,
@@ -58,10 +83,22 @@ namespace micro_profiler
 
 		void track(timestamp_t timestamp, const void *callee);
 
+#ifdef MP_FAST_CURSOR
+		// Binds the queues to g_fast_cursor of their threads: the calling thread's one right away, the others' as they
+		// are constructed. Must be called before any fast trampoline intercepting to this collector is installed.
+		void bind_fast_cursors();
+#endif
+
 	private:
 		typedef thread_queue_manager<calls_collector_thread> base_t;
 
 	private:
+		calls_collector_thread &get_thread_trace();
 		calls_collector_thread &construct_thread_trace();
+
+	private:
+#ifdef MP_FAST_CURSOR
+		std::atomic<bool> _fast_cursors;
+#endif
 	};
 }
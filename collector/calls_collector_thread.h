@@ -21,15 +21,40 @@
 #pragma once
 
 #include "buffers_queue.h"
+#include "compact_trace.h"
+#include "hw_counters.h"
 
+#include <atomic>
 #include <common/pod_vector.h>
 #include <functional>
+#include <memory>
+
+#if defined(__linux__) && defined(__x86_64__) && !defined(MP_COMPACT_TRACE)
+	#define MP_FAST_CURSOR
+	#include <patcher/dynamic_hooking.h>
+#endif
 
 namespace micro_profiler
 {
 	struct allocator;
 
-	class calls_collector_thread : public buffers_queue<call_record>
+	// With a short call threshold set by the buffering policy, an entry is not written until it is known to be of a
+	// long or a non-leaf call. Consecutive short leaf calls to the same callee are folded together and written as a
+	// folded_calls_tag record followed by a single entry/exit pair, which spans their total time. Calls tracked
+	// directly with track() are never folded.
+	// With hardware counters enabled by the policy, the thread opens its counters on the first traced call and
+	// precedes each entry and exit written with hw_counter_tag records. If the counters are not available, the trace is
+	// written as usual. Neither are the records written for the readings falling short (see hw_counters::read()).
+	// Heap allocations reported by on_allocation() are accumulated and written as an allocations_tag and
+	// allocated_bytes_tag pair before the next entry or exit, thus being attributed to the call active when they were
+	// made. A short leaf call that has allocated is never folded.
+	// A contended lock wait reported by on_lock_wait() is written right away as a lock_wait_tag record followed by an
+	// entry/exit pair of the blocking function, which is never deferred or folded. The waits of the queue itself for an
+	// empty buffer are not written.
+	// A queue bound to a fast_cursor exposes its active buffer and return stack through it, so that the fast trampoline
+	// could write the regular entries and exits directly. The records written this way are accounted on the next call
+	// to the queue, which republishes the cursor before returning.
+	class calls_collector_thread : public buffers_queue<trace_record>
 	{
 	public:
 		typedef std::function<void (unsigned int id, const call_record *calls, size_t count)> reader_t;
@@ -42,19 +67,173 @@ namespace micro_profiler
 
 		void track(const void *callee, timestamp_t timestamp) throw();
 
+		// Must only be called by the owning thread. Never allocates.
+		void on_allocation(size_t size) throw();
+
+		// Must only be called by the owning thread, after the wait is over. Never allocates.
+		void on_lock_wait(const void *lock, const void *blocking_function, timestamp_t started, timestamp_t finished)
+			throw();
+
 		void flush();
+		void set_buffering_policy(const buffering_policy &policy);
+		void reset(unsigned int id) throw();
+
+#ifdef MP_FAST_CURSOR
+		// Must only be called by the owning thread with the cursor of it. A reset() unbinds the queue.
+		void bind_cursor(fast_cursor &cursor) throw();
+#endif
+
+#ifdef MP_COMPACT_TRACE
+		template <typename ReaderT>
+		void read_collected(const ReaderT &reader);
+
+		// The reader is invoked as reader(id, calls, count, callees) for the compact records.
+		template <typename ReaderT, typename DropReaderT>
+		void read_collected(const ReaderT &reader, const DropReaderT &drop_reader);
+#endif
+
+	private:
+		enum {	max_folded_calls = 4096,	};
+
+	private:
+		void pull_cursor() throw();
+		void push_cursor() throw();
+		void write(const void *callee, timestamp_t timestamp) throw();
+		void enter(const void *callee, timestamp_t timestamp) throw();
+		void exit(timestamp_t timestamp) throw();
+		void fold(timestamp_t timestamp) throw();
+		void write_deferred() throw();
+		void write_folded() throw();
+		void write_hw_counters() throw();
+		void write_allocations() throw();
 
 	private:
 		pod_vector<return_entry> _return_stack;
+		std::atomic<timestamp_t> _short_call_threshold;
+		const void *_deferred_callee;
+		timestamp_t _deferred_at;
+		const void *_folded_callee;
+		timestamp_t _folded_at, _folded_time;
+		count_t _folded_calls;
+		std::atomic<bool> _hw_counters_enabled;
+		std::unique_ptr<hw_counters> _hw_counters;
+		bool _hw_counters_unavailable;
+		count_t _allocations, _allocated_bytes;
+#ifdef MP_COMPACT_TRACE
+		compact_encoder _encoder;
+#endif
+#ifdef MP_FAST_CURSOR
+		fast_cursor *_cursor;
+#endif
 	};
 
 
 
 	FORCE_INLINE void calls_collector_thread::track(const void *callee, timestamp_t timestamp) throw()
 	{
+		pull_cursor();
+		write(callee, timestamp);
+		push_cursor();
+	}
+
+	FORCE_INLINE void calls_collector_thread::pull_cursor() throw()
+	{
+#ifdef MP_FAST_CURSOR
+		if (!_cursor)
+			return;
+		advance(static_cast<unsigned int>(reinterpret_cast<trace_record *>(_cursor->records) - &current()));
+		_return_stack.resize(reinterpret_cast<return_entry *>(_cursor->returns) - _return_stack.begin());
+#endif
+	}
+
+	FORCE_INLINE void calls_collector_thread::push_cursor() throw()
+	{
+#ifdef MP_FAST_CURSOR
+		if (!_cursor)
+			return;
+
+		// The last record of the buffer is left to push(), so that the buffer full is handed off.
+		_cursor->records = reinterpret_cast<fast_cursor::record *>(&current());
+		_cursor->records_end = _cursor->records + available() - 1;
+		_cursor->returns = reinterpret_cast<fast_cursor::return_entry *>(_return_stack.end());
+		_cursor->returns_end = reinterpret_cast<fast_cursor::return_entry *>(_return_stack.begin()
+			+ _return_stack.capacity());
+#endif
+	}
+
+	FORCE_INLINE void calls_collector_thread::write(const void *callee, timestamp_t timestamp) throw()
+	{
+#ifdef MP_COMPACT_TRACE
+		_encoder.encode(*this, callee, timestamp);
+#else
 		auto &c = current();
 
 		c.timestamp = timestamp, c.callee = callee;
 		push();
+#endif
+	}
+
+	FORCE_INLINE void calls_collector_thread::enter(const void *callee, timestamp_t timestamp) throw()
+	{
+		if (_deferred_callee)
+			write_deferred(); // The call deferred is not a leaf one.
+		if (_allocations)
+			write_allocations();
+		if (_short_call_threshold.load(std::memory_order_relaxed))
+		{
+			_deferred_callee = callee, _deferred_at = timestamp;
+		}
+		else
+		{
+			if (_hw_counters_enabled.load(std::memory_order_relaxed))
+				write_hw_counters();
+			write(callee, timestamp);
+		}
+	}
+
+	FORCE_INLINE void calls_collector_thread::exit(timestamp_t timestamp) throw()
+	{
+		if (_deferred_callee)
+		{
+			if (!_allocations && timestamp - _deferred_at < _short_call_threshold.load(std::memory_order_relaxed))
+			{
+				fold(timestamp);
+				return;
+			}
+			write_deferred();
+		}
+		else if (_folded_calls)
+		{
+			write_folded(); // The calls folded are the children of the one exiting.
+		}
+		if (_allocations)
+			write_allocations();
+		if (_hw_counters_enabled.load(std::memory_order_relaxed))
+			write_hw_counters();
+		write(0, timestamp);
+	}
+
+
+	inline void calls_collector_thread::on_allocation(size_t size) throw()
+	{
+		_allocations++;
+		_allocated_bytes += size;
+	}
+
+
+#ifdef MP_COMPACT_TRACE
+	template <typename ReaderT>
+	inline void calls_collector_thread::read_collected(const ReaderT &reader)
+	{	read_collected(reader, [] (unsigned int, count_t) {	});	}
+
+	template <typename ReaderT, typename DropReaderT>
+	inline void calls_collector_thread::read_collected(const ReaderT &reader, const DropReaderT &drop_reader)
+	{
+		const auto &callees = _encoder.callees();
+
+		buffers_queue<trace_record>::read_collected([&] (unsigned int id, const compact_call_record *calls, size_t count) {
+			reader(id, calls, count, callees);
+		}, drop_reader);
 	}
+#endif
 }
@@ -22,38 +22,58 @@
 
 #include "active_server_app.h"
 
+#include <common/protocol.h>
+#include <vector>
+
 namespace micro_profiler
 {
 	class analyzer;
 	struct calls_collector_i;
+	class coverage_tracker;
 	class module_tracker;
 	struct overhead;
+	class overhead_governor;
 	struct patch_manager;
 	class thread_monitor;
 
 	class collector_app : active_server_app::events
 	{
 	public:
+		// Traces are partitioned by thread among 'analysis_workers' analyzers: the first partition is analyzed on the
+		// server thread and each of the rest - on a thread of its own. Statistics are merged upon an update request.
+		// A non-zero 'overhead_budget' (in percent) makes the patches of the functions too cheap to be traced reverted
+		// upon the updates, whenever the tracing overhead exceeds it (see overhead_governor). With 'coverage' given, the
+		// functions hit are collected from it and their patches are reverted upon the updates. Histograms of the call
+		// times are collected only if 'call_times' is set.
 		collector_app(calls_collector_i &collector, const overhead &overhead_, thread_monitor &threads,
-			module_tracker &module_tracker_, patch_manager &patch_manager_);
+			module_tracker &module_tracker_, patch_manager &patch_manager_, unsigned int analysis_workers = 1,
+			unsigned int overhead_budget = 0, coverage_tracker *coverage = nullptr, bool call_times = false);
 		~collector_app();
 
 		void connect(const active_server_app::client_factory_t &factory, bool injected);
 
 		tasker::queue &get_queue();
 
+	private:
+		class analysis_worker;
+
 	private:
 		virtual void initialize_session(ipc::server_session &session) override;
 		virtual bool finalize_session(ipc::server_session &session) override;
 
 		void collect_and_reschedule();
+		void merge_workers();
+		void revert_covered(covered_functions &covered);
 
 	private:
 		calls_collector_i &_collector;
 		const std::unique_ptr<analyzer> _analyzer;
+		std::vector< std::unique_ptr<analysis_worker> > _workers;
 		thread_monitor &_thread_monitor;
 		module_tracker &_module_tracker;
 		patch_manager &_patch_manager;
+		std::unique_ptr<overhead_governor> _governor;
+		coverage_tracker *_coverage;
 		bool _injected;
 		active_server_app _server;
 	};
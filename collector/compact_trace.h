@@ -0,0 +1,379 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include "types.h"
+
+#include <common/compiler.h>
+#include <common/noncopyable.h>
+#include <iterator>
+#include <memory>
+
+namespace micro_profiler
+{
+	// A per-thread table of callee addresses, referred to by compact records. It is only appended to by the owning
+	// (profilee) thread, while the analyzer reads the entries referred to by the records it has received.
+	class callee_table : noncopyable
+	{
+	public:
+		enum {	capacity = 2048,	};
+
+	public:
+		callee_table();
+
+		// Returns a one-based index of the callee, or zero if the table is full and the callee is not there.
+		unsigned int index_of(const void *callee) throw();
+		const void *operator [](unsigned int index) const throw();
+
+	private:
+		enum {	hash_size = 2 * capacity, hash_mask = hash_size - 1,	};
+
+	private:
+		unsigned int insert(unsigned int slot, const void *callee) throw();
+		static unsigned int hash(const void *callee) throw();
+
+	private:
+		const std::unique_ptr<const void *[]> _callees;
+		const std::unique_ptr<unsigned short[]> _hash;
+		unsigned int _size;
+	};
+
+	// Encodes calls into compact records: timestamps as deltas from the previous record of the thread and callees
+	// as indices in its callee_table. Whenever a delta or an index does not fit, a two-records sequence is written.
+	// A two-records sequence never spans two buffers and the timestamps are rebased once the queue has discarded the
+	// records collected, so that the records delivered after a loss are decoded correctly.
+	class compact_encoder
+	{
+	public:
+		compact_encoder();
+
+		template <typename QueueT>
+		void encode(QueueT &queue, const void *callee, timestamp_t timestamp) throw();
+
+		// Writes a folded calls record - it is decoded as a call_record with folded_calls_tag for a callee.
+		template <typename QueueT>
+		void encode_folded(QueueT &queue, count_t calls) throw();
+
+		// Writes a hardware counter reading - it is decoded as a call_record with hw_counter_tag for a callee.
+		template <typename QueueT>
+		void encode_counter(QueueT &queue, unsigned long long value) throw();
+
+		// Writes the allocations made - they are decoded as call_record-s with allocations_tag and allocated_bytes_tag.
+		template <typename QueueT>
+		void encode_allocations(QueueT &queue, count_t allocations, count_t bytes) throw();
+
+		// Writes a lock waited for - it is decoded as a call_record with lock_wait_tag for a callee.
+		template <typename QueueT>
+		void encode_lock_wait(QueueT &queue, const void *lock) throw();
+
+		const callee_table &callees() const throw();
+
+		// Restarts the timestamp deltas for a new thread. The callee table is kept, since the records refer to it.
+		void reset() throw();
+
+	private:
+		template <typename QueueT>
+		static void write(QueueT &queue, unsigned int delta, unsigned int callee) throw();
+
+		template <typename QueueT>
+		static void write_wide(QueueT &queue, unsigned int delta, unsigned int tag, unsigned long long value) throw();
+
+	private:
+		timestamp_t _last;
+		callee_table _callees;
+	};
+
+	// Decoding state of a thread trace - it persists between the buffers read. It must be reset on a loss of records.
+	struct compact_decoder
+	{
+		compact_decoder();
+
+		void reset() throw();
+
+		timestamp_t last;
+		unsigned int pending_tag, pending_delta;
+	};
+
+	// Presents a range of compact records as a sequence of call_record-s.
+	class compact_trace_iterator : public std::iterator<std::input_iterator_tag, call_record>
+	{
+	public:
+		compact_trace_iterator(const compact_call_record *begin, const compact_call_record *end,
+			compact_decoder &decoder, const callee_table &callees);
+		explicit compact_trace_iterator(const compact_call_record *end);
+
+		const call_record &operator *() const throw();
+		const call_record *operator ->() const throw();
+		compact_trace_iterator &operator ++();
+
+		bool operator ==(const compact_trace_iterator &rhs) const throw();
+		bool operator !=(const compact_trace_iterator &rhs) const throw();
+
+	private:
+		void fetch();
+
+	private:
+		const compact_call_record *_current, *_next, *_end;
+		compact_decoder *_decoder;
+		const callee_table *_callees;
+		call_record _record;
+	};
+
+
+
+	inline callee_table::callee_table()
+		: _callees(new const void *[capacity]), _hash(new unsigned short[hash_size]()), _size(0)
+	{	}
+
+	FORCE_INLINE unsigned int callee_table::index_of(const void *callee) throw()
+	{
+		for (auto slot = hash(callee); ; slot = (slot + 1) & hash_mask)
+		{
+			if (const unsigned int index = _hash[slot])
+			{
+				if (_callees[index - 1] == callee)
+					return index;
+			}
+			else
+			{
+				return insert(slot, callee);
+			}
+		}
+	}
+
+	inline const void *callee_table::operator [](unsigned int index) const throw()
+	{	return _callees[index - 1];	}
+
+	FORCE_NOINLINE inline unsigned int callee_table::insert(unsigned int slot, const void *callee) throw()
+	{
+		if (_size == capacity)
+			return 0;
+		_callees[_size] = callee;
+		_hash[slot] = static_cast<unsigned short>(++_size);
+		return _size;
+	}
+
+	inline unsigned int callee_table::hash(const void *callee) throw()
+	{
+		const auto value = reinterpret_cast<size_t>(callee);
+
+		return static_cast<unsigned int>((value >> 4) ^ (value >> 16)) & hash_mask;
+	}
+
+
+	inline compact_encoder::compact_encoder()
+		: _last(0)
+	{	}
+
+	template <typename QueueT>
+	FORCE_INLINE void compact_encoder::encode(QueueT &queue, const void *callee, timestamp_t timestamp) throw()
+	{
+		const unsigned int index = callee ? _callees.index_of(callee) : compact_call_record::exit_tag;
+		const auto escaped = callee && !index;
+
+		if (escaped)
+			queue.reserve(4); // The rebase and the escape sequences must not be separated by a loss.
+		if (queue.discarded())
+			_last = 0; // The decoder is reset on a loss as well.
+
+		auto delta = static_cast<unsigned long long>(timestamp - _last);
+
+		_last = timestamp;
+		if (delta > compact_call_record::max_delta)
+		{
+			write_wide(queue, 0u, compact_call_record::rebase_tag, static_cast<unsigned long long>(timestamp));
+			delta = 0;
+		}
+		if (!escaped)
+		{
+			write(queue, static_cast<unsigned int>(delta), index);
+		}
+		else
+		{
+			write_wide(queue, static_cast<unsigned int>(delta), compact_call_record::escape_tag,
+				reinterpret_cast<size_t>(callee));
+		}
+	}
+
+	template <typename QueueT>
+	inline void compact_encoder::encode_folded(QueueT &queue, count_t calls) throw()
+	{	write_wide(queue, 0u, compact_call_record::folded_tag, static_cast<unsigned long long>(calls));	}
+
+	template <typename QueueT>
+	inline void compact_encoder::encode_counter(QueueT &queue, unsigned long long value) throw()
+	{	write_wide(queue, 0u, compact_call_record::counter_tag, value);	}
+
+	template <typename QueueT>
+	inline void compact_encoder::encode_allocations(QueueT &queue, count_t allocations, count_t bytes) throw()
+	{
+		write_wide(queue, 0u, compact_call_record::allocations_tag, static_cast<unsigned long long>(allocations));
+		write_wide(queue, 0u, compact_call_record::allocated_bytes_tag, static_cast<unsigned long long>(bytes));
+	}
+
+	template <typename QueueT>
+	inline void compact_encoder::encode_lock_wait(QueueT &queue, const void *lock) throw()
+	{	write_wide(queue, 0u, compact_call_record::lock_wait_tag, reinterpret_cast<size_t>(lock));	}
+
+	inline const callee_table &compact_encoder::callees() const throw()
+	{	return _callees;	}
+
+	inline void compact_encoder::reset() throw()
+	{	_last = 0;	}
+
+	template <typename QueueT>
+	FORCE_INLINE void compact_encoder::write(QueueT &queue, unsigned int delta, unsigned int callee) throw()
+	{
+		auto &r = queue.current();
+
+		r.delta = delta, r.callee = callee;
+		queue.push();
+	}
+
+	template <typename QueueT>
+	inline void compact_encoder::write_wide(QueueT &queue, unsigned int delta, unsigned int tag,
+		unsigned long long value) throw()
+	{
+		queue.reserve(2);
+		write(queue, delta, tag);
+		write(queue, static_cast<unsigned int>(value), static_cast<unsigned int>(value >> 32));
+	}
+
+
+	inline compact_decoder::compact_decoder()
+		: last(0), pending_tag(compact_call_record::exit_tag), pending_delta(0)
+	{	}
+
+	inline void compact_decoder::reset() throw()
+	{
+		last = 0;
+		pending_tag = compact_call_record::exit_tag;
+	}
+
+
+	inline compact_trace_iterator::compact_trace_iterator(const compact_call_record *begin,
+			const compact_call_record *end, compact_decoder &decoder, const callee_table &callees)
+		: _next(begin), _end(end), _decoder(&decoder), _callees(&callees)
+	{	fetch();	}
+
+	inline compact_trace_iterator::compact_trace_iterator(const compact_call_record *end)
+		: _current(end), _next(end), _end(end), _decoder(nullptr), _callees(nullptr)
+	{	}
+
+	inline const call_record &compact_trace_iterator::operator *() const throw()
+	{	return _record;	}
+
+	inline const call_record *compact_trace_iterator::operator ->() const throw()
+	{	return &_record;	}
+
+	inline compact_trace_iterator &compact_trace_iterator::operator ++()
+	{	return fetch(), *this;	}
+
+	inline bool compact_trace_iterator::operator ==(const compact_trace_iterator &rhs) const throw()
+	{	return _current == rhs._current;	}
+
+	inline bool compact_trace_iterator::operator !=(const compact_trace_iterator &rhs) const throw()
+	{	return _current != rhs._current;	}
+
+	inline void compact_trace_iterator::fetch()
+	{
+		auto &d = *_decoder;
+
+		for (_current = _next; _next != _end; )
+		{
+			const auto &r = *_next++;
+
+			switch (d.pending_tag)
+			{
+			case compact_call_record::rebase_tag:
+				d.last = static_cast<timestamp_t>(r.wide());
+				d.pending_tag = compact_call_record::exit_tag;
+				continue;
+
+			case compact_call_record::escape_tag:
+				d.last += d.pending_delta;
+				d.pending_tag = compact_call_record::exit_tag;
+				_record.timestamp = d.last;
+				_record.callee = reinterpret_cast<const void *>(static_cast<size_t>(r.wide()));
+				return;
+
+			case compact_call_record::folded_tag:
+				d.pending_tag = compact_call_record::exit_tag;
+				_record.timestamp = static_cast<timestamp_t>(r.wide());
+				_record.callee = folded_calls_tag;
+				return;
+
+			case compact_call_record::counter_tag:
+				d.pending_tag = compact_call_record::exit_tag;
+				_record.timestamp = static_cast<timestamp_t>(r.wide());
+				_record.callee = hw_counter_tag;
+				return;
+
+			case compact_call_record::allocations_tag:
+				d.pending_tag = compact_call_record::exit_tag;
+				_record.timestamp = static_cast<timestamp_t>(r.wide());
+				_record.callee = allocations_tag;
+				return;
+
+			case compact_call_record::allocated_bytes_tag:
+				d.pending_tag = compact_call_record::exit_tag;
+				_record.timestamp = static_cast<timestamp_t>(r.wide());
+				_record.callee = allocated_bytes_tag;
+				return;
+
+			case compact_call_record::lock_wait_tag:
+				d.pending_tag = compact_call_record::exit_tag;
+				_record.timestamp = static_cast<timestamp_t>(r.wide());
+				_record.callee = lock_wait_tag;
+				return;
+			}
+			switch (r.callee)
+			{
+			case compact_call_record::rebase_tag:
+			case compact_call_record::folded_tag:
+			case compact_call_record::counter_tag:
+			case compact_call_record::allocations_tag:
+			case compact_call_record::allocated_bytes_tag:
+			case compact_call_record::lock_wait_tag:
+				d.pending_tag = r.callee;
+				continue;
+
+			case compact_call_record::escape_tag:
+				d.pending_tag = r.callee, d.pending_delta = r.delta;
+				continue;
+
+			case compact_call_record::exit_tag:
+				d.last += r.delta;
+				_record.timestamp = d.last;
+				_record.callee = nullptr;
+				return;
+
+			default:
+				if (r.callee > callee_table::capacity)
+					continue; // Not an index - the record is corrupt.
+				d.last += r.delta;
+				_record.timestamp = d.last;
+				_record.callee = (*_callees)[r.callee];
+				return;
+			}
+		}
+		_current = _end;
+	}
+}
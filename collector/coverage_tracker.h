@@ -0,0 +1,82 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <common/noncopyable.h>
+#include <common/protocol.h>
+#include <map>
+#include <memory>
+#include <mt/mutex.h>
+#include <patcher/interface.h>
+
+namespace micro_profiler
+{
+	// Keeps the hits bitmaps for the coverage patches: a bit per function of each module, assigned the first time a
+	// patch is made for it. The bitmaps are never moved or freed until the tracker is destroyed, thus the tracker must
+	// outlive the patches and, since the function's module is found among the mappings notified, subscribe before the
+	// patch manager does.
+	class coverage_tracker : public mapping_access::events, noncopyable
+	{
+	public:
+		explicit coverage_tracker(mapping_access &mappings);
+
+		// Returns the byte and the bit mask in it for the function at the target address. Throws if the address is
+		// outside of the modules mapped.
+		std::pair<byte *, byte> get_hit(void *target);
+
+		// Appends the functions hit since the previous call to 'covered', clearing their bits - so that a function is
+		// reported again, if its patch is reapplied and hit again.
+		void collect(covered_functions &covered);
+
+	private:
+		enum {	block_size = 4096,	};
+
+		struct hits_block
+		{
+			std::atomic<byte> bits[block_size];
+		};
+
+		struct image
+		{
+			id_t module_id, mapping_id;
+		};
+
+		struct module_hits
+		{
+			std::map<unsigned int /*rva*/, unsigned int /*index*/> indices;
+			std::vector<unsigned int /*rva*/> functions;
+			std::vector< std::unique_ptr<hits_block> > blocks;
+
+			std::atomic<byte> &hits(unsigned int index);
+		};
+
+	private:
+		virtual void mapped(id_t module_id, id_t mapping_id, const module::mapping &mapping) override;
+		virtual void unmapped(id_t mapping_id) override;
+
+	private:
+		mt::mutex _mtx;
+		std::map<const byte *, image> _images;
+		std::map<id_t, module_hits> _modules;
+		std::shared_ptr<void> _mapping_subscription;
+	};
+}
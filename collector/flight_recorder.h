@@ -0,0 +1,136 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include "calls_collector.h"
+
+#include <atomic>
+#include <common/noncopyable.h>
+#include <common/unordered_map.h>
+#include <functional>
+#include <memory>
+#include <mt/mutex.h>
+#include <string>
+#include <vector>
+
+namespace micro_profiler
+{
+	class write_file_stream;
+
+	// A flight recorder ring file is a header followed by fixed-size slots, each holding a chunk of a single thread's
+	// trace. The slots are written in order, overwriting the oldest ones once the ring is full.
+	struct flight_ring_header
+	{
+		enum {	magic_value = 0x5246504D /* 'MPFR' */, version_value = 1,	};
+
+		unsigned int magic, version;
+		unsigned int slot_size, slots;
+		unsigned int pid, reserved;
+		timestamp_t ticks_per_second;
+		std::atomic<unsigned long long> written; // Total number of slots written so far.
+	};
+
+	struct flight_slot_header
+	{
+		unsigned long long sequence; // Number of slots written before this one plus one, zero while being written.
+		unsigned long long dropped; // Records lost right before the ones contained in this slot.
+		timestamp_t last; // Timestamp of the last record contained.
+		unsigned int thread_id, count;
+	};
+
+	// A call_record of a fixed layout - exit records have zero callee and folded calls records have ~0 for a callee.
+	struct flight_record
+	{
+		timestamp_t timestamp;
+		unsigned long long callee;
+	};
+
+	typedef std::function<std::string (unsigned long long address)> address_resolver_t;
+
+	// Retains the traces read through it in a memory-mapped ring file, while passing them further to the acceptor
+	// unchanged. As the file is shared, the trace of the last moments survives a crash of the profilee. The dumps
+	// requested are made on a subsequent read of the first partition. The hardware counter readings, the allocation counts
+	// and the lock wait tags are not retained.
+	class flight_recorder : public calls_collector_i, noncopyable
+	{
+	public:
+		enum {	default_slot_size = 4096,	};
+
+	public:
+		flight_recorder(calls_collector_i &underlying, const std::string &path, size_t capacity,
+			timestamp_t ticks_per_second_, unsigned int slot_size = default_slot_size);
+		~flight_recorder();
+
+		// Exports the last 'window' seconds (everything, if zero) recorded so far to the Chrome trace-event file.
+		void dump(const std::string &json_path, double window, const address_resolver_t &resolver = nullptr);
+
+		// Sets up the dump made by dump() and upon request_dump() or the signal specified in dump_on_signal().
+		void dump_on_request(const std::string &json_path, double window, const address_resolver_t &resolver = nullptr);
+		void dump();
+		void request_dump() throw(); // Async-signal-safe.
+		void dump_on_signal(int signo); // Not supported on Windows.
+
+		virtual void read_collected(acceptor &a) override;
+		virtual void read_collected(acceptor &a, unsigned int partition, unsigned int partitions) override;
+		virtual void flush() override;
+
+	private:
+		class tee;
+
+		struct thread_state
+		{
+			thread_state();
+
+			compact_decoder decoder;
+			std::vector<call_record> decoded;
+			count_t dropped;
+		};
+
+	private:
+		void record(unsigned int thread_id, const call_record *calls, size_t count);
+		void record(unsigned int thread_id, const compact_call_record *calls, size_t count,
+			const callee_table &callees);
+		void record_dropped(unsigned int thread_id, count_t count);
+		void check_dump_requested();
+		void write(unsigned int thread_id, thread_state &t, const call_record *calls, size_t count);
+		static void on_signal(int signo);
+
+	private:
+		calls_collector_i &_underlying;
+		const std::string _path;
+		std::shared_ptr<void> _mapping;
+		flight_ring_header *_header;
+		byte *_slots;
+		size_t _slot_capacity; // Records.
+		containers::unordered_map<unsigned int, thread_state> _threads;
+		std::atomic<bool> _dump_requested;
+		std::string _dump_path;
+		double _dump_window;
+		address_resolver_t _dump_resolver;
+		mt::mutex _mtx;
+	};
+
+	// Streams the calls recorded in the ring file into a Chrome trace-event (Perfetto compatible) JSON, reading a
+	// single slot at a time. Only the calls made within the last 'window' seconds are exported (all of them, if zero).
+	// The callees are named with the resolver given, or with their addresses.
+	void export_chrome_trace(write_file_stream &output, const std::string &ring_path, double window = 0,
+		const address_resolver_t &resolver = nullptr);
+}
@@ -0,0 +1,51 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include <common/noncopyable.h>
+#include <common/types.h>
+#include <memory>
+
+namespace micro_profiler
+{
+	// Hardware performance counters of the calling thread (see hw_counter), read in user mode. An instance must only
+	// be read by the thread that has opened it.
+	class hw_counters : noncopyable
+	{
+	public:
+		// Returns nullptr if the counters cannot be read in user mode: perf events are not supported or not permitted,
+		// rdpmc is disabled or the platform has no support for it.
+		static std::unique_ptr<hw_counters> open();
+
+		~hw_counters();
+
+		// The counters the CPU does not provide always read zero. Returns false if the counters have been off the PMU
+		// for a while (e.g. taken by a pinned system-wide event), so that the values read fall short of the actual ones.
+		bool read(unsigned long long (&values)[max_hw_counters]) const throw();
+
+	private:
+		hw_counters();
+
+	private:
+		int _fds[max_hw_counters];
+		void *_pages[max_hw_counters];
+	};
+}
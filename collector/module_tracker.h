@@ -75,6 +75,8 @@ namespace micro_profiler
 		virtual std::shared_ptr<module::mapping> lock_mapping(id_t mapping_id) override;
 		virtual std::shared_ptr<void> notify(mapping_access::events &events_) override;
 
+		static std::uint32_t calculate_hash(const std::string &path_);
+
 	private:
 		struct unmapped_entry
 		{
@@ -83,8 +85,6 @@ namespace micro_profiler
 		};
 
 	private:
-		static std::uint32_t calculate_hash(const std::string &path_);
-
 		// module::events methods
 		virtual void mapped(const module::mapping &mapping_) override;
 		virtual void unmapped(void *base) override;
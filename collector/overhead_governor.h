@@ -0,0 +1,84 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include <common/hash.h>
+#include <common/noncopyable.h>
+#include <common/protocol.h>
+#include <map>
+#include <mt/mutex.h>
+#include <patcher/interface.h>
+
+namespace micro_profiler
+{
+	class analyzer;
+
+	// Reverts the patches of the functions too cheap to be traced - the ones spending less time per call on their own
+	// than the tracing overhead adds to each call. Once the overhead estimated for the calls accounted exceeds the
+	// budget (a percentage of the time elapsed), such functions are reverted, the most costly first, until the rest
+	// fits the budget. The functions of the modules notified are reverted only, thus the governor must subscribe to the
+	// same mappings the patch manager does.
+	class overhead_governor : public mapping_access::events, noncopyable
+	{
+	public:
+		overhead_governor(patch_manager &patch_manager_, mapping_access &mappings, const overhead &overhead_,
+			unsigned int budget_percent, timestamp_t period);
+
+		// Accumulates the calls analyzed since the previous statistics update.
+		void account(const analyzer &analyzer_);
+
+		// Decides on the calls accounted since the previous decision, once the period has passed since it, and appends
+		// the patches reverted to 'throttled'.
+		void govern(throttled_patches &throttled, timestamp_t now);
+
+	private:
+		struct image
+		{
+			id_t module_id, mapping_id;
+		};
+
+		struct function_calls
+		{
+			count_t times_called;
+			timestamp_t exclusive_time;
+		};
+
+		typedef std::map< id_t /*module_id*/, std::vector<unsigned int> > revert_requests;
+
+	private:
+		virtual void mapped(id_t module_id, id_t mapping_id, const module::mapping &mapping) override;
+		virtual void unmapped(id_t mapping_id) override;
+
+		void select(revert_requests &requests, timestamp_t elapsed);
+
+	private:
+		patch_manager &_patch_manager;
+		const timestamp_t _overhead;
+		const unsigned int _budget_percent;
+		const timestamp_t _period;
+		timestamp_t _period_start;
+		containers::unordered_map<const void *, function_calls, knuth_hash> _functions;
+		patch_manager::patch_change_results _results;
+		mt::mutex _mtx;
+		std::map<const byte *, image> _images;
+		std::shared_ptr<void> _mapping_subscription;
+	};
+}
@@ -0,0 +1,102 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+#pragma once
+
+#include "calls_collector.h"
+#include "types.h"
+
+#include <atomic>
+#include <common/noncopyable.h>
+#include <common/unordered_map.h>
+#include <memory>
+#include <signal.h>
+#include <time.h>
+#include <vector>
+
+namespace micro_profiler
+{
+	struct module;
+	class thread_monitor;
+
+	// Statistical profiler: the process CPU-time clock interrupts the running threads with SIGPROF at the frequency
+	// specified, and their stacks are captured by walking the frame pointers. The samples are presented to the
+	// analyzer as synthetic call traces: a sample closes the frames no longer seen on the thread's stack and opens the
+	// new ones, while each sample advances the thread's time by one sampling period. Thus the inclusive/exclusive
+	// times estimate the CPU time spent and the call counts reflect the number of stack changes observed.
+	// Samples are only read for the first partition; the instrumented collector (if any) is drained and its records
+	// are discarded, since the two traces of a thread cannot be mixed.
+	class sampler : public calls_collector_i, noncopyable
+	{
+	public:
+		enum {	max_depth = 64, capacity = 4096, /* samples, must be a power of two */	};
+
+	public:
+		sampler(thread_monitor &thread_monitor_, module &module_helper, unsigned int frequency,
+			calls_collector_i *instrumented = nullptr);
+		~sampler();
+
+		count_t dropped() const throw();
+
+		virtual void read_collected(acceptor &a) override;
+		virtual void read_collected(acceptor &a, unsigned int partition, unsigned int partitions) override;
+		virtual void flush() override;
+
+	private:
+		struct sample
+		{
+			std::atomic<unsigned int> sequence;
+			unsigned int native_id;
+			unsigned int depth;
+			const void *frames[max_depth]; // The innermost frame goes first.
+		};
+
+		struct thread_trace
+		{
+			unsigned int thread_id;
+			timestamp_t time;
+			std::vector<const void *> stack; // The outermost frame goes first.
+			std::vector<call_record> pending;
+		};
+
+		typedef std::vector< std::pair<unsigned int /*rva*/, unsigned int /*size*/> > functions_t;
+
+	private:
+		static void on_signal(int signo, siginfo_t *info, void *context);
+		void capture(const void *context) throw();
+		void read_samples(acceptor &a);
+		void translate(const sample &s);
+		const void *resolve(const void *address);
+
+	private:
+		thread_monitor &_thread_monitor;
+		module &_module_helper;
+		calls_collector_i *const _instrumented;
+		const timestamp_t _period;
+		std::unique_ptr<sample[]> _samples;
+		std::atomic<unsigned int> _head;
+		std::atomic<count_t> _dropped;
+		unsigned int _tail;
+		timer_t _timer;
+		containers::unordered_map<unsigned int /*native_id*/, thread_trace> _threads;
+		containers::unordered_map<const void * /*address*/, const void * /*function*/> _functions;
+		containers::unordered_map<const void * /*base*/, std::shared_ptr<functions_t> > _modules;
+		std::vector<const void *> _frames;
+	};
+}
@@ -27,6 +27,8 @@
 namespace strmd
 {
 	template <typename KeyT> struct version< micro_profiler::call_graph_node<KeyT> > {	enum {	value = 5	};	};
+	template <typename KeyT> struct version< micro_profiler::call_graph_entry<KeyT> > {	enum {	value = 5	};	};
+	template <typename KeyT> struct type_traits< micro_profiler::call_graph_level<KeyT> > { typedef container_type_tag category; };
 	template <> struct type_traits<micro_profiler::thread_analyzer> { typedef container_type_tag category; };
 	template <> struct type_traits<micro_profiler::analyzer> { typedef container_type_tag category; };
 }
@@ -39,4 +41,16 @@ namespace micro_profiler
 		archive(static_cast<function_statistics &>(data));
 		archive(data.callees);
 	}
+
+	// Serialized exactly as a call_graph_node.
+	template <typename ArchiveT, typename KeyT>
+	inline void serialize(ArchiveT &archive, call_graph_entry<KeyT> &data, unsigned int /*ver*/)
+	{
+		auto statistics = data.statistics();
+		auto callees = data.callees();
+
+		data.get_call_times(statistics.call_times);
+		archive(statistics);
+		archive(callees);
+	}
 }
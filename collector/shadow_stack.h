@@ -20,142 +20,228 @@
 
 #pragma once
 
+#include "call_graph.h"
 #include "types.h"
 #include "primitives.h"
 
 #include <common/pod_vector.h>
+#include <common/unordered_map.h>
 
 namespace micro_profiler
 {
+	// Hardware counter readings (see hw_counter_tag) are accumulated into the inclusive totals of a call, only if both
+	// its entry and its exit are preceded by the complete set of them. Heap allocations (see allocations_tag) are
+	// attributed to the call on top of the stack, the ones made outside of any call are ignored. A contended lock wait
+	// (see lock_wait_tag) is a call of the blocking function, which adds its time to the time blocked of itself and of
+	// all the calls it is nested in, as well as to the lock's contention statistics.
 	template <typename KeyT>
 	class shadow_stack
 	{
 	public:
-		typedef call_graph_types<KeyT> statistic_types;
-		typedef typename statistic_types::nodes_map map_type;
+		typedef call_graph<KeyT> graph_type;
+		typedef containers::unordered_map<const void * /*lock*/, lock_statistics> locks_type;
 
 	public:
 		shadow_stack(const overhead & overhead_);
 
 		template <typename IteratorT>
-		void update(IteratorT trace_begin, IteratorT trace_end, map_type &statistics);
+		void update(IteratorT trace_begin, IteratorT trace_end, graph_type &statistics);
+
+		// Discards all the calls currently in progress - exits not matched by the entries seen after the reset are
+		// ignored.
+		void reset() throw();
+
+		// Contention statistics of the locks, accumulated since they were last cleared.
+		locks_type &locks() throw();
 
 	private:
 		struct stack_record;
 		typedef pod_vector<stack_record> stack;
 
-	private:
-		void restore_state(function_statistics &root, map_type &callees);
-
 	private:
 		const timestamp_t _inner_overhead, _total_overhead;
 		stack _stack;
+		locks_type _locks;
+		count_t _calls; // Number of calls the next entry stands for (see folded_calls_tag).
+		const void *_lock; // A lock the next entry waits for (see lock_wait_tag).
+		count_t _counters[max_hw_counters]; // Readings preceding the next entry or exit.
+		unsigned int _counters_n;
 	};
 
 	template <typename KeyT>
 	struct shadow_stack<KeyT>::stack_record
 	{
-		static void exit(stack &stack_, const call_record &entry, timestamp_t inner_overhead, timestamp_t total_overhead);
-		static void reset_stack(stack &stack_, function_statistics &root, map_type &callees);
-		static void enter(stack &stack_, const call_record &entry);
-		static typename statistic_types::node &get(map_type &callees, typename statistic_types::key callee);
-		static typename statistic_types::node &get_slow(map_type &callees, typename statistic_types::key callee);
+		static void exit(stack &stack_, graph_type &statistics, locks_type &locks, const call_record &entry,
+			timestamp_t inner_overhead, timestamp_t total_overhead, const count_t *counters);
+		static void reset_stack(stack &stack_, graph_type &statistics);
+		static void enter(stack &stack_, graph_type &statistics, const call_record &entry, count_t calls,
+			const count_t *counters, const void *lock);
 
-		typename statistic_types::key callee;
+		KeyT callee;
 		timestamp_t enter_at;
 		timestamp_t children_time_observed, children_overhead;
-		function_statistics *function;
-		map_type *callees;
+		timestamp_t children_time_blocked;
+		count_t calls;
+		unsigned int node;
+		bool counted;
+		count_t counters[max_hw_counters];
+		const void *lock;
 	};
 
 
 
 	template <typename KeyT>
 	inline shadow_stack<KeyT>::shadow_stack(const overhead &overhead_)
-		: _inner_overhead(overhead_.inner), _total_overhead(overhead_.inner + overhead_.outer)
+		: _inner_overhead(overhead_.inner), _total_overhead(overhead_.inner + overhead_.outer), _calls(1),
+			_lock(nullptr), _counters_n(0)
 	{	_stack.push_back();	}
 
 	template <typename KeyT>
 	template <typename IteratorT>
-	inline void shadow_stack<KeyT>::update(IteratorT i, IteratorT end, map_type &statistics)
+	inline void shadow_stack<KeyT>::update(IteratorT i, IteratorT end, graph_type &statistics)
 	{
-		function_statistics root;
-
-		stack_record::reset_stack(_stack, root, statistics);
+		stack_record::reset_stack(_stack, statistics);
 		for (; i != end; ++i)
 		{
-			if (i->callee)
-				stack_record::enter(_stack, *i);
+			const auto counters = max_hw_counters == _counters_n ? _counters : nullptr;
+
+			if (!i->callee)
+			{
+				if (_stack.size() > 1)
+					stack_record::exit(_stack, statistics, _locks, *i, _inner_overhead, _total_overhead, counters);
+				_counters_n = 0;
+			}
+			else if (i->callee == folded_calls_tag)
+			{
+				_calls = static_cast<count_t>(i->timestamp);
+			}
+			else if (i->callee == hw_counter_tag)
+			{
+				if (_counters_n != max_hw_counters)
+					_counters[_counters_n++] = static_cast<count_t>(i->timestamp);
+			}
+			else if (i->callee == allocations_tag)
+			{
+				if (_stack.size() > 1)
+					statistics[_stack.back().node].allocations += static_cast<count_t>(i->timestamp);
+			}
+			else if (i->callee == allocated_bytes_tag)
+			{
+				if (_stack.size() > 1)
+					statistics[_stack.back().node].allocated_bytes += static_cast<count_t>(i->timestamp);
+			}
+			else if (i->callee == lock_wait_tag)
+			{
+				_lock = reinterpret_cast<const void *>(static_cast<size_t>(i->timestamp));
+			}
 			else
-				stack_record::exit(_stack, *i, _inner_overhead, _total_overhead);
+			{
+				stack_record::enter(_stack, statistics, *i, _calls, counters, _lock);
+				_calls = 1;
+				_lock = nullptr;
+				_counters_n = 0;
+			}
 		}
 	}
 
+	template <typename KeyT>
+	inline void shadow_stack<KeyT>::reset() throw()
+	{
+		_stack.clear();
+		_stack.push_back();
+		_calls = 1;
+		_lock = nullptr;
+		_counters_n = 0;
+	}
+
+	template <typename KeyT>
+	inline typename shadow_stack<KeyT>::locks_type &shadow_stack<KeyT>::locks() throw()
+	{	return _locks;	}
+
 
 	template <typename KeyT>
-	inline void shadow_stack<KeyT>::stack_record::exit(stack &stack_, const call_record &entry,
-		timestamp_t inner_overhead, timestamp_t total_overhead)
+	inline void shadow_stack<KeyT>::stack_record::exit(stack &stack_, graph_type &statistics, locks_type &locks,
+		const call_record &entry, timestamp_t inner_overhead, timestamp_t total_overhead, const count_t *counters)
 	{
 		const auto &current = stack_.back();
-		const timestamp_t inclusive_time_observed = (entry.timestamp - current.enter_at) - inner_overhead;
+
+		if (current.lock)
+			inner_overhead = total_overhead = 0; // A lock wait is written by the hook, rather than by a thunk.
+
+		const auto calls = static_cast<timestamp_t>(current.calls);
+		const timestamp_t inclusive_time_observed = (entry.timestamp - current.enter_at) - calls * inner_overhead;
 		const timestamp_t children_overhead = current.children_overhead;
 		const timestamp_t inclusive_time = inclusive_time_observed - children_overhead;
 		const timestamp_t exclusive_time = inclusive_time_observed - current.children_time_observed;
 
-		add(*current.function, inclusive_time, exclusive_time);
+		if (1 == calls)
+		{
+			add(statistics[current.node], inclusive_time, exclusive_time);
+			statistics.add_call_times(current.node, inclusive_time, 1);
+		}
+		else
+		{
+			add(statistics[current.node], inclusive_time, exclusive_time, current.calls);
+			statistics.add_call_times(current.node, inclusive_time / calls, current.calls);
+		}
+		if (counters && current.counted)
+		{
+			count_t deltas[max_hw_counters];
+
+			for (auto i = 0; i != max_hw_counters; ++i)
+				deltas[i] = counters[i] - current.counters[i];
+			add(statistics[current.node].hw_counters, deltas);
+		}
+
+		const auto time_blocked = current.lock ? inclusive_time : current.children_time_blocked;
+
+		if (current.lock)
+		{
+			const lock_statistics contention = {	current.calls, inclusive_time	};
+
+			add(locks[current.lock], contention);
+		}
+		statistics[current.node].time_blocked += time_blocked;
+		statistics.mark_updated(current.node);
 		stack_.pop_back();
 
 		auto &parent = stack_.back();
 
-		parent.children_time_observed += inclusive_time_observed + total_overhead;
-		parent.children_overhead += total_overhead + children_overhead;
+		parent.children_time_observed += inclusive_time_observed + calls * total_overhead;
+		parent.children_overhead += calls * total_overhead + children_overhead;
+		parent.children_time_blocked += time_blocked;
 	}
 
 
 	template <typename KeyT>
-	inline void shadow_stack<KeyT>::stack_record::reset_stack(stack &stack_, function_statistics &root,
-		map_type &callees)
+	inline void shadow_stack<KeyT>::stack_record::reset_stack(stack &stack_, graph_type &statistics)
 	{
 		auto i = stack_.begin();
 
-		i->function = &root;
-		i->callees = &callees;
+		i->node = graph_type::root;
 		for (auto previous = i++; i != stack_.end(); previous = i++)
-		{
-			auto &p = (*previous->callees)[i->callee];
-
-			i->function = &p;
-			i->callees = &p.callees;
-		}
+			i->node = statistics.callee(previous->node, i->callee);
 	}
 
 	template <typename KeyT>
-	inline void shadow_stack<KeyT>::stack_record::enter(stack &stack_, const call_record &entry)
+	inline void shadow_stack<KeyT>::stack_record::enter(stack &stack_, graph_type &statistics,
+		const call_record &entry, count_t calls, const count_t *counters, const void *lock)
 	{
 		stack_.push_back();
 
 		auto i = stack_.end();
 		auto &current = *--i;
 		auto &previous = *--i;
-		auto &in_previous = get(*previous.callees, entry.callee);// (*previous.callees)[entry.callee];
 
 		current.callee = entry.callee;
 		current.enter_at = entry.timestamp;
 		current.children_time_observed = current.children_overhead = 0;
-		current.function = &in_previous;
-		current.callees = &in_previous.callees;
-	}
-
-	template <typename KeyT>
-	inline typename call_graph_types<KeyT>::node &shadow_stack<KeyT>::stack_record::get(map_type &callees, typename statistic_types::key callee)
-	{
-		auto i = callees.find(callee);
-		return callees.end() != i ? i->second : get_slow(callees, callee);
-	}
-
-	template <typename KeyT>
-	FORCE_NOINLINE inline typename call_graph_types<KeyT>::node &shadow_stack<KeyT>::stack_record::get_slow(map_type &callees, typename statistic_types::key callee)
-	{
-		return callees.insert(std::make_pair(callee, typename call_graph_types<KeyT>::node())).first->second;
+		current.children_time_blocked = 0;
+		current.calls = calls;
+		current.node = statistics.callee(previous.node, entry.callee);
+		current.counted = !!counters;
+		if (counters)
+			std::copy(counters, counters + max_hw_counters, current.counters);
+		current.lock = lock;
 	}
 }
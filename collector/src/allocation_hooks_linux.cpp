@@ -0,0 +1,186 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+#include <collector/allocation_tracker.h>
+
+#include <algorithm>
+#include <atomic>
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PUBLIC __attribute__ ((visibility ("default")))
+
+using namespace std;
+using micro_profiler::allocation_tracker;
+
+// The allocation functions are interposed and forwarded to the ones next in the lookup order (glibc's or those of an
+// allocator replacing it), and so is free(), so that the memory is always released by the allocator it came from.
+// The C++ runtime implements operator new and delete on top of malloc() and free(), thus these are covered as well.
+// dlsym() may allocate itself, so the allocations made while the functions are being resolved are served from a
+// static buffer, which is never released.
+
+extern "C"
+{
+	void *__libc_malloc(size_t size);
+	void *__libc_calloc(size_t n, size_t size);
+	void *__libc_realloc(void *ptr, size_t size);
+	void *__libc_memalign(size_t alignment, size_t size);
+	void __libc_free(void *ptr);
+}
+
+namespace
+{
+	struct allocator_functions
+	{
+		void *(*malloc_)(size_t size);
+		void *(*calloc_)(size_t n, size_t size);
+		void *(*realloc_)(void *ptr, size_t size);
+		void *(*memalign_)(size_t alignment, size_t size);
+		void (*free_)(void *ptr);
+	};
+
+	enum {	unresolved, resolving, resolved	};
+	enum {	bootstrap_size = 16384, bootstrap_alignment = 16,	};
+
+	allocator_functions g_next;
+	atomic<int> g_state(unresolved);
+	alignas(bootstrap_alignment) unsigned char g_bootstrap[bootstrap_size];
+	atomic<size_t> g_bootstrap_used(0);
+
+	void *bootstrap_allocate(size_t size, size_t alignment = bootstrap_alignment)
+	{
+		for (auto used = g_bootstrap_used.load(memory_order_relaxed); ; )
+		{
+			const auto start = (used + alignment - 1) & ~(alignment - 1);
+
+			if (start < used || size > bootstrap_size || start > bootstrap_size - size)
+				return nullptr;
+			if (g_bootstrap_used.compare_exchange_weak(used, start + size, memory_order_relaxed))
+				return g_bootstrap + start;
+		}
+	}
+
+	bool is_bootstrap(const void *ptr)
+	{	return ptr >= g_bootstrap && ptr < g_bootstrap + bootstrap_size;	}
+
+	template <typename T>
+	void resolve(T *&function, const char *name, T *fallback)
+	{
+		function = reinterpret_cast<T *>(dlsym(RTLD_NEXT, name));
+		if (!function)
+			function = fallback;
+	}
+
+	// Returns nullptr while the functions are being resolved (by this or another thread).
+	const allocator_functions *get_next()
+	{
+		auto state = g_state.load(memory_order_acquire);
+
+		if (resolved == state)
+			return &g_next;
+		if (unresolved != state || !g_state.compare_exchange_strong(state, resolving, memory_order_acquire))
+			return nullptr;
+		resolve(g_next.malloc_, "malloc", &__libc_malloc);
+		resolve(g_next.calloc_, "calloc", &__libc_calloc);
+		resolve(g_next.realloc_, "realloc", &__libc_realloc);
+		resolve(g_next.memalign_, "memalign", &__libc_memalign);
+		resolve(g_next.free_, "free", &__libc_free);
+		g_state.store(resolved, memory_order_release);
+		return &g_next;
+	}
+
+	__attribute__ ((constructor)) void resolve_on_load()
+	{	get_next();	}
+
+	void *allocate_aligned(size_t alignment, size_t size)
+	{
+		if (const auto next = get_next())
+			return next->memalign_(alignment, size);
+		return bootstrap_allocate(size, (max)(alignment, static_cast<size_t>(bootstrap_alignment)));
+	}
+}
+
+extern "C" PUBLIC void *malloc(size_t size) throw()
+{
+	allocation_tracker::on_allocation(size);
+	if (const auto next = get_next())
+		return next->malloc_(size);
+	return bootstrap_allocate(size);
+}
+
+extern "C" PUBLIC void *calloc(size_t n, size_t size) throw()
+{
+	if (size && n > static_cast<size_t>(-1) / size)
+		return errno = ENOMEM, nullptr;
+	allocation_tracker::on_allocation(n * size);
+	if (const auto next = get_next())
+		return next->calloc_(n, size);
+	return bootstrap_allocate(n * size); // The buffer is zeroed and never reused.
+}
+
+extern "C" PUBLIC void *realloc(void *ptr, size_t size) throw()
+{
+	if (size)
+		allocation_tracker::on_allocation(size);
+	if (is_bootstrap(ptr))
+	{
+		// The size of a bootstrap block is not kept, but the buffer can be read past it.
+		const auto available = static_cast<size_t>(g_bootstrap + bootstrap_size - static_cast<unsigned char *>(ptr));
+		const auto moved = size ? malloc(size) : nullptr;
+
+		if (moved)
+			memcpy(moved, ptr, (min)(size, available));
+		return moved;
+	}
+	if (const auto next = get_next())
+		return next->realloc_(ptr, size);
+	return nullptr;
+}
+
+extern "C" PUBLIC void free(void *ptr) throw()
+{
+	if (is_bootstrap(ptr))
+		return;
+	if (const auto next = get_next())
+		next->free_(ptr);
+}
+
+extern "C" PUBLIC void *memalign(size_t alignment, size_t size) throw()
+{
+	allocation_tracker::on_allocation(size);
+	return allocate_aligned(alignment, size);
+}
+
+extern "C" PUBLIC void *aligned_alloc(size_t alignment, size_t size) throw()
+{
+	allocation_tracker::on_allocation(size);
+	return allocate_aligned(alignment, size);
+}
+
+extern "C" PUBLIC int posix_memalign(void **ptr, size_t alignment, size_t size) throw()
+{
+	if (!alignment || alignment % sizeof(void *) || alignment & (alignment - 1))
+		return EINVAL;
+	allocation_tracker::on_allocation(size);
+	if (const auto p = allocate_aligned(alignment, size))
+		return *ptr = p, 0;
+	return ENOMEM;
+}
@@ -22,12 +22,20 @@
 
 namespace micro_profiler
 {
-	thread_analyzer::thread_analyzer(const overhead &overhead_)
-		: _stack(overhead_)
+	thread_analyzer::thread_analyzer(const overhead &overhead_, bool call_times)
+		: _statistics(call_times), _stack(overhead_), _dropped(0), _reported_nodes(1), _exited(false)
 	{	}
 
 	void thread_analyzer::clear() throw()
-	{	_statistics.clear();	}
+	{
+		_statistics.clear();
+		_stack.locks().clear();
+		_dropped = 0;
+		_reported_nodes = 1;
+	}
+
+	bool thread_analyzer::exited() const throw()
+	{	return _exited;	}
 
 	size_t thread_analyzer::size() const throw()
 	{	return _statistics.size();	}
@@ -38,18 +46,97 @@ namespace micro_profiler
 	thread_analyzer::const_iterator thread_analyzer::end() const throw()
 	{	return _statistics.end();	}
 
+	count_t thread_analyzer::dropped() const throw()
+	{	return _dropped;	}
+
+	const thread_analyzer::statistics_t &thread_analyzer::graph() const throw()
+	{	return _statistics;	}
+
+	void thread_analyzer::merge(thread_analyzer &from)
+	{
+		if (_statistics.empty())
+			_statistics.swap(from._statistics);
+		else
+			_statistics.merge(from._statistics);
+		for (auto i = from._stack.locks().begin(); i != from._stack.locks().end(); ++i)
+			add(_stack.locks()[i->first], i->second);
+		_dropped += from._dropped;
+		_exited |= from._exited;
+		from.clear();
+	}
+
+	void thread_analyzer::get_changes(call_graph_delta &delta)
+	{
+		const auto count = _statistics.node_count();
+		const auto &updated = _statistics.updated();
+
+		delta.created.clear();
+		delta.updated.clear();
+		for (auto i = updated.begin(); i != updated.end(); ++i)
+		{
+			const auto &s = _statistics[*i];
+
+			if (*i >= _reported_nodes || !s.times_called)
+				continue;
+			delta.updated.push_back(std::make_pair(*i, s));
+			_statistics.get_call_times(delta.updated.back().second.call_times, *i);
+		}
+		for (auto i = _reported_nodes; i < count; ++i)
+		{
+			const call_graph_delta::created_node n = {
+				_statistics.parent(i), reinterpret_cast<size_t>(_statistics.key(i)), _statistics[i]
+			};
+
+			delta.created.push_back(n);
+			_statistics.get_call_times(delta.created.back().statistics.call_times, i);
+			_statistics.reset(i);
+		}
+		_statistics.reset_updated();
+		_reported_nodes = count;
+		_dropped = 0;
+	}
+
+	void thread_analyzer::rewind_changes() throw()
+	{	_reported_nodes = 1;	}
+
+	void thread_analyzer::get_lock_contention(lock_contention &contention)
+	{
+		auto &locks = _stack.locks();
+
+		for (auto i = locks.begin(); i != locks.end(); ++i)
+			contention.push_back(std::make_pair(reinterpret_cast<size_t>(i->first), i->second));
+		locks.clear();
+	}
+
 	void thread_analyzer::accept_calls(const call_record *calls, size_t count)
 	{	_stack.update(calls, calls + count, _statistics);	}
 
+	void thread_analyzer::accept_calls(const compact_call_record *calls, size_t count, const callee_table &callees)
+	{
+		_stack.update(compact_trace_iterator(calls, calls + count, _decoder, callees),
+			compact_trace_iterator(calls + count), _statistics);
+	}
+
+	void thread_analyzer::accept_dropped(count_t count)
+	{
+		_dropped += count;
+		_stack.reset();
+		_decoder.reset();
+	}
+
+	void thread_analyzer::accept_exited() throw()
+	{	_exited = true;	}
 
-	analyzer::analyzer(const overhead &overhead_)
-		: _overhead(overhead_)
+
+	analyzer::analyzer(const overhead &overhead_, bool call_times)
+		: _overhead(overhead_), _call_times(call_times)
 	{	}
 
 	void analyzer::clear() throw()
 	{
 		for (auto i = _thread_analyzers.begin(); i != _thread_analyzers.end(); ++i)
 			i->second.clear();
+		drop_exited();
 	}
 
 	size_t analyzer::size() const throw()
@@ -65,18 +152,91 @@ namespace micro_profiler
 	{
 		for (auto i = _thread_analyzers.begin(); i != _thread_analyzers.end(); ++i)
 		{
-			if (i->second.size())
+			if (i->second.size() || i->second.dropped())
 				return true;
 		}
 		return false;
 	}
 
+	void analyzer::merge(analyzer &from)
+	{
+		for (auto i = from._thread_analyzers.begin(); i != from._thread_analyzers.end(); ++i)
+			get_thread_analyzer(i->first).merge(i->second);
+		from.drop_exited();
+	}
+
+	void analyzer::get_exited(exited_threads &exited) const
+	{
+		exited.clear();
+		for (auto i = _thread_analyzers.begin(); i != _thread_analyzers.end(); ++i)
+		{
+			if (i->second.exited())
+				exited.push_back(i->first);
+		}
+	}
+
+	void analyzer::get_changes(statistics_delta &delta)
+	{
+		delta.resize(_thread_analyzers.size()); // The buffers of the delta are reused for as long as threads stay.
+
+		auto j = delta.begin();
+
+		for (auto i = _thread_analyzers.begin(); i != _thread_analyzers.end(); ++i, ++j)
+		{
+			j->first = i->first;
+			i->second.get_changes(j->second);
+		}
+		drop_exited();
+	}
+
+	void analyzer::rewind_changes() throw()
+	{
+		for (auto i = _thread_analyzers.begin(); i != _thread_analyzers.end(); ++i)
+			i->second.rewind_changes();
+	}
+
+	void analyzer::get_lock_contention(lock_contention &contention)
+	{
+		contention.clear();
+		for (auto i = _thread_analyzers.begin(); i != _thread_analyzers.end(); ++i)
+			i->second.get_lock_contention(contention);
+	}
+
 	void analyzer::accept_calls(unsigned int threadid, const call_record *calls, size_t count)
+	{	get_thread_analyzer(threadid).accept_calls(calls, count);	}
+
+	void analyzer::accept_calls(unsigned int threadid, const compact_call_record *calls, size_t count,
+		const callee_table &callees)
+	{	get_thread_analyzer(threadid).accept_calls(calls, count, callees);	}
+
+	void analyzer::accept_dropped(unsigned int threadid, count_t count)
+	{	get_thread_analyzer(threadid).accept_dropped(count);	}
+
+	void analyzer::accept_exited(unsigned int threadid)
+	{
+		const auto i = _thread_analyzers.find(threadid);
+
+		if (i != _thread_analyzers.end())
+			i->second.accept_exited();
+	}
+
+	void analyzer::drop_exited() throw()
+	{
+		for (auto i = _thread_analyzers.begin(); i != _thread_analyzers.end(); )
+		{
+			if (i->second.exited())
+				i = _thread_analyzers.erase(i);
+			else
+				++i;
+		}
+	}
+
+	thread_analyzer &analyzer::get_thread_analyzer(unsigned int threadid)
 	{
 		auto i = _thread_analyzers.find(threadid);
 
 		if (i == _thread_analyzers.end())
-			i = _thread_analyzers.insert(std::make_pair(threadid, thread_analyzer(_overhead))).first;
-		i->second.accept_calls(calls, count);
+			i = _thread_analyzers.insert(std::make_pair(threadid, thread_analyzer(_overhead, _call_times))).first;
+		return i->second;
 	}
 }
@@ -32,6 +32,15 @@ namespace micro_profiler
 		{
 			virtual void accept_calls(unsigned int, const call_record *, size_t)
 			{ }
+
+			virtual void accept_calls(unsigned int, const compact_call_record *, size_t, const callee_table &)
+			{ }
+
+			virtual void accept_dropped(unsigned int, count_t)
+			{ }
+
+			virtual void accept_exited(unsigned int)
+			{ }
 		};
 
 		template <typename FunctionT>
@@ -42,10 +51,13 @@ namespace micro_profiler
 		}
 	}
 
-	overhead calibrate_overhead(calls_collector &collector, size_t trace_limit)
+	overhead calibrate_overhead(calls_collector &collector, size_t trace_limit, const buffering_policy &working_policy)
 	{
 		const auto iterations = trace_limit / 10;
 
+		// The calls are traced the way they will be (reading the hardware counters, if requested), but never folded.
+		collector.set_buffering_policy(buffering_policy(trace_limit, 1, 1, buffering_policy::block_on_overflow,
+			buffering_policy::buffer_size, buffering_policy::buffer_size, 0, working_policy.hw_counters()));
 		for (int warmup_rounds = 10; warmup_rounds--; )
 		{
 			null_reader nr;
@@ -75,14 +87,14 @@ namespace micro_profiler
 
 			if (1u == aa.size())
 			{
-				const statistic_types::node &f = aa.begin()->second;
+				const function_statistics &f = aa.begin()->second.statistics();
 				const timestamp_t inner = f.inclusive_time / f.times_called;
 				const timestamp_t total = ((end - start) - (end_ref - start_ref)) / f.times_called;
 
 				o = overhead(inner, total - inner);
 			}
 		}
-		collector.set_buffering_policy(buffering_policy(trace_limit, 0.1, 0.01));
+		collector.set_buffering_policy(working_policy);
 		return o;
 	}
 
@@ -0,0 +1,192 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <collector/calibration_cache.h>
+
+#include <collector/calls_collector.h>
+#include <collector/module_tracker.h>
+#include <collector/thread_monitor.h>
+#include <common/file_stream.h>
+#include <common/formatting.h>
+#include <common/time.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		const unsigned int c_ticks_tolerance = 3; // percent
+		const unsigned int c_tracking_tolerance = 25; // percent
+		const int c_tracking_rounds = 3;
+
+		struct null_reader : calls_collector_i::acceptor
+		{
+			virtual void accept_calls(unsigned int, const call_record *, size_t) override
+			{	}
+
+			virtual void accept_calls(unsigned int, const compact_call_record *, size_t, const callee_table &) override
+			{	}
+
+			virtual void accept_dropped(unsigned int, count_t) override
+			{	}
+
+			virtual void accept_exited(unsigned int) override
+			{	}
+		};
+
+		string cpu_signature()
+		{
+#ifdef __linux__
+			const char *c_fields[] = {	"vendor_id", "cpu family", "model", "model name", "stepping", "microcode",	};
+			char buffer[1000];
+			string signature;
+
+			if (const auto f = fopen("/proc/cpuinfo", "r"))
+			{
+				// Only the first processor is looked at - the rest are expected to match it.
+				while (fgets(buffer, sizeof(buffer), f) && *buffer != '\n')
+				{
+					const string line(buffer, strcspn(buffer, "\n"));
+					const auto colon = line.find(':');
+
+					if (colon == string::npos)
+						continue;
+
+					const auto name = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+
+					for (auto i = begin(c_fields); i != end(c_fields); ++i)
+					{
+						if (name == *i)
+							signature += line.substr(line.find_first_not_of(" \t", colon + 1)) + ";";
+					}
+				}
+				fclose(f);
+			}
+			return signature;
+#else
+			return string();
+#endif
+		}
+
+		bool is_within(timestamp_t value, timestamp_t reference, unsigned int tolerance)
+		{	return (value > reference ? value - reference : reference - value) * 100 <= reference * tolerance;	}
+	}
+
+	string calibration_key(const string &collector_path)
+	{
+		auto key = cpu_signature();
+
+		if (key.empty())
+			return key;
+		try
+		{
+			key += "build=";
+			itoa<16>(key, module_tracker::calculate_hash(collector_path), 8);
+			return key;
+		}
+		catch (const exception &)
+		{
+			return string();
+		}
+	}
+
+	bool load_calibration(calibration_info &info, const string &path, const string &key)
+	{
+		string content;
+
+		try
+		{
+			content = read_file(path);
+		}
+		catch (const exception &)
+		{
+			return false;
+		}
+
+		const auto eol = content.find('\n');
+		unsigned long long values[4];
+		char terminator = 0;
+		int length = 0;
+
+		// A file written partially by a concurrent process fails the format check.
+		if (eol == string::npos || content.compare(0, eol, key)
+			|| 5 != sscanf(content.c_str() + eol + 1, "%llu %llu %llu %llu%c%n", &values[0], &values[1], &values[2],
+				&values[3], &terminator, &length)
+			|| '\n' != terminator || eol + 1 + length != content.size() || !values[0])
+		{
+			return false;
+		}
+		info.ticks_per_second = values[0];
+		info.inner = values[1];
+		info.outer = values[2];
+		info.tracking = values[3];
+		return true;
+	}
+
+	void store_calibration(const string &path, const string &key, const calibration_info &info)
+	{
+		auto content = key;
+
+		content += '\n';
+		itoa<10>(content, info.ticks_per_second), content += ' ';
+		itoa<10>(content, info.inner), content += ' ';
+		itoa<10>(content, info.outer), content += ' ';
+		itoa<10>(content, info.tracking), content += '\n';
+		write_file_stream(path).write(content.data(), content.size());
+	}
+
+	bool is_calibration_valid(const calibration_info &cached, timestamp_t ticks_per_second_, timestamp_t tracking)
+	{
+		return is_within(ticks_per_second_, cached.ticks_per_second, c_ticks_tolerance)
+			&& is_within(tracking, cached.tracking, c_tracking_tolerance);
+	}
+
+	timestamp_t measure_tracking_overhead(allocator &allocator_, mt::thread_callbacks &thread_callbacks,
+		size_t iterations)
+	{
+		const auto monitor = make_shared<thread_monitor>(thread_callbacks);
+		calls_collector collector(allocator_, 4 * iterations, *monitor, thread_callbacks);
+		const auto callee = reinterpret_cast<const void *>(&measure_tracking_overhead);
+		timestamp_t best = 0;
+
+		for (auto rounds = c_tracking_rounds; iterations && rounds--; )
+		{
+			null_reader nr;
+			const auto start = read_tick_counter();
+
+			for (auto n = iterations; n--; )
+			{
+				collector.track(read_tick_counter(), callee);
+				collector.track(read_tick_counter(), nullptr);
+			}
+
+			const auto per_call = static_cast<timestamp_t>((read_tick_counter() - start) / iterations);
+
+			collector.flush();
+			collector.read_collected(nr);
+			if (!best || per_call < best)
+				best = per_call;
+		}
+		return best;
+	}
+}
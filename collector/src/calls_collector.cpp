@@ -29,34 +29,96 @@ using namespace std;
 
 namespace micro_profiler
 {
+#ifdef MP_FAST_CURSOR
+	__thread fast_cursor g_fast_cursor __attribute__((tls_model("initial-exec")));
+#endif
+
+	namespace
+	{
+		struct forwarding_reader
+		{
+			forwarding_reader(calls_collector_i::acceptor &a)
+				: _acceptor(a)
+			{	}
+
+			void operator ()(unsigned int thread_id, const call_record *calls, size_t count) const
+			{	_acceptor.accept_calls(thread_id, calls, count);	}
+
+			void operator ()(unsigned int thread_id, const compact_call_record *calls, size_t count,
+				const callee_table &callees) const
+			{	_acceptor.accept_calls(thread_id, calls, count, callees);	}
+
+		private:
+			calls_collector_i::acceptor &_acceptor;
+		};
+	}
+
 	calls_collector::calls_collector(allocator &allocator_, size_t trace_limit, thread_monitor &m,
 			mt::thread_callbacks &callbacks)
 		: base_t(allocator_, buffering_policy(trace_limit, 1, 1), callbacks, [&m] {	return m.register_self();	})
+#ifdef MP_FAST_CURSOR
+			, _fast_cursors(false)
+#endif
 	{	}
 
 	void calls_collector::read_collected(acceptor &a)
 	{
-		base_t::read_collected([&a] (unsigned int thread_id, const call_record *calls, size_t count)	{
-			a.accept_calls(thread_id, calls, count);
+		base_t::read_collected(forwarding_reader(a), [&a] (unsigned int thread_id, count_t count) {
+			a.accept_dropped(thread_id, count);
+		}, [&a] (unsigned int thread_id) {
+			a.accept_exited(thread_id);
 		});
 	}
 
+	void calls_collector::read_collected(acceptor &a, unsigned int partition, unsigned int partitions)
+	{
+		base_t::read_collected(forwarding_reader(a), [&a] (unsigned int thread_id, count_t count) {
+			a.accept_dropped(thread_id, count);
+		}, [&a] (unsigned int thread_id) {
+			a.accept_exited(thread_id);
+		}, partition, partitions);
+	}
+
 	void calls_collector::flush()
 	{	base_t::flush();	}
 
+	FORCE_INLINE calls_collector_thread &calls_collector::get_thread_trace()
+	{
+		if (const auto trace = find_queue())
+			return *trace;
+		return construct_thread_trace();
+	}
+
 	void CC_(fastcall) calls_collector::on_enter(calls_collector *instance, const void **stack_ptr,
 		timestamp_t timestamp, const void *callee)
-	{	instance->get_queue().on_enter(stack_ptr, timestamp, callee);	}
+	{	instance->get_thread_trace().on_enter(stack_ptr, timestamp, callee);	}
 
 	const void *CC_(fastcall) calls_collector::on_exit(calls_collector *instance, const void **stack_ptr,
 		timestamp_t timestamp)
-	{	return instance->get_queue().on_exit(stack_ptr, timestamp);	}
+	{	return instance->get_thread_trace().on_exit(stack_ptr, timestamp);	}
 
-#if !defined(_M_X64)
+#if !defined(_M_X64) || defined(MP_COMPACT_TRACE)
 	void calls_collector::track(timestamp_t timestamp, const void *callee)
-	{	get_queue().track(callee, timestamp);	}
+	{	get_thread_trace().track(callee, timestamp);	}
 #endif
 
-	calls_collector_thread &calls_collector::construct_thread_trace()
-	{	return construct_queue();	}
+#ifdef MP_FAST_CURSOR
+	void calls_collector::bind_fast_cursors()
+	{
+		_fast_cursors = true;
+		if (const auto trace = find_queue())
+			trace->bind_cursor(g_fast_cursor);
+	}
+#endif
+
+	FORCE_NOINLINE calls_collector_thread &calls_collector::construct_thread_trace()
+	{
+		auto &trace = construct_queue();
+
+#ifdef MP_FAST_CURSOR
+		if (_fast_cursors.load(memory_order_relaxed))
+			trace.bind_cursor(g_fast_cursor);
+#endif
+		return trace;
+	}
 }
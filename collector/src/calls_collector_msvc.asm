@@ -19,6 +19,7 @@
 ;	THE SOFTWARE.
 
 IFDEF _M_IX86
+ELSEIFDEF MP_COMPACT_TRACE
 ELSEIFDEF _M_X64
 	.code
 
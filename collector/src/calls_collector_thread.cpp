@@ -24,16 +24,21 @@ using namespace std;
 
 namespace micro_profiler
 {
-	calls_collector_thread::calls_collector_thread(allocator &allocator_, const buffering_policy &policy, unsigned int id)
-		: buffers_queue<call_record>(allocator_, policy, id)
+	namespace
 	{
-		return_entry re = { reinterpret_cast<const void **>(static_cast<size_t>(-1)), };
-
-		_return_stack.push_back(re);
+		// The calls folded have no counter readings, so nothing is folded while the counters are collected.
+		timestamp_t get_short_call_threshold(const buffering_policy &policy)
+		{	return policy.hw_counters() ? 0 : policy.short_call_threshold();	}
 	}
 
+	calls_collector_thread::calls_collector_thread(allocator &allocator_, const buffering_policy &policy, unsigned int id)
+		: buffers_queue<trace_record>(allocator_, policy, id), _short_call_threshold(get_short_call_threshold(policy)),
+			_deferred_callee(nullptr), _folded_calls(0), _hw_counters_enabled(policy.hw_counters())
+	{	reset(id);	}
+
 	void calls_collector_thread::on_enter(const void **stack_ptr, timestamp_t timestamp, const void *callee) throw()
 	{
+		pull_cursor();
 		if (_return_stack.back().stack_ptr != stack_ptr)
 		{
 			// Regular nesting...
@@ -47,25 +52,189 @@ namespace micro_profiler
 		else
 		{
 			// Tail-call optimization...
-			track(0, timestamp);
+			exit(timestamp);
 		}
-		track(callee, timestamp);
+		enter(callee, timestamp);
+		push_cursor();
 	}
 
 	const void *calls_collector_thread::on_exit(const void **stack_ptr, timestamp_t timestamp) throw()
 	{
 		const void *return_address;
 		
+		pull_cursor();
 		do
 		{
 			return_address = _return_stack.back().return_address;
 
 			_return_stack.pop_back();
-			track(0, timestamp);
+			exit(timestamp);
 		} while (_return_stack.back().stack_ptr <= stack_ptr);
+		push_cursor();
 		return return_address;
 	}
 
+	FORCE_NOINLINE void calls_collector_thread::on_lock_wait(const void *lock, const void *blocking_function,
+		timestamp_t started, timestamp_t finished) throw()
+	{
+		if (handing_off())
+			return; // The wait is of the queue itself - the analyzer is behind.
+		pull_cursor();
+		if (_deferred_callee)
+			write_deferred(); // The call deferred is the one waiting.
+		else if (_folded_calls)
+			write_folded(); // The calls folded are the preceding siblings of the wait.
+		if (_allocations)
+			write_allocations();
+#ifdef MP_COMPACT_TRACE
+		_encoder.encode_lock_wait(*this, lock);
+#else
+		auto &c = current();
+
+		c.timestamp = static_cast<timestamp_t>(reinterpret_cast<size_t>(lock)), c.callee = lock_wait_tag;
+		push();
+#endif
+		write(blocking_function, started);
+		write(0, finished);
+		push_cursor();
+	}
+
 	FORCE_NOINLINE void calls_collector_thread::flush()
-	{	buffers_queue<call_record>::flush();	}
+	{
+		pull_cursor();
+		if (_deferred_callee)
+			write_deferred();
+		else if (_folded_calls)
+			write_folded();
+		buffers_queue<trace_record>::flush();
+		push_cursor();
+#ifdef MP_FAST_CURSOR
+		if (_cursor)
+			_cursor->records_end = _cursor->records; // The calls past the thread's exit must take the slow path.
+#endif
+	}
+
+	void calls_collector_thread::set_buffering_policy(const buffering_policy &policy)
+	{
+		_short_call_threshold.store(get_short_call_threshold(policy), memory_order_relaxed);
+		_hw_counters_enabled.store(policy.hw_counters(), memory_order_relaxed);
+		buffers_queue<trace_record>::set_buffering_policy(policy);
+	}
+
+	void calls_collector_thread::reset(unsigned int id) throw()
+	{
+		return_entry re = { reinterpret_cast<const void **>(static_cast<size_t>(-1)), };
+
+		buffers_queue<trace_record>::reset(id);
+		_return_stack.clear();
+		_return_stack.push_back(re);
+		_deferred_callee = nullptr;
+		_folded_calls = 0;
+		_hw_counters.reset(); // The counters are of the thread that has opened them.
+		_hw_counters_unavailable = false;
+		_allocations = _allocated_bytes = 0;
+#ifdef MP_COMPACT_TRACE
+		_encoder.reset();
+#endif
+#ifdef MP_FAST_CURSOR
+		_cursor = nullptr;
+#endif
+	}
+
+#ifdef MP_FAST_CURSOR
+	void calls_collector_thread::bind_cursor(fast_cursor &cursor) throw()
+	{
+		_cursor = &cursor;
+		push_cursor();
+	}
+#endif
+
+	FORCE_NOINLINE void calls_collector_thread::fold(timestamp_t timestamp) throw()
+	{
+		if (_folded_calls && (_folded_callee != _deferred_callee || _folded_calls == max_folded_calls))
+			write_folded();
+		if (!_folded_calls)
+			_folded_callee = _deferred_callee, _folded_at = _deferred_at, _folded_time = 0;
+		_folded_time += timestamp - _deferred_at;
+		_folded_calls++;
+		_deferred_callee = nullptr;
+	}
+
+	FORCE_NOINLINE void calls_collector_thread::write_deferred() throw()
+	{
+		if (_folded_calls)
+			write_folded(); // The calls folded are the preceding siblings of the one deferred.
+		write(_deferred_callee, _deferred_at);
+		_deferred_callee = nullptr;
+	}
+
+	FORCE_NOINLINE void calls_collector_thread::write_folded() throw()
+	{
+#ifdef MP_COMPACT_TRACE
+		_encoder.encode_folded(*this, _folded_calls);
+#else
+		auto &c = current();
+
+		c.timestamp = static_cast<timestamp_t>(_folded_calls), c.callee = folded_calls_tag;
+		push();
+#endif
+		write(_folded_callee, _folded_at);
+		write(0, _folded_at + _folded_time);
+		_folded_calls = 0;
+	}
+
+	FORCE_NOINLINE void calls_collector_thread::write_hw_counters() throw()
+	{
+		unsigned long long values[max_hw_counters];
+
+		if (!_hw_counters)
+		{
+			if (_hw_counters_unavailable)
+				return;
+			try
+			{
+				// The counters are opened on the thread traced, since they only count its own execution.
+				_hw_counters = hw_counters::open();
+			}
+			catch (...)
+			{
+			}
+			if (!_hw_counters)
+			{
+				_hw_counters_unavailable = true;
+				return;
+			}
+		}
+		if (!_hw_counters->read(values))
+			return; // The call is left without the readings rather than with the ones falling short.
+		for (auto i = 0; i != max_hw_counters; ++i)
+		{
+#ifdef MP_COMPACT_TRACE
+			_encoder.encode_counter(*this, values[i]);
+#else
+			auto &c = current();
+
+			c.timestamp = static_cast<timestamp_t>(values[i]), c.callee = hw_counter_tag;
+			push();
+#endif
+		}
+	}
+
+	FORCE_NOINLINE void calls_collector_thread::write_allocations() throw()
+	{
+#ifdef MP_COMPACT_TRACE
+		_encoder.encode_allocations(*this, _allocations, _allocated_bytes);
+#else
+		auto &c1 = current();
+
+		c1.timestamp = static_cast<timestamp_t>(_allocations), c1.callee = allocations_tag;
+		push();
+
+		auto &c2 = current();
+
+		c2.timestamp = static_cast<timestamp_t>(_allocated_bytes), c2.callee = allocated_bytes_tag;
+		push();
+#endif
+		_allocations = _allocated_bytes = 0;
+	}
 }
@@ -21,15 +21,22 @@
 #include <collector/collector_app.h>
 
 #include <collector/analyzer.h>
+#include <collector/coverage_tracker.h>
 #include <collector/module_tracker.h>
+#include <collector/overhead_governor.h>
 #include <collector/serialization.h>
 #include <collector/thread_monitor.h>
 
+#include <algorithm>
 #include <common/constants.h>
+#include <common/image_info.h>
 #include <common/protocol.h>
 #include <common/time.h>
 #include <ipc/server_session.h>
 #include <logger/log.h>
+#include <mt/event.h>
+#include <mt/mutex.h>
+#include <mt/thread.h>
 #include <patcher/interface.h>
 
 #define PREAMBLE "Collector app: "
@@ -38,12 +45,105 @@ using namespace std;
 
 namespace micro_profiler
 {
-	collector_app::collector_app(calls_collector_i &collector, const overhead &overhead_, thread_monitor &threads,
-			module_tracker &module_tracker_, patch_manager &patch_manager_)
-		: _collector(collector), _analyzer(new analyzer(overhead_)), _thread_monitor(threads),
-			_module_tracker(module_tracker_), _patch_manager(patch_manager_), _server(*this)
+	namespace
+	{
+		const mt::milliseconds c_collection_period(10);
+		const size_t c_metadata_symbols_chunk = 4096u;
+
+		template <typename F>
+		void get_metadata(module_info_metadata &md, module_tracker::module_info &module_info,
+			module_tracker &module_tracker_, unsigned int module_id, const F &on_symbol)
+		{
+			const auto metadata = module_tracker_.get_metadata(module_id);
+
+			module_tracker_.get_module(module_info, module_id); // TODO: check the result.
+			md.path = module_info.path;
+			md.hash = module_info.hash;
+			md.source_files.clear();
+			metadata->enumerate_functions(on_symbol);
+			metadata->enumerate_files([&] (const pair<unsigned, string> &file) {
+				md.source_files.insert(file);
+			});
+		}
+	}
+
+	class collector_app::analysis_worker : noncopyable
+	{
+	public:
+		analysis_worker(calls_collector_i &collector, const overhead &overhead_, unsigned int partition,
+			unsigned int partitions, bool call_times);
+		~analysis_worker();
+
+		void start();
+		void collect();
+		void merge_to(analyzer &to);
+
+	private:
+		calls_collector_i &_collector;
+		const unsigned int _partition, _partitions;
+		analyzer _analyzer;
+		mt::mutex _mtx;
+		mt::event _exit;
+		unique_ptr<mt::thread> _thread;
+	};
+
+
+
+	collector_app::analysis_worker::analysis_worker(calls_collector_i &collector, const overhead &overhead_,
+			unsigned int partition, unsigned int partitions, bool call_times)
+		: _collector(collector), _partition(partition), _partitions(partitions), _analyzer(overhead_, call_times)
 	{	}
 
+	collector_app::analysis_worker::~analysis_worker()
+	{
+		if (!_thread)
+			return;
+		_exit.set();
+		_thread->join();
+	}
+
+	void collector_app::analysis_worker::start()
+	{
+		if (_thread)
+			return;
+		_thread.reset(new mt::thread([this] {
+			while (!_exit.wait(c_collection_period))
+				collect();
+		}));
+	}
+
+	void collector_app::analysis_worker::collect()
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		_collector.read_collected(_analyzer, _partition, _partitions);
+	}
+
+	void collector_app::analysis_worker::merge_to(analyzer &to)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		to.merge(_analyzer);
+	}
+
+
+	collector_app::collector_app(calls_collector_i &collector, const overhead &overhead_, thread_monitor &threads,
+			module_tracker &module_tracker_, patch_manager &patch_manager_, unsigned int analysis_workers,
+			unsigned int overhead_budget, coverage_tracker *coverage, bool call_times)
+		: _collector(collector), _analyzer(new analyzer(overhead_, call_times)), _thread_monitor(threads),
+			_module_tracker(module_tracker_), _patch_manager(patch_manager_), _coverage(coverage), _server(*this)
+	{
+		analysis_workers = (max)(analysis_workers, 1u);
+		for (auto partition = 1u; partition < analysis_workers; ++partition)
+			_workers.emplace_back(new analysis_worker(collector, overhead_, partition, analysis_workers, call_times));
+		if (overhead_budget)
+		{
+			_governor.reset(new overhead_governor(patch_manager_, module_tracker_, overhead_, overhead_budget,
+				ticks_per_second()));
+		}
+		LOG(PREAMBLE "constructed...") % A(analysis_workers) % A(overhead_budget) % A(call_times);
+	}
+
 	collector_app::~collector_app()
 	{	_collector.flush();	}
 
@@ -64,36 +164,92 @@ namespace micro_profiler
 		auto history_key = make_shared<module_tracker::mapping_history_key>();
 		auto mapped_ = make_shared<loaded_modules>();
 		auto unmapped_ = make_shared<unloaded_modules>();
+		auto dropped = make_shared<dropped_records>();
+		auto contention = make_shared<lock_contention>();
+		auto exited = make_shared<exited_threads>();
+		auto delta = make_shared<statistics_delta>();
 		auto metadata = make_shared<module_info_metadata>();
 		auto module_info = make_shared<module_tracker::module_info>();
 		auto threads_buffer = make_shared< vector< pair<thread_monitor::thread_id, thread_info> > >();
 		auto patch_results = make_shared<response_patched_data>();
+		auto throttled = make_shared<throttled_patches>();
+		auto covered = make_shared<covered_functions>();
+
+		// A new frontend knows none of the nodes reported to the previous one - the delta must start over.
+		_analyzer->rewind_changes();
+
+		session.add_handler(request_update, [this, history_key, mapped_, unmapped_, dropped, contention, throttled, covered,
+			exited, delta] (response &resp, update_request_flags flags) {
 
-		session.add_handler(request_update, [this, history_key, mapped_, unmapped_] (response &resp) {
 			_module_tracker.get_changes(*history_key, *mapped_, *unmapped_);
+			merge_workers();
+			throttled->clear();
+			if (_governor)
+			{
+				_governor->account(*_analyzer);
+				_governor->govern(*throttled, read_tick_counter());
+			}
+			covered->clear();
+			if (_coverage)
+				revert_covered(*covered);
+			dropped->clear();
+			for (auto i = _analyzer->begin(); i != _analyzer->end(); ++i)
+			{
+				if (const auto n = i->second.dropped())
+					dropped->push_back(make_pair(i->first, n));
+			}
 			resp(response_modules_loaded, *mapped_);
-			resp(response_statistics_update, *_analyzer);
+			resp(response_dropped_records, *dropped);
+			_analyzer->get_lock_contention(*contention);
+			resp(response_lock_contention, *contention);
+			resp(response_patches_throttled, *throttled);
+			resp(response_functions_covered, *covered);
+			_analyzer->get_exited(*exited);
+			resp(response_threads_exited, *exited);
+			if (flags & update_delta)
+			{
+				_analyzer->get_changes(*delta);
+				resp(response_statistics_delta, *delta);
+			}
+			else
+			{
+				resp(response_statistics_update, *_analyzer);
+				_analyzer->clear();
+			}
 			resp(response_modules_unloaded, *unmapped_);
-			_analyzer->clear();
 		});
 
 		session.add_handler(request_module_metadata,
 			[this, metadata, module_info] (response &resp, unsigned int module_id) {
 
+			// Legacy frontends expect all the symbols in a single message, with the names demangled.
+			symbol_demangler demangle;
 			auto &md = *metadata;
-			auto metadata_ = _module_tracker.get_metadata(module_id);
 
-			_module_tracker.get_module(*module_info, module_id); // TODO: check the result.
-			md.path = module_info->path;
-			md.hash = module_info->hash;
 			md.symbols.clear();
-			md.source_files.clear();
-			metadata_->enumerate_functions([&] (const symbol_info &symbol) {
+			get_metadata(md, *module_info, _module_tracker, module_id, [&] (const symbol_info &symbol) {
 				md.symbols.push_back(symbol);
+				demangle(md.symbols.back().name);
 			});
-			metadata_->enumerate_files([&] (const pair<unsigned, string> &file) {
-				md.source_files.insert(file);
+			resp(response_module_metadata, md);
+		});
+
+		session.add_handler(request_module_metadata_chunked,
+			[this, metadata, module_info] (response &resp, unsigned int module_id) {
+
+			auto &md = *metadata;
+			size_t n = 0;
+
+			// Symbols are sent in chunks of a bounded size, reusing the entries (and their names' storage) of the chunk.
+			get_metadata(md, *module_info, _module_tracker, module_id, [&] (const symbol_info &symbol) {
+				if (n == md.symbols.size())
+					md.symbols.push_back(symbol);
+				else
+					md.symbols[n] = symbol;
+				if (++n == c_metadata_symbols_chunk)
+					resp(response_module_metadata_symbols, md.symbols), n = 0;
 			});
+			md.symbols.resize(n);
 			resp(response_module_metadata, md);
 		});
 
@@ -121,24 +277,52 @@ namespace micro_profiler
 				_module_tracker.helper().executable(),
 				ticks_per_second(),
 				_injected,
+				capability_chunked_metadata,
 			};
 
 			ser(idata);
 		});
 
-		_server.schedule([this] {	collect_and_reschedule();	}, mt::milliseconds(10));
+		for (auto i = _workers.begin(); i != _workers.end(); ++i)
+			(*i)->start();
+		_server.schedule([this] {	collect_and_reschedule();	}, c_collection_period);
 	}
 
 	bool collector_app::finalize_session(ipc::server_session &session)
 	{
-		_collector.read_collected(*_analyzer);
+		_collector.read_collected(*_analyzer, 0, static_cast<unsigned int>(_workers.size() + 1));
+		for (auto i = _workers.begin(); i != _workers.end(); ++i)
+			(*i)->collect();
 		session.message(exiting, [] (ipc::serializer &) {	});
 		return true;
 	}
 
 	void collector_app::collect_and_reschedule()
 	{
-		_collector.read_collected(*_analyzer);
-		_server.schedule([this] {	collect_and_reschedule();	}, mt::milliseconds(10));
+		_collector.read_collected(*_analyzer, 0, static_cast<unsigned int>(_workers.size() + 1));
+		_server.schedule([this] {	collect_and_reschedule();	}, c_collection_period);
+	}
+
+	void collector_app::merge_workers()
+	{
+		for (auto i = _workers.begin(); i != _workers.end(); ++i)
+			(*i)->merge_to(*_analyzer);
+	}
+
+	void collector_app::revert_covered(covered_functions &covered)
+	{
+		patch_manager::patch_change_results results;
+		vector<unsigned int> rvas;
+
+		_coverage->collect(covered);
+		for (auto i = covered.begin(); i != covered.end(); )
+		{
+			const auto module_id = i->first;
+
+			// The functions covered come grouped by module.
+			for (rvas.clear(); i != covered.end() && i->first == module_id; ++i)
+				rvas.push_back(i->second);
+			_patch_manager.revert(results, module_id, make_range(rvas));
+		}
 	}
 }
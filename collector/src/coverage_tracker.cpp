@@ -0,0 +1,110 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <collector/coverage_tracker.h>
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	coverage_tracker::coverage_tracker(mapping_access &mappings)
+		: _mapping_subscription(mappings.notify(*this))
+	{	}
+
+	pair<byte *, byte> coverage_tracker::get_hit(void *target)
+	{
+		const auto target_ = static_cast<const byte *>(target);
+		mt::lock_guard<mt::mutex> l(_mtx);
+		auto i = _images.upper_bound(target_);
+
+		if (i == _images.begin())
+			throw invalid_argument("the function is outside of the modules mapped");
+		--i;
+
+		const auto rva = static_cast<unsigned int>(target_ - i->first);
+		auto &m = _modules[i->second.module_id];
+		auto j = m.indices.find(rva);
+
+		if (j == m.indices.end())
+		{
+			const auto index = static_cast<unsigned int>(m.functions.size());
+
+			if (index / 8 / block_size == m.blocks.size())
+				m.blocks.emplace_back(new hits_block());
+			j = m.indices.insert(make_pair(rva, index)).first;
+			m.functions.push_back(rva);
+		}
+
+		return make_pair(reinterpret_cast<byte *>(&m.hits(j->second)), static_cast<byte>(1 << j->second % 8));
+	}
+
+	void coverage_tracker::collect(covered_functions &covered)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		for (auto i = _modules.begin(); i != _modules.end(); ++i)
+		{
+			const auto &functions = i->second.functions;
+
+			for (auto index = 0u, count = static_cast<unsigned int>(functions.size()); index < count; index += 8)
+			{
+				auto &hits = i->second.hits(index);
+
+				if (!hits.load(memory_order_relaxed))
+					continue;
+				for (auto bits = hits.exchange(0); bits; bits &= bits - 1)
+				{
+					auto bit = 0u;
+
+					while (!(bits & (1 << bit)))
+						bit++;
+					covered.push_back(make_pair(i->first, functions[index + bit]));
+				}
+			}
+		}
+	}
+
+	atomic<byte> &coverage_tracker::module_hits::hits(unsigned int index)
+	{	return blocks[index / 8 / block_size]->bits[index / 8 % block_size];	}
+
+	void coverage_tracker::mapped(id_t module_id, id_t mapping_id, const module::mapping &mapping)
+	{
+		image i = {	module_id, mapping_id	};
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		_images[mapping.base] = i;
+	}
+
+	void coverage_tracker::unmapped(id_t mapping_id)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		for (auto i = _images.begin(); i != _images.end(); ++i)
+		{
+			if (i->second.mapping_id == mapping_id)
+			{
+				_images.erase(i);
+				break;
+			}
+		}
+	}
+}
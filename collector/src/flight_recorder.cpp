@@ -0,0 +1,524 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <collector/flight_recorder.h>
+
+#include <common/file_stream.h>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+	#include <common/string.h>
+	#include <process.h>
+	#include <windows.h>
+
+	#define getpid _getpid
+
+#else
+	#include <fcntl.h>
+	#include <signal.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+
+#endif
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		const unsigned long long c_folded_callee = ~0ull;
+		const size_t c_output_threshold = 0x10000;
+
+		atomic<flight_recorder *> g_signalled_recorder(nullptr);
+
+		// The hardware counter readings, the allocation counts and the lock addresses carry no timestamps and are not a
+		// part of the timeline recorded. A lock wait remains there as a call to the blocking function.
+		bool is_recorded(const void *callee)
+		{
+			return hw_counter_tag != callee && allocations_tag != callee && allocated_bytes_tag != callee
+				&& lock_wait_tag != callee;
+		}
+
+		shared_ptr<void> map_ring(const string &path, size_t size)
+		{
+#ifdef _WIN32
+			const auto file = ::CreateFileW(unicode(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+				CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+			if (INVALID_HANDLE_VALUE == file)
+				throw runtime_error("cannot create a flight recorder file");
+
+			const auto mapping = ::CreateFileMappingW(file, nullptr, PAGE_READWRITE,
+				static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32), static_cast<DWORD>(size), nullptr);
+			const auto view = mapping ? ::MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+
+			if (mapping)
+				::CloseHandle(mapping);
+			::CloseHandle(file);
+			if (!view)
+				throw runtime_error("cannot map a flight recorder file");
+			return shared_ptr<void>(view, [] (void *address) {	::UnmapViewOfFile(address);	});
+#else
+			const auto file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+			if (file < 0)
+				throw runtime_error("cannot create a flight recorder file");
+
+			const auto view = ::ftruncate(file, static_cast<off_t>(size)) ? MAP_FAILED
+				: ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+
+			::close(file);
+			if (MAP_FAILED == view)
+				throw runtime_error("cannot map a flight recorder file");
+			return shared_ptr<void>(view, [size] (void *address) {	::munmap(address, size);	});
+#endif
+		}
+
+		class chrome_trace_writer : noncopyable
+		{
+		public:
+			chrome_trace_writer(write_file_stream &output, unsigned int pid, timestamp_t ticks_per_second_,
+					const address_resolver_t &resolver)
+				: _output(output), _pid(pid), _ticks_per_second(ticks_per_second_), _resolver(resolver), _first(true)
+			{	_buffer = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";	}
+
+			~chrome_trace_writer()
+			{
+				_buffer += "\n]}\n";
+				flush();
+			}
+
+			void begin(unsigned int thread_id, timestamp_t timestamp, unsigned long long callee, count_t calls)
+			{
+				start_event(thread_id, timestamp, 'B');
+				_buffer += ",\"name\":\"";
+				_buffer += name(callee);
+				_buffer += '\"';
+				if (calls != 1)
+				{
+					char text[50];
+
+					sprintf(text, ",\"args\":{\"calls\":%llu}", static_cast<unsigned long long>(calls));
+					_buffer += text;
+				}
+				end_event();
+			}
+
+			void end(unsigned int thread_id, timestamp_t timestamp)
+			{
+				start_event(thread_id, timestamp, 'E');
+				end_event();
+			}
+
+		private:
+			void start_event(unsigned int thread_id, timestamp_t timestamp, char phase)
+			{
+				// Microseconds are printed as integers not to depend on the decimal separator of the current locale.
+				const auto ns = static_cast<long long>(1e9 * timestamp / _ticks_per_second);
+				char text[100];
+
+				sprintf(text, "%s\n{\"ph\":\"%c\",\"pid\":%u,\"tid\":%u,\"ts\":%lld.%03lld", _first ? "" : ",", phase, _pid,
+					thread_id, ns / 1000, ns % 1000);
+				_buffer += text;
+				_first = false;
+			}
+
+			void end_event()
+			{
+				_buffer += '}';
+				if (_buffer.size() > c_output_threshold)
+					flush();
+			}
+
+			void flush()
+			{
+				_output.write(_buffer.data(), _buffer.size());
+				_buffer.clear();
+			}
+
+			const string &name(unsigned long long callee)
+			{
+				auto &cached = _names[callee];
+
+				if (cached.empty())
+				{
+					const auto resolved = _resolver ? _resolver(callee) : string();
+
+					if (resolved.empty())
+					{
+						char text[30];
+
+						sprintf(text, "0x%llx", callee);
+						cached = text;
+					}
+					for (auto i = resolved.begin(); i != resolved.end(); ++i)
+					{
+						if ('\"' == *i || '\\' == *i)
+							cached += '\\';
+						if (static_cast<unsigned char>(*i) >= 0x20)
+							cached += *i;
+					}
+				}
+				return cached;
+			}
+
+		private:
+			write_file_stream &_output;
+			const unsigned int _pid;
+			const timestamp_t _ticks_per_second;
+			const address_resolver_t &_resolver;
+			containers::unordered_map<unsigned long long, string> _names;
+			string _buffer;
+			bool _first;
+		};
+	}
+
+	class flight_recorder::tee : public calls_collector_i::acceptor, noncopyable
+	{
+	public:
+		tee(flight_recorder &recorder, calls_collector_i::acceptor &underlying)
+			: _recorder(recorder), _underlying(underlying)
+		{	}
+
+		virtual void accept_calls(unsigned int threadid, const call_record *calls, size_t count) override
+		{
+			_recorder.record(threadid, calls, count);
+			_underlying.accept_calls(threadid, calls, count);
+		}
+
+		virtual void accept_calls(unsigned int threadid, const compact_call_record *calls, size_t count,
+			const callee_table &callees) override
+		{
+			_recorder.record(threadid, calls, count, callees);
+			_underlying.accept_calls(threadid, calls, count, callees);
+		}
+
+		virtual void accept_dropped(unsigned int threadid, count_t count) override
+		{
+			_recorder.record_dropped(threadid, count);
+			_underlying.accept_dropped(threadid, count);
+		}
+
+		virtual void accept_exited(unsigned int threadid) override
+		{	_underlying.accept_exited(threadid);	}
+
+	private:
+		flight_recorder &_recorder;
+		calls_collector_i::acceptor &_underlying;
+	};
+
+
+	flight_recorder::thread_state::thread_state()
+		: dropped(0)
+	{	}
+
+
+	flight_recorder::flight_recorder(calls_collector_i &underlying, const string &path, size_t capacity,
+			timestamp_t ticks_per_second_, unsigned int slot_size)
+		: _underlying(underlying), _path(path), _dump_requested(false), _dump_window(0)
+	{
+		const auto slots = static_cast<unsigned int>(capacity / slot_size);
+
+		if (slot_size < sizeof(flight_slot_header) + sizeof(flight_record) || slot_size % sizeof(flight_record) || !slots)
+			throw invalid_argument("invalid flight recorder ring layout");
+		_mapping = map_ring(path, sizeof(flight_ring_header) + static_cast<size_t>(slots) * slot_size);
+		_header = new (_mapping.get()) flight_ring_header;
+		_slots = static_cast<byte *>(_mapping.get()) + sizeof(flight_ring_header);
+		_slot_capacity = (slot_size - sizeof(flight_slot_header)) / sizeof(flight_record);
+		_header->version = flight_ring_header::version_value;
+		_header->slot_size = slot_size;
+		_header->slots = slots;
+		_header->pid = static_cast<unsigned int>(getpid());
+		_header->reserved = 0;
+		_header->ticks_per_second = ticks_per_second_;
+		_header->written.store(0, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+		_header->magic = flight_ring_header::magic_value;
+	}
+
+	flight_recorder::~flight_recorder()
+	{
+		flight_recorder *self = this;
+
+		// The handler is left installed - it ignores the signals, once no recorder is set.
+		g_signalled_recorder.compare_exchange_strong(self, nullptr);
+	}
+
+	void flight_recorder::dump(const string &json_path, double window, const address_resolver_t &resolver)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+		write_file_stream output(json_path);
+
+		export_chrome_trace(output, _path, window, resolver);
+	}
+
+	void flight_recorder::dump_on_request(const string &json_path, double window, const address_resolver_t &resolver)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		_dump_path = json_path;
+		_dump_window = window;
+		_dump_resolver = resolver;
+	}
+
+	void flight_recorder::dump()
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		if (!_dump_path.empty())
+		{
+			write_file_stream output(_dump_path);
+
+			export_chrome_trace(output, _path, _dump_window, _dump_resolver);
+		}
+	}
+
+	void flight_recorder::request_dump() throw()
+	{	_dump_requested = true;	}
+
+	void flight_recorder::dump_on_signal(int signo)
+	{
+#ifdef _WIN32
+		signo;
+#else
+		struct sigaction action = {};
+
+		action.sa_handler = &flight_recorder::on_signal;
+		action.sa_flags = SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		g_signalled_recorder = this;
+		if (::sigaction(signo, &action, nullptr))
+			throw runtime_error("cannot set a flight recorder dump signal handler");
+#endif
+	}
+
+	void flight_recorder::read_collected(acceptor &a)
+	{
+		tee t(*this, a);
+
+		_underlying.read_collected(t);
+		check_dump_requested();
+	}
+
+	void flight_recorder::read_collected(acceptor &a, unsigned int partition, unsigned int partitions)
+	{
+		tee t(*this, a);
+
+		_underlying.read_collected(t, partition, partitions);
+		if (!partition)
+			check_dump_requested();
+	}
+
+	void flight_recorder::flush()
+	{	_underlying.flush();	}
+
+	void flight_recorder::record(unsigned int thread_id, const call_record *calls, size_t count)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		write(thread_id, _threads[thread_id], calls, count);
+	}
+
+	void flight_recorder::record(unsigned int thread_id, const compact_call_record *calls, size_t count,
+		const callee_table &callees)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+		auto &t = _threads[thread_id];
+
+		t.decoded.assign(compact_trace_iterator(calls, calls + count, t.decoder, callees),
+			compact_trace_iterator(calls + count));
+		write(thread_id, t, t.decoded.data(), t.decoded.size());
+	}
+
+	void flight_recorder::record_dropped(unsigned int thread_id, count_t count)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+		auto &t = _threads[thread_id];
+
+		t.dropped += count;
+		t.decoder.reset(); // Compact records following a loss are encoded from scratch.
+	}
+
+	void flight_recorder::check_dump_requested()
+	{
+		if (_dump_requested.exchange(false))
+			dump();
+	}
+
+	void flight_recorder::write(unsigned int thread_id, thread_state &t, const call_record *calls, size_t count)
+	{
+		while (count)
+		{
+			if (!is_recorded(calls->callee))
+			{
+				calls++, count--;
+				continue;
+			}
+
+			const auto written = _header->written.load(memory_order_relaxed);
+			auto &slot = *reinterpret_cast<flight_slot_header *>(_slots + written % _header->slots * _header->slot_size);
+			auto records = reinterpret_cast<flight_record *>(&slot + 1);
+			size_t n = 0;
+
+			slot.sequence = 0;
+			atomic_thread_fence(memory_order_release);
+			for (; count && n != _slot_capacity; calls++, count--)
+			{
+				if (!is_recorded(calls->callee))
+					continue;
+				records[n].timestamp = calls->timestamp;
+				records[n++].callee = folded_calls_tag == calls->callee ? c_folded_callee
+					: static_cast<unsigned long long>(reinterpret_cast<size_t>(calls->callee));
+			}
+			slot.dropped = t.dropped;
+			slot.last = records[n - 1].timestamp;
+			slot.thread_id = thread_id;
+			slot.count = static_cast<unsigned int>(n);
+			atomic_thread_fence(memory_order_release);
+			slot.sequence = written + 1;
+			_header->written.store(written + 1, memory_order_release);
+			t.dropped = 0;
+		}
+	}
+
+	void flight_recorder::on_signal(int /*signo*/)
+	{
+		if (const auto recorder = g_signalled_recorder.load())
+			recorder->request_dump();
+	}
+
+
+	void export_chrome_trace(write_file_stream &output, const string &ring_path, double window,
+		const address_resolver_t &resolver)
+	{
+		struct thread_trace
+		{
+			unsigned int depth;
+			timestamp_t last;
+			count_t calls;
+		};
+
+		flight_ring_header header;
+
+		read_file_stream(ring_path).read(&header, sizeof(header));
+		if (flight_ring_header::magic_value != header.magic || flight_ring_header::version_value != header.version
+				|| header.slot_size < sizeof(flight_slot_header) + sizeof(flight_record) || !header.slots
+				|| header.ticks_per_second <= 0)
+			throw invalid_argument("not a flight recorder ring file");
+
+		const unsigned long long slots = header.slots, written = header.written.load();
+		const auto first = written > slots ? written - slots : 0ull;
+		const auto capacity = (header.slot_size - sizeof(flight_slot_header)) / sizeof(flight_record);
+		vector<byte> buffer(header.slot_size);
+		const auto &slot = *reinterpret_cast<const flight_slot_header *>(buffer.data());
+		const auto records = reinterpret_cast<const flight_record *>(&slot + 1);
+		auto read_slots = [&] (bool headers_only, const function<void ()> &callback) {
+			// The slots are read in the order they were written - from the oldest one to the end of the file and then
+			// from its beginning. The slots overwritten or being written are skipped.
+			for (auto sequence = first; sequence != written; )
+			{
+				read_file_stream stream(ring_path);
+				auto index = sequence % slots;
+
+				stream.skip(sizeof(flight_ring_header));
+				for (auto i = index; i--; )
+					stream.skip(header.slot_size);
+				for (; index != slots && sequence != written; ++index, ++sequence)
+				{
+					stream.read(buffer.data(), headers_only ? sizeof(flight_slot_header) : header.slot_size);
+					if (headers_only)
+						stream.skip(header.slot_size - sizeof(flight_slot_header));
+					if (slot.sequence == sequence + 1 && slot.count && slot.count <= capacity)
+						callback();
+				}
+			}
+		};
+		auto cutoff = timestamp_t();
+		map<unsigned int, thread_trace> threads;
+		chrome_trace_writer writer(output, header.pid, header.ticks_per_second, resolver);
+
+		if (window > 0)
+		{
+			auto newest = timestamp_t();
+
+			read_slots(true, [&] {
+				if (slot.last > newest)
+					newest = slot.last;
+			});
+			cutoff = newest - static_cast<timestamp_t>(window * header.ticks_per_second);
+		}
+		read_slots(false, [&] {
+			auto i = threads.find(slot.thread_id);
+
+			if (threads.end() == i)
+			{
+				const thread_trace t = {	0u, 0, 1u	};
+
+				i = threads.insert(make_pair(slot.thread_id, t)).first;
+			}
+
+			auto &t = i->second;
+
+			if (slot.dropped)
+			{
+				// The stack is unknown past a drop, so the calls open are closed.
+				for (t.calls = 1; t.depth; t.depth--)
+					writer.end(slot.thread_id, t.last);
+			}
+			if (slot.last < cutoff)
+				return;
+			for (auto r = records; r != records + slot.count; ++r)
+			{
+				if (c_folded_callee == r->callee)
+				{
+					t.calls = static_cast<count_t>(r->timestamp);
+					continue;
+				}
+				if (r->timestamp < cutoff)
+				{
+					t.calls = 1;
+					continue;
+				}
+				t.last = r->timestamp;
+				if (r->callee)
+				{
+					writer.begin(slot.thread_id, r->timestamp, r->callee, t.calls);
+					t.depth++;
+					t.calls = 1;
+				}
+				else if (t.depth)
+				{
+					writer.end(slot.thread_id, r->timestamp);
+					t.depth--;
+				}
+			}
+		});
+		for (auto i = threads.begin(); i != threads.end(); ++i)
+		{
+			for (; i->second.depth; i->second.depth--)
+				writer.end(i->first, i->second.last);
+		}
+	}
+}
@@ -0,0 +1,176 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <collector/hw_counters.h>
+
+#include <atomic>
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		struct event_type
+		{
+			unsigned int type;
+			unsigned long long config;
+		};
+
+		const event_type c_events[max_hw_counters] = {
+			{	PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES	},
+			{	PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS	},
+			{	PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8
+				| PERF_COUNT_HW_CACHE_RESULT_MISS << 16	},
+			{	PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES	},
+		};
+
+		// The events are opened as a single group led by the cycles, so that they are always scheduled together. The
+		// group is pinned, so that it is never multiplexed with other events - it is put into an error state instead,
+		// when it cannot be put on the PMU.
+		int open_event(const event_type &event, int group_fd)
+		{
+			perf_event_attr attr = {};
+
+			attr.size = sizeof(attr);
+			attr.type = event.type;
+			attr.config = event.config;
+			attr.pinned = group_fd < 0;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0 /*calling thread*/, -1 /*any CPU*/,
+				group_fd, PERF_FLAG_FD_CLOEXEC));
+		}
+
+#if defined(__x86_64__) || defined(__i386__)
+		unsigned long long read_pmc(unsigned int index) throw()
+		{
+			unsigned int low, high;
+
+			__asm__ __volatile__ ("rdpmc" : "=a" (low), "=d" (high) : "c" (index));
+			return static_cast<unsigned long long>(high) << 32 | low;
+		}
+#else
+		unsigned long long read_pmc(unsigned int /*index*/) throw()
+		{	return 0;	}
+#endif
+
+		// See the description of perf_event_mmap_page in linux/perf_event.h for the reading protocol. Returns false if
+		// the event has been off the PMU while enabled, thus its value falls short.
+		bool read_counter(unsigned long long &value, const volatile perf_event_mmap_page &page) throw()
+		{
+			unsigned int sequence;
+			bool scheduled;
+
+			do
+			{
+				sequence = page.lock;
+				atomic_signal_fence(memory_order_acq_rel);
+
+				const unsigned int index = page.index;
+
+				value = page.offset;
+				scheduled = page.time_enabled == page.time_running;
+				if (page.cap_user_rdpmc && index)
+				{
+					const auto shift = 64 - page.pmc_width;
+
+					value += static_cast<long long>(read_pmc(index - 1) << shift) >> shift;
+				}
+				atomic_signal_fence(memory_order_acq_rel);
+			} while (page.lock != sequence);
+			return scheduled;
+		}
+	}
+
+	hw_counters::hw_counters()
+	{
+		for (auto i = 0; i != max_hw_counters; ++i)
+			_fds[i] = -1, _pages[i] = nullptr;
+	}
+
+	hw_counters::~hw_counters()
+	{
+		const auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+
+		for (auto i = 0; i != max_hw_counters; ++i)
+		{
+			if (_pages[i])
+				::munmap(_pages[i], page_size);
+			if (_fds[i] >= 0)
+				::close(_fds[i]);
+		}
+	}
+
+	unique_ptr<hw_counters> hw_counters::open()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		const auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+		unique_ptr<hw_counters> c(new hw_counters);
+		unsigned long long value;
+
+		for (auto i = 0; i != max_hw_counters; ++i)
+		{
+			const auto fd = c->_fds[i] = open_event(c_events[i], c->_fds[hw_cycles]);
+
+			if (hw_cycles == i && fd < 0)
+				return nullptr;
+			if (fd < 0)
+				continue;
+
+			const auto page = ::mmap(nullptr, page_size, PROT_READ, MAP_SHARED, fd, 0);
+
+			if (MAP_FAILED == page)
+				continue;
+			c->_pages[i] = page;
+			if (!static_cast<const perf_event_mmap_page *>(page)->cap_user_rdpmc)
+				return nullptr;
+		}
+
+		// Neither IPC, nor miss rates make sense without these two.
+		if (!c->_pages[hw_cycles] || !c->_pages[hw_instructions])
+			return nullptr;
+
+		// The group is put on the PMU as soon as it is opened - a read yields nothing if it is in an error state.
+		if (sizeof(value) != ::read(c->_fds[hw_cycles], &value, sizeof(value)))
+			return nullptr;
+		return c;
+#else
+		return nullptr;
+#endif
+	}
+
+	bool hw_counters::read(unsigned long long (&values)[max_hw_counters]) const throw()
+	{
+		auto scheduled = true;
+
+		for (auto i = 0; i != max_hw_counters; ++i)
+		{
+			values[i] = 0;
+			if (_pages[i] && !read_counter(values[i], *static_cast<const perf_event_mmap_page *>(_pages[i])))
+				scheduled = false;
+		}
+		return scheduled;
+	}
+}
@@ -0,0 +1,165 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <collector/lock_tracker.h>
+
+#include <atomic>
+#include <common/time.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define PUBLIC __attribute__ ((visibility ("default")))
+
+using namespace std;
+using namespace micro_profiler;
+
+// The locking functions are interposed and forwarded to the ones next in the lookup order, which are resolved once, on
+// load. A lock is first tried without blocking (the trying functions are not interposed), so that only the contended
+// acquisitions are timed and reported, while a condition variable wait is always reported. dlsym() may lock itself, so
+// the locks acquired while the functions are being resolved are spun on, and a condition variable wait returns
+// spuriously then. The calls made by the profiler's own threads are not reported, since these have no traces.
+
+namespace
+{
+	typedef int (cond_wait_t)(pthread_cond_t *cv, pthread_mutex_t *mutex);
+
+	struct lock_functions
+	{
+		int (*mutex_lock)(pthread_mutex_t *mutex);
+		int (*rwlock_rdlock)(pthread_rwlock_t *rwlock);
+		int (*rwlock_wrlock)(pthread_rwlock_t *rwlock);
+		cond_wait_t *cond_wait;
+	};
+
+	enum {	unresolved, resolving, resolved	};
+
+	lock_functions g_next;
+	atomic<int> g_state(unresolved);
+
+	template <typename T>
+	void resolve(T *&function, const char *name)
+	{	function = reinterpret_cast<T *>(dlsym(RTLD_NEXT, name));	}
+
+	cond_wait_t *resolve_cond_wait()
+	{
+		// The versioned lookup picks the modern condition variable ABI; it yields nothing on libcs that do not
+		// version the symbol (musl) or use a different version tag (non-x86 glibc ports).
+		if (const auto versioned = dlvsym(RTLD_NEXT, "pthread_cond_wait", "GLIBC_2.3.2"))
+			return reinterpret_cast<cond_wait_t *>(versioned);
+		return reinterpret_cast<cond_wait_t *>(dlsym(RTLD_NEXT, "pthread_cond_wait"));
+	}
+
+	// Returns nullptr while the functions are being resolved (by this or another thread).
+	const lock_functions *get_next()
+	{
+		auto state = g_state.load(memory_order_acquire);
+
+		if (resolved == state)
+			return &g_next;
+		if (unresolved != state || !g_state.compare_exchange_strong(state, resolving, memory_order_acquire))
+			return nullptr;
+		resolve(g_next.mutex_lock, "pthread_mutex_lock");
+		resolve(g_next.rwlock_rdlock, "pthread_rwlock_rdlock");
+		resolve(g_next.rwlock_wrlock, "pthread_rwlock_wrlock");
+		g_next.cond_wait = resolve_cond_wait();
+		g_state.store(resolved, memory_order_release);
+		return &g_next;
+	}
+
+	__attribute__ ((constructor)) void resolve_on_load()
+	{	get_next();	}
+
+	template <typename LockT>
+	int spin(LockT *lock, int (&try_acquire)(LockT *lock))
+	{
+		int result;
+
+		while (EBUSY == (result = try_acquire(lock)))
+			sched_yield();
+		return result;
+	}
+
+	template <typename LockT>
+	int acquire(LockT *lock, int (&try_acquire)(LockT *lock), int (*acquire_)(LockT *lock), const void *function)
+	{
+		if (!acquire_)
+			return spin(lock, try_acquire);
+		if (!lock_tracker::enabled())
+			return acquire_(lock);
+
+		auto result = try_acquire(lock);
+
+		if (EBUSY != result)
+			return result;
+
+		const auto started = read_tick_counter();
+
+		result = acquire_(lock);
+		if (!result)
+			lock_tracker::on_wait(lock, function, started, read_tick_counter());
+		return result;
+	}
+}
+
+extern "C" PUBLIC int pthread_mutex_lock(pthread_mutex_t *mutex) throw()
+{
+	const auto next = get_next();
+
+	return acquire(mutex, pthread_mutex_trylock, next ? next->mutex_lock : nullptr,
+		reinterpret_cast<const void *>(&pthread_mutex_lock));
+}
+
+extern "C" PUBLIC int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock) throw()
+{
+	const auto next = get_next();
+
+	return acquire(rwlock, pthread_rwlock_tryrdlock, next ? next->rwlock_rdlock : nullptr,
+		reinterpret_cast<const void *>(&pthread_rwlock_rdlock));
+}
+
+extern "C" PUBLIC int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock) throw()
+{
+	const auto next = get_next();
+
+	return acquire(rwlock, pthread_rwlock_trywrlock, next ? next->rwlock_wrlock : nullptr,
+		reinterpret_cast<const void *>(&pthread_rwlock_wrlock));
+}
+
+extern "C" PUBLIC int pthread_cond_wait(pthread_cond_t *cv, pthread_mutex_t *mutex) throw()
+{
+	const auto next = get_next();
+
+	if (!next || !next->cond_wait)
+	{
+		pthread_mutex_unlock(mutex);
+		sched_yield();
+		return spin(mutex, pthread_mutex_trylock);
+	}
+	if (!lock_tracker::enabled())
+		return next->cond_wait(cv, mutex);
+
+	const auto started = read_tick_counter();
+	const auto result = next->cond_wait(cv, mutex);
+
+	lock_tracker::on_wait(cv, reinterpret_cast<const void *>(&pthread_cond_wait), started, read_tick_counter());
+	return result;
+}
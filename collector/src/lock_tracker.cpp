@@ -0,0 +1,59 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <collector/lock_tracker.h>
+
+#include <atomic>
+#include <collector/calls_collector.h>
+#include <stdexcept>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		atomic<calls_collector *> g_collector(nullptr);
+	}
+
+	lock_tracker::lock_tracker(calls_collector &collector)
+	{
+		calls_collector *expected = nullptr;
+
+		if (!g_collector.compare_exchange_strong(expected, &collector))
+			throw logic_error("another lock tracker is already running");
+	}
+
+	lock_tracker::~lock_tracker()
+	{	g_collector = nullptr;	}
+
+	bool lock_tracker::enabled() throw()
+	{	return !!g_collector.load(memory_order_relaxed);	}
+
+	void lock_tracker::on_wait(const void *lock, const void *blocking_function, timestamp_t started,
+		timestamp_t finished) throw()
+	{
+		if (const auto collector = g_collector.load(memory_order_acquire))
+		{
+			if (const auto queue = collector->find_queue())
+				queue->on_lock_wait(lock, blocking_function, started, finished);
+		}
+	}
+}
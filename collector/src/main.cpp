@@ -21,8 +21,11 @@
 #include "main.h"
 
 #include <collector/calibration.h>
+#include <collector/calibration_cache.h>
+#include <collector/hw_counters.h>
 #include <collector/thread_monitor.h>
 #include <common/constants.h>
+#include <common/formatting.h>
 #include <common/module.h>
 #include <common/path.h>
 #include <common/time.h>
@@ -30,9 +33,11 @@
 #include <ipc/misc.h>
 #include <logger/writer.h>
 #include <mt/thread_callbacks.h>
+#include <patcher/coverage_patch.h>
 #include <patcher/function_patch.h>
 #include <patcher/image_patch_manager.h>
 #include <patcher/translated_function_patch.h>
+#include <stdio.h>
 
 #ifdef _WIN32
 	#include <process.h>
@@ -43,18 +48,34 @@
 	extern "C" int _mkdir(const char *pathname, int mode);
 
 #else
+	#include <signal.h>
 	#include <sys/stat.h>
 	#include <sys/types.h>
 	#include <unistd.h>
 
 #endif
 
+#ifdef __linux__
+	#include <collector/sampler.h>
+#endif
+
 #define PREAMBLE "Profiler Instance: "
 
 using namespace std;
 
-const size_t c_trace_limit = 5000000;
+const size_t c_trace_limit = 5000000 * sizeof(micro_profiler::call_record) / sizeof(micro_profiler::trace_record);
+const size_t c_min_buffer_size = 64;
+const size_t c_max_buffer_size = 16384;
+const unsigned int c_max_analysis_workers = 64;
+const unsigned int c_max_sampling_frequency = 10000;
+const unsigned int c_max_short_call_threshold = 1000000;
+const size_t c_max_flight_recorder_size = 4096; // megabytes
+const double c_flight_recorder_window = 10; // seconds
 const mt::milliseconds c_auto_connect_delay(50);
+const mt::milliseconds c_revalidation_delay(1000);
+const size_t c_tracking_iterations = 100000;
+const char *c_calibration_cache = "calibration.cache";
+const char *c_translation_cache = "translation.cache";
 #ifdef _MSC_VER
 	extern "C"
 #endif
@@ -80,6 +101,136 @@ namespace micro_profiler
 
 			ipc::channel &_inbound;
 		};
+
+		buffering_policy::overflow_mode get_overflow_mode()
+		{
+			const auto mode = getenv(constants::overflow_policy_ev);
+
+			return mode && string(mode) == "drop" ? buffering_policy::drop_on_overflow
+				: buffering_policy::block_on_overflow;
+		}
+
+		buffering_policy get_working_policy(size_t trace_limit, timestamp_t short_call_threshold = 0,
+			bool hw_counters_ = false)
+		{
+			size_t min_size = c_min_buffer_size, max_size = c_max_buffer_size;
+
+			if (const auto sizes = getenv(constants::buffer_size_ev))
+			{
+				char *end = nullptr;
+				const auto min_size_ = static_cast<size_t>(strtoul(sizes, &end, 10));
+				auto max_size_ = min_size_;
+
+				if (*end == '-')
+					max_size_ = static_cast<size_t>(strtoul(end + 1, &end, 10));
+				if (!*end && min_size_ && min_size_ <= max_size_)
+					min_size = min_size_, max_size = max_size_;
+				else
+					LOG(PREAMBLE "invalid buffer size range, using default...") % A(sizes);
+			}
+			LOG(PREAMBLE "buffer size range...") % A(min_size) % A(max_size);
+			return buffering_policy(trace_limit, 0.1, 0.01, get_overflow_mode(), min_size, max_size, short_call_threshold,
+				hw_counters_);
+		}
+
+		unsigned int get_analysis_workers()
+		{
+			if (const auto workers = getenv(constants::analysis_workers_ev))
+			{
+				char *end = nullptr;
+				const auto n = static_cast<unsigned int>(strtoul(workers, &end, 10));
+
+				if (!*end && n && n <= c_max_analysis_workers)
+					return n;
+				LOG(PREAMBLE "invalid number of analysis workers, using default...") % A(workers);
+			}
+			return 1;
+		}
+
+		unsigned int get_sampling_frequency()
+		{
+			if (const auto frequency = getenv(constants::sampling_ev))
+			{
+				char *end = nullptr;
+				const auto n = static_cast<unsigned int>(strtoul(frequency, &end, 10));
+
+				if (!*end && n && n <= c_max_sampling_frequency)
+					return n;
+				LOG(PREAMBLE "invalid sampling frequency, using instrumentation...") % A(frequency);
+			}
+			return 0;
+		}
+
+		unsigned int get_short_call_threshold_ns()
+		{
+			if (const auto threshold = getenv(constants::short_calls_ev))
+			{
+				char *end = nullptr;
+				const auto n = static_cast<unsigned int>(strtoul(threshold, &end, 10));
+
+				if (!*end && n <= c_max_short_call_threshold)
+					return n;
+				LOG(PREAMBLE "invalid short call threshold, tracing all calls...") % A(threshold);
+			}
+			return 0;
+		}
+
+		unsigned int get_overhead_budget()
+		{
+			if (const auto budget = getenv(constants::overhead_budget_ev))
+			{
+				char *end = nullptr;
+				const auto n = static_cast<unsigned int>(strtoul(budget, &end, 10));
+
+				if (!*end && n && n <= 100)
+					return n;
+				LOG(PREAMBLE "invalid overhead budget, keeping all patches...") % A(budget);
+			}
+			return 0;
+		}
+
+		bool get_hw_counters()
+		{
+			if (!getenv(constants::hw_counters_ev))
+				return false;
+			if (hw_counters::open())
+				return true;
+			LOG(PREAMBLE "hardware counters are not available, not collecting them...");
+			return false;
+		}
+
+		size_t get_flight_recorder_size(double &window)
+		{
+			if (const auto settings = getenv(constants::flight_recorder_ev))
+			{
+				char *end = nullptr;
+				const auto size = static_cast<size_t>(strtoul(settings, &end, 10));
+
+				window = c_flight_recorder_window;
+				if (*end == ',')
+					window = strtod(end + 1, &end);
+				if (!*end && size && size <= c_max_flight_recorder_size && window > 0)
+					return size << 20;
+				LOG(PREAMBLE "invalid flight recorder settings, not recording...") % A(settings);
+			}
+			return 0;
+		}
+
+		// The plans are only valid for the patcher that has made them - an empty key is returned if it is unknown.
+		string get_translation_cache_key(module &module_helper)
+		{
+			string key = "build=";
+
+			try
+			{
+				itoa<16>(key, module_tracker::calculate_hash(module_helper.locate(&g_collector_ptr).path), 8);
+				return key;
+			}
+			catch (const exception &)
+			{
+				return string();
+			}
+		}
 	}
 
 
@@ -129,20 +280,105 @@ namespace micro_profiler
 		: _logger(create_writer(module_helper), (log::g_logger = &_logger, &get_datetime)),
 			_memory_manager(virtual_memory::granularity()), _thread_monitor(make_shared<thread_monitor>(thread_callbacks)),
 			_collector(_allocator, trace_limit, *_thread_monitor, thread_callbacks), _module_tracker(module_helper),
+			_translation_cache(_module_tracker), _translation_cache_key(get_translation_cache_key(module_helper)),
+			_coverage_tracker(getenv(constants::coverage_ev) ? new coverage_tracker(_module_tracker) : nullptr),
 			_patch_manager([this] (void *target, size_t target_size, id_t /*id*/, executable_memory_allocator &allocator) {
-				return unique_ptr<patch>(new translated_function_patch(target, target_size, &_collector, allocator));
+				if (_coverage_tracker)
+				{
+					const auto hit = _coverage_tracker->get_hit(target);
+
+					return unique_ptr<patch>(new coverage_patch(target, target_size, hit.first, hit.second, allocator,
+						_translation_cache.get_plan(target, target_size)));
+				}
+#ifdef MP_FAST_CURSOR
+				if (_fast_trampolines)
+				{
+					return unique_ptr<patch>(new translated_function_patch(target, target_size, &_collector, allocator,
+						_translation_cache.get_plan(target, target_size), get_thread_pointer_offset(&g_fast_cursor)));
+				}
+#endif
+				return unique_ptr<patch>(new translated_function_patch(target, target_size, &_collector, allocator,
+					_translation_cache.get_plan(target, target_size)));
 //				return unique_ptr<patch>(new function_patch(target, &_collector, allocator));
-			}, _module_tracker, _memory_manager), _auto_connect(true)
+			}, _module_tracker, _memory_manager), _auto_connect(true), _fast_trampolines(false)
 	{
 		collector_ptr = &_collector;
 
-		const auto oh = calibrate_overhead(_collector, trace_limit);
+		if (!_translation_cache_key.empty()
+			&& _translation_cache.load(constants::data_directory() & c_translation_cache, _translation_cache_key))
+		{
+			LOG(PREAMBLE "using cached translation plans...");
+		}
+
+		if (_coverage_tracker)
+			LOG(PREAMBLE "collecting coverage, patches are reverted once hit...");
+		if (const auto frequency = get_sampling_frequency())
+		{
+#ifdef __linux__
+			_sampler.reset(new sampler(*_thread_monitor, module_helper, frequency, &_collector));
+			LOG(PREAMBLE "sampling...") % A(frequency);
+#else
+			LOG(PREAMBLE "sampling is not supported on this platform, using instrumentation...") % A(frequency);
+#endif
+		}
+
+		const auto hw_counters_ = !_sampler && get_hw_counters();
+		const auto oh = _sampler ? overhead(0, 0)
+			: calibrate(module_helper, thread_callbacks, trace_limit, get_working_policy(trace_limit, 0, hw_counters_));
 		const auto period = 1e9 / ticks_per_second();
 		const auto inner_ns = static_cast<int>(oh.inner * period);
 		const auto total_ns = static_cast<int>((oh.inner + oh.outer) * period);
 
 		LOG(PREAMBLE "overhead calibrated...") % A(inner_ns) % A(total_ns);
-		_app.reset(new collector_app(_collector, oh, *_thread_monitor, _module_tracker, _patch_manager));
+
+		const auto threshold_ns = _sampler || hw_counters_ ? 0u : get_short_call_threshold_ns();
+
+		if (hw_counters_)
+		{
+			LOG(PREAMBLE "collecting hardware counters...");
+		}
+		else if (threshold_ns)
+		{
+			// Applied past the calibration, since ticks per second are only known reliably by then.
+			LOG(PREAMBLE "folding short leaf calls...") % A(threshold_ns);
+			_collector.set_buffering_policy(get_working_policy(trace_limit,
+				static_cast<timestamp_t>(threshold_ns / period)));
+		}
+		if (!_sampler && getenv(constants::allocations_ev))
+		{
+#if defined(__linux__) && defined(MP_HOOK_ALLOCATIONS)
+			_allocation_tracker.reset(new allocation_tracker(_collector));
+			LOG(PREAMBLE "tracking heap allocations...");
+#else
+			LOG(PREAMBLE "heap allocations tracking is not supported by this build...");
+#endif
+		}
+		if (!_sampler && getenv(constants::locks_ev))
+		{
+#if defined(__linux__) && defined(MP_HOOK_LOCKS)
+			_lock_tracker.reset(new lock_tracker(_collector));
+			LOG(PREAMBLE "tracking lock contention...");
+#else
+			LOG(PREAMBLE "lock contention tracking is not supported by this build...");
+#endif
+		}
+#ifdef MP_FAST_CURSOR
+		if (!_sampler && !_coverage_tracker && !hw_counters_ && !threshold_ns && !_allocation_tracker && !_lock_tracker)
+		{
+			// Nothing but the entries and exits is written on a call, so the trampolines can write them directly.
+			_collector.bind_fast_cursors();
+			_fast_trampolines = true;
+			LOG(PREAMBLE "using fast trampolines...");
+		}
+#endif
+		calls_collector_i *source = _sampler ? _sampler.get() : &_collector;
+
+		start_flight_recorder(module_helper, *source);
+		if (_flight_recorder)
+			source = _flight_recorder.get();
+		_app.reset(new collector_app(*source, oh, *_thread_monitor, _module_tracker, _patch_manager,
+			get_analysis_workers(), _sampler ? 0u : get_overhead_budget(), _coverage_tracker.get(),
+			!!getenv(constants::call_times_ev)));
 		_app->get_queue().schedule([this, auto_frontend_factory] {
 			if (_auto_connect)
 				_app->connect(auto_frontend_factory, false);
@@ -159,7 +395,137 @@ namespace micro_profiler
 	}
 
 	void collector_app_instance::terminate() throw()
-	{	_app.reset();	}
+	{
+		if (_revalidation)
+		{
+			_revalidation_exit.set();
+			_revalidation->join();
+			_revalidation.reset();
+		}
+		_allocation_tracker.reset();
+		_lock_tracker.reset();
+		_app.reset();
+		try
+		{
+			if (!_translation_cache_key.empty())
+				_translation_cache.store(constants::data_directory() & c_translation_cache, _translation_cache_key);
+		}
+		catch (const exception &e)
+		{
+			LOG(PREAMBLE "failed to store the translation plans...") % A(e.what());
+		}
+		if (_flight_recorder)
+		{
+			try
+			{
+				_flight_recorder->dump();
+			}
+			catch (const exception &e)
+			{
+				LOG(PREAMBLE "failed to dump the flight recorder...") % A(e.what());
+			}
+			_flight_recorder.reset();
+		}
+	}
+
+	void collector_app_instance::start_flight_recorder(module &module_helper, calls_collector_i &underlying)
+	{
+		double window;
+		const auto size = get_flight_recorder_size(window);
+
+		if (!size)
+			return;
+
+		const auto base = constants::data_directory() & ("micro-profiler." + *module_helper.executable());
+
+		try
+		{
+			_flight_recorder.reset(new flight_recorder(underlying, base + ".ring", size, ticks_per_second()));
+			_flight_recorder->dump_on_request(base + ".trace.json", window, [&module_helper] (unsigned long long address) {
+				const auto m = module_helper.locate(reinterpret_cast<const void *>(static_cast<size_t>(address)));
+				char rva[30];
+
+				if (!m.base)
+					return string();
+				sprintf(rva, "+0x%llx", address - reinterpret_cast<size_t>(m.base));
+				return string(*m.path) + rva;
+			});
+#ifndef _WIN32
+			_flight_recorder->dump_on_signal(SIGUSR2);
+#endif
+			const auto window_ms = static_cast<int>(window * 1000);
+
+			LOG(PREAMBLE "flight recorder started...") % A(base) % A(size) % A(window_ms);
+		}
+		catch (const exception &e)
+		{
+			_flight_recorder.reset();
+			LOG(PREAMBLE "failed to start the flight recorder...") % A(e.what());
+		}
+	}
+
+	overhead collector_app_instance::calibrate(module &module_helper, mt::thread_callbacks &thread_callbacks,
+		size_t trace_limit, const buffering_policy &working_policy)
+	{
+		const auto cache_path = constants::data_directory() & c_calibration_cache;
+		auto key = calibration_key(module_helper.locate(&g_collector_ptr).path);
+		calibration_info info;
+
+		if (!key.empty() && working_policy.hw_counters())
+			key += "hw_counters;"; // Reading the counters adds to the overhead.
+		if (!key.empty() && load_calibration(info, cache_path, key))
+		{
+			LOG(PREAMBLE "using cached calibration...") % A(info.ticks_per_second) % A(info.inner) % A(info.outer);
+			set_ticks_per_second(info.ticks_per_second);
+			_collector.set_buffering_policy(working_policy);
+
+			// Remeasuring is cheaper than a calibration, but is still deferred not to delay the profilee's startup.
+			_revalidation.reset(new mt::thread([this, &thread_callbacks, cache_path, info] {
+				if (_revalidation_exit.wait(c_revalidation_delay))
+					return;
+
+				const auto ticks_per_second_ = measure_ticks_per_second();
+				const auto tracking = measure_tracking_overhead(_allocator, thread_callbacks, c_tracking_iterations);
+
+				if (is_calibration_valid(info, ticks_per_second_, tracking))
+				{
+					LOG(PREAMBLE "cached calibration revalidated...") % A(ticks_per_second_) % A(tracking);
+				}
+				else
+				{
+					// The overhead is already in use by the analysis, so this run's statistics keep the bias - the next
+					// run recalibrates.
+					const auto period = 1e9 / static_cast<double>(ticks_per_second_);
+					const auto bias_ns = static_cast<int>((static_cast<double>(tracking)
+						- static_cast<double>(info.tracking)) * period);
+
+					LOG(PREAMBLE "cached calibration is stale, statistics of this run are biased, discarding...")
+						% A(ticks_per_second_) % A(tracking) % A(info.tracking) % A(bias_ns);
+					::remove(cache_path.c_str());
+				}
+			}));
+			return overhead(info.inner, info.outer);
+		}
+
+		const auto oh = calibrate_overhead(_collector, trace_limit, working_policy);
+
+		if (!key.empty())
+		{
+			info.ticks_per_second = ticks_per_second();
+			info.inner = oh.inner;
+			info.outer = oh.outer;
+			info.tracking = measure_tracking_overhead(_allocator, thread_callbacks, c_tracking_iterations);
+			try
+			{
+				store_calibration(cache_path, key, info);
+			}
+			catch (const exception &e)
+			{
+				LOG(PREAMBLE "failed to store calibration...") % A(cache_path) % A(e.what());
+			}
+		}
+		return oh;
+	}
 
 	void collector_app_instance::block_auto_connect()
 	{	_app->get_queue().schedule([this] {	_auto_connect = false;	});	}
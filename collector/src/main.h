@@ -20,14 +20,21 @@
 
 #pragma once
 
+#include <collector/allocation_tracker.h>
 #include <collector/calls_collector.h>
 #include <collector/collector_app.h>
+#include <collector/coverage_tracker.h>
+#include <collector/flight_recorder.h>
+#include <collector/lock_tracker.h>
 #include <collector/module_tracker.h>
+#include <collector/translation_cache.h>
 #include <common/allocator.h>
 #include <common/memory_manager.h>
 #include <common/noncopyable.h>
 #include <logger/multithreaded_logger.h>
 #include <logger/writer.h>
+#include <mt/event.h>
+#include <mt/thread.h>
 #include <patcher/image_patch_manager.h>
 
 namespace micro_profiler
@@ -48,6 +55,9 @@ namespace micro_profiler
 
 	private:
 		void platform_specific_init();
+		overhead calibrate(module &module_helper, mt::thread_callbacks &thread_callbacks, size_t trace_limit,
+			const buffering_policy &working_policy);
+		void start_flight_recorder(module &module_helper, calls_collector_i &underlying);
 		static log::writer_t create_writer(module &module_helper);
 
 	private:
@@ -56,10 +66,19 @@ namespace micro_profiler
 		memory_manager _memory_manager;
 		std::shared_ptr<thread_monitor> _thread_monitor;
 		calls_collector _collector;
+		std::unique_ptr<calls_collector_i> _sampler;
+		std::unique_ptr<allocation_tracker> _allocation_tracker;
+		std::unique_ptr<lock_tracker> _lock_tracker;
+		std::unique_ptr<flight_recorder> _flight_recorder;
 		module_tracker _module_tracker;
+		translation_cache _translation_cache;
+		const std::string _translation_cache_key;
+		const std::unique_ptr<coverage_tracker> _coverage_tracker;
 		image_patch_manager _patch_manager;
 		std::unique_ptr<collector_app> _app;
-		bool _auto_connect;
+		bool _auto_connect, _fast_trampolines;
+		mt::event _revalidation_exit;
+		std::unique_ptr<mt::thread> _revalidation;
 	};
 }
 
@@ -0,0 +1,141 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <collector/overhead_governor.h>
+
+#include <algorithm>
+#include <collector/analyzer.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	overhead_governor::overhead_governor(patch_manager &patch_manager_, mapping_access &mappings,
+			const overhead &overhead_, unsigned int budget_percent, timestamp_t period)
+		: _patch_manager(patch_manager_), _overhead(overhead_.inner + overhead_.outer), _budget_percent(budget_percent),
+			_period(period), _period_start(0), _mapping_subscription(mappings.notify(*this))
+	{	}
+
+	void overhead_governor::account(const analyzer &analyzer_)
+	{
+		for (auto i = analyzer_.begin(); i != analyzer_.end(); ++i)
+		{
+			const auto &graph = i->second.graph();
+
+			for (auto n = 1u, count = graph.node_count(); n < count; ++n)
+			{
+				const auto &s = graph[n];
+
+				if (!s.times_called)
+					continue;
+
+				auto &f = _functions[graph.key(n)];
+
+				f.times_called += s.times_called;
+				f.exclusive_time += s.exclusive_time;
+			}
+		}
+	}
+
+	void overhead_governor::govern(throttled_patches &throttled, timestamp_t now)
+	{
+		if (!_period_start)
+			_period_start = now;
+		if (now - _period_start < _period)
+			return;
+
+		revert_requests requests;
+
+		select(requests, now - _period_start);
+		_functions.clear();
+		_period_start = now;
+		for (auto i = requests.begin(); i != requests.end(); ++i)
+		{
+			_results.clear();
+			_patch_manager.revert(_results, i->first, make_range(i->second));
+			for (auto j = _results.begin(); j != _results.end(); ++j)
+			{
+				if (patch_change_result::ok == j->result)
+					throttled.push_back(make_pair(i->first, j->rva));
+			}
+		}
+	}
+
+	void overhead_governor::mapped(id_t module_id, id_t mapping_id, const module::mapping &mapping)
+	{
+		image i = {	module_id, mapping_id	};
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		_images[mapping.base] = i;
+	}
+
+	void overhead_governor::unmapped(id_t mapping_id)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		for (auto i = _images.begin(); i != _images.end(); ++i)
+		{
+			if (i->second.mapping_id == mapping_id)
+			{
+				_images.erase(i);
+				break;
+			}
+		}
+	}
+
+	void overhead_governor::select(revert_requests &requests, timestamp_t elapsed)
+	{
+		vector< pair<timestamp_t /*overhead*/, const void *> > cheap;
+		auto total = timestamp_t();
+
+		for (auto i = _functions.begin(); i != _functions.end(); ++i)
+		{
+			const auto overhead_ = i->second.times_called * _overhead;
+
+			total += overhead_;
+			if (i->second.exclusive_time < overhead_)
+				cheap.push_back(make_pair(overhead_, i->first));
+		}
+
+		const auto budget = elapsed / 100 * _budget_percent;
+
+		if (total <= budget)
+			return;
+		sort(cheap.begin(), cheap.end(), [] (const pair<timestamp_t, const void *> &lhs,
+			const pair<timestamp_t, const void *> &rhs) {
+
+			return lhs.first > rhs.first;
+		});
+
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		for (auto i = cheap.begin(); i != cheap.end() && total > budget; ++i)
+		{
+			const auto address = static_cast<const byte *>(i->second);
+			auto image_ = _images.upper_bound(address);
+
+			if (image_ == _images.begin())
+				continue;
+			--image_;
+			requests[image_->second.module_id].push_back(static_cast<unsigned int>(address - image_->first));
+			total -= i->first;
+		}
+	}
+}
@@ -29,6 +29,9 @@ namespace micro_profiler
 	struct this_process
 	{
 		static mt::milliseconds get_process_uptime();
+#ifdef __linux__
+		static std::function<void (thread_info &info)> open_thread_info(unsigned long long native_id);
+#endif
 	};
 
 	struct this_thread
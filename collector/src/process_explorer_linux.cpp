@@ -22,7 +22,6 @@
 
 #include <common/formatting.h>
 #include <memory>
-#include <pthread.h>
 #include <stdio.h>
 #include <sys/syscall.h>
 #include <unistd.h>
@@ -91,12 +90,14 @@ namespace micro_profiler
 	{	return ::syscall(SYS_gettid);	}
 
 	function<void (thread_info &info)> this_thread::open_info()
+	{	return this_process::open_thread_info(get_native_id());	}
+
+	function<void (thread_info &info)> this_process::open_thread_info(unsigned long long native_id)
 	{
-		const auto id = get_native_id();
-		const auto start_time = get_thread_start_time(get_native_id()) - get_process_start_time();
-		clockid_t clock_handle;
+		const auto id = native_id;
+		const auto start_time = get_thread_start_time(static_cast<unsigned int>(id)) - get_process_start_time();
+		const auto clock_handle = static_cast<clockid_t>(~static_cast<unsigned int>(id) << 3 | 6); // Per-thread CPU clock.
 
-		::pthread_getcpuclockid(::pthread_self(), &clock_handle);
 		return [id, start_time, clock_handle] (thread_info &info) {
 			timespec t = {};
 
@@ -0,0 +1,323 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+#include <collector/sampler.h>
+
+#include "process_explorer.h"
+
+#include <algorithm>
+#include <collector/thread_monitor.h>
+#include <common/image_info.h>
+#include <common/module.h>
+#include <common/time.h>
+#include <errno.h>
+#include <logger/log.h>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#define PREAMBLE "Sampler: "
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		const size_t c_max_frame_size = 1024 * 1024;
+
+		atomic<sampler *> g_sampler(nullptr);
+		atomic<int> g_capturing(0);
+
+		struct discarding_acceptor : calls_collector_i::acceptor
+		{
+			virtual void accept_calls(unsigned int, const call_record *, size_t) override
+			{	}
+
+			virtual void accept_calls(unsigned int, const compact_call_record *, size_t, const callee_table &) override
+			{	}
+
+			virtual void accept_dropped(unsigned int, count_t) override
+			{	}
+
+			virtual void accept_exited(unsigned int) override
+			{	}
+		};
+
+		// Reads a frame record without dereferencing the frame pointer: a pointer left stale by the code interrupted may
+		// refer to an unmapped page, which is reported as a failure instead of faulting the thread sampled.
+		bool read_frame(const void *(&record)[2], const void * const *fp) throw()
+		{
+			iovec local = {	record, sizeof(record)	};
+			iovec remote = {	const_cast<const void **>(fp), sizeof(record)	};
+
+			return ::process_vm_readv(::getpid(), &local, 1, &remote, 1, 0) == static_cast<ssize_t>(sizeof(record));
+		}
+
+		// Must remain async-signal-safe. Requires the code profiled to be built with frame pointers.
+		unsigned int walk_stack(const void **frames, const void *context) throw()
+		{
+			const auto &mc = static_cast<const ucontext_t *>(context)->uc_mcontext;
+#if defined(__x86_64__)
+			const auto pc = reinterpret_cast<const void *>(mc.gregs[REG_RIP]);
+			auto fp = reinterpret_cast<const void * const *>(mc.gregs[REG_RBP]);
+			auto lower = reinterpret_cast<const byte *>(mc.gregs[REG_RSP]);
+#elif defined(__i386__)
+			const auto pc = reinterpret_cast<const void *>(mc.gregs[REG_EIP]);
+			auto fp = reinterpret_cast<const void * const *>(mc.gregs[REG_EBP]);
+			auto lower = reinterpret_cast<const byte *>(mc.gregs[REG_ESP]);
+#elif defined(__aarch64__)
+			const auto pc = reinterpret_cast<const void *>(mc.pc);
+			auto fp = reinterpret_cast<const void * const *>(mc.regs[29]);
+			auto lower = reinterpret_cast<const byte *>(mc.sp);
+#else
+			const void *pc = nullptr;
+			const void * const *fp = nullptr;
+			const byte *lower = nullptr;
+#endif
+			unsigned int depth = 0;
+
+			if (pc)
+				frames[depth++] = pc;
+			while (depth != sampler::max_depth)
+			{
+				const auto frame = reinterpret_cast<const byte *>(fp);
+				const void *record[2];
+
+				// A frame record is {	previous frame pointer, return address	} and frames only grow up the stack.
+				if (frame < lower || static_cast<size_t>(frame - lower) > c_max_frame_size
+					|| reinterpret_cast<size_t>(frame) % sizeof(void *) || !read_frame(record, fp) || !record[0]
+					|| !record[1])
+				{
+					break;
+				}
+				frames[depth++] = static_cast<const byte *>(record[1]) - 1; // Points inside the call instruction.
+				lower = frame + 2 * sizeof(void *);
+				fp = static_cast<const void * const *>(record[0]);
+			}
+			return depth;
+		}
+	}
+
+	sampler::sampler(thread_monitor &thread_monitor_, module &module_helper, unsigned int frequency,
+			calls_collector_i *instrumented)
+		: _thread_monitor(thread_monitor_), _module_helper(module_helper), _instrumented(instrumented),
+			_period(ticks_per_second() / frequency), _samples(new sample[capacity]), _head(0), _dropped(0), _tail(0)
+	{
+		const auto period_ns = 1000000000ll / frequency;
+		struct sigaction action = {};
+		sigevent event = {};
+		itimerspec interval = {};
+		sampler *expected = nullptr;
+
+		for (unsigned int i = 0; i != capacity; ++i)
+			_samples[i].sequence.store(i, memory_order_relaxed);
+		if (!g_sampler.compare_exchange_strong(expected, this))
+			throw logic_error("another sampler is already running");
+		action.sa_sigaction = &sampler::on_signal;
+		action.sa_flags = SA_SIGINFO | SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		event.sigev_notify = SIGEV_SIGNAL;
+		event.sigev_signo = SIGPROF;
+		if (::sigaction(SIGPROF, &action, nullptr) || ::timer_create(CLOCK_PROCESS_CPUTIME_ID, &event, &_timer))
+		{
+			g_sampler = nullptr;
+			throw runtime_error("cannot start a sampling timer");
+		}
+		interval.it_value.tv_sec = interval.it_interval.tv_sec = period_ns / 1000000000;
+		interval.it_value.tv_nsec = interval.it_interval.tv_nsec = period_ns % 1000000000;
+		::timer_settime(_timer, 0, &interval, nullptr);
+	}
+
+	sampler::~sampler()
+	{
+		::timer_delete(_timer);
+
+		// The handler is left installed - it ignores the signals still pending, once no sampler is running.
+		g_sampler = nullptr;
+		while (g_capturing)
+		{	}
+	}
+
+	count_t sampler::dropped() const throw()
+	{	return _dropped;	}
+
+	void sampler::read_collected(acceptor &a)
+	{	read_collected(a, 0, 1);	}
+
+	void sampler::read_collected(acceptor &a, unsigned int partition, unsigned int partitions)
+	{
+		if (_instrumented)
+		{
+			discarding_acceptor d;
+
+			_instrumented->read_collected(d, partition, partitions);
+		}
+		if (!partition)
+			read_samples(a);
+	}
+
+	void sampler::flush()
+	{
+		if (_instrumented)
+			_instrumented->flush();
+	}
+
+	void sampler::on_signal(int /*signo*/, siginfo_t * /*info*/, void *context)
+	{
+		const auto errno_ = errno;
+
+		++g_capturing;
+		if (const auto self = g_sampler.load())
+			self->capture(context);
+		--g_capturing;
+		errno = errno_;
+	}
+
+	void sampler::capture(const void *context) throw()
+	{
+		auto position = _head.load(memory_order_relaxed);
+		sample *s;
+
+		for (;;)
+		{
+			s = &_samples[position & (capacity - 1)];
+
+			const auto difference = static_cast<int>(s->sequence.load(memory_order_acquire) - position);
+
+			if (!difference)
+			{
+				if (_head.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0)
+			{
+				_dropped.fetch_add(1, memory_order_relaxed);
+				return;
+			}
+			else
+			{
+				position = _head.load(memory_order_relaxed);
+			}
+		}
+		s->native_id = static_cast<unsigned int>(::syscall(SYS_gettid));
+		s->depth = walk_stack(s->frames, context);
+		s->sequence.store(position + 1, memory_order_release);
+	}
+
+	void sampler::read_samples(acceptor &a)
+	{
+		for (;; ++_tail)
+		{
+			auto &s = _samples[_tail & (capacity - 1)];
+
+			if (s.sequence.load(memory_order_acquire) != _tail + 1)
+				break;
+			translate(s);
+			s.sequence.store(_tail + capacity, memory_order_release);
+		}
+		for (auto i = _threads.begin(); i != _threads.end(); ++i)
+		{
+			auto &pending = i->second.pending;
+
+			if (pending.empty())
+				continue;
+			a.accept_calls(i->second.thread_id, pending.data(), pending.size());
+			pending.clear();
+		}
+	}
+
+	void sampler::translate(const sample &s)
+	{
+		auto i = _threads.find(s.native_id);
+
+		if (i == _threads.end())
+		{
+			thread_trace t = {
+				_thread_monitor.register_external(s.native_id, this_process::open_thread_info(s.native_id)), 0,
+			};
+
+			i = _threads.insert(make_pair(s.native_id, t)).first;
+		}
+
+		auto &t = i->second;
+		size_t common = 0;
+
+		_frames.clear();
+		for (auto j = s.frames + s.depth; j != s.frames; )
+			_frames.push_back(resolve(*--j));
+		while (common != t.stack.size() && common != _frames.size() && t.stack[common] == _frames[common])
+			common++;
+		for (auto n = t.stack.size(); n != common; --n)
+		{
+			const call_record exit = {	t.time, nullptr	};
+
+			t.pending.push_back(exit);
+		}
+		for (auto j = _frames.begin() + common; j != _frames.end(); ++j)
+		{
+			const call_record enter = {	t.time, *j	};
+
+			t.pending.push_back(enter);
+		}
+		t.stack.swap(_frames);
+		t.time += _period;
+	}
+
+	const void *sampler::resolve(const void *address)
+	{
+		const auto i = _functions.find(address);
+
+		if (i != _functions.end())
+			return i->second;
+
+		const auto m = _module_helper.locate(address);
+		auto function = address;
+
+		if (m.base)
+		{
+			auto &functions = _modules[m.base];
+
+			if (!functions)
+			{
+				functions = make_shared<functions_t>();
+				try
+				{
+					load_image_info(m.path)->enumerate_functions([&functions] (const symbol_info &symbol) {
+						functions->push_back(make_pair(symbol.rva, symbol.size));
+					});
+				}
+				catch (const exception &e)
+				{
+					LOG(PREAMBLE "failed to read module symbols...") % A(m.path) % A(e.what());
+				}
+				sort(functions->begin(), functions->end());
+			}
+
+			const auto rva = static_cast<unsigned int>(static_cast<const byte *>(address) - m.base);
+			auto j = upper_bound(functions->begin(), functions->end(), make_pair(rva, ~0u));
+
+			if (j != functions->begin() && rva - (--j)->first < (max)(j->second, 1u))
+				function = m.base + j->first;
+		}
+		return _functions[address] = function;
+	}
+}
@@ -54,6 +54,23 @@ namespace micro_profiler
 		return lti.thread_info_entry->first;
 	}
 
+	thread_monitor::thread_id thread_monitor::register_external(native_thread_id native_id,
+		const function<void (thread_info &info)> &accessor)
+	{
+		mt::lock_guard<mt::mutex> lock(_mutex);
+		const auto i = _alive_threads.insert(make_pair(native_id, live_thread_info()));
+		auto &lti = i.first->second;
+
+		if (i.second)
+		{
+			thread_info ti = {	native_id, string(), mt::milliseconds(0), mt::milliseconds(0), mt::milliseconds(0), false	};
+
+			(lti.accessor = accessor)(ti);
+			lti.thread_info_entry = &*_threads.insert(make_pair(_next_id++, ti)).first;
+		}
+		return lti.thread_info_entry->first;
+	}
+
 	void thread_monitor::update_live_info(thread_info &info, native_thread_id native_id) const
 	{
 		const auto i = _alive_threads.find(native_id);
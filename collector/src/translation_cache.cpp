@@ -0,0 +1,162 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <collector/translation_cache.h>
+
+#include <collector/module_tracker.h>
+#include <common/file_stream.h>
+#include <common/formatting.h>
+#include <stdio.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	translation_cache::translation_cache(mapping_access &mappings)
+		: _mapping_subscription(mappings.notify(*this))
+	{	}
+
+	translation_plan translation_cache::get_plan(void *target, size_t size)
+	{
+		const auto target_ = static_cast<const byte *>(target);
+		const auto function = const_byte_range(target_, size);
+		mt::lock_guard<mt::mutex> l(_mtx);
+		auto i = _images.upper_bound(target_);
+
+		if (i == _images.begin() || !get_hash((--i)->second))
+			return plan_translation(function);
+
+		auto &e = _plans[make_tuple(i->second.hash, static_cast<unsigned int>(target_ - i->first))];
+
+		if (e.size != size || (!e.plan.prologue_size && e.plan.error.empty()))
+			e.size = static_cast<unsigned int>(size), e.plan = plan_translation(function);
+		e.used = true;
+		return e.plan;
+	}
+
+	bool translation_cache::load(const string &path, const string &key)
+	{
+		string content;
+
+		try
+		{
+			content = read_file(path);
+		}
+		catch (const exception &)
+		{
+			return false;
+		}
+
+		auto eol = content.find('\n');
+		map<plan_key, plan_entry> plans;
+
+		if (eol == string::npos || content.compare(0, eol, key))
+			return false;
+		for (size_t line = eol + 1; line != content.size(); line = eol + 1)
+		{
+			unsigned int hash, rva, size, prologue_size;
+			int length = 0;
+
+			// A file written partially by a concurrent process fails the format check.
+			eol = content.find('\n', line);
+			if (eol == string::npos
+				|| 4 != sscanf(content.c_str() + line, "%x %x %u %u%n", &hash, &rva, &size, &prologue_size, &length)
+				|| line + length >= eol || ' ' != content[line + length] || prologue_size > 0xFF)
+			{
+				return false;
+			}
+
+			auto &e = plans[make_tuple(hash, rva)];
+
+			e.size = size;
+			e.plan.prologue_size = static_cast<byte>(prologue_size);
+			e.plan.error = content.substr(line + length + 1, eol - line - length - 1);
+			e.used = false;
+		}
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		for (auto i = plans.begin(); i != plans.end(); ++i)
+			_plans.insert(*i);
+		return true;
+	}
+
+	void translation_cache::store(const string &path, const string &key) const
+	{
+		auto content = key;
+
+		content += '\n';
+		{
+			mt::lock_guard<mt::mutex> l(_mtx);
+
+			for (auto i = _plans.begin(); i != _plans.end(); ++i)
+			{
+				if (!i->second.used)
+					continue;
+				itoa<16>(content, get<0>(i->first)), content += ' ';
+				itoa<16>(content, get<1>(i->first)), content += ' ';
+				itoa<10>(content, i->second.size), content += ' ';
+				itoa<10>(content, i->second.plan.prologue_size), content += ' ';
+				for (auto c = i->second.plan.error.begin(); c != i->second.plan.error.end(); ++c)
+					content += *c != '\n' ? *c : ' ';
+				content += '\n';
+			}
+		}
+		write_file_stream(path).write(content.data(), content.size());
+	}
+
+	void translation_cache::mapped(id_t /*module_id*/, id_t mapping_id, const module::mapping &mapping)
+	{
+		image i = {	mapping_id, mapping.path, 0, not_hashed	};
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		_images[mapping.base] = i;
+	}
+
+	void translation_cache::unmapped(id_t mapping_id)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		for (auto i = _images.begin(); i != _images.end(); ++i)
+		{
+			if (i->second.mapping_id == mapping_id)
+			{
+				_images.erase(i);
+				break;
+			}
+		}
+	}
+
+	bool translation_cache::get_hash(image &image_)
+	{
+		if (not_hashed == image_.state)
+		{
+			try
+			{
+				image_.hash = module_tracker::calculate_hash(image_.path);
+				image_.state = hashed;
+			}
+			catch (const exception &)
+			{
+				image_.state = unhashable;
+			}
+		}
+		return hashed == image_.state;
+	}
+}
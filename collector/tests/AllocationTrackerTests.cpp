@@ -0,0 +1,162 @@
+#include <collector/allocation_tracker.h>
+
+#include "helpers.h"
+#include "mocks.h"
+#include "mocks_allocator.h"
+
+#include <collector/calls_collector.h>
+#include <stdexcept>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			struct trace_acceptor : calls_collector_i::acceptor
+			{
+				virtual void accept_calls(unsigned /*threadid*/, const call_record *calls, size_t count) override
+				{	trace.insert(trace.end(), calls, calls + count);	}
+
+				virtual void accept_calls(unsigned /*threadid*/, const compact_call_record *calls, size_t count,
+					const callee_table &callees) override
+				{
+					trace.insert(trace.end(), compact_trace_iterator(calls, calls + count, decoder, callees),
+						compact_trace_iterator(calls + count));
+				}
+
+				virtual void accept_dropped(unsigned /*threadid*/, count_t /*count*/) override
+				{	}
+
+				virtual void accept_exited(unsigned /*threadid*/) override
+				{	}
+
+				vector<call_record> trace;
+				compact_decoder decoder;
+			};
+		}
+
+		begin_test_suite( AllocationTrackerTests )
+			virtual_stack vstack;
+			mocks::thread_monitor threads;
+			mocks::thread_callbacks tcallbacks;
+			mocks::allocator allocator_;
+			unique_ptr<calls_collector> collector;
+
+			init( ConstructCollector )
+			{	collector.reset(new calls_collector(allocator_, 1000, threads, tcallbacks));	}
+
+
+			test( OnlyASingleTrackerCanExistAtATime )
+			{
+				// INIT
+				unique_ptr<allocation_tracker> t(new allocation_tracker(*collector));
+
+				// ACT / ASSERT
+				assert_throws(allocation_tracker t2(*collector), logic_error);
+
+				// INIT
+				t.reset();
+
+				// ACT / ASSERT (does not throw)
+				allocation_tracker t3(*collector);
+			}
+
+
+			test( AllocationsAreWrittenBeforeTheNextEntryOrExit )
+			{
+				// INIT
+				allocation_tracker t(*collector);
+				trace_acceptor a;
+
+				// ACT
+				vstack.on_enter(*collector, 1000, addr(0x1000));
+					allocation_tracker::on_allocation(10);
+					allocation_tracker::on_allocation(22);
+					vstack.on_enter(*collector, 1010, addr(0x2000));
+						allocation_tracker::on_allocation(5);
+					vstack.on_exit(*collector, 1020);
+				vstack.on_exit(*collector, 1030);
+				collector->flush();
+				collector->read_collected(a);
+
+				// ASSERT
+				call_record reference[] = {
+					{	1000, addr(0x1000)	},
+						{	2, allocations_tag	}, {	32, allocated_bytes_tag	},
+						{	1010, addr(0x2000)	},
+							{	1, allocations_tag	}, {	5, allocated_bytes_tag	},
+						{	1020, nullptr	},
+					{	1030, nullptr	},
+				};
+
+				assert_equal(reference, a.trace);
+			}
+
+
+			test( AllocationsAreNotTrackedWithoutATrackerOrBeforeAThreadHasATrace )
+			{
+				// INIT
+				trace_acceptor a;
+
+				// ACT
+				{
+					allocation_tracker t(*collector);
+
+					allocation_tracker::on_allocation(100);
+				}
+				vstack.on_enter(*collector, 1000, addr(0x1000));
+					allocation_tracker::on_allocation(7);
+				vstack.on_exit(*collector, 1010);
+				collector->flush();
+				collector->read_collected(a);
+
+				// ASSERT
+				call_record reference[] = {
+					{	1000, addr(0x1000)	},
+					{	1010, nullptr	},
+				};
+
+				assert_equal(reference, a.trace);
+			}
+
+
+			test( ShortLeafCallsThatHaveAllocatedAreNotFolded )
+			{
+				// INIT
+				allocation_tracker t(*collector);
+				trace_acceptor a;
+
+				collector->set_buffering_policy(buffering_policy(1000, 1, 1,
+					buffering_policy::block_on_overflow, buffering_policy::buffer_size, buffering_policy::buffer_size, 100));
+
+				// ACT
+				vstack.on_enter(*collector, 1000, addr(0x1000));
+					vstack.on_enter(*collector, 1010, addr(0x2000));
+						allocation_tracker::on_allocation(8);
+					vstack.on_exit(*collector, 1020);
+					vstack.on_enter(*collector, 1030, addr(0x2000));
+					vstack.on_exit(*collector, 1040);
+				vstack.on_exit(*collector, 5000);
+				collector->flush();
+				collector->read_collected(a);
+
+				// ASSERT
+				call_record reference[] = {
+					{	1000, addr(0x1000)	},
+						{	1010, addr(0x2000)	},
+							{	1, allocations_tag	}, {	8, allocated_bytes_tag	},
+						{	1020, nullptr	},
+						{	1, folded_calls_tag	}, {	1030, addr(0x2000)	}, {	1040, nullptr	},
+					{	5000, nullptr	},
+				};
+
+				assert_equal(reference, a.trace);
+			}
+		end_test_suite
+	}
+}
@@ -226,6 +226,445 @@ namespace micro_profiler
 				// ASSERT
 				assert_is_true(a.has_data());
 			}
+
+
+			test( DroppedRecordsAreAccumulatedPerThreadAndResetOnClear )
+			{
+				// INIT
+				analyzer a(overhead(0, 0));
+				calls_collector_i::acceptor &as_acceptor(a);
+
+				// ACT
+				as_acceptor.accept_dropped(111888, 384);
+				as_acceptor.accept_dropped(111889, 17);
+				as_acceptor.accept_dropped(111888, 100);
+
+				// ASSERT
+				assert_is_true(a.has_data());
+				assert_equal(484u, find_by_first(a, 111888u)->dropped());
+				assert_equal(17u, find_by_first(a, 111889u)->dropped());
+
+				// ACT
+				a.clear();
+
+				// ASSERT
+				assert_is_false(a.has_data());
+				assert_equal(0u, find_by_first(a, 111888u)->dropped());
+				assert_equal(0u, find_by_first(a, 111889u)->dropped());
+			}
+
+
+			test( CallsInProgressAreDiscardedOnDroppedRecords )
+			{
+				// INIT
+				analyzer a(overhead(0, 0));
+				call_record trace1[] = {
+					{	12300, addr(1234)	},
+						{	12305, addr(2234)	},
+				};
+				call_record trace2[] = {
+						{	12400, addr(3234)	},
+						{	12410, addr(0)	},
+					{	12415, addr(0)	},
+				{	12420, addr(0)	},
+				{	12430, addr(3234)	},
+				{	12431, addr(0)	},
+				};
+
+				a.accept_calls(111888, trace1, array_size(trace1));
+
+				// ACT
+				a.accept_dropped(111888, 1000);
+				a.accept_calls(111888, trace2, array_size(trace2));
+
+				// ASSERT
+				assert_equivalent(plural
+					+ make_statistics(addr(1234), 0, 0, 0, 0, 0, plural
+						+ make_statistics(addr(2234), 0, 0, 0, 0, 0))
+					+ make_statistics(addr(3234), 2, 0, 11, 11, 10),
+					*find_by_first(a, 111888u));
+			}
+
+
+			test( CompactCallsAreDecodedWithTheCalleesTableProvided )
+			{
+				// INIT
+				analyzer a(overhead(0, 0));
+				callee_table callees;
+				const auto i1 = callees.index_of(addr(1234));
+				const auto i2 = callees.index_of(addr(2234));
+				compact_call_record trace1[] = {
+					{	0, compact_call_record::rebase_tag	}, {	12300, 0	},
+					{	0, i1	},
+						{	5, i2	},
+						{	5, compact_call_record::exit_tag	},
+					{	7, compact_call_record::exit_tag	},
+					{	3, compact_call_record::escape_tag	},
+				};
+				compact_call_record trace2[] = {
+					{	3234, 0	},
+					{	4, compact_call_record::exit_tag	},
+				};
+
+				// ACT
+				a.accept_calls(111888, trace1, array_size(trace1), callees);
+				a.accept_calls(111888, trace2, array_size(trace2), callees);
+
+				// ASSERT
+				assert_equivalent(plural
+					+ make_statistics(addr(1234), 1, 0, 17, 12, 17, plural
+						+ make_statistics(addr(2234), 1, 0, 5, 5, 5))
+					+ make_statistics(addr(3234), 1, 0, 4, 4, 4),
+					*find_by_first(a, 111888u));
+			}
+
+
+			test( MergingMovesStatisticsOfAllThreadsAndLeavesStackStatesIntact )
+			{
+				// INIT
+				analyzer a1(overhead(0, 0)), a2(overhead(0, 0));
+				call_record trace1[] = {
+					{	10, addr(1234)	},
+					{	15, addr(0)	},
+				};
+				call_record trace2[] = {
+					{	20, addr(1234)	},
+					{	27, addr(0)	},
+					{	30, addr(2234)	},
+				};
+				call_record trace3[] = {
+					{	31, addr(0)	},
+				};
+
+				a1.accept_calls(1u, trace1, array_size(trace1));
+				a2.accept_calls(1u, trace2, array_size(trace2));
+				a2.accept_dropped(2u, 3);
+				a2.accept_calls(2u, trace1, array_size(trace1));
+
+				// ACT
+				a1.merge(a2);
+
+				// ASSERT
+				assert_equal(2, distance(a1.begin(), a1.end()));
+				assert_equivalent(plural
+					+ make_statistics(addr(1234), 2, 0, 12, 12, 7)
+					+ make_statistics(addr(2234), 0, 0, 0, 0, 0),
+					*find_by_first(a1, 1u));
+				assert_equivalent(plural
+					+ make_statistics(addr(1234), 1, 0, 5, 5, 5),
+					*find_by_first(a1, 2u));
+				assert_equal(0u, find_by_first(a1, 1u)->dropped());
+				assert_equal(3u, find_by_first(a1, 2u)->dropped());
+				assert_is_false(a2.has_data());
+
+				// ACT
+				a2.accept_calls(1u, trace3, array_size(trace3));
+				a1.merge(a2);
+
+				// ASSERT
+				assert_equivalent(plural
+					+ make_statistics(addr(1234), 2, 0, 12, 12, 7)
+					+ make_statistics(addr(2234), 1, 0, 1, 1, 1),
+					*find_by_first(a1, 1u));
+				assert_is_false(a2.has_data());
+			}
+
+
+			test( ChangesContainNodesCreatedAndStatisticsAccumulatedSinceThePreviousRequest )
+			{
+				// INIT
+				analyzer a(overhead(0, 0));
+				statistics_delta d;
+				call_record trace1[] = {
+					{	10, addr(1234)	},
+						{	12, addr(2234)	},
+						{	15, addr(0)	},
+					{	20, addr(0)	},
+					{	21, addr(3234)	},
+				};
+				call_record trace2[] = {
+						{	22, addr(2234)	},
+						{	25, addr(0)	},
+					{	30, addr(0)	},
+				};
+
+				a.accept_calls(1u, trace1, array_size(trace1));
+
+				// ACT
+				a.get_changes(d);
+
+				// ASSERT
+				assert_equal(1u, d.size());
+				assert_not_null(find_by_first(d, 1u));
+				assert_equal(plural
+					+ make_created_node(0, 1234, 1, 10, 7, 10)
+					+ make_created_node(1, 2234, 1, 3, 3, 3)
+					+ make_created_node(0, 3234, 0, 0, 0, 0), find_by_first(d, 1u)->created);
+				assert_is_empty(find_by_first(d, 1u)->updated);
+				assert_equivalent(plural
+					+ make_statistics(addr(1234), 0, 0, 0, 0, 0, plural
+						+ make_statistics(addr(2234), 0, 0, 0, 0, 0))
+					+ make_statistics(addr(3234), 0, 0, 0, 0, 0),
+					*find_by_first(a, 1u));
+
+				// INIT
+				a.accept_calls(1u, trace2, array_size(trace2));
+				a.accept_dropped(2u, 3);
+
+				// ACT
+				a.get_changes(d);
+
+				// ASSERT
+				assert_equal(2u, d.size());
+				assert_equal(plural
+					+ make_created_node(3, 2234, 1, 3, 3, 3), find_by_first(d, 1u)->created);
+				assert_equal(plural
+					+ make_pair(3u, function_statistics(1, 9, 6, 9)), find_by_first(d, 1u)->updated);
+				assert_is_empty(find_by_first(d, 2u)->created);
+				assert_equal(0u, find_by_first(a, 2u)->dropped());
+
+				// ACT
+				a.get_changes(d);
+
+				// ASSERT
+				assert_equal(2u, d.size());
+				assert_is_empty(find_by_first(d, 1u)->created);
+				assert_is_empty(find_by_first(d, 1u)->updated);
+			}
+
+
+			test( OnlyNodesCalledSinceThePreviousRequestAreReportedAsUpdated )
+			{
+				// INIT
+				analyzer a(overhead(0, 0));
+				statistics_delta d;
+				call_record trace1[] = {
+					{	10, addr(1234)	},
+					{	12, addr(0)	},
+					{	20, addr(2234)	},
+					{	21, addr(0)	},
+					{	30, addr(3234)	},
+					{	33, addr(0)	},
+				};
+				call_record trace2[] = {
+					{	40, addr(3234)	},
+					{	44, addr(0)	},
+					{	50, addr(1234)	},
+					{	55, addr(0)	},
+				};
+
+				a.accept_calls(1u, trace1, array_size(trace1));
+				a.get_changes(d);
+				a.accept_calls(1u, trace2, array_size(trace2));
+
+				// ACT
+				a.get_changes(d);
+
+				// ASSERT
+				assert_is_empty(find_by_first(d, 1u)->created);
+				assert_equivalent(plural
+					+ make_pair(1u, function_statistics(1, 5, 5, 5))
+					+ make_pair(3u, function_statistics(1, 4, 4, 4)), find_by_first(d, 1u)->updated);
+
+				// INIT
+				a.accept_calls(1u, trace2, 2);
+
+				// ACT
+				a.get_changes(d);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair(3u, function_statistics(1, 4, 4, 4)), find_by_first(d, 1u)->updated);
+			}
+
+
+			test( ExitedThreadsAreListedAndDroppedAfterTheirFinalChangesAreTaken )
+			{
+				// INIT
+				analyzer a(overhead(0, 0));
+				calls_collector_i::acceptor &as_acceptor(a);
+				statistics_delta d;
+				exited_threads e;
+				call_record trace[] = {
+					{	10, addr(1234)	},
+					{	13, addr(0)	},
+				};
+
+				a.accept_calls(1u, trace, array_size(trace));
+				a.accept_calls(2u, trace, array_size(trace));
+				a.accept_calls(3u, trace, array_size(trace));
+
+				// ACT
+				as_acceptor.accept_exited(3u);
+				as_acceptor.accept_exited(1u);
+				as_acceptor.accept_exited(17u);
+				a.get_exited(e);
+
+				// ASSERT
+				assert_equivalent(plural + 1u + 3u, e);
+				assert_equal(3, distance(a.begin(), a.end()));
+
+				// ACT
+				a.get_changes(d);
+
+				// ASSERT
+				assert_equal(3u, d.size());
+				assert_equal(plural
+					+ make_created_node(0, 1234, 1, 3, 3, 3), find_by_first(d, 1u)->created);
+				assert_equal(plural
+					+ make_created_node(0, 1234, 1, 3, 3, 3), find_by_first(d, 3u)->created);
+				assert_equal(1, distance(a.begin(), a.end()));
+				assert_not_null(find_by_first(a, 2u));
+
+				// ACT
+				a.get_exited(e);
+				a.get_changes(d);
+
+				// ASSERT
+				assert_is_empty(e);
+				assert_equal(1u, d.size());
+			}
+
+
+			test( ExitedThreadsAreDroppedOnClear )
+			{
+				// INIT
+				analyzer a(overhead(0, 0));
+				call_record trace[] = {
+					{	10, addr(1234)	},
+					{	13, addr(0)	},
+				};
+
+				a.accept_calls(1u, trace, array_size(trace));
+				a.accept_calls(2u, trace, array_size(trace));
+				a.accept_exited(2u);
+
+				// ACT
+				a.clear();
+
+				// ASSERT
+				assert_equal(1, distance(a.begin(), a.end()));
+				assert_not_null(find_by_first(a, 1u));
+			}
+
+
+			test( ExitedThreadsAreMovedOnMergeKeepingTheirExitedState )
+			{
+				// INIT
+				analyzer a1(overhead(0, 0)), a2(overhead(0, 0));
+				statistics_delta d;
+				exited_threads e;
+				call_record trace[] = {
+					{	10, addr(1234)	},
+					{	13, addr(0)	},
+				};
+
+				a1.accept_calls(1u, trace, array_size(trace));
+				a2.accept_calls(1u, trace, array_size(trace));
+				a2.accept_calls(2u, trace, array_size(trace));
+				a2.accept_exited(1u);
+
+				// ACT
+				a1.merge(a2);
+				a1.get_exited(e);
+
+				// ASSERT
+				assert_equal(plural + 1u, e);
+				assert_null(find_by_first(a2, 1u));
+				assert_not_null(find_by_first(a2, 2u));
+				assert_equivalent(plural
+					+ make_statistics(addr(1234), 2, 0, 6, 6, 3),
+					*find_by_first(a1, 1u));
+
+				// ACT
+				a1.get_changes(d);
+
+				// ASSERT
+				assert_equal(2u, d.size());
+				assert_null(find_by_first(a1, 1u));
+			}
+
+
+			test( AllNodesAreReportedAsCreatedAfterChangesAreRewound )
+			{
+				// INIT
+				analyzer a(overhead(0, 0));
+				statistics_delta d;
+				call_record trace1[] = {
+					{	10, addr(1234)	},
+						{	12, addr(2234)	},
+						{	15, addr(0)	},
+					{	20, addr(0)	},
+				};
+				call_record trace2[] = {
+					{	22, addr(1234)	},
+					{	25, addr(0)	},
+				};
+
+				a.accept_calls(1u, trace1, array_size(trace1));
+				a.get_changes(d);
+				a.accept_calls(1u, trace2, array_size(trace2));
+
+				// ACT
+				a.rewind_changes();
+				a.get_changes(d);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_created_node(0, 1234, 1, 3, 3, 3)
+					+ make_created_node(1, 2234, 0, 0, 0, 0), find_by_first(d, 1u)->created);
+				assert_is_empty(find_by_first(d, 1u)->updated);
+
+				// ACT
+				a.get_changes(d);
+
+				// ASSERT
+				assert_is_empty(find_by_first(d, 1u)->created);
+				assert_is_empty(find_by_first(d, 1u)->updated);
+			}
+
+
+			test( LockContentionOfAllThreadsIsCollectedMergedAndResetAfterRequest )
+			{
+				// INIT
+				analyzer a1(overhead(0, 0)), a2(overhead(0, 0));
+				lock_contention c;
+				call_record trace1[] = {
+					{	10, addr(1234)	},
+						{	0x5000, lock_wait_tag	}, {	11, addr(100)	}, {	15, addr(0)	},
+						{	0x5000, lock_wait_tag	}, {	16, addr(100)	}, {	17, addr(0)	},
+					{	20, addr(0)	},
+				};
+				call_record trace2[] = {
+					{	10, addr(2234)	},
+						{	0x6000, lock_wait_tag	}, {	11, addr(101)	}, {	30, addr(0)	},
+					{	40, addr(0)	},
+				};
+
+				a1.accept_calls(1u, trace1, array_size(trace1));
+				a2.accept_calls(2u, trace2, array_size(trace2));
+				a2.accept_calls(3u, trace1, array_size(trace1));
+
+				// ACT
+				a1.merge(a2);
+				a1.get_lock_contention(c);
+
+				// ASSERT
+				assert_equal(3u, c.size());
+				assert_equal(2u, find_by_first(c, 0x5000u)->contentions);
+				assert_equal(5u, find_by_first(c, 0x5000u)->time_blocked);
+				assert_equal(1u, find_by_first(c, 0x6000u)->contentions);
+				assert_equal(19u, find_by_first(c, 0x6000u)->time_blocked);
+				assert_equal(2, count_if(c.begin(), c.end(), [] (const pair<long_address_t, lock_statistics> &e) {
+					return e.first == 0x5000u;
+				}));
+
+				// ACT
+				a1.get_lock_contention(c);
+
+				// ASSERT
+				assert_is_empty(c);
+			}
 		end_test_suite
 	}
 }
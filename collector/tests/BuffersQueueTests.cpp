@@ -2,6 +2,8 @@
 
 #include "mocks_allocator.h"
 
+#include <atomic>
+#include <mt/thread.h>
 #include <test-helpers/helpers.h>
 #include <ut/assert.h>
 #include <ut/test.h>
@@ -46,6 +48,214 @@ namespace micro_profiler
 				assert_equal(1177u, q1.get_id());
 				assert_equal(1977u, q2.get_id());
 			}
+
+
+			test( RecordsAreDroppedAndCountedWhenNoEmptyBuffersAreAvailableInDropMode )
+			{
+				// INIT
+				buffers_queue<int> q(al, buffering_policy(2 * buffering_policy::buffer_size, 0, 0,
+					buffering_policy::drop_on_overflow), 13);
+				vector< pair<unsigned, size_t> > read;
+				vector< pair<unsigned, count_t> > dropped;
+				auto reader = [&] (unsigned id, const int *, size_t n) {	read.push_back(make_pair(id, n));	};
+				auto drop_reader = [&] (unsigned id, count_t n) {	dropped.push_back(make_pair(id, n));	};
+
+				// ACT (the single spare buffer is taken, the following ones are dropped)
+				fill_buffer(q, 4 * buffering_policy::buffer_size + 10);
+				q.flush();
+				q.read_collected(reader, drop_reader);
+
+				// ASSERT
+				pair<unsigned, size_t> reference1[] = {	make_pair(13u, (size_t)buffering_policy::buffer_size),	};
+
+				assert_equal(reference1, read);
+				assert_is_empty(dropped);
+
+				// ACT (a spare buffer is now available - the loss is reported before the records that follow it)
+				fill_buffer(q, 7);
+				q.flush();
+				q.read_collected(reader, drop_reader);
+
+				// ASSERT
+				pair<unsigned, size_t> reference2[] = {
+					make_pair(13u, (size_t)buffering_policy::buffer_size), make_pair(13u, (size_t)7),
+				};
+				pair<unsigned, count_t> reference3[] = {
+					make_pair(13u, (count_t)3 * buffering_policy::buffer_size + 10),
+				};
+
+				assert_equal(reference2, read);
+				assert_equal(reference3, dropped);
+			}
+
+
+			test( ProducerIsNotBlockedByAnEmptyQueueInDropMode )
+			{
+				// INIT
+				buffers_queue<int> q(al, buffering_policy(buffering_policy::buffer_size, 0, 0,
+					buffering_policy::drop_on_overflow), 1);
+
+				// ACT / ASSERT (does not hang)
+				fill_buffer(q, 100 * buffering_policy::buffer_size);
+			}
+
+
+			test( BuffersGrowForAThreadFillingSeveralBuffersPerRead )
+			{
+				// INIT
+				buffers_queue<int> q(al, buffering_policy(100 * buffering_policy::buffer_size, 0.03, 0.03,
+					buffering_policy::block_on_overflow, 64, 1024), 1);
+				vector<size_t> read;
+				auto reader = [&] (unsigned, const int *, size_t n) {	read.push_back(n);	};
+
+				fill_buffer(q, 2 * buffering_policy::buffer_size);
+				q.read_collected(reader);
+				read.clear();
+
+				// ACT (the active buffer and the empty ones allocated before are still of the old size)
+				fill_buffer(q, 3 * buffering_policy::buffer_size);
+				q.read_collected(reader);
+
+				// ASSERT
+				size_t reference1[] = {
+					buffering_policy::buffer_size, buffering_policy::buffer_size, buffering_policy::buffer_size,
+				};
+
+				assert_equal(reference1, read);
+
+				// INIT (the buffers are replaced as they come back)
+				for (auto i = 4; i--; )
+				{
+					fill_buffer(q, 2 * 1024);
+					q.read_collected(reader);
+				}
+				read.clear();
+
+				// ACT (limited by the maximum size)
+				fill_buffer(q, 2 * 1024);
+				q.read_collected(reader);
+
+				// ASSERT
+				size_t reference2[] = {	1024u, 1024u,	};
+
+				assert_equal(reference2, read);
+			}
+
+
+			test( BuffersShrinkForAThreadFillingLessThanABufferPerFourReads )
+			{
+				// INIT
+				buffers_queue<int> q(al, buffering_policy(100 * buffering_policy::buffer_size, 0.03, 0.03,
+					buffering_policy::block_on_overflow, 64, 1024), 1);
+				vector<size_t> read;
+				auto reader = [&] (unsigned, const int *, size_t n) {	read.push_back(n);	};
+
+				// ACT
+				for (auto i = 5; i--; )
+				{
+					for (auto j = 3; j--; )
+						q.read_collected(reader);
+					fill_buffer(q, buffering_policy::buffer_size);
+					q.read_collected(reader);
+				}
+
+				// ASSERT
+				size_t reference1[] = {
+					buffering_policy::buffer_size, buffering_policy::buffer_size, buffering_policy::buffer_size,
+					buffering_policy::buffer_size, buffering_policy::buffer_size,
+				};
+
+				assert_equal(reference1, read);
+
+				// INIT
+				read.clear();
+
+				// ACT
+				for (auto i = 16; i--; )
+					q.read_collected(reader);
+				fill_buffer(q, buffering_policy::buffer_size + buffering_policy::buffer_size / 2);
+
+				// ASSERT
+				assert_is_empty(read);
+
+				// ACT
+				q.read_collected(reader);
+
+				// ASSERT
+				size_t reference2[] = {	buffering_policy::buffer_size, buffering_policy::buffer_size / 2,	};
+
+				assert_equal(reference2, read);
+
+				// INIT
+				read.clear();
+
+				// ACT (limited by the minimum size)
+				for (auto i = 16 * 10; i--; )
+					q.read_collected(reader);
+				fill_buffer(q, buffering_policy::buffer_size / 2 + 64);
+				q.read_collected(reader);
+
+				// ASSERT
+				size_t reference3[] = {	buffering_policy::buffer_size / 2, 64u,	};
+
+				assert_equal(reference3, read);
+			}
+
+
+			test( EmptyBuffersAreNotTakenFromTheProducerWhenResizedInDropMode )
+			{
+				// INIT
+				mocks::allocator allocator_;
+				buffers_queue<int> q(allocator_, buffering_policy(8 * buffering_policy::buffer_size, 0.25, 0.25,
+					buffering_policy::drop_on_overflow, 64, 1024), 1);
+				vector<size_t> read;
+				vector<count_t> dropped;
+				auto reader = [&] (unsigned, const int *, size_t n) {	read.push_back(n);	};
+				auto drop_reader = [&] (unsigned, count_t n) {	dropped.push_back(n);	};
+
+				// INIT (the producer hands a buffer off on every allocator call made while resizing)
+				allocator_.on_operation = [&q] {	fill_buffer(q, q.available());	};
+
+				// ACT (the thread is found cold)
+				q.skip_reads(16);
+				allocator_.on_operation = nullptr;
+				fill_buffer(q, buffering_policy::buffer_size + buffering_policy::buffer_size / 2);
+				q.read_collected(reader, drop_reader);
+
+				// ASSERT (the buffer taken after the shrink is filled up to the new size)
+				size_t reference[] = {	buffering_policy::buffer_size, buffering_policy::buffer_size / 2,	};
+
+				assert_equal(reference, read);
+				assert_is_empty(dropped);
+			}
+
+
+			test( BlockedProducerIsAlwaysResumedByAConcurrentReader )
+			{
+				// INIT
+				const auto n = 200000u;
+				buffers_queue<int> q(al, buffering_policy(2, 0, 0, buffering_policy::block_on_overflow, 1, 1), 1);
+				atomic<bool> done(false);
+				size_t total = 0;
+
+				// INIT / ACT (buffers are recycled while the producer hands off and waits for them)
+				mt::thread reader([&] {
+					while (!done.load())
+					{
+						q.read_collected([&] (unsigned, const int *, size_t n_) {	total += n_;	});
+					}
+					q.read_collected([&] (unsigned, const int *, size_t n_) {	total += n_;	});
+				});
+
+				// ACT (does not hang)
+				fill_buffer(q, n);
+				q.flush();
+				done = true;
+				reader.join();
+
+				// ASSERT
+				assert_equal(n, total);
+			}
 		end_test_suite
 	}
 }
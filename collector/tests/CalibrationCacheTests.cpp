@@ -0,0 +1,180 @@
+#include <collector/calibration_cache.h>
+
+#include "mocks.h"
+
+#include <common/allocator.h>
+#include <common/file_stream.h>
+#include <common/path.h>
+#include <test-helpers/file_helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			void write_file(const string &path, const string &content)
+			{	write_file_stream(path).write(content.data(), content.size());	}
+
+			calibration_info make_info(timestamp_t ticks_per_second_, timestamp_t inner, timestamp_t outer,
+				timestamp_t tracking)
+			{
+				calibration_info info = {	ticks_per_second_, inner, outer, tracking	};
+				return info;
+			}
+		}
+
+		begin_test_suite( CalibrationCacheTests )
+			temporary_directory dir;
+			default_allocator allocator_;
+			mocks::thread_callbacks callbacks;
+
+
+			test( StoredCalibrationIsLoadedForTheMatchingKey )
+			{
+				// INIT
+				const auto path1 = dir.track_file("calibration1.cache");
+				const auto path2 = dir.track_file("calibration2.cache");
+				calibration_info info = {};
+
+				store_calibration(path1, "Intel(R) Xeon;0x1;build=1234abcd", make_info(2100000000, 31, 17, 59));
+				store_calibration(path2, "AMD EPYC;0xa0011d1;build=ffff0000", make_info(3000000000, 7, 19, 23));
+
+				// ACT / ASSERT
+				assert_is_true(load_calibration(info, path1, "Intel(R) Xeon;0x1;build=1234abcd"));
+
+				// ASSERT
+				assert_equal(2100000000u, info.ticks_per_second);
+				assert_equal(31u, info.inner);
+				assert_equal(17u, info.outer);
+				assert_equal(59u, info.tracking);
+
+				// ACT / ASSERT
+				assert_is_true(load_calibration(info, path2, "AMD EPYC;0xa0011d1;build=ffff0000"));
+
+				// ASSERT
+				assert_equal(3000000000u, info.ticks_per_second);
+				assert_equal(7u, info.inner);
+				assert_equal(19u, info.outer);
+				assert_equal(23u, info.tracking);
+			}
+
+
+			test( CalibrationIsNotLoadedForAMismatchingKey )
+			{
+				// INIT
+				const auto path = dir.track_file("calibration.cache");
+				auto info = make_info(1, 2, 3, 4);
+
+				store_calibration(path, "Intel(R) Xeon;0x1;build=1234abcd", make_info(2100000000, 31, 17, 59));
+
+				// ACT / ASSERT
+				assert_is_false(load_calibration(info, path, "Intel(R) Xeon;0x2;build=1234abcd"));
+				assert_is_false(load_calibration(info, path, "Intel(R) Xeon;0x1;build=1234abce"));
+				assert_is_false(load_calibration(info, path, "Intel(R) Xeon;0x1;build=1234abcd;"));
+				assert_is_false(load_calibration(info, path, ""));
+
+				// ASSERT
+				assert_equal(1u, info.ticks_per_second);
+				assert_equal(4u, info.tracking);
+			}
+
+
+			test( MissingOrMalformedCacheIsNotLoaded )
+			{
+				// INIT
+				const auto path = dir.track_file("calibration.cache");
+				calibration_info info;
+
+				// ACT / ASSERT
+				assert_is_false(load_calibration(info, path, "abc"));
+
+				// INIT
+				write_file(path, "abc\n2100000000 31 17");
+
+				// ACT / ASSERT
+				assert_is_false(load_calibration(info, path, "abc"));
+
+				// INIT
+				write_file(path, "abc\n2100000000 31 17 59");
+
+				// ACT / ASSERT
+				assert_is_false(load_calibration(info, path, "abc"));
+
+				// INIT
+				write_file(path, "abc\n2100000000 31 17 59\n1");
+
+				// ACT / ASSERT
+				assert_is_false(load_calibration(info, path, "abc"));
+
+				// INIT
+				write_file(path, "abc\n0 31 17 59\n");
+
+				// ACT / ASSERT
+				assert_is_false(load_calibration(info, path, "abc"));
+
+				// INIT
+				write_file(path, "abc\n2100000000 31 17 59\n");
+
+				// ACT / ASSERT
+				assert_is_true(load_calibration(info, path, "abc"));
+			}
+
+
+			test( CalibrationIsValidOnlyIfRemeasuredValuesAreWithinTolerance )
+			{
+				// INIT
+				const auto cached = make_info(2000000000, 31, 17, 100);
+
+				// ACT / ASSERT
+				assert_is_true(is_calibration_valid(cached, 2000000000, 100));
+				assert_is_true(is_calibration_valid(cached, 1950000000, 80));
+				assert_is_true(is_calibration_valid(cached, 2050000000, 125));
+				assert_is_false(is_calibration_valid(cached, 2100000000, 100));
+				assert_is_false(is_calibration_valid(cached, 1900000000, 100));
+				assert_is_false(is_calibration_valid(cached, 2000000000, 130));
+				assert_is_false(is_calibration_valid(cached, 2000000000, 70));
+			}
+
+
+			test( TrackingOverheadIsMeasured )
+			{
+				// ACT
+				const auto tracking = measure_tracking_overhead(allocator_, callbacks, 1000);
+
+				// ASSERT
+				assert_is_true(tracking > 0u);
+				assert_equal(0u, measure_tracking_overhead(allocator_, callbacks, 0));
+			}
+
+#ifdef __linux__
+			test( CalibrationKeyIdentifiesCollectorBuild )
+			{
+				// INIT
+				const auto path1 = dir.track_file("collector1.so");
+				const auto path2 = dir.track_file("collector2.so");
+				const auto path3 = dir.track_file("collector3.so");
+
+				write_file(path1, "some collector build");
+				write_file(path2, "some collector build");
+				write_file(path3, "another collector build");
+
+				// ACT
+				const auto key1 = calibration_key(path1);
+				const auto key2 = calibration_key(path2);
+				const auto key3 = calibration_key(path3);
+
+				// ASSERT
+				assert_is_false(key1.empty());
+				assert_equal(key1, key2);
+				assert_not_equal(key1, key3);
+				assert_equal(string(), calibration_key(dir.path() & "missing.so"));
+			}
+#endif
+		end_test_suite
+	}
+}
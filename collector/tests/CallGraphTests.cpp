@@ -0,0 +1,206 @@
+#include <collector/call_graph.h>
+
+#include "helpers.h"
+
+#include <test-helpers/comparisons.h>
+#include <test-helpers/helpers.h>
+#include <test-helpers/primitive_helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			typedef call_graph<const void *> graph_type;
+		}
+
+		begin_test_suite( CallGraphTests )
+			test( NewGraphIsEmpty )
+			{
+				// INIT / ACT
+				graph_type g;
+
+				// ACT / ASSERT
+				assert_is_empty(g);
+				assert_equal(0u, g.size());
+				assert_equal(g.begin(), g.end());
+			}
+
+
+			test( CalleesAreIndexedPerParentAndFoundOnceCreated )
+			{
+				// INIT
+				graph_type g;
+
+				// ACT
+				const auto a = g.callee(graph_type::root, addr(0x1000));
+				const auto b = g.callee(graph_type::root, addr(0x2000));
+				const auto aa = g.callee(a, addr(0x1000));
+				const auto ba = g.callee(b, addr(0x1000));
+
+				// ASSERT
+				assert_not_equal(a, b);
+				assert_not_equal(a, aa);
+				assert_not_equal(aa, ba);
+				assert_equal(a, g.callee(graph_type::root, addr(0x1000)));
+				assert_equal(b, g.callee(graph_type::root, addr(0x2000)));
+				assert_equal(aa, g.callee(a, addr(0x1000)));
+				assert_equal(ba, g.callee(b, addr(0x1000)));
+				assert_equal(2u, g.size());
+			}
+
+
+			test( StatisticsAreAccessibleAsATreeOfCallees )
+			{
+				// INIT
+				graph_type g;
+				const auto a = g.callee(graph_type::root, addr(0x1000));
+				const auto b = g.callee(graph_type::root, addr(0x2000));
+
+				// ACT
+				g[a] = function_statistics(1, 10, 7, 10);
+				g[b] = function_statistics(2, 20, 11, 12);
+				g[g.callee(a, addr(0x3000))] = function_statistics(3, 3, 3, 1);
+				g[g.callee(a, addr(0x2000))] = function_statistics(4, 5, 5, 2);
+
+				// ASSERT
+				assert_equivalent(plural
+					+ make_statistics(addr(0x1000), 1, 0, 10, 7, 10, plural
+						+ make_statistics(addr(0x3000), 3, 0, 3, 3, 1)
+						+ make_statistics(addr(0x2000), 4, 0, 5, 5, 2))
+					+ make_statistics(addr(0x2000), 2, 0, 20, 11, 12),
+					g);
+			}
+
+
+			test( NodesRemainAddressableWhenTheGraphGrows )
+			{
+				// INIT
+				graph_type g;
+				vector<unsigned int> indices;
+				auto parent = static_cast<unsigned int>(graph_type::root);
+
+				// ACT
+				for (auto i = 0u; i != 10000u; ++i)
+				{
+					indices.push_back(g.callee(parent, addr(0x1000 + 0x10 * (i % 100))));
+					g[indices.back()].times_called = i;
+					if (i % 100 == 99)
+						parent = indices.back();
+				}
+
+				// ASSERT
+				parent = graph_type::root;
+				for (auto i = 0u; i != 10000u; ++i)
+				{
+					const auto index = g.callee(parent, addr(0x1000 + 0x10 * (i % 100)));
+
+					assert_equal(indices[i], index);
+					assert_equal(i, g[index].times_called);
+					if (i % 100 == 99)
+						parent = index;
+				}
+			}
+
+
+			test( ClearedGraphIsEmpty )
+			{
+				// INIT
+				graph_type g;
+
+				g[g.callee(g.callee(graph_type::root, addr(0x1000)), addr(0x3000))].times_called = 3;
+
+				// ACT
+				g.clear();
+
+				// ASSERT
+				assert_is_empty(g);
+
+				// ACT
+				const auto a = g.callee(graph_type::root, addr(0x1000));
+
+				// ASSERT
+				assert_equal(0u, g[a].times_called);
+				assert_equivalent(plural + make_statistics(addr(0x1000), 0, 0, 0, 0, 0), g);
+			}
+
+
+			test( MergingAddsStatisticsOfMatchingNodesAndCreatesMissingOnes )
+			{
+				// INIT
+				graph_type g1, g2;
+				const auto a1 = g1.callee(graph_type::root, addr(0x1000));
+				const auto b2 = g2.callee(graph_type::root, addr(0x2000));
+				const auto a2 = g2.callee(graph_type::root, addr(0x1000));
+
+				g1[a1] = function_statistics(1, 10, 7, 10);
+				g1[g1.callee(a1, addr(0x3000))] = function_statistics(3, 3, 3, 1);
+				g2[a2] = function_statistics(2, 20, 11, 12);
+				g2[b2] = function_statistics(5, 50, 50, 13);
+				g2[g2.callee(b2, addr(0x3000))] = function_statistics(1, 4, 4, 4);
+				g2[g2.callee(a2, addr(0x3000))] = function_statistics(3, 5, 5, 3);
+
+				// ACT
+				g1.merge(g2);
+
+				// ASSERT
+				assert_equivalent(plural
+					+ make_statistics(addr(0x1000), 3, 0, 30, 18, 12, plural
+						+ make_statistics(addr(0x3000), 6, 0, 8, 8, 3))
+					+ make_statistics(addr(0x2000), 5, 0, 50, 50, 13, plural
+						+ make_statistics(addr(0x3000), 1, 0, 4, 4, 4)),
+					g1);
+			}
+
+
+			test( CallTimesAreKeptPerNodeAndMergedResetAndClearedAlongWithTheStatistics )
+			{
+				// INIT
+				graph_type g1(true), g2(true);
+				const auto a1 = g1.callee(graph_type::root, addr(0x1000));
+				const auto b1 = g1.callee(graph_type::root, addr(0x2000));
+				const auto a2 = g2.callee(graph_type::root, addr(0x1000));
+				const auto c2 = g2.callee(a2, addr(0x3000));
+				call_times_histogram reference1, reference2, times;
+
+				reference1.set_scale(call_times_scale());
+				reference1.add(10, 2);
+				reference1.add(1000, 3);
+				reference2.set_scale(call_times_scale());
+				reference2.add(7);
+
+				// ACT
+				g1.add_call_times(a1, 10, 2);
+				g1.add_call_times(b1, 20, 1);
+				g2.add_call_times(a2, 1000, 3);
+				g2.add_call_times(c2, 7, 1);
+				g1.merge(g2);
+
+				// ASSERT
+				g1.get_call_times(times, a1);
+				assert_equal(vector<count_t>(reference1.begin(), reference1.end()), vector<count_t>(times.begin(), times.end()));
+				g1.get_call_times(times, g1.callee(a1, addr(0x3000)));
+				assert_equal(vector<count_t>(reference2.begin(), reference2.end()), vector<count_t>(times.begin(), times.end()));
+
+				// ACT
+				g1.reset(a1);
+				g1.get_call_times(times, a1);
+
+				// ASSERT
+				assert_equal(vector<count_t>(times.size()), vector<count_t>(times.begin(), times.end()));
+
+				// ACT
+				g1.clear();
+				g1.get_call_times(times, g1.callee(graph_type::root, addr(0x2000)));
+
+				// ASSERT
+				assert_equal(vector<count_t>(times.size()), vector<count_t>(times.begin(), times.end()));
+			}
+		end_test_suite
+	}
+}
@@ -5,6 +5,7 @@
 #include "mocks_allocator.h"
 
 #include <algorithm>
+#include <map>
 #include <test-helpers/helpers.h>
 #include <vector>
 #include <utility>
@@ -28,7 +29,21 @@ namespace micro_profiler
 				virtual void accept_calls(unsigned /*threadid*/, const call_record * /*calls*/, size_t count) override
 				{	read += count;	}
 
+				virtual void accept_calls(unsigned /*threadid*/, const compact_call_record *calls, size_t count,
+					const callee_table &callees) override
+				{
+					read += distance(compact_trace_iterator(calls, calls + count, decoder, callees),
+						compact_trace_iterator(calls + count));
+				}
+
+				virtual void accept_dropped(unsigned /*threadid*/, count_t /*count*/) override
+				{	}
+
+				virtual void accept_exited(unsigned /*threadid*/) override
+				{	}
+
 				size_t &read;
+				compact_decoder decoder;
 			};
 
 			struct collection_acceptor : calls_collector_i::acceptor
@@ -44,8 +59,24 @@ namespace micro_profiler
 					total_entries += count;
 				}
 
+				virtual void accept_calls(unsigned threadid, const compact_call_record *calls, size_t count,
+					const callee_table &callees) override
+				{
+					collected.push_back(make_pair(threadid, vector<call_record>()));
+					collected.back().second.assign(compact_trace_iterator(calls, calls + count, decoders[threadid], callees),
+						compact_trace_iterator(calls + count));
+					total_entries += collected.back().second.size();
+				}
+
+				virtual void accept_dropped(unsigned /*threadid*/, count_t /*count*/) override
+				{	}
+
+				virtual void accept_exited(unsigned /*threadid*/) override
+				{	}
+
 				size_t total_entries;
 				vector< pair< unsigned, vector<call_record> > > collected;
+				map<unsigned, compact_decoder> decoders;
 			};
 
 			void emulate_n_calls_no_flush(calls_collector &collector, size_t calls_number, void *callee)
@@ -479,6 +510,135 @@ namespace micro_profiler
 			}
 
 
+			test( ShortLeafCallsToTheSameCalleeAreFolded )
+			{
+				// INIT
+				collection_acceptor a;
+				const auto A = addr(0x1000), B = addr(0x2000), C = addr(0x3000), D = addr(0x4000), E = addr(0x5000);
+
+				collector->set_buffering_policy(buffering_policy(1000, 1, 1,
+					buffering_policy::block_on_overflow, buffering_policy::buffer_size, buffering_policy::buffer_size, 100));
+
+				// ACT
+				vstack.on_enter(*collector, 1000, A);
+					vstack.on_enter(*collector, 1010, B);
+					vstack.on_exit(*collector, 1020);
+					vstack.on_enter(*collector, 1030, B);
+					vstack.on_exit(*collector, 1050);
+					vstack.on_enter(*collector, 1060, C);
+					vstack.on_exit(*collector, 1070);
+					vstack.on_enter(*collector, 1080, B);
+					vstack.on_exit(*collector, 1300);
+					vstack.on_enter(*collector, 1310, D);
+						vstack.on_enter(*collector, 1320, E);
+						vstack.on_exit(*collector, 1330);
+					vstack.on_exit(*collector, 1400);
+				vstack.on_exit(*collector, 5000);
+				collector->flush();
+				collector->read_collected(a);
+
+				// ASSERT
+				call_record reference[] = {
+					{	1000, A	},
+						{	2, folded_calls_tag	}, {	1010, B	}, {	1040, nullptr	},
+						{	1, folded_calls_tag	}, {	1060, C	}, {	1070, nullptr	},
+						{	1080, B	}, {	1300, nullptr	},
+						{	1310, D	},
+							{	1, folded_calls_tag	}, {	1320, E	}, {	1330, nullptr	},
+						{	1400, nullptr	},
+					{	5000, nullptr	},
+				};
+
+				assert_equal(1u, a.collected.size());
+				assert_equal(reference, a.collected[0].second);
+			}
+
+
+			test( DeferredAndFoldedCallsAreWrittenOnFlush )
+			{
+				// INIT
+				collection_acceptor a;
+
+				collector->set_buffering_policy(buffering_policy(1000, 1, 1,
+					buffering_policy::block_on_overflow, buffering_policy::buffer_size, buffering_policy::buffer_size, 100));
+				vstack.on_enter(*collector, 1000, addr(0x1000));
+				vstack.on_exit(*collector, 1010);
+
+				// ACT
+				collector->flush();
+				collector->read_collected(a);
+
+				// ASSERT
+				call_record reference1[] = {
+					{	1, folded_calls_tag	}, {	1000, addr(0x1000)	}, {	1010, nullptr	},
+				};
+
+				assert_equal(1u, a.collected.size());
+				assert_equal(reference1, a.collected[0].second);
+
+				// INIT
+				vstack.on_enter(*collector, 1020, addr(0x2000));
+
+				// ACT
+				collector->flush();
+				collector->read_collected(a);
+				vstack.on_exit(*collector, 1025);
+				collector->flush();
+				collector->read_collected(a);
+
+				// ASSERT
+				call_record reference2[] = {	{	1020, addr(0x2000)	},	};
+				call_record reference3[] = {	{	1025, nullptr	},	};
+
+				assert_equal(3u, a.collected.size());
+				assert_equal(reference2, a.collected[1].second);
+				assert_equal(reference3, a.collected[2].second);
+			}
+
+
+			test( HardwareCounterReadingsIfAvailablePrecedeEachEntryAndExit )
+			{
+				// INIT
+				collection_acceptor a;
+				const auto A = addr(0x1000), B = addr(0x2000);
+				vector<call_record> calls;
+				vector<unsigned> readings(1);
+
+				collector->set_buffering_policy(buffering_policy(1000, 1, 1, buffering_policy::block_on_overflow,
+					buffering_policy::buffer_size, buffering_policy::buffer_size, 100, true));
+
+				// ACT
+				vstack.on_enter(*collector, 1000, A);
+					vstack.on_enter(*collector, 1010, B);
+					vstack.on_exit(*collector, 1020);
+				vstack.on_exit(*collector, 1030);
+				collector->flush();
+				collector->read_collected(a);
+
+				// ASSERT
+				call_record reference[] = {
+					{	1000, A	},
+						{	1010, B	},
+						{	1020, nullptr	},
+					{	1030, nullptr	},
+				};
+
+				assert_equal(1u, a.collected.size());
+				for (auto i = a.collected[0].second.begin(); i != a.collected[0].second.end(); ++i)
+				{
+					if (hw_counter_tag == i->callee)
+						readings.back()++;
+					else
+						calls.push_back(*i), readings.push_back(0);
+				}
+				readings.pop_back();
+
+				// Short calls are not folded, once the counters are collected.
+				assert_equal(reference, calls);
+				assert_is_true(vector<unsigned>(4, 0) == readings || vector<unsigned>(4, max_hw_counters) == readings);
+			}
+
+
 			test( CollectorCanWithstandOverallocatedTLSes )
 			{
 				// INIT
@@ -504,6 +664,45 @@ namespace micro_profiler
 				assert_equal(reference, a.collected[0].second);
 			}
 
+#ifdef MP_FAST_CURSOR
+
+			test( QueuesAreBoundToTheFastCursorsOfTheirThreadsOnlyWhenRequested )
+			{
+				// INIT
+				fast_cursor c[3];
+
+				// ACT
+				mt::thread t1([&] {
+					virtual_stack vstack_;
+
+					vstack_.on_enter(*collector, 100, addr(0x100));
+					c[0] = g_fast_cursor;
+					collector->bind_fast_cursors();
+					c[1] = g_fast_cursor;
+					vstack_.on_exit(*collector, 110);
+				});
+				t1.join();
+				mt::thread t2([&] {
+					virtual_stack vstack_;
+
+					vstack_.on_enter(*collector, 100, addr(0x100));
+					c[2] = g_fast_cursor;
+					vstack_.on_exit(*collector, 110);
+				});
+				t2.join();
+
+				// ASSERT
+				assert_null(c[0].records);
+				assert_null(c[0].records_end);
+				assert_not_null(c[1].records);
+				assert_is_true(c[1].records < c[1].records_end);
+				assert_is_true(c[1].returns < c[1].returns_end);
+				assert_not_null(c[2].records);
+				assert_is_true(c[2].records < c[2].records_end);
+				assert_is_true(c[2].returns < c[2].returns_end);
+			}
+#endif
+
 		end_test_suite
 	}
 }
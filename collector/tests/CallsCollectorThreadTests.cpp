@@ -799,6 +799,80 @@ namespace micro_profiler
 				assert_equal(19u, al.allocated);
 			}
 
+#ifdef MP_FAST_CURSOR
+
+			test( RecordsWrittenThroughTheCursorAreAccountedOnTheNextCallToTheQueue )
+			{
+				// INIT
+				fast_cursor c;
+				const void *stack[] = {	addr(0x2222), 0, addr(0x1111),	};
+
+				collector->bind_cursor(c);
+
+				// ACT (fast entry into the outer function)
+				c.returns->stack_ptr = stack + 2, c.returns->return_address = stack[2], c.returns++;
+				c.records->timestamp = 100, c.records->callee = addr(0x100), c.records++;
+				on_enter(*collector, stack + 0, 110, addr(0x200));
+
+				// ASSERT
+				assert_is_true(c.records < c.records_end);
+				assert_is_true(c.returns < c.returns_end);
+
+				// ACT (fast exit from the inner function)
+				c.returns--;
+				c.records->timestamp = 120, c.records->callee = 0, c.records++;
+
+				// ACT / ASSERT
+				assert_equal(addr(0x1111), on_exit(*collector, stack + 2, 130));
+
+				// ACT
+				collector->flush();
+				collector->read_collected(acceptor);
+
+				// ASSERT
+				call_record reference[] = {
+					{	100, addr(0x100)	},
+						{	110, addr(0x200)	}, {	120, 0	},
+					{	130, 0	},
+				};
+
+				assert_equal(1u, acceptor_object.collected.size());
+				assert_equal(reference, acceptor_object.collected[0]);
+				assert_equal(c.records, c.records_end);
+			}
+
+
+			test( LastRecordOfABufferIsLeftToTheQueueToHandTheBufferOff )
+			{
+				// INIT
+				fast_cursor c;
+
+				collector->bind_cursor(c);
+
+				// ASSERT
+				assert_equal(buffering_policy::buffer_size - 1, static_cast<size_t>(c.records_end - c.records));
+
+				// INIT
+				for (timestamp_t t = 0; c.records != c.records_end; ++t)
+					c.records->timestamp = t, c.records->callee = addr(0x100), c.records++;
+
+				// ACT
+				collector->read_collected(acceptor);
+
+				// ASSERT
+				assert_equal(0u, acceptor_object.total_entries);
+
+				// ACT
+				collector->track(addr(0x200), 1000000);
+				collector->read_collected(acceptor);
+
+				// ASSERT
+				assert_equal(buffering_policy::buffer_size, acceptor_object.total_entries);
+				assert_equal(addr(0x200), acceptor_object.collected[0].back().callee);
+				assert_equal(buffering_policy::buffer_size - 1, static_cast<size_t>(c.records_end - c.records));
+			}
+#endif
+
 		end_test_suite
 	}
 }
@@ -15,6 +15,7 @@
 #include <ipc/client_session.h>
 #include <mt/event.h>
 #include <mt/thread.h>
+#include <set>
 #include <test-helpers/constants.h>
 #include <test-helpers/comparisons.h>
 #include <test-helpers/helpers.h>
@@ -105,6 +106,7 @@ namespace micro_profiler
 				assert_is_false(!!id.injected);
 				assert_equal(unique_name, id.executable);
 				assert_approx_equal(ticks_per_second(), id.ticks_per_second, 0.05);
+				assert_equal((unsigned)capability_chunked_metadata, id.capabilities);
 			}
 
 
@@ -372,6 +374,105 @@ namespace micro_profiler
 			}
 
 
+			test( TracesArePartitionedAmongAnalysisWorkersReadingFromDistinctThreads )
+			{
+				// INIT
+				mt::mutex mtx;
+				mt::event done;
+				containers::unordered_map<unsigned, mt::thread::id> readers;
+				set<unsigned> partitions_seen;
+
+				collector.on_read_partition = [&] (calls_collector_i::acceptor &, unsigned partition, unsigned partitions) {
+					mt::lock_guard<mt::mutex> l(mtx);
+
+					readers[partition] = mt::this_thread::get_id();
+					partitions_seen.insert(partitions);
+					if (readers.size() == 3)
+						done.set();
+				};
+
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager, 3);
+
+				app.connect(factory, false);
+
+				// ACT
+				done.wait();
+
+				// ASSERT
+				mt::lock_guard<mt::mutex> l(mtx);
+				set<mt::thread::id> reader_threads;
+
+				for (auto i = readers.begin(); i != readers.end(); ++i)
+					reader_threads.insert(i->second);
+				assert_equal(3u, readers.size());
+				assert_not_null(find_by_first(readers, 0u));
+				assert_not_null(find_by_first(readers, 1u));
+				assert_not_null(find_by_first(readers, 2u));
+				assert_equal(3u, reader_threads.size());
+				assert_equivalent(plural + 3u, partitions_seen);
+			}
+
+
+			test( StatisticsOfAllAnalysisWorkersIsMergedOnRequest )
+			{
+				// INIT
+				mt::mutex mtx;
+				mt::event ready, updated;
+				set<unsigned> fed;
+				call_record trace[] = {
+					{	0, (void *)0x1223	},
+					{	1000 + c_overhead.inner, (void *)0	},
+				};
+				thread_statistics_map u;
+				shared_ptr<void> req;
+
+				collector.on_read_partition = [&] (calls_collector_i::acceptor &a, unsigned partition, unsigned) {
+					mt::lock_guard<mt::mutex> l(mtx);
+
+					if (!fed.insert(partition).second)
+						return;
+					a.accept_calls(30 + partition, trace, array_size(trace));
+					if (fed.size() == 3)
+						ready.set();
+				};
+
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager, 3);
+
+				app.connect(factory, false);
+				client_ready.wait();
+				ready.wait();
+
+				// ACT
+				client->request(req, request_update, 0, response_statistics_update, [&] (deserializer &d) {
+					d(u);
+					updated.set();
+				});
+				updated.wait();
+
+				// ASSERT
+				assert_equal(3u, u.size());
+				assert_equivalent(plural + make_statistics(0x1223u, 1, 0, 1000, 1000, 1000), u[30]);
+				assert_equivalent(plural + make_statistics(0x1223u, 1, 0, 1000, 1000, 1000), u[31]);
+				assert_equivalent(plural + make_statistics(0x1223u, 1, 0, 1000, 1000, 1000), u[32]);
+
+				// INIT
+				u.clear();
+
+				// ACT
+				client->request(req, request_update, 0, response_statistics_update, [&] (deserializer &d) {
+					d(u);
+					updated.set();
+				});
+				updated.wait();
+
+				// ASSERT
+				assert_equal(3u, u.size());
+				assert_is_true(u[30].empty());
+				assert_is_true(u[31].empty());
+				assert_is_true(u[32].empty());
+			}
+
+
 			test( AnalyzedStatisticsIsAvailableOnRequest ) // ex: MakeACallAndWaitForDataPost
 			{
 				// INIT
@@ -451,6 +552,139 @@ namespace micro_profiler
 			}
 
 
+			test( OnlyChangedCallNodesAreSentOnDeltaUpdateRequest )
+			{
+				// INIT
+				mt::event ready, updated;
+				mt::mutex mtx;
+				vector<call_record> trace;
+				statistics_delta d;
+				shared_ptr<void> req;
+				call_record trace1[] = {
+					{	0, (void *)0x1223	},
+						{	10, (void *)0x31223	},
+						{	20, (void *)0	},
+					{	1000, (void *)0	},
+				};
+				call_record trace2[] = {
+					{	2000, (void *)0x1223	},
+					{	2500, (void *)0	},
+				};
+
+				collector.on_read_collected = [&] (calls_collector_i::acceptor &a) {
+					mt::lock_guard<mt::mutex> l(mtx);
+
+					if (trace.empty())
+						return;
+					a.accept_calls(11710u, &trace[0], trace.size());
+					trace.clear();
+					ready.set();
+				};
+
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager);
+
+				app.connect(factory, false);
+				client_ready.wait();
+
+				// ACT
+				{	mt::lock_guard<mt::mutex> l(mtx);	trace.assign(begin(trace1), end(trace1));	}
+				ready.wait();
+				client->request(req, request_update, update_delta, response_statistics_delta, [&] (deserializer &d_) {
+					d_(d);
+					updated.set();
+				});
+				updated.wait();
+
+				// ASSERT
+				assert_equal(1u, d.size());
+				assert_not_null(find_by_first(d, 11710u));
+				assert_equal(plural
+					+ make_created_node(0, 0x1223u, 1, 1000, 990, 1000)
+					+ make_created_node(1, 0x31223u, 1, 10, 10, 10), find_by_first(d, 11710u)->created);
+				assert_is_empty(find_by_first(d, 11710u)->updated);
+
+				// ACT
+				{	mt::lock_guard<mt::mutex> l(mtx);	trace.assign(begin(trace2), end(trace2));	}
+				ready.wait();
+				client->request(req, request_update, update_delta, response_statistics_delta, [&] (deserializer &d_) {
+					d_(d);
+					updated.set();
+				});
+				updated.wait();
+
+				// ASSERT
+				assert_equal(1u, d.size());
+				assert_is_empty(find_by_first(d, 11710u)->created);
+				assert_equal(plural
+					+ make_pair(1u, function_statistics(1, 500, 500, 500)), find_by_first(d, 11710u)->updated);
+			}
+
+
+			test( DroppedRecordsArePostedPerThreadOnUpdateRequest )
+			{
+				// INIT
+				mt::event ready, updated;
+				vector<dropped_records> updates;
+				mt::mutex mtx;
+				vector< pair<unsigned, count_t> > dropped;
+				shared_ptr<void> req;
+
+				collector.on_read_collected = [&] (calls_collector_i::acceptor &a) {
+					mt::lock_guard<mt::mutex> l(mtx);
+
+					if (dropped.empty())
+						return;
+					for (auto i = dropped.begin(); i != dropped.end(); ++i)
+						a.accept_dropped(i->first, i->second);
+					dropped.clear();
+					ready.set();
+				};
+
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager);
+
+				app.connect(factory, false);
+				client_ready.wait();
+
+				// ACT
+				{
+					mt::lock_guard<mt::mutex> l(mtx);
+
+					dropped.push_back(make_pair(11710u, 384u));
+					dropped.push_back(make_pair(11713u, 1000u));
+					dropped.push_back(make_pair(11710u, 17u));
+				}
+				ready.wait();
+				client->request(req, request_update, 0, response_dropped_records, [&] (deserializer &d) {
+					dropped_records v;
+
+					d(v);
+					updates.push_back(v);
+					updated.set();
+				});
+				updated.wait();
+
+				// ASSERT
+				pair<id_t, count_t> reference1[] = {	make_pair(11710u, 401u), make_pair(11713u, 1000u),	};
+
+				assert_equal(1u, updates.size());
+				assert_equivalent(reference1, updates[0]);
+
+				// ACT
+				client->request(req, request_update, 0, response_dropped_records, [&] (deserializer &d) {
+					dropped_records v;
+
+					d(v);
+					updates.push_back(v);
+					updated.set();
+				});
+				updated.wait();
+
+				// ASSERT
+				assert_equal(2u, updates.size());
+				assert_is_empty(updates[1]);
+			}
+
+
 			test( AnalysisLoopKeepsOnSpinningAfterClientIsDisconnected )
 			{
 				// INIT
@@ -613,6 +847,45 @@ namespace micro_profiler
 			}
 
 
+			test( ChunkedModuleMetadataRequestLeadsToMetadataSending )
+			{
+				// INIT
+				shared_ptr<void> req;
+				mt::event ready;
+				unordered_map<unsigned, module::mapping_ex> l;
+				module_info_metadata md;
+				image img1(c_symbol_container_1);
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager);
+
+				app.connect(factory, false);
+				client_ready.wait();
+				module_helper.on_load = [] (string path) {	return module::platform().load(path);	};
+				module_helper.emulate_mapped(img1);
+
+				client->request(req, request_update, 0, response_modules_loaded, [&] (deserializer &d) {
+					d(l);
+					ready.set();
+				});
+				ready.wait();
+				module_helper.on_lock_at = [&] (void *) {	return make_shared_copy(module::platform().locate(img1.base_ptr()));	};
+
+				// ACT
+				client->request(req, request_module_metadata_chunked, 1u, response_module_metadata,
+					[&] (deserializer &d) {
+
+					d(md);
+					ready.set();
+				});
+				ready.wait();
+
+				// ASSERT
+				assert_equal(l[1].hash, md.hash);
+				assert_is_true(any_of(md.symbols.begin(), md.symbols.end(),
+					[] (symbol_info si) { return string::npos != si.name.find("get_function_addresses_1");	}));
+				assert_equal((file_id)c_symbol_container_1, (file_id)md.path);
+			}
+
+
 			test( ThreadInfoRequestLeadsToThreadInfoSending )
 			{
 				// INIT
@@ -0,0 +1,398 @@
+#include <collector/compact_trace.h>
+
+#include "helpers.h"
+
+#include <collector/buffers_queue.h>
+#include <test-helpers/helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			const buffering_policy big_policy(100 * buffering_policy::buffer_size, 1, 1);
+
+			struct compact_trace
+			{
+				compact_trace(const buffering_policy &policy = big_policy)
+					: queue(al, policy, 1)
+				{	}
+
+				void encode(const call_record *begin, const call_record *end)
+				{
+					for (; begin != end; ++begin)
+						encoder.encode(queue, begin->callee, begin->timestamp);
+				}
+
+				vector<call_record> decode(bool flush = true)
+				{
+					vector<call_record> result;
+
+					if (flush)
+						queue.flush();
+					queue.read_collected([&] (unsigned, const compact_call_record *calls, size_t count) {
+						raw_size += count;
+						result.insert(result.end(), compact_trace_iterator(calls, calls + count, decoder, encoder.callees()),
+							compact_trace_iterator(calls + count));
+					});
+					return result;
+				}
+
+				default_allocator al;
+				buffers_queue<compact_call_record> queue;
+				compact_encoder encoder;
+				compact_decoder decoder;
+				size_t raw_size = 0;
+			};
+		}
+
+		begin_test_suite( CompactTraceTests )
+			test( CompactRecordIsHalfTheSizeOfARegularOne )
+			{
+				// ASSERT
+				assert_equal(8u, sizeof(compact_call_record));
+			}
+
+
+			test( EncodedCallsAreDecodedToTheSameRecords )
+			{
+				// INIT
+				compact_trace t;
+				call_record trace[] = {
+					{	12300, addr(0x12345670)	},
+						{	12305, addr(0x22345670)	},
+						{	12310, nullptr	},
+						{	12317, addr(0x22345670)	},
+							{	12319, addr(0x12345670)	},
+							{	12400, nullptr	},
+						{	13300, nullptr	},
+					{	13301, nullptr	},
+				};
+
+				// ACT
+				t.encode(begin(trace), end(trace));
+				const auto result = t.decode();
+
+				// ASSERT
+				assert_equal(trace, result);
+				assert_equal(array_size(trace), t.raw_size);
+			}
+
+
+			test( FoldedCallsCountIsDecodedAsAFoldedCallsRecord )
+			{
+				// INIT
+				compact_trace t;
+
+				// ACT
+				t.encoder.encode(t.queue, addr(0x1000), 100);
+				t.encoder.encode_folded(t.queue, 3);
+				t.encoder.encode(t.queue, addr(0x2000), 110);
+				t.encoder.encode(t.queue, nullptr, 140);
+				t.encoder.encode_folded(t.queue, 0x100000001ull);
+				t.encoder.encode(t.queue, addr(0x2000), 150);
+				t.encoder.encode(t.queue, nullptr, 160);
+				t.encoder.encode(t.queue, nullptr, 200);
+				const auto result = t.decode();
+
+				// ASSERT
+				call_record reference[] = {
+					{	100, addr(0x1000)	},
+						{	3, folded_calls_tag	}, {	110, addr(0x2000)	}, {	140, nullptr	},
+						{	0x100000001ull, folded_calls_tag	}, {	150, addr(0x2000)	}, {	160, nullptr	},
+					{	200, nullptr	},
+				};
+
+				assert_equal(reference, result);
+			}
+
+
+			test( HardwareCounterReadingsAreDecodedAsCounterRecords )
+			{
+				// INIT
+				compact_trace t;
+
+				// ACT
+				t.encoder.encode_counter(t.queue, 12345678901234ull);
+				t.encoder.encode_counter(t.queue, 7);
+				t.encoder.encode(t.queue, addr(0x1000), 100);
+				t.encoder.encode_counter(t.queue, 0);
+				t.encoder.encode_counter(t.queue, 0xFFFFFFFFFFull);
+				t.encoder.encode(t.queue, nullptr, 130);
+				const auto result = t.decode();
+
+				// ASSERT
+				call_record reference[] = {
+					{	12345678901234ll, hw_counter_tag	}, {	7, hw_counter_tag	},
+					{	100, addr(0x1000)	},
+					{	0, hw_counter_tag	}, {	0xFFFFFFFFFFll, hw_counter_tag	},
+					{	130, nullptr	},
+				};
+
+				assert_equal(reference, result);
+			}
+
+
+			test( AllocationsAreDecodedAsAPairOfAllocationRecords )
+			{
+				// INIT
+				compact_trace t;
+
+				// ACT
+				t.encoder.encode(t.queue, addr(0x1000), 100);
+				t.encoder.encode_allocations(t.queue, 3, 0x100000010ull);
+				t.encoder.encode(t.queue, nullptr, 130);
+				const auto result = t.decode();
+
+				// ASSERT
+				call_record reference[] = {
+					{	100, addr(0x1000)	},
+						{	3, allocations_tag	}, {	0x100000010ll, allocated_bytes_tag	},
+					{	130, nullptr	},
+				};
+
+				assert_equal(reference, result);
+			}
+
+
+			test( LockWaitIsDecodedAsALockWaitRecordWithTheLockAddress )
+			{
+				// INIT
+				compact_trace t;
+
+				// ACT
+				t.encoder.encode(t.queue, addr(0x1000), 100);
+				t.encoder.encode_lock_wait(t.queue, addr(0x12345678));
+				t.encoder.encode(t.queue, addr(0x2000), 110);
+				t.encoder.encode(t.queue, nullptr, 120);
+				t.encoder.encode(t.queue, nullptr, 130);
+				const auto result = t.decode();
+
+				// ASSERT
+				call_record reference[] = {
+					{	100, addr(0x1000)	},
+						{	0x12345678, lock_wait_tag	}, {	110, addr(0x2000)	}, {	120, nullptr	},
+					{	130, nullptr	},
+				};
+
+				assert_equal(reference, result);
+			}
+
+
+			test( CalleesAreIndexedInOrderOfAppearance )
+			{
+				// INIT
+				callee_table table;
+
+				// ACT / ASSERT
+				assert_equal(1u, table.index_of(addr(0x1000)));
+				assert_equal(2u, table.index_of(addr(0x2000)));
+				assert_equal(1u, table.index_of(addr(0x1000)));
+				assert_equal(3u, table.index_of(addr(0x1010)));
+				assert_equal(2u, table.index_of(addr(0x2000)));
+
+				// ASSERT
+				assert_equal(addr(0x1000), table[1]);
+				assert_equal(addr(0x2000), table[2]);
+				assert_equal(addr(0x1010), table[3]);
+			}
+
+
+			test( TimestampGapsNotFittingDeltaAreEncodedAsRebase )
+			{
+				// INIT
+				compact_trace t;
+				call_record trace[] = {
+					{	100, addr(0x1000)	},
+					{	0x100000100ull, nullptr	},
+					{	0x100000110ull, addr(0x1000)	},
+					{	0x100000120ull, nullptr	},
+					{	0x90, addr(0x1000)	}, // Timestamps going back are rebased as well.
+					{	0x95, nullptr	},
+				};
+
+				// ACT
+				t.encode(begin(trace), end(trace));
+				const auto result = t.decode();
+
+				// ASSERT
+				assert_equal(trace, result);
+				assert_equal(array_size(trace) + 2u * 2u, t.raw_size);
+			}
+
+
+			test( CalleesNotFittingTableAreEscaped )
+			{
+				// INIT
+				compact_trace t;
+				vector<call_record> trace;
+
+				for (size_t i = 0; i != callee_table::capacity + 10; ++i)
+				{
+					call_record r = {	static_cast<timestamp_t>(i * 2 + 1), addr(0x1000 + 0x10 * i)	};
+					call_record e = {	static_cast<timestamp_t>(i * 2 + 2), nullptr	};
+
+					trace.push_back(r), trace.push_back(e);
+				}
+
+				// ACT
+				t.encode(trace.data(), trace.data() + trace.size());
+				const auto result = t.decode();
+
+				// ASSERT
+				assert_equal(trace, result);
+				assert_equal(trace.size() + 10u, t.raw_size);
+			}
+
+
+			test( TwoRecordsSequencesNeverSpanBuffers )
+			{
+				// INIT
+				compact_trace t(buffering_policy(100 * buffering_policy::buffer_size, 1, 1,
+					buffering_policy::block_on_overflow, 4, 4));
+				vector<size_t> sizes;
+				vector<call_record> result;
+				call_record trace[] = {
+					{	0x100000000ull, addr(0x1000)	},
+					{	0x100000001ull, nullptr	},
+					{	0x200000001ull, addr(0x2000)	},
+					{	0x300000001ull, addr(0x3000)	}, // The rebase sequence does not fit the second buffer.
+					{	0x300000009ull, nullptr	},
+					{	0x30000000Aull, nullptr	},
+				};
+
+				// ACT
+				t.encode(begin(trace), end(trace));
+				t.queue.flush();
+				t.queue.read_collected([&] (unsigned, const compact_call_record *calls, size_t count) {
+					sizes.push_back(count);
+					assert_is_true(calls[count - 1].callee < compact_call_record::lock_wait_tag);
+					result.insert(result.end(), compact_trace_iterator(calls, calls + count, t.decoder,
+						t.encoder.callees()), compact_trace_iterator(calls + count));
+				});
+
+				// ASSERT
+				size_t reference[] = {	4u, 3u, 4u, 1u,	};
+
+				assert_equal(trace, result);
+				assert_equal(reference, sizes);
+			}
+
+
+			test( RecordsFollowingALossAreDecodedAfterTheDecoderIsReset )
+			{
+				// INIT
+				compact_trace t(buffering_policy(2 * buffering_policy::buffer_size, 0, 0,
+					buffering_policy::drop_on_overflow, 8, 8));
+				vector<call_record> trace, result;
+				auto reader = [&] (unsigned, const compact_call_record *calls, size_t count) {
+					result.insert(result.end(), compact_trace_iterator(calls, calls + count, t.decoder,
+						t.encoder.callees()), compact_trace_iterator(calls + count));
+				};
+				auto drop_reader = [&] (unsigned, count_t) {
+					t.decoder.reset();
+					result.clear();
+				};
+
+				for (auto i = 0u; i != 100u; ++i)
+				{
+					call_record r[] = {
+						{	0x100000000ull * i + 3u * i, addr(0x1000)	},
+						{	0x123456789ull + i, hw_counter_tag	},
+						{	0x100000000ull * i + 3u * i + 1u, nullptr	},
+					};
+
+					trace.insert(trace.end(), begin(r), end(r));
+				}
+
+				// ACT (the records are lost past the first buffer, including the rebase and the counter sequences)
+				for (auto i = trace.begin(); i != trace.end(); i += 3)
+				{
+					t.encoder.encode(t.queue, i[0].callee, i[0].timestamp);
+					t.encoder.encode_counter(t.queue, i[1].timestamp);
+					t.encoder.encode(t.queue, i[2].callee, i[2].timestamp);
+				}
+				t.queue.read_collected(reader, drop_reader);
+				t.queue.flush();
+				t.queue.read_collected(reader, drop_reader);
+
+				// ASSERT
+				assert_is_false(result.empty());
+				assert_equal(vector<call_record>(trace.end() - result.size(), trace.end()), result);
+
+				// INIT
+				result.clear();
+
+				// ACT
+				t.encoder.encode(t.queue, addr(0x2000), 0x300u);
+				t.encoder.encode(t.queue, nullptr, 0x301u);
+				t.encoder.encode(t.queue, addr(0x3000), 0x1000000301ull);
+				t.encoder.encode(t.queue, nullptr, 0x1000000307ull);
+				t.queue.flush();
+				t.queue.read_collected(reader, drop_reader);
+
+				// ASSERT
+				call_record reference[] = {
+					{	0x300u, addr(0x2000)	}, {	0x301u, nullptr	},
+					{	0x1000000301ull, addr(0x3000)	}, {	0x1000000307ull, nullptr	},
+				};
+
+				assert_equal(reference, result);
+			}
+
+
+			test( DecoderResetDiscardsPendingTagAndBase )
+			{
+				// INIT
+				compact_trace t;
+				compact_call_record trace1[] = {
+					{	0, compact_call_record::rebase_tag	}, {	0x10, 0x1	},
+					{	0x11, compact_call_record::exit_tag	},
+					{	0, compact_call_record::counter_tag	},
+				};
+				compact_call_record trace2[] = {	{	5, compact_call_record::exit_tag	},	};
+
+				vector<call_record>(compact_trace_iterator(begin(trace1), end(trace1), t.decoder, t.encoder.callees()),
+					compact_trace_iterator(end(trace1)));
+
+				// ACT
+				t.decoder.reset();
+				vector<call_record> result(compact_trace_iterator(begin(trace2), end(trace2), t.decoder,
+					t.encoder.callees()), compact_trace_iterator(end(trace2)));
+
+				// ASSERT
+				call_record reference[] = {	{	5, nullptr	},	};
+
+				assert_equal(reference, result);
+			}
+
+
+			test( RecordsReferringBeyondTheCalleeTableAreSkipped )
+			{
+				// INIT
+				compact_trace t;
+				compact_call_record trace[] = {
+					{	10, callee_table::capacity + 1	},
+					{	5, 1	},
+					{	7, compact_call_record::exit_tag	},
+				};
+
+				t.encoder.encode(t.queue, addr(0x1000), 1);
+
+				// ACT
+				vector<call_record> result(compact_trace_iterator(begin(trace), end(trace), t.decoder,
+					t.encoder.callees()), compact_trace_iterator(end(trace)));
+
+				// ASSERT
+				call_record reference[] = {	{	5, addr(0x1000)	}, {	12, nullptr	},	};
+
+				assert_equal(reference, result);
+			}
+		end_test_suite
+	}
+}
@@ -0,0 +1,174 @@
+#include <collector/coverage_tracker.h>
+
+#include "mocks_mapping_access.h"
+
+#include <algorithm>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			void hit(const pair<byte *, byte> &h)
+			{	*h.first |= h.second;	}
+		}
+
+		begin_test_suite( CoverageTrackerTests )
+			mocks::mapping_access mappings;
+			vector<byte> images;
+			byte *image1, *image2;
+
+			init( Init )
+			{
+				images.resize(0x20000);
+				image1 = images.data();
+				image2 = images.data() + 0x10000;
+			}
+
+
+			test( TrackerSubscribesToMappingsAtConstruction )
+			{
+				// INIT / ACT
+				coverage_tracker t(mappings);
+
+				// ASSERT
+				assert_equal(&t, mappings.subscription);
+			}
+
+
+			test( HitsAreOnlyAllocatedForTheFunctionsOfTheModulesMapped )
+			{
+				// INIT
+				coverage_tracker t(mappings);
+
+				mappings.emulate_mapped(11, 1, "a.so", image2);
+
+				// ACT / ASSERT
+				assert_throws(t.get_hit(image1 + 0x10), invalid_argument);
+
+				// INIT
+				mappings.emulate_mapped(13, 2, "b.so", image1);
+				mappings.emulate_unmapped(2);
+
+				// ACT / ASSERT
+				assert_throws(t.get_hit(image1 + 0x10), invalid_argument);
+			}
+
+
+			test( DistinctFunctionsGetDistinctBitsAndTheSameFunctionGetsTheSameBit )
+			{
+				// INIT
+				coverage_tracker t(mappings);
+				vector< pair<byte *, byte> > allocated;
+
+				mappings.emulate_mapped(11, 1, "a.so", image1);
+				mappings.emulate_mapped(13, 2, "b.so", image2);
+
+				// ACT
+				for (auto rva = 0u; rva != 0x1000; rva += 0x10)
+				{
+					allocated.push_back(t.get_hit(image1 + rva));
+					allocated.push_back(t.get_hit(image2 + rva));
+				}
+
+				// ASSERT
+				for (auto i = allocated.begin(); i != allocated.end(); ++i)
+				{
+					assert_is_true(i->second && !(i->second & (i->second - 1)));
+					assert_equal(1, count(allocated.begin(), allocated.end(), *i));
+				}
+				assert_equal(allocated[0], t.get_hit(image1));
+				assert_equal(allocated[3], t.get_hit(image2 + 0x10));
+				assert_equal(allocated[100], t.get_hit(image1 + 0x320));
+			}
+
+
+			test( FunctionsHitAreCollectedOnceByModule )
+			{
+				// INIT
+				coverage_tracker t(mappings);
+				covered_functions covered;
+
+				mappings.emulate_mapped(11, 1, "a.so", image1);
+				mappings.emulate_mapped(13, 2, "b.so", image2);
+
+				const auto a1 = t.get_hit(image1 + 0x10);
+				const auto b1 = t.get_hit(image2 + 0x100);
+				const auto a2 = t.get_hit(image1 + 0x20);
+				const auto b2 = t.get_hit(image2 + 0x200);
+
+				t.get_hit(image1 + 0x30);
+
+				// ACT
+				t.collect(covered);
+
+				// ASSERT
+				assert_is_empty(covered);
+
+				// INIT
+				hit(a2), hit(b1), hit(a1), hit(b2), hit(a1);
+
+				// ACT
+				t.collect(covered);
+
+				// ASSERT
+				pair<id_t, unsigned int> reference1[] = {
+					make_pair(11u, 0x10u), make_pair(11u, 0x20u), make_pair(13u, 0x100u), make_pair(13u, 0x200u),
+				};
+
+				assert_equal(reference1, covered);
+
+				// INIT
+				covered.clear();
+
+				// ACT
+				t.collect(covered);
+
+				// ASSERT
+				assert_is_empty(covered);
+
+				// INIT
+				hit(a2);
+
+				// ACT
+				t.collect(covered);
+
+				// ASSERT
+				pair<id_t, unsigned int> reference2[] = {	make_pair(11u, 0x20u),	};
+
+				assert_equal(reference2, covered);
+			}
+
+
+			test( HitsBeyondTheFirstBlockAreCollected )
+			{
+				// INIT
+				coverage_tracker t(mappings);
+				covered_functions covered;
+				vector< pair<byte *, byte> > allocated;
+
+				mappings.emulate_mapped(11, 1, "a.so", image1);
+				for (auto rva = 0u; rva != 0x10000; rva += 2)
+					allocated.push_back(t.get_hit(image1 + rva));
+
+				// ACT
+				hit(allocated[0x7FFF]);
+				hit(allocated[0x7FF7]);
+				hit(allocated[0x1000]);
+				t.collect(covered);
+
+				// ASSERT
+				pair<id_t, unsigned int> reference[] = {
+					make_pair(11u, 0x2000u), make_pair(11u, 0xFFEEu), make_pair(11u, 0xFFFEu),
+				};
+
+				assert_equal(reference, covered);
+			}
+		end_test_suite
+	}
+}
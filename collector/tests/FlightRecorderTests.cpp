@@ -0,0 +1,460 @@
+#include <collector/flight_recorder.h>
+
+#include "helpers.h"
+#include "mocks.h"
+
+#include <common/file_stream.h>
+#include <map>
+#include <stdio.h>
+#include <test-helpers/file_helpers.h>
+#include <test-helpers/helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			struct trace_acceptor : calls_collector_i::acceptor
+			{
+				virtual void accept_calls(unsigned threadid, const call_record *calls, size_t count) override
+				{
+					auto &trace = traces[threadid];
+
+					trace.insert(trace.end(), calls, calls + count);
+				}
+
+				virtual void accept_calls(unsigned, const compact_call_record *, size_t, const callee_table &) override
+				{	}
+
+				virtual void accept_dropped(unsigned threadid, count_t count) override
+				{	dropped[threadid] += count;	}
+
+				virtual void accept_exited(unsigned /*threadid*/) override
+				{	}
+
+				map< unsigned, vector<call_record> > traces;
+				map<unsigned, count_t> dropped;
+			};
+
+			template <size_t n>
+			function<void (calls_collector_i::acceptor &a)> deliver(unsigned int thread_id, call_record (&calls)[n])
+			{	return [thread_id, &calls] (calls_collector_i::acceptor &a) {	a.accept_calls(thread_id, calls, n);	};	}
+
+			string read_text(const string &path)
+			{
+				read_file_stream s(path);
+				char buffer[1000];
+				string text;
+
+				for (size_t n; n = s.read_l(buffer, sizeof(buffer)), n; )
+					text.append(buffer, n);
+				return text;
+			}
+
+			string export_text(const string &ring_path, double window = 0)
+			{
+				temporary_directory dir;
+				const auto json_path = dir.track_file("trace.json");
+
+				{
+					write_file_stream output(json_path);
+
+					export_chrome_trace(output, ring_path, window);
+				}
+				return read_text(json_path);
+			}
+
+			struct chrome_trace
+			{
+				chrome_trace(const string &ring_path)
+				{
+					flight_ring_header header;
+
+					read_file_stream(ring_path).read(&header, sizeof(header));
+					pid = header.pid;
+					text = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+				}
+
+				chrome_trace &operator ()(char phase, unsigned int thread_id, const char *ts, const char *name = nullptr,
+					count_t calls = 1)
+				{
+					char buffer[200];
+
+					sprintf(buffer, "%s\n{\"ph\":\"%c\",\"pid\":%u,\"tid\":%u,\"ts\":%s", events++ ? "," : "", phase, pid,
+						thread_id, ts);
+					text += buffer;
+					if (name)
+						text += string(",\"name\":\"") + name + "\"";
+					if (calls != 1)
+						sprintf(buffer, ",\"args\":{\"calls\":%u}", static_cast<unsigned>(calls)), text += buffer;
+					text += "}";
+					return *this;
+				}
+
+				string str() const
+				{	return text + "\n]}\n";	}
+
+				unsigned int pid, events = 0;
+				string text;
+			};
+		}
+
+		begin_test_suite( FlightRecorderTests )
+			temporary_directory dir;
+			mocks::tracer underlying;
+			string ring_path;
+
+			init( Init )
+			{	ring_path = dir.track_file("test.ring");	}
+
+
+			test( CallsReadAreForwardedUnchanged )
+			{
+				// INIT
+				flight_recorder r(underlying, ring_path, 100000, 1000);
+				trace_acceptor a;
+				vector< pair<unsigned, unsigned> > partitions;
+				auto flushed = 0;
+				call_record trace1[] = {
+					{	100, addr(0x1000)	}, {	110, nullptr	},
+				};
+				call_record trace2[] = {
+					{	120, addr(0x2000)	}, {	5, folded_calls_tag	}, {	121, addr(0x3000)	},
+				};
+
+				underlying.on_read_partition = [&] (calls_collector_i::acceptor &a_, unsigned partition, unsigned n) {
+					partitions.push_back(make_pair(partition, n));
+					deliver(3, trace1)(a_);
+					a_.accept_dropped(7, 19);
+					deliver(7, trace2)(a_);
+				};
+				underlying.on_flush = [&] {	flushed++;	};
+
+				// ACT
+				r.read_collected(a, 1, 3);
+				r.flush();
+
+				// ASSERT
+				pair<unsigned, unsigned> reference[] = {	make_pair(1u, 3u),	};
+
+				assert_equal(reference, partitions);
+				assert_equal(trace1, a.traces[3]);
+				assert_equal(trace2, a.traces[7]);
+				assert_equal(19u, a.dropped[7]);
+				assert_equal(1, flushed);
+			}
+
+
+			test( RecordedCallsAreExportedAsChromeTraceEvents )
+			{
+				// INIT
+				flight_recorder r(underlying, ring_path, 100000, 2000000);
+				trace_acceptor a;
+				call_record trace1[] = {
+					{	2000, addr(0x1000)	},
+						{	2001, addr(0x2000)	},
+						{	2003, nullptr	},
+						{	2, folded_calls_tag	},
+						{	2005, addr(0x3000)	},
+						{	2011, nullptr	},
+				};
+				call_record trace2[] = {
+					{	2500, addr(0x4000)	},
+				};
+				call_record trace3[] = {
+					{	4000, nullptr	},
+				};
+
+				underlying.on_read_collected = [&] (calls_collector_i::acceptor &a_) {
+					deliver(3, trace1)(a_);
+					deliver(5, trace2)(a_);
+					deliver(3, trace3)(a_);
+				};
+
+				// ACT
+				r.read_collected(a);
+
+				// ASSERT
+				assert_equal(chrome_trace(ring_path)
+					('B', 3, "1000.000", "0x1000")
+					('B', 3, "1000.500", "0x2000")
+					('E', 3, "1001.500")
+					('B', 3, "1002.500", "0x3000", 2)
+					('E', 3, "1005.500")
+					('B', 5, "1250.000", "0x4000")
+					('E', 3, "2000.000")
+					('E', 5, "1250.000").str(), export_text(ring_path));
+			}
+
+
+			test( OldestSlotsAreOverwrittenAndUnmatchedExitsAreSkipped )
+			{
+				// INIT
+				const auto slot_size = sizeof(flight_slot_header) + 2 * sizeof(flight_record);
+				flight_recorder r(underlying, ring_path, 2 * slot_size, 1000000, slot_size);
+				trace_acceptor a;
+				call_record trace[] = {
+					{	10, addr(0x1000)	},
+						{	20, addr(0x2000)	},
+						{	30, nullptr	},
+					{	40, nullptr	},
+					{	50, addr(0x3000)	},
+					{	60, nullptr	},
+				};
+
+				underlying.on_read_collected = deliver(1, trace);
+
+				// ACT
+				r.read_collected(a);
+
+				// ASSERT
+				assert_equal(chrome_trace(ring_path)
+					('B', 1, "50.000", "0x3000")
+					('E', 1, "60.000").str(), export_text(ring_path));
+			}
+
+
+			test( HardwareCounterReadingsAreNotRecorded )
+			{
+				// INIT
+				const auto slot_size = sizeof(flight_slot_header) + 2 * sizeof(flight_record);
+				flight_recorder r(underlying, ring_path, 3 * slot_size, 1000000, slot_size);
+				trace_acceptor a;
+				call_record trace[] = {
+					{	1, hw_counter_tag	}, {	2, hw_counter_tag	},
+					{	10, addr(0x1000)	},
+						{	3, hw_counter_tag	},
+						{	20, addr(0x2000)	},
+						{	30, nullptr	},
+					{	4, hw_counter_tag	},
+					{	40, nullptr	},
+					{	5, hw_counter_tag	},
+				};
+
+				underlying.on_read_collected = deliver(1, trace);
+
+				// ACT
+				r.read_collected(a);
+
+				// ASSERT
+				assert_equal(chrome_trace(ring_path)
+					('B', 1, "10.000", "0x1000")
+					('B', 1, "20.000", "0x2000")
+					('E', 1, "30.000")
+					('E', 1, "40.000").str(), export_text(ring_path));
+			}
+
+
+			test( AllocationCountsAreNotRecorded )
+			{
+				// INIT
+				const auto slot_size = sizeof(flight_slot_header) + 2 * sizeof(flight_record);
+				flight_recorder r(underlying, ring_path, 3 * slot_size, 1000000, slot_size);
+				trace_acceptor a;
+				call_record trace[] = {
+					{	10, addr(0x1000)	},
+						{	3, allocations_tag	}, {	96, allocated_bytes_tag	},
+						{	20, addr(0x2000)	},
+						{	1, allocations_tag	}, {	100000, allocated_bytes_tag	},
+						{	30, nullptr	},
+					{	2, allocations_tag	}, {	48, allocated_bytes_tag	},
+					{	40, nullptr	},
+				};
+
+				underlying.on_read_collected = deliver(1, trace);
+
+				// ACT
+				r.read_collected(a);
+
+				// ASSERT
+				assert_equal(trace, a.traces[1]);
+				assert_equal(chrome_trace(ring_path)
+					('B', 1, "10.000", "0x1000")
+					('B', 1, "20.000", "0x2000")
+					('E', 1, "30.000")
+					('E', 1, "40.000").str(), export_text(ring_path));
+			}
+
+
+			test( LockWaitTagsAreNotRecorded )
+			{
+				// INIT
+				const auto slot_size = sizeof(flight_slot_header) + 2 * sizeof(flight_record);
+				flight_recorder r(underlying, ring_path, 3 * slot_size, 1000000, slot_size);
+				trace_acceptor a;
+				call_record trace[] = {
+					{	10, addr(0x1000)	},
+						{	0x7F0000001000ull, lock_wait_tag	},
+						{	20, addr(0x2000)	},
+						{	30, nullptr	},
+					{	40, nullptr	},
+					{	0x7F0000002000ull, lock_wait_tag	},
+				};
+
+				underlying.on_read_collected = deliver(1, trace);
+
+				// ACT
+				r.read_collected(a);
+
+				// ASSERT
+				assert_equal(trace, a.traces[1]);
+				assert_equal(chrome_trace(ring_path)
+					('B', 1, "10.000", "0x1000")
+					('B', 1, "20.000", "0x2000")
+					('E', 1, "30.000")
+					('E', 1, "40.000").str(), export_text(ring_path, 0.0001));
+			}
+
+
+			test( CallsOpenAreClosedUponADrop )
+			{
+				// INIT
+				flight_recorder r(underlying, ring_path, 100000, 1000000);
+				trace_acceptor a;
+				call_record trace1[] = {
+					{	10, addr(0x1000)	},
+						{	20, addr(0x2000)	},
+				};
+				call_record trace2[] = {
+						{	70, nullptr	},
+					{	80, nullptr	},
+					{	90, addr(0x3000)	},
+					{	95, nullptr	},
+				};
+
+				underlying.on_read_collected = [&] (calls_collector_i::acceptor &a_) {
+					deliver(1, trace1)(a_);
+					a_.accept_dropped(1, 100);
+					deliver(1, trace2)(a_);
+				};
+
+				// ACT
+				r.read_collected(a);
+
+				// ASSERT
+				assert_equal(chrome_trace(ring_path)
+					('B', 1, "10.000", "0x1000")
+					('B', 1, "20.000", "0x2000")
+					('E', 1, "20.000")
+					('E', 1, "20.000")
+					('B', 1, "90.000", "0x3000")
+					('E', 1, "95.000").str(), export_text(ring_path));
+			}
+
+
+			test( CompactRecordsFollowingADropAreDecodedFromScratch )
+			{
+				// INIT
+				flight_recorder r(underlying, ring_path, 100000, 1000000);
+				trace_acceptor a;
+				callee_table callees;
+				compact_call_record trace1[] = {
+					{	10, callees.index_of(addr(0x1000))	},
+					{	0, compact_call_record::rebase_tag	}, // The wide value following is lost.
+				};
+				compact_call_record trace2[] = {
+					{	25, callees.index_of(addr(0x1000))	},
+					{	5, compact_call_record::exit_tag	},
+				};
+
+				underlying.on_read_collected = [&] (calls_collector_i::acceptor &a_) {
+					a_.accept_calls(1, trace1, 2, callees);
+					a_.accept_dropped(1, 3);
+					a_.accept_calls(1, trace2, 2, callees);
+				};
+
+				// ACT
+				r.read_collected(a);
+
+				// ASSERT
+				assert_equal(chrome_trace(ring_path)
+					('B', 1, "10.000", "0x1000")
+					('E', 1, "10.000")
+					('B', 1, "25.000", "0x1000")
+					('E', 1, "30.000").str(), export_text(ring_path));
+			}
+
+
+			test( OnlyTheCallsWithinTheWindowAreExported )
+			{
+				// INIT
+				flight_recorder r(underlying, ring_path, 100000, 1000);
+				trace_acceptor a;
+				call_record trace1[] = {
+					{	100, addr(0x1000)	},
+						{	285, addr(0x2000)	},
+				};
+				call_record trace2[] = {
+							{	292, addr(0x3000)	},
+							{	295, nullptr	},
+						{	296, nullptr	},
+					{	300, nullptr	},
+				};
+
+				underlying.on_read_collected = [&] (calls_collector_i::acceptor &a_) {
+					deliver(1, trace1)(a_);
+					deliver(2, trace2)(a_);
+				};
+
+				// ACT
+				r.read_collected(a);
+
+				// ASSERT
+				assert_equal(chrome_trace(ring_path)
+					('B', 2, "292000.000", "0x3000")
+					('E', 2, "295000.000").str(), export_text(ring_path, 0.01));
+			}
+
+
+			test( RequestedDumpIsMadeOnReadingTheFirstPartition )
+			{
+				// INIT
+				flight_recorder r(underlying, ring_path, 100000, 1000000);
+				trace_acceptor a;
+				const auto json_path = dir.track_file("dump.json");
+				call_record trace[] = {
+					{	10, addr(0x1000)	},
+					{	20, nullptr	},
+				};
+
+				underlying.on_read_partition = [&] (calls_collector_i::acceptor &a_, unsigned partition, unsigned) {
+					if (partition)
+						deliver(1, trace)(a_);
+				};
+				r.dump_on_request(json_path, 0, [] (unsigned long long address) {
+					return 0x1000 == address ? string("foo\\\"bar") : string();
+				});
+				r.request_dump();
+
+				// ACT
+				r.read_collected(a, 1, 2);
+
+				// ASSERT
+				assert_throws(read_text(json_path), file_not_found_exception);
+
+				// ACT
+				r.read_collected(a, 0, 2);
+
+				// ASSERT
+				assert_equal(chrome_trace(ring_path)
+					('B', 1, "10.000", "foo\\\\\\\"bar")
+					('E', 1, "20.000").str(), read_text(json_path));
+			}
+
+
+			test( ExportingAForeignFileFails )
+			{
+				// INIT
+				write_file_stream(ring_path).write("abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz", 62);
+
+				// ACT / ASSERT
+				assert_throws(export_text(ring_path), invalid_argument);
+			}
+		end_test_suite
+	}
+}
@@ -0,0 +1,165 @@
+#include <collector/lock_tracker.h>
+
+#include "helpers.h"
+#include "mocks.h"
+#include "mocks_allocator.h"
+
+#include <collector/calls_collector.h>
+#include <stdexcept>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			struct trace_acceptor : calls_collector_i::acceptor
+			{
+				virtual void accept_calls(unsigned /*threadid*/, const call_record *calls, size_t count) override
+				{	trace.insert(trace.end(), calls, calls + count);	}
+
+				virtual void accept_calls(unsigned /*threadid*/, const compact_call_record *calls, size_t count,
+					const callee_table &callees) override
+				{
+					trace.insert(trace.end(), compact_trace_iterator(calls, calls + count, decoder, callees),
+						compact_trace_iterator(calls + count));
+				}
+
+				virtual void accept_dropped(unsigned /*threadid*/, count_t /*count*/) override
+				{	}
+
+				virtual void accept_exited(unsigned /*threadid*/) override
+				{	}
+
+				vector<call_record> trace;
+				compact_decoder decoder;
+			};
+		}
+
+		begin_test_suite( LockTrackerTests )
+			virtual_stack vstack;
+			mocks::thread_monitor threads;
+			mocks::thread_callbacks tcallbacks;
+			mocks::allocator allocator_;
+			unique_ptr<calls_collector> collector;
+
+			init( ConstructCollector )
+			{	collector.reset(new calls_collector(allocator_, 1000, threads, tcallbacks));	}
+
+
+			test( OnlyASingleTrackerCanExistAtATime )
+			{
+				// INIT
+				unique_ptr<lock_tracker> t(new lock_tracker(*collector));
+
+				// ACT / ASSERT
+				assert_is_true(lock_tracker::enabled());
+				assert_throws(lock_tracker t2(*collector), logic_error);
+
+				// INIT
+				t.reset();
+
+				// ACT / ASSERT
+				assert_is_false(lock_tracker::enabled());
+
+				// ACT / ASSERT (does not throw)
+				lock_tracker t3(*collector);
+			}
+
+
+			test( ContendedWaitIsWrittenAsACallOfTheBlockingFunctionPrecededByTheLock )
+			{
+				// INIT
+				lock_tracker t(*collector);
+				trace_acceptor a;
+
+				// ACT
+				vstack.on_enter(*collector, 1000, addr(0x1000));
+					lock_tracker::on_wait(addr(0x5000), addr(0x100), 1010, 1050);
+					vstack.on_enter(*collector, 1060, addr(0x2000));
+						lock_tracker::on_wait(addr(0x6000), addr(0x101), 1061, 1063);
+					vstack.on_exit(*collector, 1070);
+				vstack.on_exit(*collector, 1080);
+				collector->flush();
+				collector->read_collected(a);
+
+				// ASSERT
+				call_record reference[] = {
+					{	1000, addr(0x1000)	},
+						{	0x5000, lock_wait_tag	}, {	1010, addr(0x100)	}, {	1050, nullptr	},
+						{	1060, addr(0x2000)	},
+							{	0x6000, lock_wait_tag	}, {	1061, addr(0x101)	}, {	1063, nullptr	},
+						{	1070, nullptr	},
+					{	1080, nullptr	},
+				};
+
+				assert_equal(reference, a.trace);
+			}
+
+
+			test( WaitsAreNotTrackedWithoutATrackerOrBeforeAThreadHasATrace )
+			{
+				// INIT
+				trace_acceptor a;
+
+				// ACT
+				{
+					lock_tracker t(*collector);
+
+					lock_tracker::on_wait(addr(0x5000), addr(0x100), 900, 950);
+				}
+				vstack.on_enter(*collector, 1000, addr(0x1000));
+					lock_tracker::on_wait(addr(0x5000), addr(0x100), 1010, 1050);
+				vstack.on_exit(*collector, 1060);
+				collector->flush();
+				collector->read_collected(a);
+
+				// ASSERT
+				call_record reference[] = {
+					{	1000, addr(0x1000)	},
+					{	1060, nullptr	},
+				};
+
+				assert_equal(reference, a.trace);
+			}
+
+
+			test( ShortCallsFoldedAndTheCallDeferredAreWrittenBeforeAWait )
+			{
+				// INIT
+				lock_tracker t(*collector);
+				trace_acceptor a;
+
+				collector->set_buffering_policy(buffering_policy(1000, 1, 1,
+					buffering_policy::block_on_overflow, buffering_policy::buffer_size, buffering_policy::buffer_size, 100));
+
+				// ACT
+				vstack.on_enter(*collector, 1000, addr(0x1000));
+					vstack.on_enter(*collector, 1010, addr(0x2000));
+					vstack.on_exit(*collector, 1020);
+					vstack.on_enter(*collector, 1030, addr(0x3000));
+						lock_tracker::on_wait(addr(0x5000), addr(0x100), 1031, 1035);
+					vstack.on_exit(*collector, 1040);
+				vstack.on_exit(*collector, 5000);
+				collector->flush();
+				collector->read_collected(a);
+
+				// ASSERT
+				call_record reference[] = {
+					{	1000, addr(0x1000)	},
+						{	1, folded_calls_tag	}, {	1010, addr(0x2000)	}, {	1020, nullptr	},
+						{	1030, addr(0x3000)	},
+							{	0x5000, lock_wait_tag	}, {	1031, addr(0x100)	}, {	1035, nullptr	},
+						{	1040, nullptr	},
+					{	5000, nullptr	},
+				};
+
+				assert_equal(reference, a.trace);
+			}
+		end_test_suite
+	}
+}
@@ -0,0 +1,235 @@
+#include <collector/overhead_governor.h>
+
+#include "mocks_mapping_access.h"
+#include "mocks_patch_manager.h"
+
+#include <collector/analyzer.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			typedef pair<id_t, vector<unsigned int> > revert_log_entry;
+
+			// Makes the number of top-level calls to the function, each taking 'duration' ticks.
+			void add_calls(vector<call_record> &trace, timestamp_t &t, const void *callee, unsigned int n,
+				timestamp_t duration)
+			{
+				while (n--)
+				{
+					call_record enter = {	t, callee	}, exit = {	t += duration, nullptr	};
+
+					trace.push_back(enter), trace.push_back(exit);
+					t += 1;
+				}
+			}
+		}
+
+		begin_test_suite( OverheadGovernorTests )
+			mocks::mapping_access mappings;
+			mocks::patch_manager pmanager;
+			unique_ptr<analyzer> a;
+			vector<byte> images;
+			byte *image1, *image2;
+			vector<revert_log_entry> reverted;
+			vector<call_record> trace;
+			timestamp_t t;
+
+			init( Init )
+			{
+				a.reset(new analyzer(overhead(0, 0)));
+				images.resize(0x200);
+				image1 = images.data();
+				image2 = images.data() + 0x100;
+				t = 0;
+				pmanager.on_revert = [this] (patch_manager::patch_change_results &results, id_t module_id,
+					patch_manager::revert_request_range targets) {
+
+					reverted.push_back(make_pair(module_id, vector<unsigned int>(targets.begin(), targets.end())));
+					for (auto i = targets.begin(); i != targets.end(); ++i)
+					{
+						patch_change_result r = {	0, *i, patch_change_result::ok	};
+						results.push_back(r);
+					}
+				};
+			}
+
+
+			test( GovernorSubscribesToMappingsAtConstruction )
+			{
+				// INIT / ACT
+				overhead_governor g(pmanager, mappings, overhead(3, 7), 10, 1000);
+
+				// ASSERT
+				assert_equal(&g, mappings.subscription);
+			}
+
+
+			test( CheapFunctionsAreRevertedCostliestFirstUntilOverheadFitsTheBudget )
+			{
+				// INIT
+				overhead_governor g(pmanager, mappings, overhead(3, 7), 20, 1000);
+				throttled_patches throttled;
+
+				mappings.emulate_mapped(11, 1, "a.so", image1);
+				add_calls(trace, t, image1 + 0x10, 100, 2); // overhead: 1000, cheap
+				add_calls(trace, t, image1 + 0x20, 10, 100); // overhead: 100
+				add_calls(trace, t, image1 + 0x30, 5, 2); // overhead: 50, cheap
+				a->accept_calls(1, trace.data(), trace.size());
+				g.govern(throttled, 5000);
+
+				// ACT
+				g.account(*a);
+				g.govern(throttled, 6000);
+
+				// ASSERT
+				pair<id_t, unsigned int> reference1[] = {	make_pair(11u, 0x10u),	};
+
+				assert_equal(1u, reverted.size());
+				assert_equal(reference1, throttled);
+
+				// INIT
+				overhead_governor g2(pmanager, mappings, overhead(3, 7), 10, 1000);
+
+				throttled.clear();
+				mappings.emulate_mapped(11, 1, "a.so", image1);
+				g2.govern(throttled, 5000);
+
+				// ACT
+				g2.account(*a);
+				g2.govern(throttled, 6000);
+
+				// ASSERT
+				pair<id_t, unsigned int> reference2[] = {	make_pair(11u, 0x10u), make_pair(11u, 0x30u),	};
+
+				assert_equal(reference2, throttled);
+			}
+
+
+			test( NothingIsRevertedWithinTheBudgetOrBeforeThePeriodPasses )
+			{
+				// INIT
+				overhead_governor g(pmanager, mappings, overhead(3, 7), 20, 1000);
+				throttled_patches throttled;
+
+				mappings.emulate_mapped(11, 1, "a.so", image1);
+				add_calls(trace, t, image1 + 0x10, 100, 2);
+				a->accept_calls(1, trace.data(), trace.size());
+				g.govern(throttled, 5000);
+
+				// ACT
+				g.account(*a);
+				g.govern(throttled, 5999);
+
+				// ASSERT
+				assert_is_empty(reverted);
+				assert_is_empty(throttled);
+
+				// ACT (1000 ticks of overhead in 5001 ticks elapsed)
+				g.govern(throttled, 10001);
+
+				// ASSERT
+				assert_is_empty(reverted);
+				assert_is_empty(throttled);
+			}
+
+
+			test( ExpensiveFunctionsAreNeverReverted )
+			{
+				// INIT
+				overhead_governor g(pmanager, mappings, overhead(3, 7), 1, 1000);
+				throttled_patches throttled;
+
+				mappings.emulate_mapped(11, 1, "a.so", image1);
+				add_calls(trace, t, image1 + 0x10, 100, 11);
+				a->accept_calls(1, trace.data(), trace.size());
+				g.govern(throttled, 5000);
+
+				// ACT
+				g.account(*a);
+				g.govern(throttled, 6000);
+
+				// ASSERT
+				assert_is_empty(reverted);
+				assert_is_empty(throttled);
+			}
+
+
+			test( FunctionsAreRevertedPerModuleAndOnlyReportedIfReverted )
+			{
+				// INIT
+				overhead_governor g(pmanager, mappings, overhead(3, 7), 1, 1000);
+				vector<call_record> trace2;
+				throttled_patches throttled;
+
+				mappings.emulate_mapped(11, 1, "a.so", image1);
+				mappings.emulate_mapped(13, 2, "b.so", image2);
+				add_calls(trace, t, image1 + 0x10, 100, 2);
+				add_calls(trace, t, image2 + 0x40, 90, 2);
+				add_calls(trace2, t, image1 + 0x18, 80, 2);
+				add_calls(trace2, t, image2 + 0x40, 20, 2);
+				a->accept_calls(1, trace.data(), trace.size());
+				a->accept_calls(2, trace2.data(), trace2.size());
+				pmanager.on_revert = [this] (patch_manager::patch_change_results &results, id_t module_id,
+					patch_manager::revert_request_range targets) {
+
+					reverted.push_back(make_pair(module_id, vector<unsigned int>(targets.begin(), targets.end())));
+					for (auto i = targets.begin(); i != targets.end(); ++i)
+					{
+						patch_change_result r = {	0, *i, *i == 0x18 ? patch_change_result::unchanged
+							: patch_change_result::ok	};
+						results.push_back(r);
+					}
+				};
+				g.govern(throttled, 5000);
+
+				// ACT
+				g.account(*a);
+				g.govern(throttled, 6000);
+
+				// ASSERT
+				unsigned int reference_rva1[] = {	0x10u, 0x18u,	};
+				unsigned int reference_rva2[] = {	0x40u,	};
+				pair<id_t, unsigned int> reference[] = {	make_pair(11u, 0x10u), make_pair(13u, 0x40u),	};
+
+				assert_equal(2u, reverted.size());
+				assert_equal(11u, reverted[0].first);
+				assert_equal(reference_rva1, reverted[0].second);
+				assert_equal(13u, reverted[1].first);
+				assert_equal(reference_rva2, reverted[1].second);
+				assert_equal(reference, throttled);
+			}
+
+
+			test( FunctionsOutsideOfTheModulesMappedAreNotReverted )
+			{
+				// INIT
+				overhead_governor g(pmanager, mappings, overhead(3, 7), 1, 1000);
+				throttled_patches throttled;
+
+				mappings.emulate_mapped(11, 1, "a.so", image1);
+				mappings.emulate_mapped(13, 2, "b.so", image2);
+				mappings.emulate_unmapped(1);
+				add_calls(trace, t, image2 + 0x10, 100, 2);
+				add_calls(trace, t, image1 + 0x10, 100, 2);
+				a->accept_calls(1, trace.data(), trace.size());
+				g.govern(throttled, 5000);
+
+				// ACT
+				g.account(*a);
+				g.govern(throttled, 6000);
+
+				// ASSERT
+				pair<id_t, unsigned int> reference[] = {	make_pair(13u, 0x10u),	};
+
+				assert_equal(reference, throttled);
+			}
+		end_test_suite
+	}
+}
@@ -0,0 +1,217 @@
+#include <collector/sampler.h>
+
+#include "mocks.h"
+
+#include <collector/thread_monitor.h>
+#include <common/compiler.h>
+#include <common/time.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <test-helpers/helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+#if defined(__x86_64__)
+asm(".text\n"
+	"mp_call_with_frame_pointer:\n"
+	"	push %rbp\n"
+	"	mov %rsi, %rbp\n"
+	"	call *%rdi\n"
+	"	pop %rbp\n"
+	"	ret\n");
+
+extern "C" void mp_call_with_frame_pointer(void (*f)(), const void *fp);
+#endif
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			struct trace_acceptor : calls_collector_i::acceptor
+			{
+				virtual void accept_calls(unsigned threadid, const call_record *calls, size_t count) override
+				{
+					auto &trace = traces[threadid];
+
+					trace.insert(trace.end(), calls, calls + count);
+				}
+
+				virtual void accept_calls(unsigned, const compact_call_record *, size_t, const callee_table &) override
+				{	}
+
+				virtual void accept_dropped(unsigned, count_t) override
+				{	}
+
+				virtual void accept_exited(unsigned) override
+				{	}
+
+				map< unsigned, vector<call_record> > traces;
+			};
+
+			volatile double g_sink = 1.0;
+
+			FORCE_NOINLINE void burn_cpu(timestamp_t duration_ms)
+			{
+				for (const auto start = clock(); clock() - start < duration_ms; )
+				{
+					for (auto n = 10000; n--; )
+						g_sink = sin(g_sink);
+				}
+			}
+
+#if defined(__x86_64__)
+			FORCE_NOINLINE void burn_cpu_300()
+			{	burn_cpu(300);	}
+
+			// Burns CPU with the caller's frame pointer set to the 'fp' passed.
+			void *burn_cpu_with_stale_frame(void *fp)
+			{
+				mp_call_with_frame_pointer(&burn_cpu_300, fp);
+				return nullptr;
+			}
+#endif
+		}
+
+		begin_test_suite( SamplerTests )
+			shared_ptr<thread_monitor> threads;
+			mocks::thread_callbacks callbacks;
+			mocks::module_helper module_helper;
+
+			init( Init )
+			{	threads = make_shared<thread_monitor>(callbacks);	}
+
+
+			test( OnlyASingleSamplerCanRunAtATime )
+			{
+				// INIT
+				unique_ptr<sampler> s(new sampler(*threads, module_helper, 1000));
+
+				// ACT / ASSERT
+				assert_throws(sampler(*threads, module_helper, 1000), logic_error);
+
+				// INIT
+				s.reset();
+
+				// ACT / ASSERT (does not throw)
+				sampler s2(*threads, module_helper, 1000);
+			}
+
+
+			test( BusyThreadIsSampledIntoABalancedTrace )
+			{
+				// INIT
+				sampler s(*threads, module_helper, 1000);
+				trace_acceptor a;
+
+				// ACT
+				burn_cpu(300);
+				s.read_collected(a);
+
+				// ASSERT
+				const auto thread_id = threads->register_self();
+				const auto &trace = a.traces[thread_id];
+				auto depth = 0;
+				auto previous = timestamp_t();
+
+				assert_is_true(trace.size() > 50u);
+				assert_is_true(trace.back().timestamp < ticks_per_second()); // Sampled time is CPU time spent.
+				for (auto i = trace.begin(); i != trace.end(); ++i)
+				{
+					depth += i->callee ? 1 : -1;
+					assert_is_true(depth >= 0);
+					assert_is_true(i->timestamp >= previous);
+					previous = i->timestamp;
+				}
+			}
+
+
+			test( SampledAddressesAreResolvedToFunctionStarts )
+			{
+				// INIT
+				sampler s(*threads, module_helper, 1000);
+				trace_acceptor a;
+
+				// ACT
+				burn_cpu(200);
+				s.read_collected(a);
+
+				// ASSERT
+				const auto &trace = a.traces[threads->register_self()];
+
+				assert_is_true(any_of(trace.begin(), trace.end(), [] (const call_record &r) {
+					return r.callee == address_cast_hack<const void *>(&burn_cpu);
+				}));
+			}
+
+
+#if defined(__x86_64__)
+			test( StaleFramePointerDoesNotFaultTheThreadSampled )
+			{
+				// INIT
+				const size_t stack_size = 256 * 1024, page = ::sysconf(_SC_PAGESIZE);
+				const auto region = static_cast<byte *>(::mmap(nullptr, stack_size + page, PROT_READ | PROT_WRITE,
+					MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+				pthread_attr_t attr;
+				pthread_t thread;
+				trace_acceptor a;
+				size_t n = 0;
+
+				::mprotect(region + stack_size, page, PROT_NONE); // Right above the stack, i.e. passes the bounds check.
+				::pthread_attr_init(&attr);
+				::pthread_attr_setstack(&attr, region, stack_size);
+
+				// ACT
+				{
+					sampler s(*threads, module_helper, 1000);
+
+					::pthread_create(&thread, &attr, &burn_cpu_with_stale_frame, region + stack_size);
+					::pthread_join(thread, nullptr);
+					s.read_collected(a);
+				}
+
+				// ASSERT
+				for (auto i = a.traces.begin(); i != a.traces.end(); ++i)
+					n += i->second.size();
+				assert_is_true(n > 50u);
+
+				// INIT
+				::pthread_attr_destroy(&attr);
+				::munmap(region, stack_size + page);
+			}
+#endif
+
+
+			test( InstrumentedTraceIsDrainedWhenSampling )
+			{
+				// INIT
+				mocks::tracer instrumented;
+				vector< pair<unsigned, unsigned> > partitions;
+				sampler s(*threads, module_helper, 1000, &instrumented);
+				trace_acceptor a;
+				auto flushed = 0;
+
+				instrumented.on_read_partition = [&] (calls_collector_i::acceptor &, unsigned partition, unsigned n) {
+					partitions.push_back(make_pair(partition, n));
+				};
+				instrumented.on_flush = [&] {	flushed++;	};
+
+				// ACT
+				s.read_collected(a, 0, 3);
+				s.read_collected(a, 2, 3);
+				s.flush();
+
+				// ASSERT
+				pair<unsigned, unsigned> reference[] = {	make_pair(0u, 3u), make_pair(2u, 3u),	};
+
+				assert_equal(reference, partitions);
+				assert_equal(1, flushed);
+			}
+		end_test_suite
+	}
+}
@@ -15,6 +15,15 @@ namespace micro_profiler
 		namespace
 		{
 			typedef call_graph_types<const void *> statistic_types;
+			typedef shadow_stack<statistic_types::key>::graph_type graph_type;
+
+			template <typename LevelT>
+			typename LevelT::value_type::second_type find_callee(const LevelT &level, const void *callee)
+			{
+				return find_if(level.begin(), level.end(), [callee] (const typename LevelT::value_type &entry) {
+					return entry.first == callee;
+				})->second;
+			}
 		}
 
 		begin_test_suite( ShadowStackTests )
@@ -23,7 +32,7 @@ namespace micro_profiler
 				// INIT
 				shadow_stack<statistic_types::key> ss(overhead(0, 0));
 				vector<call_record> trace;
-				statistic_types::nodes_map statistics;
+				graph_type statistics;
 
 				// ACT
 				ss.update(trace.begin(), trace.end(), statistics);
@@ -37,7 +46,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss(overhead(0, 0));
-				statistic_types::nodes_map statistics;
+				graph_type statistics;
 				call_record trace1[] = {
 					{	123450000, (void *)0x01234567	},
 					{	123450013, (void *)0	},
@@ -70,7 +79,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss(overhead(0, 0));
-				statistic_types::nodes_map statistics;
+				graph_type statistics;
 				call_record trace1[] = {	{	123450000, (void *)0x01234567	},	};
 				call_record trace2[] = {	{	123450013, (void *)0	},	};
 				call_record trace3[] = {	{	123450000, (void *)0x0bcdef12	},	};
@@ -116,7 +125,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss1(overhead(0, 0)), ss2(overhead(0, 0));
-				statistic_types::nodes_map statistics1, statistics2;
+				graph_type statistics1, statistics2;
 				call_record trace1[] = {
 					{	123450000, (void *)0x01234567	},
 						{	123450013, (void *)0x01234568	},
@@ -151,7 +160,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss(overhead(0, 0));
-				statistic_types::nodes_map statistics;
+				graph_type statistics;
 				call_record trace[] = {
 					{	123450000, (void *)0x01234567	},
 						{	123450013, (void *)0x0bcdef12	},
@@ -174,7 +183,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss(overhead(0, 0));
-				statistic_types::nodes_map statistics;
+				graph_type statistics;
 				call_record trace[] = {
 					{	123450000, (void *)0x01234567	},
 					{	123450019, (void *)0	},
@@ -184,9 +193,9 @@ namespace micro_profiler
 					{	123450047, (void *)0	},
 				};
 
-				static_cast<function_statistics &>(statistics[(void *)0xabcdef01]) = make_statistics((const void *)0xabcdef01, 7, 0, 1170, 117, 112).second;
-				static_cast<function_statistics &>(statistics[(void *)0x01234567]) = make_statistics((const void *)0x01234567, 2, 0, 1179, 1171, 25).second;
-				static_cast<function_statistics &>(statistics[(void *)0x0bcdef12]) = make_statistics((const void *)0x0bcdef12, 3, 0, 1185, 1172, 11).second;
+				statistics[statistics.callee(graph_type::root, (void *)0xabcdef01)] = make_statistics((const void *)0xabcdef01, 7, 0, 1170, 117, 112).second;
+				statistics[statistics.callee(graph_type::root, (void *)0x01234567)] = make_statistics((const void *)0x01234567, 2, 0, 1179, 1171, 25).second;
+				statistics[statistics.callee(graph_type::root, (void *)0x0bcdef12)] = make_statistics((const void *)0x0bcdef12, 3, 0, 1185, 1172, 11).second;
 
 				// ACT
 				ss.update(begin(trace), end(trace), statistics);
@@ -204,7 +213,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss(overhead(0, 0));
-				statistic_types::nodes_map statistics;
+				graph_type statistics;
 				call_record trace1[] ={
 					{	123440000, (void *)0x00000010	},
 						{	123450000, (void *)0x01234560	},
@@ -240,7 +249,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss(overhead(0, 0));
-				statistic_types::nodes_map statistics;
+				graph_type statistics;
 				call_record trace[] = {
 					{	123440000, (void *)0x00000010	},
 						{	123450003, (void *)0x01234560	},
@@ -270,7 +279,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss1(overhead(1, 1)), ss2(overhead(2, 5));
-				statistic_types::nodes_map statistics1, statistics2;
+				graph_type statistics1, statistics2;
 				call_record trace[] = {
 					{	123440000, (void *)0x00000010	},
 						{	123450013, (void *)0x01234560	},
@@ -307,7 +316,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss(overhead(0, 0)), ss_delayed(overhead(1, 0));
-				statistic_types::nodes_map statistics, statistics_delayed;
+				graph_type statistics, statistics_delayed;
 				call_record trace[] = {
 					{	1, (void *)1	},
 						{	2, (void *)101	},
@@ -366,7 +375,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss(overhead(0, 0));
-				statistic_types::nodes_map statistics;
+				graph_type statistics;
 				call_record trace[] = {
 					{	1, (void *)1	},
 						{	2, (void *)101	},
@@ -401,7 +410,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss(overhead(0, 0));
-				statistic_types::nodes_map statistics;
+				graph_type statistics;
 				call_record trace[] = {
 					{	1, (void *)0x1	},
 						{	2, (void *)0x2	},
@@ -452,7 +461,7 @@ namespace micro_profiler
 			{
 				// INIT
 				shadow_stack<statistic_types::key> ss1(overhead(0, 0)), ss2(overhead(0, 0));
-				statistic_types::nodes_map statistics;
+				graph_type statistics;
 				call_record trace1[] = {
 					{	1, (void *)1	},
 						{	2, (void *)2	},
@@ -517,6 +526,257 @@ namespace micro_profiler
 						+ make_statistics((const void *)11, 0, 0, 0, 0, 0)),
 					statistics);
 			}
+
+
+			test( InclusiveCallTimesAreAccumulatedInNodesHistograms )
+			{
+				// INIT
+				shadow_stack<statistic_types::key> ss(overhead(0, 0));
+				graph_type statistics(true);
+				call_record trace[] = {
+					{	1000, (void *)1	},
+						{	1001, (void *)2	},
+						{	1002, (void *)0	},
+						{	1010, (void *)2	},
+						{	1013, (void *)0	},
+						{	1020, (void *)2	},
+						{	1023, (void *)0	},
+					{	1100, (void *)0	},
+				};
+				call_times_histogram reference1, reference2;
+
+				reference1.set_scale(call_times_scale());
+				reference1.add(100);
+				reference2.set_scale(call_times_scale());
+				reference2.add(1);
+				reference2.add(3, 2);
+
+				// ACT
+				ss.update(begin(trace), end(trace), statistics);
+
+				// ASSERT
+				const auto s1 = statistics.begin()->second;
+				const auto s2 = s1.callees().begin()->second;
+				call_times_histogram times1, times2;
+
+				s1.get_call_times(times1);
+				s2.get_call_times(times2);
+
+				assert_equal(call_times_scale(), times1.get_scale());
+				assert_equal(vector<count_t>(reference1.begin(), reference1.end()),
+					vector<count_t>(times1.begin(), times1.end()));
+				assert_equal(vector<count_t>(reference2.begin(), reference2.end()),
+					vector<count_t>(times2.begin(), times2.end()));
+				assert_equal(0u, s1.statistics().call_times.size());
+			}
+
+
+			test( CallTimesAreNotCollectedUnlessRequested )
+			{
+				// INIT
+				shadow_stack<statistic_types::key> ss(overhead(0, 0));
+				graph_type statistics;
+				call_record trace[] = {
+					{	1000, (void *)1	},
+					{	1100, (void *)0	},
+				};
+				call_times_histogram times;
+
+				// ACT
+				ss.update(begin(trace), end(trace), statistics);
+				statistics.begin()->second.get_call_times(times);
+
+				// ASSERT
+				assert_equal(0u, times.size());
+			}
+
+
+			test( FoldedCallsAreAccountedAsIfTracedIndividually )
+			{
+				// INIT
+				shadow_stack<statistic_types::key> ss(overhead(2, 5)), ss_folded(overhead(2, 5));
+				graph_type statistics, statistics_folded(true);
+				call_record trace[] = {
+					{	100, (void *)1	},
+						{	110, (void *)2	},
+						{	120, (void *)0	},
+						{	120, (void *)2	},
+						{	130, (void *)0	},
+						{	130, (void *)2	},
+						{	140, (void *)0	},
+						{	150, (void *)3	},
+						{	170, (void *)0	},
+					{	200, (void *)0	},
+				};
+				call_record trace_folded1[] = {
+					{	100, (void *)1	},
+						{	3, folded_calls_tag	},
+				};
+				call_record trace_folded2[] = {
+						{	110, (void *)2	},
+						{	140, (void *)0	},
+						{	150, (void *)3	},
+						{	170, (void *)0	},
+					{	200, (void *)0	},
+				};
+
+				// ACT
+				ss.update(begin(trace), end(trace), statistics);
+				ss_folded.update(begin(trace_folded1), end(trace_folded1), statistics_folded);
+				ss_folded.update(begin(trace_folded2), end(trace_folded2), statistics_folded);
+
+				// ASSERT
+				const auto reference = plural
+					+ make_statistics((const void *)1, 1, 0, 70, 28, 70, plural
+						+ make_statistics((const void *)2, 3, 0, 24, 24, 8)
+						+ make_statistics((const void *)3, 1, 0, 18, 18, 18));
+
+				assert_equivalent(reference, statistics);
+				assert_equivalent(reference, statistics_folded);
+
+				// INIT
+				const auto callees = statistics_folded.begin()->second.callees();
+				call_times_histogram reference_times;
+				vector<count_t> times;
+
+				reference_times.set_scale(call_times_scale());
+				reference_times.add(8, 3);
+				for (auto i = callees.begin(); i != callees.end(); ++i)
+				{
+					if (i->first == (const void *)2)
+					{
+						call_times_histogram h;
+
+						i->second.get_call_times(h);
+						times.assign(h.begin(), h.end());
+					}
+				}
+
+				// ASSERT
+				assert_equal(vector<count_t>(reference_times.begin(), reference_times.end()), times);
+			}
+
+
+			test( HardwareCounterDeltasAreAccumulatedOnlyForCallsCountedOnBothEnds )
+			{
+				// INIT
+				shadow_stack<statistic_types::key> ss(overhead(0, 0));
+				graph_type statistics;
+				call_record trace[] = {
+					{	10, hw_counter_tag	}, {	20, hw_counter_tag	}, {	1, hw_counter_tag	}, {	0, hw_counter_tag	},
+					{	1000, (void *)1	},
+						{	100, hw_counter_tag	}, {	300, hw_counter_tag	}, {	5, hw_counter_tag	}, {	1, hw_counter_tag	},
+						{	1001, (void *)2	},
+						{	400, hw_counter_tag	}, {	900, hw_counter_tag	}, {	9, hw_counter_tag	}, {	2, hw_counter_tag	},
+						{	1002, (void *)0	},
+						{	500, hw_counter_tag	}, {	1000, hw_counter_tag	},
+						{	1010, (void *)2	},
+						{	600, hw_counter_tag	}, {	1200, hw_counter_tag	}, {	20, hw_counter_tag	}, {	3, hw_counter_tag	},
+						{	1013, (void *)0	},
+						{	1020, (void *)3	},
+						{	700, hw_counter_tag	}, {	1300, hw_counter_tag	}, {	21, hw_counter_tag	}, {	4, hw_counter_tag	},
+						{	1023, (void *)0	},
+					{	1000, hw_counter_tag	}, {	2020, hw_counter_tag	}, {	31, hw_counter_tag	}, {	10, hw_counter_tag	},
+					{	1100, (void *)0	},
+				};
+
+				// ACT
+				ss.update(begin(trace), end(trace), statistics);
+
+				// ASSERT
+				const auto s1 = statistics.begin()->second;
+				const auto callees = s1.callees();
+				count_t reference1[] = {	990, 2000, 30, 10,	};
+				count_t reference2[] = {	300, 600, 4, 1,	};
+				count_t reference3[] = {	0, 0, 0, 0,	};
+
+				assert_equal(2u, callees.size());
+				assert_equal(mkvector(reference1), vector<count_t>(begin(s1.statistics().hw_counters), end(s1.statistics().hw_counters)));
+				for (auto i = callees.begin(); i != callees.end(); ++i)
+				{
+					const auto &counters = i->second.statistics().hw_counters;
+
+					assert_equal(i->first == (const void *)2 ? mkvector(reference2) : mkvector(reference3),
+						vector<count_t>(begin(counters), end(counters)));
+				}
+			}
+
+
+			test( AllocationsAreAttributedToTheCallOnTopOfTheStack )
+			{
+				// INIT
+				shadow_stack<statistic_types::key> ss(overhead(0, 0));
+				graph_type statistics;
+				call_record trace[] = {
+					{	5, allocations_tag	}, {	500, allocated_bytes_tag	},
+					{	1000, (void *)1	},
+						{	2, allocations_tag	}, {	48, allocated_bytes_tag	},
+						{	1001, (void *)2	},
+							{	1, allocations_tag	}, {	16, allocated_bytes_tag	},
+						{	1002, (void *)0	},
+						{	1010, (void *)2	},
+							{	3, allocations_tag	}, {	24, allocated_bytes_tag	},
+						{	1013, (void *)0	},
+						{	1, allocations_tag	}, {	8, allocated_bytes_tag	},
+					{	1100, (void *)0	},
+				};
+
+				// ACT
+				ss.update(begin(trace), end(trace), statistics);
+
+				// ASSERT
+				const auto s1 = statistics.begin()->second;
+				const auto s2 = s1.callees().begin()->second;
+
+				assert_equal(3u, s1.statistics().allocations);
+				assert_equal(56u, s1.statistics().allocated_bytes);
+				assert_equal(4u, s2.statistics().allocations);
+				assert_equal(40u, s2.statistics().allocated_bytes);
+			}
+
+
+			test( ContendedWaitsAreCallsOfTheBlockingFunctionAddingToTheTimeBlocked )
+			{
+				// INIT
+				shadow_stack<statistic_types::key> ss(overhead(1, 2));
+				graph_type statistics;
+				call_record trace[] = {
+					{	1000, (void *)1	},
+						{	1010, (void *)2	},
+							{	0x5000, lock_wait_tag	}, {	1020, (void *)100	}, {	1050, (void *)0	},
+							{	0x5000, lock_wait_tag	}, {	1060, (void *)100	}, {	1070, (void *)0	},
+						{	1080, (void *)0	},
+						{	0x6000, lock_wait_tag	}, {	1090, (void *)101	}, {	1190, (void *)0	},
+					{	1200, (void *)0	},
+				};
+
+				// ACT
+				ss.update(begin(trace), end(trace), statistics);
+
+				// ASSERT
+				const auto s1 = find_callee(statistics, (void *)1);
+				const auto s2 = find_callee(s1.callees(), (void *)2);
+				const auto s1w = find_callee(s1.callees(), (void *)101);
+				const auto s2w = find_callee(s2.callees(), (void *)100);
+
+				assert_equal(196u, s1.statistics().inclusive_time);
+				assert_equal(27u, s1.statistics().exclusive_time);
+				assert_equal(140u, s1.statistics().time_blocked);
+				assert_equal(69u, s2.statistics().inclusive_time);
+				assert_equal(29u, s2.statistics().exclusive_time);
+				assert_equal(40u, s2.statistics().time_blocked);
+				assert_equal(2u, s2w.statistics().times_called);
+				assert_equal(40u, s2w.statistics().inclusive_time);
+				assert_equal(40u, s2w.statistics().time_blocked);
+				assert_equal(100u, s1w.statistics().inclusive_time);
+				assert_equal(100u, s1w.statistics().time_blocked);
+
+				assert_equal(2u, ss.locks().size());
+				assert_equal(2u, ss.locks()[(void *)0x5000].contentions);
+				assert_equal(40u, ss.locks()[(void *)0x5000].time_blocked);
+				assert_equal(1u, ss.locks()[(void *)0x6000].contentions);
+				assert_equal(100u, ss.locks()[(void *)0x6000].time_blocked);
+			}
 		end_test_suite
 	}
 }
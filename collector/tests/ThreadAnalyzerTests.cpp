@@ -169,6 +169,71 @@ namespace micro_profiler
 
 				assert_equivalent(reference, a);
 			}
+
+
+			test( CallTimesAreReportedInChangesAndCollectedFurtherAfterReset )
+			{
+				// INIT
+				thread_analyzer a(overhead(0, 0), true);
+				call_graph_delta delta;
+				call_record trace1[] = {
+					{	100, addr(1234)	},
+					{	103, nullptr	},
+				};
+				call_record trace2[] = {
+					{	200, addr(1234)	},
+					{	300, nullptr	},
+				};
+				call_times_histogram reference1, reference2;
+
+				reference1.set_scale(call_times_scale());
+				reference1.add(3);
+				reference2.set_scale(call_times_scale());
+				reference2.add(100);
+
+				a.accept_calls(trace1, array_size(trace1));
+
+				// ACT
+				a.get_changes(delta);
+
+				// ASSERT
+				assert_equal(1u, delta.created.size());
+				assert_equal(vector<count_t>(reference1.begin(), reference1.end()),
+					vector<count_t>(delta.created[0].statistics.call_times.begin(),
+						delta.created[0].statistics.call_times.end()));
+
+				// INIT
+				a.accept_calls(trace2, array_size(trace2));
+
+				// ACT
+				a.get_changes(delta);
+
+				// ASSERT
+				assert_equal(1u, delta.updated.size());
+				assert_equal(vector<count_t>(reference2.begin(), reference2.end()),
+					vector<count_t>(delta.updated[0].second.call_times.begin(), delta.updated[0].second.call_times.end()));
+			}
+
+
+			test( CallTimesAreNotReportedUnlessRequested )
+			{
+				// INIT
+				thread_analyzer a(overhead(0, 0));
+				call_graph_delta delta;
+				call_record trace[] = {
+					{	100, addr(1234)	},
+					{	103, nullptr	},
+				};
+
+				a.accept_calls(trace, array_size(trace));
+
+				// ACT
+				a.get_changes(delta);
+
+				// ASSERT
+				assert_equal(1u, delta.created.size());
+				assert_equal(0u, delta.created[0].statistics.call_times.size());
+			}
 		end_test_suite
 	}
 }
@@ -402,6 +402,42 @@ namespace micro_profiler
 #endif
 			}
 
+
+			test( ExternallyRegisteredThreadsShareIDsWithSelfRegisteredOnes )
+			{
+				// INIT
+				const auto native_id = this_thread::get_native_id();
+				auto accessed = 0;
+				const auto accessor = [&] (thread_info &info) {
+					info.description = "external";
+					accessed++;
+				};
+
+				// ACT
+				const auto id1 = monitor->register_self();
+				const auto id2 = monitor->register_external(native_id, accessor);
+
+				// ASSERT
+				assert_equal(id1, id2);
+				assert_equal(0, accessed);
+
+				// ACT
+				const auto id3 = monitor->register_external(7123456, accessor);
+				const auto id4 = monitor->register_external(7123456, accessor);
+
+				// ASSERT
+				assert_not_equal(id1, id3);
+				assert_equal(id3, id4);
+				assert_equal(1, accessed);
+
+				// ACT
+				const auto info = get_info(*monitor, id3);
+
+				// ASSERT
+				assert_equal(7123456u, info.native_id);
+				assert_equal("external", info.description);
+				assert_equal(2, accessed);
+			}
 		end_test_suite
 	}
 }
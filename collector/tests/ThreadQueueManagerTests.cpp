@@ -18,6 +18,21 @@ namespace micro_profiler
 		namespace
 		{
 			const buffering_policy big_policy(10 * buffering_policy::buffer_size, 1, 1);
+
+			class counting_queue : public buffers_queue<int>
+			{
+			public:
+				counting_queue(allocator &allocator_, const buffering_policy &policy, unsigned int id)
+					: buffers_queue<int>(allocator_, policy, id), reads(0)
+				{	}
+
+				template <typename ReaderT, typename DropReaderT>
+				void read_collected(const ReaderT &reader, const DropReaderT &drop_reader)
+				{	reads++, buffers_queue<int>::read_collected(reader, drop_reader);	}
+
+			public:
+				unsigned int reads;
+			};
 		}
 
 		begin_test_suite( ThreadQueueManagerTests )
@@ -59,6 +74,365 @@ namespace micro_profiler
 
 				assert_equal(reference2, log);
 			}
+
+
+			test( OnlyQueuesOfTheRequestedPartitionAreRead )
+			{
+				// INIT
+				auto id = 0u;
+				vector<unsigned> log;
+				thread_queue_manager< buffers_queue<int> > qm(al, big_policy, thread_callbacks_, [&id] {	return id++;	});
+				const auto reader = [&log] (unsigned int id_, const int *, size_t) {	log.push_back(id_);	};
+				const auto drop_reader = [] (unsigned int, count_t) {	};
+
+				for (auto n = 5; n--; )
+				{
+					mt::thread t([&] {
+						auto &q = qm.get_queue();
+
+						q.current() = 1, q.push(), q.flush();
+					});
+					t.join();
+				}
+
+				// ACT
+				qm.read_collected(reader, drop_reader, 1, 3);
+
+				// ASSERT
+				unsigned reference1[] = {	1u, 4u,	};
+
+				assert_equal(reference1, log);
+
+				// INIT
+				log.clear();
+
+				// ACT
+				qm.read_collected(reader, drop_reader, 0, 3);
+				qm.read_collected(reader, drop_reader, 1, 3);
+				qm.read_collected(reader, drop_reader, 2, 3);
+
+				// ASSERT
+				unsigned reference2[] = {	0u, 3u, 2u,	};
+
+				assert_equal(reference2, log);
+			}
+
+
+			test( QueueOfAnExitedThreadIsDrainedAndReusedByANewThread )
+			{
+				// INIT
+				auto id = 0u;
+				vector< pair<unsigned, int> > log;
+				thread_queue_manager< buffers_queue<int> > qm(al, big_policy, thread_callbacks_, [&id] {	return id++;	});
+				const auto reader = [&log] (unsigned int id_, const int *items, size_t n) {
+					for (; n--; ++items)
+						log.push_back(make_pair(id_, *items));
+				};
+				const auto drop_reader = [] (unsigned int, count_t) {	};
+				buffers_queue<int> *q1 = nullptr, *q2 = nullptr, *q3 = nullptr;
+				mt::thread t1([&] {
+					q1 = &qm.get_queue();
+					q1->current() = 17, q1->push();
+				});
+				const auto tid1 = t1.get_id();
+
+				t1.join();
+
+				// ACT
+				qm.read_collected(reader, drop_reader);
+
+				// ASSERT
+				assert_is_empty(log);
+
+				// ACT
+				thread_callbacks_.invoke_destructors(tid1);
+				qm.read_collected(reader, drop_reader);
+				qm.read_collected(reader, drop_reader);
+
+				// ASSERT
+				pair<unsigned, int> reference1[] = {	make_pair(0u, 17),	};
+
+				assert_equal(reference1, log);
+
+				// INIT
+				log.clear();
+
+				// ACT
+				mt::thread t2([&] {
+					q2 = &qm.get_queue();
+					q2->current() = 19, q2->push(), q2->flush();
+				});
+				t2.join();
+				mt::thread t3([&] {	q3 = &qm.get_queue();	});
+				t3.join();
+				qm.read_collected(reader, drop_reader);
+
+				// ASSERT
+				pair<unsigned, int> reference2[] = {	make_pair(1u, 19),	};
+
+				assert_equal(q1, q2);
+				assert_not_equal(q1, q3);
+				assert_equal(1u, q2->get_id());
+				assert_equal(reference2, log);
+			}
+
+
+			test( ExitOfAThreadIsReportedByTheReadTakingTheLastOfItsTrace )
+			{
+				// INIT
+				auto id = 0u;
+				vector< pair<unsigned, int> > log;
+				thread_queue_manager< buffers_queue<int> > qm(al, big_policy, thread_callbacks_, [&id] {	return id++;	});
+				const auto reader = [&log] (unsigned int id_, const int *items, size_t n) {
+					for (; n--; ++items)
+						log.push_back(make_pair(id_, *items));
+				};
+				const auto drop_reader = [] (unsigned int, count_t) {	};
+				const auto exit_reader = [&log] (unsigned int id_) {	log.push_back(make_pair(id_, -1));	};
+				mt::thread t1([&] {
+					auto &q = qm.get_queue();
+
+					q.current() = 17, q.push();
+				});
+				const auto tid1 = t1.get_id();
+
+				t1.join();
+
+				// ACT
+				qm.read_collected(reader, drop_reader, exit_reader);
+
+				// ASSERT
+				assert_is_empty(log);
+
+				// ACT
+				thread_callbacks_.invoke_destructors(tid1);
+				qm.read_collected(reader, drop_reader, exit_reader);
+				qm.read_collected(reader, drop_reader, exit_reader);
+
+				// ASSERT
+				pair<unsigned, int> reference1[] = {	make_pair(0u, 17), make_pair(0u, -1),	};
+
+				assert_equal(reference1, log);
+
+				// INIT
+				log.clear();
+
+				mt::thread t2([&] {
+					auto &q = qm.get_queue();
+
+					q.current() = 19, q.push();
+				});
+				const auto tid2 = t2.get_id();
+
+				t2.join();
+
+				// ACT
+				thread_callbacks_.invoke_destructors(tid2);
+				qm.read_collected(reader, drop_reader, exit_reader, 0, 2);
+
+				// ASSERT
+				assert_is_empty(log);
+
+				// ACT
+				qm.read_collected(reader, drop_reader, exit_reader, 1, 2);
+				qm.read_collected(reader, drop_reader, exit_reader, 1, 2);
+
+				// ASSERT
+				pair<unsigned, int> reference2[] = {	make_pair(1u, 19), make_pair(1u, -1),	};
+
+				assert_equal(reference2, log);
+			}
+
+
+			test( QueueIsUnboundFromItsThreadUponTheExitNotification )
+			{
+				// INIT
+				auto id = 0u;
+				thread_queue_manager< buffers_queue<int> > qm(al, big_policy, thread_callbacks_, [&id] {	return id++;	});
+				const auto reader = [] (unsigned int, const int *, size_t) {	};
+				const auto drop_reader = [] (unsigned int, count_t) {	};
+				buffers_queue<int> *q1 = nullptr, *q2 = nullptr, *q3 = nullptr, *found = &qm.get_queue();
+
+				// ACT
+				mt::thread t1([&] {
+					q1 = &qm.get_queue();
+					thread_callbacks_.invoke_destructors(mt::this_thread::get_id());
+					found = qm.find_queue();
+					qm.read_collected(reader, drop_reader);
+
+					mt::thread t2([&] {	q2 = &qm.get_queue();	});
+
+					t2.join();
+					q3 = &qm.get_queue();
+				});
+
+				t1.join();
+
+				// ASSERT
+				assert_null(found);
+				assert_equal(q1, q2);
+				assert_not_equal(q1, q3);
+				assert_equal(&qm.get_queue(), qm.find_queue());
+			}
+
+
+			test( ExitedQueuesAreOnlyRetiredByTheirPartitionReads )
+			{
+				// INIT
+				auto id = 1u;
+				vector<unsigned> log;
+				thread_queue_manager< buffers_queue<int> > qm(al, big_policy, thread_callbacks_, [&id] {	return id++;	});
+				const auto reader = [&log] (unsigned int id_, const int *, size_t) {	log.push_back(id_);	};
+				const auto drop_reader = [] (unsigned int, count_t) {	};
+				buffers_queue<int> *q1 = nullptr, *q2 = nullptr, *q3 = nullptr;
+				mt::thread t1([&] {	q1 = &qm.get_queue(), q1->current() = 1, q1->push();	});
+				const auto tid1 = t1.get_id();
+
+				t1.join();
+				thread_callbacks_.invoke_destructors(tid1);
+
+				// ACT
+				qm.read_collected(reader, drop_reader, 0, 2);
+				mt::thread t2([&] {	q2 = &qm.get_queue();	});
+				t2.join();
+
+				// ASSERT
+				assert_is_empty(log);
+				assert_not_equal(q1, q2);
+
+				// ACT
+				qm.read_collected(reader, drop_reader, 1, 2);
+				mt::thread t3([&] {	q3 = &qm.get_queue();	});
+				t3.join();
+
+				// ASSERT
+				unsigned reference[] = {	1u,	};
+
+				assert_equal(reference, log);
+				assert_equal(q1, q3);
+				assert_equal(3u, q3->get_id());
+			}
+
+
+			test( ExcessBuffersOfAnExitedThreadAreReturnedToAllocator )
+			{
+				// INIT
+				mocks::allocator mal;
+				auto id = 0u;
+				thread_queue_manager< buffers_queue<int> > qm(mal, buffering_policy(10 * buffering_policy::buffer_size,
+					1, 0.1), thread_callbacks_, [&id] {	return id++;	});
+				const auto reader = [] (unsigned int, const int *, size_t) {	};
+				const auto drop_reader = [] (unsigned int, count_t) {	};
+				size_t fresh = 0, used = 0;
+				mt::thread t([&] {
+					auto &q = qm.get_queue();
+
+					fresh = mal.allocated;
+					for (auto n = 3; n--; )
+						q.current() = 1, q.push(), q.flush(), qm.read_collected(reader, drop_reader);
+					used = mal.allocated;
+				});
+				const auto tid = t.get_id();
+
+				t.join();
+
+				// ACT
+				thread_callbacks_.invoke_destructors(tid);
+				qm.read_collected(reader, drop_reader);
+
+				// ASSERT
+				assert_is_true(used > fresh);
+				assert_equal(fresh, mal.allocated);
+			}
+
+
+			test( OnlyQueuesWithBuffersHandedOffAreVisitedOnRead )
+			{
+				// INIT
+				auto id = 0u;
+				vector<unsigned> log;
+				thread_queue_manager<counting_queue> qm(al, big_policy, thread_callbacks_, [&id] {	return id++;	});
+				const auto reader = [&log] (unsigned int id_, const int *, size_t) {	log.push_back(id_);	};
+				const auto drop_reader = [] (unsigned int, count_t) {	};
+				vector<counting_queue *> queues;
+
+				for (auto n = 200; n--; )
+				{
+					mt::thread t([&] {	queues.push_back(&qm.get_queue());	});
+					t.join();
+				}
+
+				// ACT
+				mt::thread t1([&] {	queues[7]->current() = 1, queues[7]->push(), queues[7]->flush();	});
+				t1.join();
+				mt::thread t2([&] {	queues[130]->current() = 1, queues[130]->push(), queues[130]->flush();	});
+				t2.join();
+				qm.read_collected(reader, drop_reader);
+
+				// ASSERT
+				unsigned reference1[] = {	7u, 130u,	};
+
+				assert_equal(reference1, log);
+				for (auto i = 0u; i != queues.size(); ++i)
+					assert_equal(i == 7 || i == 130 ? 1u : 0u, queues[i]->reads);
+
+				// ACT
+				qm.read_collected(reader, drop_reader);
+				mt::thread t3([&] {	queues[64]->current() = 1, queues[64]->push(), queues[64]->flush();	});
+				t3.join();
+				qm.read_collected(reader, drop_reader, 1, 2);
+
+				// ASSERT
+				assert_equal(1u, queues[7]->reads);
+				assert_equal(0u, queues[64]->reads);
+
+				// ACT
+				qm.read_collected(reader, drop_reader, 0, 2);
+
+				// ASSERT
+				unsigned reference2[] = {	7u, 130u, 64u,	};
+
+				assert_equal(reference2, log);
+				assert_equal(1u, queues[64]->reads);
+			}
+
+
+			test( BuffersOfAQueueSkippedByReadsAreShrunk )
+			{
+				// INIT
+				auto id = 0u;
+				vector<size_t> log;
+				thread_queue_manager< buffers_queue<int> > qm(al, buffering_policy(100 * buffering_policy::buffer_size,
+					0.03, 0.03, buffering_policy::block_on_overflow, 64, 1024), thread_callbacks_, [&id] {	return id++;	});
+				const auto reader = [&log] (unsigned int, const int *, size_t n) {	log.push_back(n);	};
+				const auto drop_reader = [] (unsigned int, count_t) {	};
+				const auto fill = [] (buffers_queue<int> &q, unsigned int n) {
+					while (n--)
+						q.push();
+				};
+				buffers_queue<int> *q = nullptr;
+				mt::thread t([&] {	q = &qm.get_queue();	});
+
+				t.join();
+				fill(*q, buffering_policy::buffer_size);
+				qm.read_collected(reader, drop_reader);
+
+				// ACT
+				for (auto n = 20; n--; )
+					qm.read_collected(reader, drop_reader);
+				fill(*q, buffering_policy::buffer_size);
+				qm.read_collected(reader, drop_reader);
+				fill(*q, buffering_policy::buffer_size + buffering_policy::buffer_size / 2);
+				qm.read_collected(reader, drop_reader);
+
+				// ASSERT
+				size_t reference[] = {
+					buffering_policy::buffer_size, buffering_policy::buffer_size, buffering_policy::buffer_size,
+					buffering_policy::buffer_size / 2,
+				};
+
+				assert_equal(reference, log);
+			}
 		end_test_suite
 	}
 }
@@ -0,0 +1,208 @@
+#include <collector/translation_cache.h>
+
+#include "mocks_mapping_access.h"
+
+#include <collector/module_tracker.h>
+#include <common/file_stream.h>
+#include <common/formatting.h>
+#include <common/path.h>
+#include <test-helpers/file_helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			void write_file(const string &path, const string &content)
+			{	write_file_stream(path).write(content.data(), content.size());	}
+
+			string read_file(const string &path)
+			{
+				char buffer[1000];
+
+				return string(buffer, read_file_stream(path).read_l(buffer, sizeof(buffer)));
+			}
+
+			string format_plan(uint32_t hash, unsigned int rva, unsigned int size, unsigned int prologue_size,
+				const string &error)
+			{
+				string line;
+
+				itoa<16>(line, hash), line += ' ';
+				itoa<16>(line, rva), line += ' ';
+				itoa<10>(line, size), line += ' ';
+				itoa<10>(line, prologue_size), line += ' ';
+				return line + error + '\n';
+			}
+		}
+
+		begin_test_suite( TranslationCacheTests )
+			temporary_directory dir;
+			mocks::mapping_access mappings;
+			vector<byte> code;
+			string image_path;
+			uint32_t image_hash;
+
+			init( Init )
+			{
+				code.assign(0x100, 0);
+				image_path = dir.track_file("image.so");
+				write_file(image_path, "some image content");
+				image_hash = module_tracker::calculate_hash(image_path);
+			}
+
+
+			test( CacheSubscribesToMappingsAtConstruction )
+			{
+				// INIT / ACT
+				translation_cache cache(mappings);
+
+				// ASSERT
+				assert_equal(&cache, mappings.subscription);
+			}
+
+
+			test( LoadedPlansAreReturnedForTheFunctionsOfTheImagesMapped )
+			{
+				// INIT
+				const auto path = dir.track_file("translation.cache");
+				translation_cache cache(mappings);
+
+				write_file(path, "build=1234abcd\n"
+					+ format_plan(image_hash, 0x10, 20, 7, "")
+					+ format_plan(image_hash, 0x30, 13, 0, "some instruction cannot be moved"));
+				mappings.emulate_mapped(1, 3, image_path, code.data());
+
+				// ACT / ASSERT
+				assert_is_true(cache.load(path, "build=1234abcd"));
+
+				// ACT
+				const auto plan1 = cache.get_plan(code.data() + 0x10, 20);
+				const auto plan2 = cache.get_plan(code.data() + 0x30, 13);
+
+				// ASSERT
+				assert_equal(7u, plan1.prologue_size);
+				assert_is_empty(plan1.error);
+				assert_equal(0u, plan2.prologue_size);
+				assert_equal("some instruction cannot be moved", plan2.error);
+			}
+
+
+			test( PlansAreMadeAnewForMismatchingSizesAndUnknownImages )
+			{
+				// INIT
+				const auto path = dir.track_file("translation.cache");
+				translation_cache cache(mappings);
+
+				write_file(path, "build=1234abcd\n"
+					+ format_plan(image_hash, 0x10, 20, 7, "")
+					+ format_plan(image_hash + 1, 0x30, 2, 7, ""));
+				cache.load(path, "build=1234abcd");
+				mappings.emulate_mapped(1, 3, image_path, code.data());
+
+				// ACT
+				const auto plan1 = cache.get_plan(code.data() + 0x10, 2);
+				const auto plan2 = cache.get_plan(code.data() + 0x30, 2);
+
+				// ASSERT
+				assert_equal(0u, plan1.prologue_size);
+				assert_is_false(plan1.error.empty());
+				assert_equal(0u, plan2.prologue_size);
+				assert_is_false(plan2.error.empty());
+
+				// INIT
+				mappings.emulate_unmapped(3);
+
+				// ACT
+				const auto plan3 = cache.get_plan(code.data() + 0x10, 20);
+
+				// ASSERT
+				assert_not_equal(7u, plan3.prologue_size);
+			}
+
+
+			test( OnlyPlansUsedAreStored )
+			{
+				// INIT
+				const auto path1 = dir.track_file("translation1.cache");
+				const auto path2 = dir.track_file("translation2.cache");
+				translation_cache cache(mappings);
+
+				write_file(path1, "build=1234abcd\n"
+					+ format_plan(image_hash, 0x10, 20, 7, "")
+					+ format_plan(image_hash, 0x30, 13, 0, "some instruction cannot be moved")
+					+ format_plan(image_hash, 0x50, 11, 5, ""));
+				cache.load(path1, "build=1234abcd");
+				mappings.emulate_mapped(1, 3, image_path, code.data());
+				cache.get_plan(code.data() + 0x50, 11);
+				cache.get_plan(code.data() + 0x30, 13);
+				cache.get_plan(code.data() + 0x60, 1);
+
+				// ACT
+				cache.store(path2, "build=ffff0000");
+
+				// ASSERT
+				assert_equal("build=ffff0000\n"
+					+ format_plan(image_hash, 0x30, 13, 0, "some instruction cannot be moved")
+					+ format_plan(image_hash, 0x50, 11, 5, "")
+					+ format_plan(image_hash, 0x60, 1, 0, cache.get_plan(code.data() + 0x60, 1).error),
+					read_file(path2));
+
+				// INIT
+				translation_cache cache2(mappings);
+
+				mappings.emulate_mapped(1, 3, image_path, code.data());
+
+				// ACT / ASSERT
+				assert_is_true(cache2.load(path2, "build=ffff0000"));
+				assert_equal(5u, cache2.get_plan(code.data() + 0x50, 11).prologue_size);
+			}
+
+
+			test( CacheIsNotLoadedForAMismatchingKeyOrAMalformedFile )
+			{
+				// INIT
+				const auto path = dir.track_file("translation.cache");
+				translation_cache cache(mappings);
+
+				mappings.emulate_mapped(1, 3, image_path, code.data());
+
+				// ACT / ASSERT
+				assert_is_false(cache.load(path, "build=1234abcd"));
+
+				// INIT
+				write_file(path, "build=1234abcd\n" + format_plan(image_hash, 0x10, 20, 7, ""));
+
+				// ACT / ASSERT
+				assert_is_false(cache.load(path, "build=1234abce"));
+				assert_is_false(cache.load(path, ""));
+
+				// INIT
+				write_file(path, "build=1234abcd\n" + format_plan(image_hash, 0x10, 20, 7, "") + "1 2 3");
+
+				// ACT / ASSERT
+				assert_is_false(cache.load(path, "build=1234abcd"));
+
+				// INIT
+				write_file(path, "build=1234abcd\n" + format_plan(image_hash, 0x10, 20, 700, ""));
+
+				// ACT / ASSERT
+				assert_is_false(cache.load(path, "build=1234abcd"));
+
+				// INIT
+				write_file(path, "build=1234abcd\n1 2 3 4\n");
+
+				// ACT / ASSERT
+				assert_is_false(cache.load(path, "build=1234abcd"));
+
+				// ASSERT
+				assert_not_equal(7u, cache.get_plan(code.data() + 0x10, 20).prologue_size);
+			}
+		end_test_suite
+	}
+}
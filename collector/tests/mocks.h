@@ -89,10 +89,12 @@ namespace micro_profiler
 			{
 			public:
 				virtual void read_collected(acceptor &a) override;
+				virtual void read_collected(acceptor &a, unsigned int partition, unsigned int partitions) override;
 				virtual void flush() override;
 
 			public:
 				std::function<void (acceptor &a)> on_read_collected;
+				std::function<void (acceptor &a, unsigned int partition, unsigned int partitions)> on_read_partition;
 				std::function<void ()> on_flush;
 			};
 
@@ -104,6 +106,14 @@ namespace micro_profiler
 					on_read_collected(a);
 			}
 
+			inline void tracer::read_collected(acceptor &a, unsigned int partition, unsigned int partitions)
+			{
+				if (on_read_partition)
+					on_read_partition(a, partition, partitions);
+				else if (!partition)
+					read_collected(a);
+			}
+
 			inline void tracer::flush()
 			{
 				if (on_flush)
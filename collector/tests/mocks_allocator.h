@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/allocator.h>
+#include <functional>
 
 namespace micro_profiler
 {
@@ -15,6 +16,7 @@ namespace micro_profiler
 
 			public:
 				size_t allocated, operations;
+				std::function<void ()> on_operation;
 
 			private:
 				virtual void *allocate(size_t length) override;
@@ -35,6 +37,8 @@ namespace micro_profiler
 				auto memory = _underlying.allocate(length);
 
 				operations++;
+				if (on_operation)
+					on_operation();
 				return allocated++, memory;
 			}
 
@@ -43,6 +47,8 @@ namespace micro_profiler
 				_underlying.deallocate(memory);
 				operations++;
 				allocated--;
+				if (on_operation)
+					on_operation();
 			}
 		}
 	}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <patcher/interface.h>
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace mocks
+		{
+			class mapping_access : public micro_profiler::mapping_access
+			{
+			public:
+				mapping_access();
+
+				void emulate_mapped(id_t module_id, id_t mapping_id, const std::string &path, byte *base);
+				void emulate_unmapped(id_t mapping_id);
+
+			public:
+				events *subscription;
+
+			private:
+				virtual std::shared_ptr<module::mapping> lock_mapping(id_t mapping_id) override;
+				virtual std::shared_ptr<void> notify(events &events_) override;
+			};
+
+
+
+			inline mapping_access::mapping_access()
+				: subscription(nullptr)
+			{	}
+
+			inline void mapping_access::emulate_mapped(id_t module_id, id_t mapping_id, const std::string &path,
+				byte *base)
+			{
+				module::mapping m = {	path, base,	};
+
+				subscription->mapped(module_id, mapping_id, m);
+			}
+
+			inline void mapping_access::emulate_unmapped(id_t mapping_id)
+			{	subscription->unmapped(mapping_id);	}
+
+			inline std::shared_ptr<module::mapping> mapping_access::lock_mapping(id_t /*mapping_id*/)
+			{	return nullptr;	}
+
+			inline std::shared_ptr<void> mapping_access::notify(events &events_)
+			{	return subscription = &events_, nullptr;	}
+		}
+	}
+}
@@ -45,6 +45,10 @@ namespace micro_profiler
 
 		virtual thread_id register_self();
 
+		// Registers a thread observed from outside of it (its exit is not tracked). Returns the ID already assigned, if
+		// the thread is registered.
+		thread_id register_external(native_thread_id native_id, const std::function<void (thread_info &info)> &accessor);
+
 		template <typename OutputIteratorT, typename IteratorT>
 		void get_info(OutputIteratorT destination, IteratorT begin_id, IteratorT end_id) const;
 
@@ -25,6 +25,8 @@
 #include <common/allocator.h>
 #include <common/noncopyable.h>
 #include <common/compiler.h>
+#include <atomic>
+#include <deque>
 #include <memory>
 #include <mt/mutex.h>
 #include <mt/thread_callbacks.h>
@@ -33,6 +35,13 @@
 
 namespace micro_profiler
 {
+	// The queues of the threads exited are drained by the next read covering them (which then reports the exit to the
+	// exit reader, if given), trimmed and kept in a bounded free list for the new threads to reuse. The exit
+	// notification unbinds the queue from its thread, so that calls the thread tracks afterwards (e.g. from the later
+	// TLS destructors) get a queue of their own, never a reused one.
+	// Each queue owns a bit in a readiness bitmap, which it raises on handing a buffer off. Reads only visit the queues
+	// with their bits raised, so idle threads cost nothing to the reader. The reads are counted, so that a queue
+	// visited learns how many reads of its partition it has been skipped by (see buffers_queue::skip_reads()).
 	template <typename Q>
 	class thread_queue_manager : noncopyable
 	{
@@ -46,19 +55,66 @@ namespace micro_profiler
 		void set_buffering_policy(const buffering_policy &policy);
 		template <typename ReaderT>
 		void read_collected(const ReaderT &reader);
+		template <typename ReaderT, typename DropReaderT>
+		void read_collected(const ReaderT &reader, const DropReaderT &drop_reader);
+		template <typename ReaderT, typename DropReaderT, typename ExitReaderT>
+		void read_collected(const ReaderT &reader, const DropReaderT &drop_reader, const ExitReaderT &exit_reader);
+
+		// Reads only the queues with 'id % partitions == partition'. Different partitions can be read concurrently,
+		// since each queue belongs to exactly one of them, but a partition must not be read by two threads at once.
+		// Partitioned reads must not overlap with the unpartitioned ones or with set_buffering_policy().
+		template <typename ReaderT, typename DropReaderT>
+		void read_collected(const ReaderT &reader, const DropReaderT &drop_reader, unsigned int partition,
+			unsigned int partitions);
+		template <typename ReaderT, typename DropReaderT, typename ExitReaderT>
+		void read_collected(const ReaderT &reader, const DropReaderT &drop_reader, const ExitReaderT &exit_reader,
+			unsigned int partition, unsigned int partitions);
+
 		void flush() throw();
 		Q &get_queue();
 
+		// Returns the queue of the calling thread, or nullptr if it has not got one yet. Never allocates.
+		Q *find_queue() const throw();
+
 	protected:
 		Q &construct_queue();
 
 	private:
 		typedef std::vector< std::shared_ptr<Q> > queues_t;
+		typedef std::vector< std::pair<std::shared_ptr<Q>, unsigned int /*slot*/> > exited_queues_t;
+		typedef std::atomic<unsigned long long> ready_word;
+
+		// Shared with the thread exit handlers, which may outlive the manager.
+		struct shared_state
+		{
+			mt::tls<Q> queue_pointers;
+			mt::mutex exited_mtx;
+			exited_queues_t exited;
+			std::deque<ready_word> ready; // Only grows (under _mtx), thus the words never move.
+		};
+
+		enum {	max_free_queues = 16, word_bits = 64,	};
+
+		struct ignore_exits
+		{
+			void operator ()(unsigned int /*id*/) const {	}
+		};
 
 	private:
-		mt::tls<Q> _queue_pointers_tls;
+		template <typename F>
+		void take_ready(unsigned int partition, unsigned int partitions, const F &f);
+		void take_exited(exited_queues_t &exited, unsigned int partition, unsigned int partitions);
+		void retire(const exited_queues_t &exited);
+		unsigned int allocate_slot();
 
-		queues_t _queues;
+	private:
+		const std::shared_ptr<shared_state> _shared;
+		mt::tls<Q> &_queue_pointers_tls;
+		queues_t _queues; // Indexed by the bit number in the readiness bitmap, the vacant slots hold nullptr.
+		std::vector<unsigned int> _visited_at; // The read count as of the last visit, indexed by the slot.
+		unsigned int _reads;
+		std::vector< std::pair<std::shared_ptr<Q>, unsigned int> > _free_queues;
+		std::vector<unsigned int> _free_slots;
 		mt::thread_callbacks &_thread_callbacks;
 		allocator &_allocator;
 		mt::mutex _mtx;
@@ -71,7 +127,8 @@ namespace micro_profiler
 	template <typename Q>
 	inline thread_queue_manager<Q>::thread_queue_manager(allocator &allocator_, const buffering_policy &policy,
 			mt::thread_callbacks &callbacks, const id_gen_cb &id_gen)
-		: _thread_callbacks(callbacks), _allocator(allocator_), _policy(policy), _id_gen(id_gen)
+		: _shared(std::make_shared<shared_state>()), _queue_pointers_tls(_shared->queue_pointers), _reads(0),
+			_thread_callbacks(callbacks), _allocator(allocator_), _policy(policy), _id_gen(id_gen)
 	{	}
 
 	template <typename Q>
@@ -80,7 +137,10 @@ namespace micro_profiler
 		mt::lock_guard<mt::mutex> l(_mtx);
 
 		for (auto i = _queues.begin(); i != _queues.end(); ++i)
-			(*i)->set_buffering_policy(policy);
+		{
+			if (*i)
+				(*i)->set_buffering_policy(policy);
+		}
 		_policy = policy;
 	}
 
@@ -89,9 +149,71 @@ namespace micro_profiler
 	inline void thread_queue_manager<Q>::read_collected(const ReaderT &reader)
 	{
 		mt::lock_guard<mt::mutex> l(_mtx);
+		exited_queues_t exited;
 
-		for (auto i = _queues.begin(); i != _queues.end(); ++i)
-			(*i)->read_collected(reader);
+		take_exited(exited, 0, 1);
+		take_ready(0, 1, [&reader] (const std::shared_ptr<Q> &queue) {
+			queue->read_collected(reader);
+		});
+		retire(exited);
+	}
+
+	template <typename Q>
+	template <typename ReaderT, typename DropReaderT>
+	inline void thread_queue_manager<Q>::read_collected(const ReaderT &reader, const DropReaderT &drop_reader)
+	{	read_collected(reader, drop_reader, ignore_exits());	}
+
+	template <typename Q>
+	template <typename ReaderT, typename DropReaderT, typename ExitReaderT>
+	inline void thread_queue_manager<Q>::read_collected(const ReaderT &reader, const DropReaderT &drop_reader,
+		const ExitReaderT &exit_reader)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+		exited_queues_t exited;
+
+		take_exited(exited, 0, 1);
+		take_ready(0, 1, [&reader, &drop_reader] (const std::shared_ptr<Q> &queue) {
+			queue->read_collected(reader, drop_reader);
+		});
+		for (auto i = exited.begin(); i != exited.end(); ++i)
+			exit_reader(i->first->get_id());
+		retire(exited);
+	}
+
+	template <typename Q>
+	template <typename ReaderT, typename DropReaderT>
+	inline void thread_queue_manager<Q>::read_collected(const ReaderT &reader, const DropReaderT &drop_reader,
+		unsigned int partition, unsigned int partitions)
+	{	read_collected(reader, drop_reader, ignore_exits(), partition, partitions);	}
+
+	template <typename Q>
+	template <typename ReaderT, typename DropReaderT, typename ExitReaderT>
+	inline void thread_queue_manager<Q>::read_collected(const ReaderT &reader, const DropReaderT &drop_reader,
+		const ExitReaderT &exit_reader, unsigned int partition, unsigned int partitions)
+	{
+		queues_t queues;
+		exited_queues_t exited;
+
+		{
+			mt::lock_guard<mt::mutex> l(_mtx);
+
+			take_exited(exited, partition, partitions);
+			take_ready(partition, partitions, [&queues] (const std::shared_ptr<Q> &queue) {
+				queues.push_back(queue);
+			});
+		}
+		for (auto i = queues.begin(); i != queues.end(); ++i)
+			(*i)->read_collected(reader, drop_reader);
+		if (!exited.empty())
+		{
+			// The queues exited are retired after reporting, so that none gets reused (and renumbered) meanwhile.
+			for (auto i = exited.begin(); i != exited.end(); ++i)
+				exit_reader(i->first->get_id());
+
+			mt::lock_guard<mt::mutex> l(_mtx);
+
+			retire(exited);
+		}
 	}
 
 	template <typename Q>
@@ -109,29 +231,140 @@ namespace micro_profiler
 		return construct_queue();
 	}
 
+	template <typename Q>
+	inline Q *thread_queue_manager<Q>::find_queue() const throw()
+	{	return _queue_pointers_tls.get();	}
+
 	template <typename Q>
 	FORCE_NOINLINE inline Q &thread_queue_manager<Q>::construct_queue()
 	{
 		unsigned int id;
 		buffering_policy policy(0, 0, 0);
+		std::shared_ptr<Q> trace;
+		auto slot = 0u;
 
 		{
 			mt::lock_guard<mt::mutex> l(_mtx);
 			
 			id = _id_gen();
 			policy = _policy;
+			if (!_free_queues.empty())
+				trace = _free_queues.back().first, slot = _free_queues.back().second, _free_queues.pop_back();
 		}
 
-		const auto trace = std::make_shared<Q>(_allocator, policy, id);
+		const auto recycled = !!trace;
 
-		_thread_callbacks.at_thread_exit([trace] {	trace->flush();	});
-		_queue_pointers_tls.set(trace.get());
+		if (recycled)
+			trace->reset(id), trace->set_buffering_policy(policy);
+		else
+			trace = std::make_shared<Q>(_allocator, policy, id);
 
 		{
 			mt::lock_guard<mt::mutex> l(_mtx);
 
-			_queues.push_back(trace);
+			if (!recycled)
+			{
+				slot = allocate_slot();
+				trace->set_ready_flag(_shared->ready[slot / word_bits], 1ull << slot % word_bits);
+			}
+			_queues[slot] = trace;
+			_visited_at[slot] = _reads;
 		}
+
+		const auto shared = _shared;
+
+		_thread_callbacks.at_thread_exit([trace, slot, shared] {
+			trace->flush();
+			if (shared->queue_pointers.get() == trace.get())
+				shared->queue_pointers.set(nullptr);
+
+			mt::lock_guard<mt::mutex> l(shared->exited_mtx);
+
+			shared->exited.push_back(std::make_pair(trace, slot));
+		});
+		_queue_pointers_tls.set(trace.get());
 		return *trace;
 	}
+
+	template <typename Q>
+	template <typename F>
+	inline void thread_queue_manager<Q>::take_ready(unsigned int partition, unsigned int partitions, const F &f)
+	{
+		const auto reads = ++_reads;
+		auto slot = 0u;
+
+		for (auto w = _shared->ready.begin(); w != _shared->ready.end(); ++w, slot += word_bits)
+		{
+			auto bits = w->load();
+
+			for (auto b = 0u; bits; ++b, bits >>= 1)
+			{
+				const auto &queue = _queues[slot + b];
+
+				if (!(bits & 1) || !queue || queue->get_id() % partitions != partition)
+					continue;
+
+				// The partitions are read in turns, so the reads of this one are about 1/partitions of all.
+				auto &visited_at = _visited_at[slot + b];
+
+				if (const auto skipped = (reads - visited_at) / partitions)
+					queue->skip_reads(skipped - 1);
+				visited_at = reads;
+
+				// The bit is lowered before reading, so that a buffer handed off meanwhile raises it again.
+				w->fetch_and(~(1ull << b)), f(queue);
+			}
+		}
+	}
+
+	template <typename Q>
+	inline void thread_queue_manager<Q>::take_exited(exited_queues_t &exited, unsigned int partition,
+		unsigned int partitions)
+	{
+		mt::lock_guard<mt::mutex> l(_shared->exited_mtx);
+
+		for (auto i = _shared->exited.begin(); i != _shared->exited.end(); )
+		{
+			if (i->first->get_id() % partitions == partition)
+				exited.push_back(*i), i = _shared->exited.erase(i);
+			else
+				++i;
+		}
+	}
+
+	template <typename Q>
+	inline void thread_queue_manager<Q>::retire(const exited_queues_t &exited)
+	{
+		for (auto i = exited.begin(); i != exited.end(); ++i)
+		{
+			const auto slot = i->second;
+
+			_queues[slot].reset();
+			_shared->ready[slot / word_bits].fetch_and(~(1ull << slot % word_bits));
+			if (_free_queues.size() < max_free_queues)
+				i->first->trim(), _free_queues.push_back(*i);
+			else
+				_free_slots.push_back(slot);
+		}
+	}
+
+	template <typename Q>
+	inline unsigned int thread_queue_manager<Q>::allocate_slot()
+	{
+		if (!_free_slots.empty())
+		{
+			const auto slot = _free_slots.back();
+
+			_free_slots.pop_back();
+			return slot;
+		}
+
+		const auto slot = static_cast<unsigned int>(_queues.size());
+
+		if (!(slot % word_bits))
+			_shared->ready.emplace_back(0);
+		_queues.push_back(std::shared_ptr<Q>());
+		_visited_at.push_back(0);
+		return slot;
+	}
 }
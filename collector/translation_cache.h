@@ -0,0 +1,83 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include <common/noncopyable.h>
+#include <map>
+#include <mt/mutex.h>
+#include <patcher/interface.h>
+#include <patcher/translated_function_patch.h>
+#include <tuple>
+
+namespace micro_profiler
+{
+	// Keeps the translation plans of the functions patched, keyed by the hash of their image and their RVA, so that a
+	// saved patch set can be reapplied on a restart without validating the functions again. The image of a function is
+	// found among the mappings notified, thus the cache must subscribe before the patch manager does.
+	class translation_cache : public mapping_access::events, noncopyable
+	{
+	public:
+		explicit translation_cache(mapping_access &mappings);
+
+		// Returns the plan known for the function or makes a new one. The functions outside of the images notified or
+		// in the images that cannot be hashed are planned anew each time.
+		translation_plan get_plan(void *target, std::size_t size);
+
+		// Returns false and leaves the cache intact, if the file is missing, malformed or is stored for another key.
+		bool load(const std::string &path, const std::string &key);
+
+		// Only stores the plans made or used since the cache was created, so that the plans for the images gone do not
+		// pile up.
+		void store(const std::string &path, const std::string &key) const;
+
+	private:
+		enum hash_state {	not_hashed, hashed, unhashable,	};
+
+		struct image
+		{
+			id_t mapping_id;
+			std::string path;
+			std::uint32_t hash;
+			hash_state state;
+		};
+
+		struct plan_entry
+		{
+			unsigned int size;
+			translation_plan plan;
+			bool used;
+		};
+
+		typedef std::tuple<std::uint32_t /*hash*/, unsigned int /*rva*/> plan_key;
+
+	private:
+		virtual void mapped(id_t module_id, id_t mapping_id, const module::mapping &mapping) override;
+		virtual void unmapped(id_t mapping_id) override;
+
+		static bool get_hash(image &image_);
+
+	private:
+		mutable mt::mutex _mtx;
+		std::map<const byte *, image> _images;
+		std::map<plan_key, plan_entry> _plans;
+		std::shared_ptr<void> _mapping_subscription;
+	};
+}
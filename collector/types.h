@@ -31,10 +31,63 @@ namespace micro_profiler
 		const void *callee;
 	};
 
+	// A delta-encoded call record (see compact_encoder). A rebase record is followed by a full timestamp, an escape
+	// record by a full callee address, a folded calls record by a number of calls, a counter record by a counter
+	// reading, the allocation records by the allocations count or size and a lock wait record by the lock address, all
+	// stored in a subsequent record as a wide value.
+	struct compact_call_record
+	{
+		enum tags {
+			exit_tag = 0,
+			lock_wait_tag = 0xFFFFFFF9,
+			allocated_bytes_tag = 0xFFFFFFFA,
+			allocations_tag = 0xFFFFFFFB,
+			counter_tag = 0xFFFFFFFC,
+			folded_tag = 0xFFFFFFFD,
+			escape_tag = 0xFFFFFFFE,
+			rebase_tag = 0xFFFFFFFF,
+		};
+
+		enum {	max_delta = 0xFFFFFFFF,	};
+
+		unsigned long long wide() const throw();
+
+		unsigned int delta; // Ticks passed since the previous record.
+		unsigned int callee; // One-based index in the thread's callee_table or a tag.
+	};
+
 	struct return_entry
 	{
 		const void **stack_ptr;
 		const void *return_address;
 	};
 #pragma pack(pop)
+
+	// The callee of a record preceding an entry/exit pair that stands for a number of short calls folded together
+	// (see calls_collector_thread). The number of calls is stored in the record's timestamp.
+	const void * const folded_calls_tag = reinterpret_cast<const void *>(static_cast<size_t>(-1));
+
+	// The callee of each of the max_hw_counters records preceding an entry or an exit, when the hardware counters are
+	// collected. The counter reading (in hw_counter order) is stored in the record's timestamp.
+	const void * const hw_counter_tag = reinterpret_cast<const void *>(static_cast<size_t>(-2));
+
+	// The callees of the pair of records preceding an entry or an exit, when the heap allocations are tracked. They
+	// carry the number of allocations and the bytes allocated within the call active, since the previous record.
+	const void * const allocations_tag = reinterpret_cast<const void *>(static_cast<size_t>(-3));
+	const void * const allocated_bytes_tag = reinterpret_cast<const void *>(static_cast<size_t>(-4));
+
+	// The callee of a record preceding an entry/exit pair that stands for a contended wait on a lock (see
+	// lock_tracker). The lock address is stored in the record's timestamp, the entry's callee is the blocking function.
+	const void * const lock_wait_tag = reinterpret_cast<const void *>(static_cast<size_t>(-5));
+
+#ifdef MP_COMPACT_TRACE
+	typedef compact_call_record trace_record;
+#else
+	typedef call_record trace_record;
+#endif
+
+
+
+	inline unsigned long long compact_call_record::wide() const throw()
+	{	return static_cast<unsigned long long>(callee) << 32 | delta;	}
 }
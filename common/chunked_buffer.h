@@ -0,0 +1,119 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include "noncopyable.h"
+#include "range.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace micro_profiler
+{
+	// A byte buffer made of fixed-size chunks. The data appended is never relocated, so a multi-megabyte content is
+	// not copied on growth nor required to fit a single allocation. The chunks are retained on clear() for reuse, and
+	// the content is presented as a sequence of ranges for a gather write.
+	class chunked_buffer : noncopyable
+	{
+	public:
+		enum {	chunk_size = 64 * 1024,	};
+
+	public:
+		chunked_buffer();
+
+		void push_back(byte value);
+		void append(const byte *begin_, const byte *end_);
+		void clear() throw();
+
+		std::size_t size() const throw();
+		const std::vector<const_byte_range> &ranges();
+
+	private:
+		void next_chunk();
+
+	private:
+		std::vector< std::unique_ptr<byte[]> > _chunks;
+		std::vector<const_byte_range> _ranges;
+		std::size_t _current;
+		byte *_ptr, *_end;
+	};
+
+
+
+	inline chunked_buffer::chunked_buffer()
+		: _current(0), _ptr(nullptr), _end(nullptr)
+	{	}
+
+	inline void chunked_buffer::push_back(byte value)
+	{
+		if (_ptr == _end)
+			next_chunk();
+		*_ptr++ = value;
+	}
+
+	inline void chunked_buffer::append(const byte *begin_, const byte *end_)
+	{
+		while (begin_ != end_)
+		{
+			if (_ptr == _end)
+				next_chunk();
+
+			const auto n = (std::min)(end_ - begin_, _end - _ptr);
+
+			_ptr = std::copy(begin_, begin_ + n, _ptr);
+			begin_ += n;
+		}
+	}
+
+	inline void chunked_buffer::clear() throw()
+	{
+		_current = 0;
+		_ptr = _end = _chunks.empty() ? nullptr : _chunks[0].get();
+		if (_ptr)
+			_end += chunk_size;
+	}
+
+	inline std::size_t chunked_buffer::size() const throw()
+	{	return _ptr ? _current * chunk_size + (_ptr - _chunks[_current].get()) : 0u;	}
+
+	inline const std::vector<const_byte_range> &chunked_buffer::ranges()
+	{
+		_ranges.clear();
+		for (std::size_t i = 0; _ptr && i <= _current; ++i)
+		{
+			const auto chunk = _chunks[i].get();
+
+			_ranges.push_back(const_byte_range(chunk, i < _current ? chunk_size : _ptr - chunk));
+		}
+		return _ranges;
+	}
+
+	inline void chunked_buffer::next_chunk()
+	{
+		if (_ptr)
+			_current++;
+		if (_current == _chunks.size())
+			_chunks.emplace_back(new byte[chunk_size]);
+		_ptr = _chunks[_current].get();
+		_end = _ptr + chunk_size;
+	}
+}
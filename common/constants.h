@@ -33,6 +33,18 @@ namespace micro_profiler
 		static const char *profiler_name;
 		static const char *profilerdir_ev;
 		static const char *frontend_id_ev;
+		static const char *overflow_policy_ev;
+		static const char *buffer_size_ev;
+		static const char *analysis_workers_ev;
+		static const char *sampling_ev;
+		static const char *short_calls_ev;
+		static const char *flight_recorder_ev;
+		static const char *hw_counters_ev;
+		static const char *allocations_ev;
+		static const char *locks_ev;
+		static const char *overhead_budget_ev;
+		static const char *coverage_ev;
+		static const char *call_times_ev;
 		static const guid_t standalone_frontend_id;
 		static const guid_t integrated_frontend_id;
 
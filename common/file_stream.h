@@ -46,6 +46,9 @@ namespace micro_profiler
 		void *_stream;
 	};
 
+	// Reads the whole file, throwing file_not_found_exception if it is missing.
+	std::string read_file(const std::string &path);
+
 	class write_file_stream : noncopyable
 	{
 	public:
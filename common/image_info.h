@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include "noncopyable.h"
 #include "types.h"
 
 #include <functional>
@@ -36,6 +37,7 @@ namespace micro_profiler
 		unsigned int line;
 	};
 
+	// Function names are reported as they appear in the image (mangled, if the platform's image format keeps them so).
 	struct image_info
 	{
 		typedef std::function<void (const symbol_info &symbol)> symbol_callback_t;
@@ -46,5 +48,21 @@ namespace micro_profiler
 		virtual void enumerate_files(const file_callback_t &/*callback*/) const {	}
 	};
 
+	// Turns mangled symbol names into human-readable ones, leaving other names intact. Reuses its buffer between calls.
+	class symbol_demangler : noncopyable
+	{
+	public:
+		symbol_demangler();
+		~symbol_demangler();
+
+		void operator ()(std::string &name);
+
+	private:
+		char *_buffer;
+		std::size_t _length;
+	};
+
+
+
 	std::shared_ptr<image_info> load_image_info(const std::string &image_path);
 }
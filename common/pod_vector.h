@@ -46,6 +46,7 @@ namespace micro_profiler
 		template <typename InputIterator>
 		void append(InputIterator b, InputIterator e) throw();
 		void clear() throw();
+		void resize(size_t size) throw();
 
 		iterator begin() throw();
 		iterator end() throw();
@@ -129,6 +130,14 @@ namespace micro_profiler
 	inline void pod_vector<T>::clear() throw()
 	{	_end = _begin;	}
 
+	template <typename T>
+	inline void pod_vector<T>::resize(size_t size) throw()
+	{
+		if (size > capacity() && !grow(size - capacity()))
+			return;
+		_end = _begin + size;
+	}
+
 	template <typename T>
 	inline typename pod_vector<T>::iterator pod_vector<T>::begin() throw()
 	{	return _begin;	}
@@ -22,8 +22,13 @@
 
 #include "types.h"
 
+#include <math/histogram.h>
+#include <math/scale.h>
+
 namespace micro_profiler
 {
+	typedef math::histogram<math::log_linear_scale<timestamp_t>, count_t> call_times_histogram;
+
 	struct function_statistics
 	{
 		explicit function_statistics(count_t times_called = 0, timestamp_t inclusive_time = 0,
@@ -33,6 +38,16 @@ namespace micro_profiler
 		timestamp_t inclusive_time;
 		timestamp_t exclusive_time;
 		timestamp_t max_call_time;
+		call_times_histogram call_times; // Inclusive times of the calls - empty, unless collected (see call_graph).
+		count_t hw_counters[max_hw_counters]; // Inclusive totals - zeroes, unless the counters were collected.
+		count_t allocations, allocated_bytes; // Heap allocations made by the function itself, if tracked.
+		timestamp_t time_blocked; // Inclusive time spent waiting for the locks contended, if tracked.
+	};
+
+	struct lock_statistics
+	{
+		count_t contentions;
+		timestamp_t time_blocked;
 	};
 
 
@@ -42,11 +57,16 @@ namespace micro_profiler
 	inline function_statistics::function_statistics(count_t times_called_, timestamp_t inclusive_time_,
 			timestamp_t exclusive_time_, timestamp_t max_call_time_)
 		: times_called(times_called_), inclusive_time(inclusive_time_), exclusive_time(exclusive_time_),
-			max_call_time(max_call_time_)
+			max_call_time(max_call_time_), hw_counters(), allocations(0), allocated_bytes(0),
+			time_blocked(0)
 	{	}
 
 
 	// function_statistics - inline helpers
+	// Two buckets per a power of two, up to 2^32 ticks - longer calls fall into the last bucket.
+	inline math::log_linear_scale<timestamp_t> call_times_scale()
+	{	return math::log_linear_scale<timestamp_t>(1, 64);	}
+
 	inline void add(function_statistics &lhs, timestamp_t rhs_inclusive_time, timestamp_t rhs_exclusive_time)
 	{
 		++lhs.times_called;
@@ -56,6 +76,31 @@ namespace micro_profiler
 			lhs.max_call_time = rhs_inclusive_time;
 	}
 
+	// Accounts for a number of calls known by their total times only - each is taken for an average one.
+	inline void add(function_statistics &lhs, timestamp_t rhs_inclusive_time, timestamp_t rhs_exclusive_time,
+		count_t calls)
+	{
+		const auto average_time = rhs_inclusive_time / static_cast<timestamp_t>(calls);
+
+		lhs.times_called += calls;
+		lhs.inclusive_time += rhs_inclusive_time;
+		lhs.exclusive_time += rhs_exclusive_time;
+		if (average_time > lhs.max_call_time)
+			lhs.max_call_time = average_time;
+	}
+
+	inline void add(call_times_histogram &lhs, const call_times_histogram &rhs)
+	{
+		if (rhs.size())
+			lhs += rhs;
+	}
+
+	inline void add(count_t (&lhs)[max_hw_counters], const count_t (&rhs)[max_hw_counters])
+	{
+		for (auto i = 0; i != max_hw_counters; ++i)
+			lhs[i] += rhs[i];
+	}
+
 	inline void add(function_statistics &lhs, const function_statistics &rhs)
 	{
 		lhs.times_called += rhs.times_called;
@@ -63,5 +108,47 @@ namespace micro_profiler
 		lhs.exclusive_time += rhs.exclusive_time;
 		if (rhs.max_call_time > lhs.max_call_time)
 			lhs.max_call_time = rhs.max_call_time;
+		add(lhs.call_times, rhs.call_times);
+		add(lhs.hw_counters, rhs.hw_counters);
+		lhs.allocations += rhs.allocations;
+		lhs.allocated_bytes += rhs.allocated_bytes;
+		lhs.time_blocked += rhs.time_blocked;
+	}
+
+	inline void add(lock_statistics &lhs, const lock_statistics &rhs)
+	{
+		lhs.contentions += rhs.contentions;
+		lhs.time_blocked += rhs.time_blocked;
+	}
+
+	// Zeroes the statistics, keeping the scale of the histogram.
+	inline void reset(function_statistics &s)
+	{
+		s.times_called = 0;
+		s.inclusive_time = s.exclusive_time = s.max_call_time = 0;
+		s.call_times.reset();
+		std::fill_n(s.hw_counters, static_cast<int>(max_hw_counters), count_t());
+		s.allocations = s.allocated_bytes = 0;
+		s.time_blocked = 0;
+	}
+
+	// Returns the call time, that is not exceeded by the specified fraction of the calls (linearly interpolated
+	// between the buckets), or zero if no call times were collected.
+	inline timestamp_t call_time_percentile(const function_statistics &s, float fraction)
+	{
+		struct partition
+		{
+			count_t midvalue;
+			timestamp_t location;
+		} p = {	0, 0	};
+		count_t total = 0;
+
+		for (auto i = s.call_times.begin(); i != s.call_times.end(); ++i)
+			total += *i;
+		if (!total)
+			return 0;
+		p.midvalue = static_cast<count_t>(fraction * total + 0.5f);
+		s.call_times.find_partitions(&p, &p + 1);
+		return p.location < s.max_call_time ? p.location : s.max_call_time;
 	}
 }
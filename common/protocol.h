@@ -22,6 +22,7 @@
 
 #include "module.h"
 #include "image_info.h"
+#include "primitives.h"
 #include "types.h"
 #include "unordered_map.h"
 
@@ -32,12 +33,20 @@ namespace micro_profiler
 {
 	enum messages_id {
 		// Requests...
-		request_update = 0x100, // responded with [modules_loaded, ]statistics_update[, modules_unloaded] sequence.
+		request_update = 0x100, // + update_request_flags; responded with [modules_loaded, dropped_records, lock_contention, patches_throttled, functions_covered, threads_exited, ]statistics_update|statistics_delta[, modules_unloaded] sequence.
 		response_modules_loaded = 1,
+		response_dropped_records = 9,
+		response_lock_contention = 22,
+		response_patches_throttled = 23,
+		response_functions_covered = 24,
+		response_threads_exited = 25,
 		response_statistics_update = 6,
+		response_statistics_delta = 12,
 		response_modules_unloaded = 3,
 
-		request_module_metadata = 5, // + instance_id
+		request_module_metadata = 5, // + instance_id; responded with module_metadata carrying all the symbols (demangled).
+		request_module_metadata_chunked = 0x103, // + instance_id; responded with [module_metadata_symbols, ...] module_metadata sequence.
+		response_module_metadata_symbols = 13,
 		response_module_metadata = 4,
 
 		request_threads_info = 7,
@@ -60,12 +69,67 @@ namespace micro_profiler
 		exiting = 0x102,
 	};
 
+	// init (initialization_data::capabilities) - the collectors not sending any support none of these.
+	enum collector_capabilities {
+		capability_chunked_metadata = 1, // request_module_metadata_chunked is served.
+	};
+
+	// request_update
+	enum update_request_flags {
+		update_full = 0, // Whole call trees accumulated since the previous update are sent (response_statistics_update).
+		update_delta = 1, // Only the call nodes changed since the previous update are sent (response_statistics_delta).
+	};
+
 	// response_modules_loaded
 	typedef std::vector<module::mapping_instance> loaded_modules;
 
 	// response_modules_unloaded
 	typedef std::vector<id_t> unloaded_modules;
 
+	// response_dropped_records
+	typedef std::vector< std::pair<id_t /*thread_id*/, count_t /*records lost since the last update*/> > dropped_records;
+
+	// response_lock_contention
+	// Contended waits on the locks of the profilee, accumulated since the last update. A lock waited for by several
+	// threads is listed once per each of them.
+	typedef std::vector< std::pair<long_address_t /*lock*/, lock_statistics> > lock_contention;
+
+	// response_patches_throttled
+	// Patches reverted by the collector since the last update, for the overhead of tracing the functions has exceeded
+	// the budget set (see overhead_governor).
+	typedef std::vector< std::pair<id_t /*module_id*/, unsigned int /*rva*/> > throttled_patches;
+
+	// response_functions_covered
+	// Functions executed since the last update while in coverage mode. The coverage patches of these are already reverted
+	// by the collector, once hit.
+	typedef std::vector< std::pair<id_t /*module_id*/, unsigned int /*rva*/> > covered_functions;
+
+	// response_threads_exited
+	// Threads that have exited, with the statistics that follow (update or delta) being their last. The collector
+	// forgets the call nodes of these - the node indices of the later deltas for the same ID start over.
+	typedef std::vector<id_t> exited_threads;
+
+	// response_statistics_delta
+	// Call nodes are referred to by indices assigned by the collector and stable through the session: zero stands for
+	// the root, created nodes get consecutive indices following the ones sent before, so a parent always precedes its
+	// callees.
+	struct call_graph_delta
+	{
+		struct created_node
+		{
+			unsigned int parent;
+			long_address_t address;
+			function_statistics statistics;
+		};
+
+		std::vector<created_node> created;
+		std::vector< std::pair<unsigned int /*node*/, function_statistics /*accumulated since the last update*/> > updated;
+	};
+
+	typedef std::vector< std::pair<id_t /*thread_id*/, call_graph_delta> > statistics_delta;
+
+	// response_module_metadata_symbols: std::vector<symbol_info>, with names left mangled.
+
 	// response_module_metadata
 	struct module_info_metadata
 	{
@@ -26,6 +26,7 @@
 #include "range.h"
 
 #include <common/auto_increment.h>
+#include <math/serialization.h>
 #include <patcher/interface.h>
 #include <strmd/container_ex.h>
 #include <strmd/packer.h>
@@ -33,8 +34,8 @@
 
 namespace strmd
 {
-	template <> struct version<micro_profiler::initialization_data> {	enum {	value = 6	};	};
-	template <> struct version<micro_profiler::function_statistics> {	enum {	value = 5	};	};
+	template <> struct version<micro_profiler::initialization_data> {	enum {	value = 7	};	};
+	template <> struct version<micro_profiler::function_statistics> {	enum {	value = 9	};	};
 	template <> struct version<micro_profiler::module::mapping_ex> {	enum {	value = 6	};	};
 	template <> struct version<micro_profiler::symbol_info> {	enum {	value = 4	};	};
 	template <> struct version<micro_profiler::module_info_metadata> {	enum {	value = 6	};	};
@@ -42,6 +43,7 @@ namespace strmd
 	template <> struct version<micro_profiler::patch_revert_request> {	enum {	value = 4	};	};
 	template <> struct version<micro_profiler::patch_apply_request> {	enum {	value = 5	};	};
 	template <> struct version<micro_profiler::patch_change_result> {	enum {	value = 5	};	};
+	template <> struct version<micro_profiler::call_graph_delta> {	enum {	value = 0	};	};
 }
 
 namespace micro_profiler
@@ -60,6 +62,8 @@ namespace micro_profiler
 			archive(data.executable);
 		if (ver >= 6)
 			archive(data.injected);
+		if (ver >= 7)
+			archive(data.capabilities);
 	}	
 
 	template <typename ArchiveT>
@@ -73,12 +77,49 @@ namespace micro_profiler
 		archive(data.inclusive_time);
 		archive(data.exclusive_time);
 		archive(data.max_call_time);
+		if (ver >= 6)
+			archive(data.call_times);
+		for (auto i = 0; ver >= 7 && i != max_hw_counters; ++i)
+			archive(data.hw_counters[i]);
+		if (ver >= 8)
+		{
+			archive(data.allocations);
+			archive(data.allocated_bytes);
+		}
+		if (ver >= 9)
+			archive(data.time_blocked);
+	}
+
+	template <typename ArchiveT>
+	inline void serialize(ArchiveT &archive, lock_statistics &data)
+	{
+		archive(data.contentions);
+		archive(data.time_blocked);
 	}
 
 	template <typename ArchiveT>
 	inline void serialize(ArchiveT &archive, messages_id &data)
 	{	archive(reinterpret_cast<int &>(data));	}
 
+	template <typename ArchiveT>
+	inline void serialize(ArchiveT &archive, update_request_flags &data)
+	{	archive(reinterpret_cast<int &>(data));	}
+
+	template <typename ArchiveT>
+	inline void serialize(ArchiveT &archive, call_graph_delta::created_node &data)
+	{
+		archive(data.parent);
+		archive(data.address);
+		archive(data.statistics);
+	}
+
+	template <typename ArchiveT>
+	inline void serialize(ArchiveT &archive, call_graph_delta &data, unsigned int /*ver*/)
+	{
+		archive(data.created);
+		archive(data.updated);
+	}
+
 	template <typename ArchiveT>
 	inline void serialize(ArchiveT &archive, module::mapping_ex &data, unsigned int ver)
 	{
@@ -36,6 +36,18 @@ namespace micro_profiler
 	const char *constants::profiler_name = ".microprofiler";
 	const char *constants::profilerdir_ev = "MICROPROFILERDIR";
 	const char *constants::frontend_id_ev = "MICROPROFILERFRONTEND";
+	const char *constants::overflow_policy_ev = "MICROPROFILEROVERFLOW";
+	const char *constants::buffer_size_ev = "MICROPROFILERBUFFERSIZE";
+	const char *constants::analysis_workers_ev = "MICROPROFILERANALYZERS";
+	const char *constants::sampling_ev = "MICROPROFILERSAMPLING";
+	const char *constants::short_calls_ev = "MICROPROFILERSHORTCALLS";
+	const char *constants::flight_recorder_ev = "MICROPROFILERFLIGHTRECORDER";
+	const char *constants::hw_counters_ev = "MICROPROFILERHWCOUNTERS";
+	const char *constants::allocations_ev = "MICROPROFILERALLOCATIONS";
+	const char *constants::locks_ev = "MICROPROFILERLOCKS";
+	const char *constants::overhead_budget_ev = "MICROPROFILEROVERHEADBUDGET";
+	const char *constants::coverage_ev = "MICROPROFILERCOVERAGE";
+	const char *constants::call_times_ev = "MICROPROFILERCALLTIMES";
 
 	// {0ED7654C-DE8A-4964-9661-0B0C391BE15E}
 	const guid_t constants::standalone_frontend_id = {
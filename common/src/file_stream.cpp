@@ -67,6 +67,23 @@ namespace micro_profiler
 	{	fseek(static_cast<FILE *>(_stream), static_cast<int>(n), SEEK_CUR);	}
 
 
+	string read_file(const string &path)
+	{
+		enum {	n = 1024	};
+
+		char buffer[n];
+		string content;
+		read_file_stream s(path);
+
+		for (size_t read = n; read == n; )
+		{
+			read = s.read_l(buffer, n);
+			content.append(buffer, read);
+		}
+		return content;
+	}
+
+
 	write_file_stream::write_file_stream(const string &path)
 		: _stream(fopen(path, "wb"))
 	{
@@ -56,23 +56,36 @@ namespace micro_profiler
 
 		void elf_image_info::enumerate_functions(const symbol_callback_t &callback) const
 		{
-			char *demangled = 0;
-			size_t length = 0;
 			symbol_info symbol = { };
 
 			symreader::read_symbols(_image->first, _image->second, [&] (const symreader::symbol &elf_symbol) {
-				int status = 0;
-				char *demangled2 = __cxxabiv1::__cxa_demangle(elf_symbol.name, demangled, &length, &status);
-
-				if (demangled2 && !status)
-					demangled = demangled2;
-
-				symbol.name = demangled2 ? demangled2 : elf_symbol.name;
+				symbol.name = elf_symbol.name;
 				symbol.rva = static_cast<unsigned int>(elf_symbol.virtual_address);
 				symbol.size = static_cast<unsigned>(elf_symbol.size);
 				callback(symbol);
 			});
-			free(demangled);
+		}
+	}
+
+
+	symbol_demangler::symbol_demangler()
+		: _buffer(nullptr), _length(0)
+	{	}
+
+	symbol_demangler::~symbol_demangler()
+	{	free(_buffer);	}
+
+	void symbol_demangler::operator ()(string &name)
+	{
+		int status = 0;
+
+		if (name.compare(0, 2, "_Z"))
+			return;
+		if (const auto demangled = __cxxabiv1::__cxa_demangle(name.c_str(), _buffer, &_length, &status))
+		{
+			_buffer = demangled;
+			if (!status)
+				name = demangled;
 		}
 	}
 
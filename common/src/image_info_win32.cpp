@@ -254,6 +254,18 @@ namespace micro_profiler
 	}
 
 
+	symbol_demangler::symbol_demangler()
+		: _buffer(nullptr), _length(0)
+	{	}
+
+	symbol_demangler::~symbol_demangler()
+	{	}
+
+	// DbgHelp reports the names undecorated already.
+	void symbol_demangler::operator ()(string &/*name*/)
+	{	}
+
+
 	shared_ptr<image_info> load_image_info(const string &image_path)
 	{
 		shared_ptr<dbghelp> dh(new dbghelp);
@@ -20,16 +20,82 @@
 
 #include <common/time.h>
 
+#include <atomic>
+#include <stdio.h>
 #include <time.h>
 
 #ifdef _MSC_VER
 	#include <intrin.h>
 #elif !defined(__arm__)
+	#include <cpuid.h>
 	#include <x86intrin.h>
 #endif
 
+using namespace std;
+
 namespace micro_profiler
 {
+	namespace
+	{
+		atomic<timestamp_t> g_ticks_per_second(0);
+
+#if !defined(__arm__)
+		void cpuid(unsigned int (&registers)[4], unsigned int leaf)
+		{
+	#ifdef _MSC_VER
+			__cpuidex(reinterpret_cast<int *>(registers), leaf, 0);
+	#else
+			__cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+	#endif
+		}
+
+		timestamp_t cpuid_ticks_per_second()
+		{
+			unsigned int r[4];
+
+			cpuid(r, 0x80000000);
+			if (r[0] < 0x80000007)
+				return 0;
+			cpuid(r, 0x80000007);
+			if (!(r[3] & (1 << 8))) // The counter is not invariant - its frequency is of no use.
+				return 0;
+			cpuid(r, 0);
+
+			const auto max_leaf = r[0];
+
+			if (max_leaf < 0x15)
+				return 0;
+			cpuid(r, 0x15);
+
+			const auto denominator = r[0], numerator = r[1], crystal_hz = r[2];
+
+			if (!denominator || !numerator)
+				return 0;
+			if (crystal_hz)
+				return static_cast<timestamp_t>(crystal_hz) * numerator / denominator;
+			if (max_leaf < 0x16)
+				return 0;
+			cpuid(r, 0x16); // The crystal frequency is not enumerated, but the base frequency matches the counter's.
+			return static_cast<timestamp_t>(r[0] & 0xFFFF) * 1000000;
+		}
+#endif
+
+#ifdef __linux__
+		timestamp_t kernel_ticks_per_second()
+		{
+			unsigned long long khz = 0;
+
+			if (const auto f = fopen("/sys/devices/system/cpu/cpu0/tsc_freq_khz", "r"))
+			{
+				if (1 != fscanf(f, "%llu", &khz))
+					khz = 0;
+				fclose(f);
+			}
+			return static_cast<timestamp_t>(khz) * 1000;
+		}
+#endif
+	}
+
 	timestamp_t read_tick_counter()
 #if !defined(__arm__)
 	{	return __rdtsc();	}
@@ -43,6 +109,35 @@ namespace micro_profiler
 #endif
 
 	timestamp_t ticks_per_second()
+	{
+		auto value = g_ticks_per_second.load(memory_order_relaxed);
+
+		if (!value)
+		{
+			if (!(value = invariant_ticks_per_second()))
+				value = measure_ticks_per_second();
+			g_ticks_per_second.store(value, memory_order_relaxed);
+		}
+		return value;
+	}
+
+	void set_ticks_per_second(timestamp_t value)
+	{	g_ticks_per_second.store(value, memory_order_relaxed);	}
+
+	timestamp_t invariant_ticks_per_second()
+#if !defined(__arm__)
+	{
+	#ifdef __linux__
+		if (const auto value = kernel_ticks_per_second())
+			return value;
+	#endif
+		return cpuid_ticks_per_second();
+	}
+#else
+	{	return 1000000000;	}
+#endif
+
+	timestamp_t measure_ticks_per_second()
 	{
 		timestamp_t tsc_start, tsc_end;
 		stopwatch sw;
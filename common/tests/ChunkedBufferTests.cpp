@@ -0,0 +1,110 @@
+#include <common/chunked_buffer.h>
+
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			vector<byte> join(const vector<const_byte_range> &ranges)
+			{
+				vector<byte> result;
+
+				for (auto i = ranges.begin(); i != ranges.end(); ++i)
+					result.insert(result.end(), i->begin(), i->end());
+				return result;
+			}
+		}
+
+		begin_test_suite( ChunkedBufferTests )
+			test( NewBufferIsEmpty )
+			{
+				// INIT / ACT
+				chunked_buffer b;
+
+				// ASSERT
+				assert_equal(0u, b.size());
+				assert_is_empty(b.ranges());
+			}
+
+
+			test( SmallContentIsPresentedAsASingleRange )
+			{
+				// INIT
+				chunked_buffer b;
+				byte data[] = {	1, 2, 3, 5, 7, 11,	};
+
+				// ACT
+				b.push_back(17);
+				b.append(data, data + 6);
+				b.push_back(19);
+
+				// ASSERT
+				byte reference[] = {	17, 1, 2, 3, 5, 7, 11, 19,	};
+
+				assert_equal(8u, b.size());
+				assert_equal(1u, b.ranges().size());
+				assert_equal(reference, join(b.ranges()));
+			}
+
+
+			test( ContentExceedingChunkIsSplitIntoFullChunkRanges )
+			{
+				// INIT
+				chunked_buffer b;
+				vector<byte> data(2 * chunked_buffer::chunk_size + 100);
+
+				for (auto i = data.begin(); i != data.end(); ++i)
+					*i = static_cast<byte>((i - data.begin()) * 13);
+
+				// ACT
+				b.append(data.data(), data.data() + 1000);
+				b.append(data.data() + 1000, data.data() + data.size() - 1);
+				b.push_back(data.back());
+
+				// ASSERT
+				const auto &ranges = b.ranges();
+
+				assert_equal(data.size(), b.size());
+				assert_equal(3u, ranges.size());
+				assert_equal(static_cast<size_t>(chunked_buffer::chunk_size), ranges[0].length());
+				assert_equal(static_cast<size_t>(chunked_buffer::chunk_size), ranges[1].length());
+				assert_equal(100u, ranges[2].length());
+				assert_equal(data, join(ranges));
+			}
+
+
+			test( ClearedBufferReusesItsChunks )
+			{
+				// INIT
+				chunked_buffer b;
+				vector<byte> data1(chunked_buffer::chunk_size + 1, 3), data2(chunked_buffer::chunk_size + 10, 5);
+
+				b.append(data1.data(), data1.data() + data1.size());
+
+				const auto chunk1 = b.ranges()[0].begin();
+				const auto chunk2 = b.ranges()[1].begin();
+
+				// ACT
+				b.clear();
+
+				// ASSERT
+				assert_equal(0u, b.size());
+
+				// ACT
+				b.append(data2.data(), data2.data() + data2.size());
+
+				// ASSERT
+				assert_equal(data2.size(), b.size());
+				assert_equal(chunk1, b.ranges()[0].begin());
+				assert_equal(chunk2, b.ranges()[1].begin());
+				assert_equal(data2, join(b.ranges()));
+			}
+		end_test_suite
+	}
+}
@@ -129,6 +129,23 @@ namespace micro_profiler
 				// ACT / ACT
 				assert_throws(read_file_stream("wjkwjkwjrr.wddd"), runtime_error);
 				assert_throws(read_file_stream("wjkwjkwjrr.wddd"), file_not_found_exception);
+				assert_throws(read_file("wjkwjkwjrr.wddd"), file_not_found_exception);
+			}
+
+
+			test( WholeFileIsReadAtOnce )
+			{
+				// INIT
+				const auto l1 = get_file_length(c_symbol_container_1);
+				vector<char> reference(l1);
+
+				fread(reference.data(), 1, l1, fopen(c_symbol_container_1).get());
+
+				// ACT
+				const auto content = read_file(c_symbol_container_1);
+
+				// ASSERT
+				assert_equal(reference, vector<char>(content.begin(), content.end()));
 			}
 
 		end_test_suite
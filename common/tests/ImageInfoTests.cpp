@@ -233,17 +233,24 @@ namespace micro_profiler
 			}
 #endif
 
-			test( CPPNamesAreDemangledOnEnumeration )
+			test( CPPNamesAreDemangledWithSymbolDemangler )
 			{
 				// INIT
+				symbol_demangler demangler;
 				map<string, symbol_info> functions;
 				shared_ptr< image_info > ii[] = {
 					load_image_info(c_symbol_container_1),
 					load_image_info(c_symbol_container_2),
 				};
+				const auto add_demangled = [&] (const symbol_info &symbol) {
+					symbol_info s = symbol;
+
+					demangler(s.name);
+					add_function(functions, s);
+				};
 
 				// ACT
-				ii[0]->enumerate_functions(bind(&add_function, ref(functions), _1));
+				ii[0]->enumerate_functions(add_demangled);
 
 				// ASSERT
 				assert_is_true(has_function_containing(functions,
@@ -253,13 +260,31 @@ namespace micro_profiler
 				functions.clear();
 
 				// ACT
-				ii[1]->enumerate_functions(bind(&add_function, ref(functions), _1));
+				ii[1]->enumerate_functions(add_demangled);
 
 				// ASSERT
 				assert_is_true(has_function_containing(functions, "vale_of_mean_creatures::this_one_for_the_birds"));
 				assert_is_true(has_function_containing(functions, "vale_of_mean_creatures::this_one_for_the_whales"));
 				assert_is_true(has_function_containing(functions, "vale_of_mean_creatures::the_abyss::bubble_sort"));
+				assert_equal(1u, functions.count("bubble_sort2"));
 			}
+
+
+#ifndef _WIN32
+			test( CPPNamesAreEnumeratedMangled )
+			{
+				// INIT
+				map<string, symbol_info> functions;
+				shared_ptr< image_info > ii = load_image_info(c_symbol_container_2);
+
+				// ACT
+				ii->enumerate_functions(bind(&add_function, ref(functions), _1));
+
+				// ASSERT
+				assert_is_false(has_function_containing(functions, "vale_of_mean_creatures::this_one_for_the_birds"));
+				assert_is_true(has_function_containing(functions, "22vale_of_mean_creatures22this_one_for_the_birds"));
+			}
+#endif
 		end_test_suite
 	}
 }
@@ -563,6 +563,44 @@ namespace micro_profiler
 				assert_equal(6u, v.size());
 			}
 
+
+			test( ResizingKeepsElementsAndGrowsWhenOverCapacity )
+			{
+				// INIT
+				pod_vector<int> v(5);
+
+				v.push_back(3);
+				v.push_back(13);
+				v.push_back(3221);
+
+				pod_vector<int>::iterator b = v.begin();
+
+				// ACT
+				v.resize(1);
+
+				// ASSERT
+				assert_equal(1u, v.size());
+				assert_equal(b, v.begin());
+				assert_equal(3, v.back());
+
+				// ACT
+				v.resize(3);
+
+				// ASSERT
+				assert_equal(3u, v.size());
+				assert_equal(b, v.begin());
+				assert_equal(3221, v.back());
+
+				// ACT
+				v.resize(7);
+
+				// ASSERT
+				assert_equal(7u, v.size());
+				assert_not_equal(b, v.begin());
+				assert_equal(3, *v.begin());
+				assert_equal(13, *(v.begin() + 1));
+			}
+
 		end_test_suite
 
 
@@ -70,6 +70,53 @@ namespace micro_profiler
 				assert_equal(96u, buffering_policy(97 * buffering_policy::buffer_size, 1, 1).min_empty());
 				assert_equal(0u, buffering_policy(0, 1, 1).min_empty());
 			}
+
+
+			test( InvalidBufferSizesAreRejectedOnConstruction )
+			{
+				// INIT / ACT / ASSERT
+				assert_throws(buffering_policy(10 * buffering_policy::buffer_size, 1, 1,
+					buffering_policy::block_on_overflow, 0, 1000), invalid_argument);
+				assert_throws(buffering_policy(10 * buffering_policy::buffer_size, 1, 1,
+					buffering_policy::block_on_overflow, 1001, 1000), invalid_argument);
+			}
+
+
+			test( MaxEntriesIsTakenAsRoundedUpToBufferSize )
+			{
+				// INIT / ACT / ASSERT
+				assert_equal(10u * buffering_policy::buffer_size, buffering_policy(10 * buffering_policy::buffer_size - 1, 1, 1,
+					buffering_policy::block_on_overflow, 100, 300).max_entries());
+				assert_equal(10u, buffering_policy(10 * buffering_policy::buffer_size - 1, 1, 1,
+					buffering_policy::block_on_overflow, 30, 3000).max_buffers());
+				assert_equal(19u * buffering_policy::buffer_size, buffering_policy(19 * buffering_policy::buffer_size, 1, 1,
+					buffering_policy::block_on_overflow, 30, 3000).max_entries());
+			}
+
+
+			test( MaxBufferSizeIsLimitedToAHalfOfAllocation )
+			{
+				// INIT / ACT / ASSERT
+				assert_equal(300u, buffering_policy(3000, 1, 1, buffering_policy::block_on_overflow, 100, 300)
+					.max_buffer_size());
+				assert_equal(1536u, buffering_policy(3000, 1, 1, buffering_policy::block_on_overflow, 100, 3000)
+					.max_buffer_size());
+				assert_equal(2000u, buffering_policy(3000, 1, 1, buffering_policy::block_on_overflow, 2000, 3000)
+					.max_buffer_size());
+			}
+
+
+			test( InitialBufferSizeIsDefaultSizeLimitedToRange )
+			{
+				// INIT / ACT / ASSERT
+				assert_equal((size_t)buffering_policy::buffer_size, buffering_policy(10000, 1, 1).initial_buffer_size());
+				assert_equal((size_t)buffering_policy::buffer_size, buffering_policy(10000, 1, 1,
+					buffering_policy::block_on_overflow, 16, 4096).initial_buffer_size());
+				assert_equal(100u, buffering_policy(10000, 1, 1, buffering_policy::block_on_overflow, 16, 100)
+					.initial_buffer_size());
+				assert_equal(1000u, buffering_policy(10000, 1, 1, buffering_policy::block_on_overflow, 1000, 4096)
+					.initial_buffer_size());
+			}
 		end_test_suite
 	}
 }
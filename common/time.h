@@ -49,6 +49,9 @@ namespace micro_profiler
 
 	timestamp_t clock(); // monotonic clock in milliseconds
 	timestamp_t read_tick_counter();
-	timestamp_t ticks_per_second();
+	timestamp_t ticks_per_second(); // Evaluated once: the invariant frequency if known, or the measured one otherwise.
+	void set_ticks_per_second(timestamp_t value); // Overrides the value returned by ticks_per_second().
+	timestamp_t invariant_ticks_per_second(); // Returns zero if the tick counter frequency is not reported.
+	timestamp_t measure_ticks_per_second();
 	datetime get_datetime(); // Zulu date/time
 }
@@ -45,6 +45,9 @@ namespace micro_profiler
 	};
 #pragma pack(pop)
 
+	// Hardware performance counters collected per call, when the collector is configured so (see buffering_policy).
+	enum hw_counter {	hw_cycles, hw_instructions, hw_l1d_misses, hw_llc_misses, max_hw_counters,	};
+
 	struct overhead
 	{
 		overhead(timestamp_t inner_, timestamp_t outer_);
@@ -58,6 +61,7 @@ namespace micro_profiler
 		std::string executable;
 		timestamp_t ticks_per_second;
 		unsigned int injected;
+		unsigned int capabilities; // A combination of collector_capabilities (see protocol.h).
 	};
 
 	struct thread_info
@@ -68,22 +72,46 @@ namespace micro_profiler
 		mt::milliseconds end_time; // Relative to the process start time.
 		mt::milliseconds cpu_time;
 		bool complete;
+		count_t dropped_records; // Not transmitted with thread_info - accumulated from response_dropped_records.
 	};
 
 	class buffering_policy
 	{
 	public:
-		enum {	buffer_size = 384 /*entries*/,	};
+		enum {	buffer_size = 384 /*entries, initial size of a buffer*/,	};
+
+		enum overflow_mode {
+			block_on_overflow, // The profilee waits for the analyzer to return an empty buffer.
+			drop_on_overflow, // The trace collected so far is discarded and the number of records lost is counted.
+		};
 
 	public:
-		buffering_policy(size_t max_allocation, double max_empty_factor, double min_empty_factor);
+		buffering_policy(size_t max_allocation, double max_empty_factor, double min_empty_factor,
+			overflow_mode overflow_ = block_on_overflow, size_t min_buffer_size = buffer_size,
+			size_t max_buffer_size = buffer_size, timestamp_t short_call_threshold = 0, bool hw_counters = false);
 
 		size_t max_buffers() const;
 		size_t max_empty() const;
 		size_t min_empty() const;
+		overflow_mode overflow() const;
+
+		size_t max_entries() const;
+		size_t min_buffer_size() const;
+		size_t max_buffer_size() const;
+		size_t initial_buffer_size() const;
+
+		// Leaf calls shorter than this (in ticks) are not traced individually, but folded together. Zero disables it.
+		timestamp_t short_call_threshold() const;
+
+		// Threads read their hardware performance counters on each traced entry and exit, where supported.
+		bool hw_counters() const;
 
 	private:
 		size_t _max_buffers, _max_empty, _min_empty;
+		overflow_mode _overflow;
+		size_t _min_buffer_size, _max_buffer_size;
+		timestamp_t _short_call_threshold;
+		bool _hw_counters;
 	};
 
 
@@ -97,14 +125,21 @@ namespace micro_profiler
 	{	}
 
 
-	inline buffering_policy::buffering_policy(size_t max_allocation, double max_empty_factor, double min_empty_factor)
-		: _max_buffers((std::max<size_t>)(max_allocation / buffer_size + !!(max_allocation % buffer_size), 1u))
+	inline buffering_policy::buffering_policy(size_t max_allocation, double max_empty_factor, double min_empty_factor,
+			overflow_mode overflow_, size_t min_buffer_size_, size_t max_buffer_size_, timestamp_t short_call_threshold_,
+			bool hw_counters_)
+		: _overflow(overflow_), _min_buffer_size(min_buffer_size_), _short_call_threshold(short_call_threshold_),
+			_hw_counters(hw_counters_)
 	{
 		if (max_empty_factor < 0 || max_empty_factor > 1 || min_empty_factor < 0 || min_empty_factor > 1
-				|| min_empty_factor > max_empty_factor)
+				|| min_empty_factor > max_empty_factor || !min_buffer_size_ || min_buffer_size_ > max_buffer_size_)
 			throw std::invalid_argument("");
+		_max_buffers = (std::max<size_t>)(max_allocation / buffer_size + !!(max_allocation % buffer_size), 1u);
 		_min_empty = (std::min<size_t>)(static_cast<size_t>(min_empty_factor * _max_buffers), _max_buffers - 1u);
 		_max_empty = (std::max<size_t>)(static_cast<size_t>(max_empty_factor * _max_buffers), 1u);
+
+		// A buffer may not take more than a half of the allocation, so that a grown buffer always has a spare one.
+		_max_buffer_size = (std::max)((std::min)(max_buffer_size_, max_entries() / 2), min_buffer_size_);
 	}
 	
 	inline size_t buffering_policy::max_buffers() const
@@ -115,4 +150,25 @@ namespace micro_profiler
 
 	inline size_t buffering_policy::min_empty() const
 	{	return _min_empty;	}
+
+	inline buffering_policy::overflow_mode buffering_policy::overflow() const
+	{	return _overflow;	}
+
+	inline size_t buffering_policy::max_entries() const
+	{	return _max_buffers * buffer_size;	}
+
+	inline size_t buffering_policy::min_buffer_size() const
+	{	return _min_buffer_size;	}
+
+	inline size_t buffering_policy::max_buffer_size() const
+	{	return _max_buffer_size;	}
+
+	inline size_t buffering_policy::initial_buffer_size() const
+	{	return (std::max)((std::min<size_t>)(buffer_size, _max_buffer_size), _min_buffer_size);	}
+
+	inline timestamp_t buffering_policy::short_call_threshold() const
+	{	return _short_call_threshold;	}
+
+	inline bool buffering_policy::hw_counters() const
+	{	return _hw_counters;	}
 }
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <winsock2.h>
+
+#define poll WSAPoll
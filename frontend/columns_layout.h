@@ -30,11 +30,11 @@ namespace micro_profiler
 	struct process_model_context;
 	struct statistics_model_context;
 
-	extern const column_definition<call_statistics, statistics_model_context> c_caller_statistics_columns[9];
-	extern const column_definition<call_statistics, statistics_model_context> c_statistics_columns[9];
-	extern const column_definition<call_statistics, statistics_model_context> c_callee_statistics_columns[9];
+	extern const column_definition<call_statistics, statistics_model_context> c_caller_statistics_columns[17];
+	extern const column_definition<call_statistics, statistics_model_context> c_statistics_columns[17];
+	extern const column_definition<call_statistics, statistics_model_context> c_callee_statistics_columns[17];
 
 	extern const column_definition<process_info, process_model_context> c_processes_columns[6];
 
-	extern const column_definition<tables::patched_symbols::value_type, image_patch_model_context> c_patched_symbols_columns[6];
+	extern const column_definition<tables::patched_symbols::value_type, image_patch_model_context> c_patched_symbols_columns[7];
 }
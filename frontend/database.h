@@ -52,6 +52,9 @@ namespace micro_profiler
 		typedef sdb::table<thread> threads;
 
 
+		typedef sdb::table< contended_lock, auto_increment_constructor<contended_lock> > locks;
+
+
 		typedef record<module::mapping_ex> module_mapping;
 		typedef sdb::table<module_mapping> module_mappings;
 
@@ -110,6 +113,7 @@ namespace micro_profiler
 		tables::source_files source_files;
 		tables::patches patches;
 		tables::threads threads;
+		tables::locks locks;
 	};
 
 
@@ -137,4 +141,7 @@ namespace micro_profiler
 
 	inline std::shared_ptr<tables::patches> patches(std::shared_ptr<profiling_session> session)
 	{	return make_shared_aspect(session, &session->patches);	}
+
+	inline std::shared_ptr<tables::locks> locks(std::shared_ptr<profiling_session> session)
+	{	return make_shared_aspect(session, &session->locks);	}
 }
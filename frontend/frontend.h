@@ -57,6 +57,8 @@ namespace micro_profiler
 		typedef containers::unordered_map<id_t /*module_id*/, std::uint32_t> module_hashes_t;
 		typedef reqm::multiplexing_request<id_t, tables::modules::metadata_ready_cb> mx_metadata_requests_t;
 		typedef std::list< std::shared_ptr<void> > requests_t;
+		typedef containers::unordered_map< id_t /*thread_id*/,
+			std::vector<calls_statistics_table::const_iterator> /*by collector's node index - 1*/ > call_nodes_t;
 
 	private:
 		// ipc::channel methods
@@ -65,10 +67,16 @@ namespace micro_profiler
 		void init_patcher();
 		void apply(id_t module_id, range<const tables::patches::patch_def, size_t> rva);
 		void revert(id_t module_id, range<const unsigned int, size_t> rva);
+		void update_throttled_patches(const throttled_patches &throttled);
+		void update_covered_functions(const covered_functions &covered);
 
 		template <typename OnUpdate>
 		void request_full_update(std::shared_ptr<void> &request_, const OnUpdate &on_update);
+		void update_statistics(const statistics_delta &delta);
+		void forget_threads(exited_threads &exited);
 		void update_threads(std::vector<id_t> &thread_ids);
+		void update_dropped_records(const dropped_records &dropped);
+		void update_lock_contention(const lock_contention &contention);
 		void finalize();
 
 		void request_metadata(std::shared_ptr<void> &request_, id_t module_id,
@@ -80,6 +88,7 @@ namespace micro_profiler
 
 		template <typename F>
 		void request_metadata_nw(std::shared_ptr<void> &request_, id_t module_id, const F &ready);
+		void append_symbols(std::vector<symbol_info> &symbols, std::vector<symbol_info> &chunk);
 
 		requests_t::iterator new_request_handle();
 
@@ -94,6 +103,17 @@ namespace micro_profiler
 		mx_metadata_requests_t::map_type_ptr _mx_metadata_requests;
 		requests_t _requests;
 		std::shared_ptr<void> _update_request;
+		dropped_records _dropped_buffer;
+		lock_contention _contention_buffer;
+		throttled_patches _throttled_buffer;
+		covered_functions _covered_buffer;
+		exited_threads _exited_buffer;
+		statistics_delta _delta_buffer;
+		call_nodes_t _call_nodes;
+
+		// request_module_metadata buffers
+		std::vector<symbol_info> _symbols_buffer;
+		symbol_demangler _demangler;
 
 		// request_apply_patches buffers
 		patch_apply_request _patch_apply_payload;
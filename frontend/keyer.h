@@ -190,9 +190,16 @@ namespace micro_profiler
 			long_address_t operator ()(const call_statistics &record) const
 			{	return record.address;	}
 
+			long_address_t operator ()(const contended_lock &record) const
+			{	return record.address;	}
+
 			template <typename IndexT>
 			void operator ()(IndexT &, call_statistics &record, long_address_t key) const
 			{	record.address = key;	}
+
+			template <typename IndexT>
+			void operator ()(IndexT &, contended_lock &record, long_address_t key) const
+			{	record.address = key;	}
 		};
 
 		struct parent_address
@@ -64,15 +64,24 @@ namespace micro_profiler
 		mutable unsigned int _reentrance;
 	};
 
-	struct patch_state_ex : patch_state // Permitted states: dormant, active, unrecoverable_error.
+	struct contended_lock : identity, lock_statistics
+	{
+		contended_lock()
+		{	id = 0, contentions = 0, time_blocked = 0, address = 0;	}
+
+		long_address_t address;
+	};
+
+	struct patch_state_ex : patch_state // Permitted states: dormant, active, unrecoverable_error, throttled.
 	{
 		patch_state_ex()
-			: in_transit(false), last_result(patch_change_result::ok)
+			: in_transit(false), last_result(patch_change_result::ok), covered(false)
 		{	id = 0, state = dormant;	}
 
 		id_t module_id;
 		bool in_transit;
 		patch_change_result::errors last_result;
+		bool covered; // The function was executed while patched in coverage mode.
 	};
 
 
@@ -101,11 +110,16 @@ namespace micro_profiler
 	{
 		lhs.times_called += rhs.times_called;
 		lhs.exclusive_time += rhs.exclusive_time;
+		lhs.allocations += rhs.allocations;
+		lhs.allocated_bytes += rhs.allocated_bytes;
 		if (!rhs.reentrance(lookup))
 		{
 			lhs.inclusive_time += rhs.inclusive_time;
 			if (rhs.max_call_time > lhs.max_call_time)
 				lhs.max_call_time = rhs.max_call_time;
+			add(lhs.call_times, rhs.call_times);
+			add(lhs.hw_counters, rhs.hw_counters);
+			lhs.time_blocked += rhs.time_blocked;
 		}
 	}
 
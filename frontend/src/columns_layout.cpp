@@ -46,8 +46,8 @@ namespace micro_profiler
 	const auto en_dash = "\xE2\x80\x93";
 	const auto secondary = style::height_scale(0.85);
 	const auto indent_spaces = "    ";
-	const char *c_complete_patch_states[] = {	"", "active", "inactive", "unpatchable", "",	};
-	const char *c_requested_patch_states[] = {	"", "removing", "applying", "unpatchable", "",	};
+	const char *c_complete_patch_states[] = {	"", "active", "inactive", "unpatchable", "", "throttled",	};
+	const char *c_requested_patch_states[] = {	"", "removing", "applying", "unpatchable", "", "applying",	};
 
 	struct utf_char_compare
 	{
@@ -55,9 +55,16 @@ namespace micro_profiler
 		{	return micro_profiler::compare(std::towupper(lhs), std::towupper(rhs));	}
 	};
 
+	// Returns a negative value for a zero denominator - it is displayed as an en dash.
+	static double ratio(count_t numerator, count_t denominator, double scale)
+	{	return denominator ? scale * static_cast<double>(numerator) / static_cast<double>(denominator) : -1.0;	}
+
 	static int encode_state(const nullable<const patch_state_ex &> &p)
 	{	return p.has_value() ? (((*p).in_transit ? 1 : 0) << 8) | static_cast<int>((*p).state) : -1;	}
 
+	static bool is_covered(const nullable<const patch_state_ex &> &p)
+	{	return p.has_value() && (*p).covered;	}
+
 	static void format_patch_status(agge::richtext_t &text, const nullable<const patch_state_ex &> &p)
 	{
 		p.and_then([&] (const patch_state_ex &patch) {
@@ -92,6 +99,10 @@ namespace micro_profiler
 			return micro_profiler::compare(lhs.inclusive_time, rhs.inclusive_time);
 		};
 
+		auto by_time_blocked = [] (const statistics_model_context &, const call_statistics &lhs, const call_statistics &rhs) {
+			return micro_profiler::compare(lhs.time_blocked, rhs.time_blocked);
+		};
+
 		auto by_avg_exclusive_call_time = [] (const statistics_model_context &, const call_statistics &lhs, const call_statistics &rhs) {
 			return micro_profiler::compare(lhs.exclusive_time, lhs.times_called, rhs.exclusive_time, rhs.times_called);
 		};
@@ -104,6 +115,54 @@ namespace micro_profiler
 			return micro_profiler::compare(lhs.max_call_time, rhs.max_call_time);
 		};
 
+		auto by_median_call_time = [] (const statistics_model_context &, const call_statistics &lhs, const call_statistics &rhs) {
+			return micro_profiler::compare(call_time_percentile(lhs, 0.5f), call_time_percentile(rhs, 0.5f));
+		};
+
+		auto by_p99_call_time = [] (const statistics_model_context &, const call_statistics &lhs, const call_statistics &rhs) {
+			return micro_profiler::compare(call_time_percentile(lhs, 0.99f), call_time_percentile(rhs, 0.99f));
+		};
+
+		auto allocations_avg = [] (const statistics_model_context &, const call_statistics &value) {
+			return micro_profiler::ratio(value.allocations, value.times_called, 1.0);
+		};
+
+		auto allocated_bytes_avg = [] (const statistics_model_context &, const call_statistics &value) {
+			return micro_profiler::ratio(value.allocated_bytes, value.times_called, 1.0);
+		};
+
+		auto instructions_per_cycle = [] (const statistics_model_context &, const call_statistics &value) {
+			return micro_profiler::ratio(value.hw_counters[hw_instructions], value.hw_counters[hw_cycles], 1.0);
+		};
+
+		auto l1d_misses_pki = [] (const statistics_model_context &, const call_statistics &value) {
+			return micro_profiler::ratio(value.hw_counters[hw_l1d_misses], value.hw_counters[hw_instructions], 1000.0);
+		};
+
+		auto llc_misses_pki = [] (const statistics_model_context &, const call_statistics &value) {
+			return micro_profiler::ratio(value.hw_counters[hw_llc_misses], value.hw_counters[hw_instructions], 1000.0);
+		};
+
+		auto by_allocations_avg = [] (const statistics_model_context &, const call_statistics &lhs, const call_statistics &rhs) {
+			return micro_profiler::compare(lhs.allocations, lhs.times_called, rhs.allocations, rhs.times_called);
+		};
+
+		auto by_allocated_bytes_avg = [] (const statistics_model_context &, const call_statistics &lhs, const call_statistics &rhs) {
+			return micro_profiler::compare(lhs.allocated_bytes, lhs.times_called, rhs.allocated_bytes, rhs.times_called);
+		};
+
+		auto by_instructions_per_cycle = [] (const statistics_model_context &context, const call_statistics &lhs, const call_statistics &rhs) {
+			return micro_profiler::compare(instructions_per_cycle(context, lhs), instructions_per_cycle(context, rhs));
+		};
+
+		auto by_l1d_misses_pki = [] (const statistics_model_context &context, const call_statistics &lhs, const call_statistics &rhs) {
+			return micro_profiler::compare(l1d_misses_pki(context, lhs), l1d_misses_pki(context, rhs));
+		};
+
+		auto by_llc_misses_pki = [] (const statistics_model_context &context, const call_statistics &lhs, const call_statistics &rhs) {
+			return micro_profiler::compare(llc_misses_pki(context, lhs), llc_misses_pki(context, rhs));
+		};
+
 
 		auto row_ = [] (agge::richtext_t &text, const statistics_model_context &, size_t row, const call_statistics &) {
 			micro_profiler::itoa<10>(text, row + 1u);
@@ -148,6 +207,10 @@ namespace micro_profiler
 			return context.tick_interval * value.inclusive_time;
 		};
 
+		auto time_blocked = [] (const statistics_model_context &context, const call_statistics &value) {
+			return context.tick_interval * value.time_blocked;
+		};
+
 		auto exclusive_time_avg = [] (const statistics_model_context &context, const call_statistics &value) {
 			return value.times_called ? context.tick_interval * value.exclusive_time / value.times_called : 0.0;
 		};
@@ -160,6 +223,14 @@ namespace micro_profiler
 			return context.tick_interval * value.max_call_time;
 		};
 
+		auto median_call_time = [] (const statistics_model_context &context, const call_statistics &value) {
+			return context.tick_interval * call_time_percentile(value, 0.5f);
+		};
+
+		auto p99_call_time = [] (const statistics_model_context &context, const call_statistics &value) {
+			return context.tick_interval * call_time_percentile(value, 0.99f);
+		};
+
 		template <typename U>
 		struct format_interval_
 		{
@@ -192,6 +263,30 @@ namespace micro_profiler
 			U underlying;
 		};
 
+		template <typename U>
+		struct format_ratio_
+		{
+			void operator ()(agge::richtext_t &text, const statistics_model_context &context, size_t /*row*/, const call_statistics &item) const
+			{
+				char buffer[100];
+				const auto value = underlying(context, item);
+
+				if (value < 0)
+				{
+					if (!context.canonical)
+						text << micro_profiler::en_dash;
+					return;
+				}
+
+				const int l = std::sprintf(buffer, context.canonical ? "%g" : "%0.2f", value);
+
+				if (l > 0)
+					text.append(buffer, buffer + l);
+			}
+
+			U underlying;
+		};
+
 		template <typename T>
 		inline format_interval_<T> format_interval2(const T &underlying)
 		{	return initialize< format_interval_<T> >(underlying);	}
@@ -200,6 +295,10 @@ namespace micro_profiler
 		inline format_integer_<T> format_integer(const T &underlying)
 		{	return initialize< format_integer_<T> >(underlying);	}
 
+		template <typename T>
+		inline format_ratio_<T> format_ratio(const T &underlying)
+		{	return initialize< format_ratio_<T> >(underlying);	}
+
 
 		auto by_process_name = [] (const process_model_context &, const process_info &lhs, const process_info &rhs) {
 			return utfia::compare<utfia::utf8>((micro_profiler::operator*)(lhs.path), (micro_profiler::operator*)(rhs.path),
@@ -272,6 +371,10 @@ namespace micro_profiler
 			return encode_state(lhs.patch()) - encode_state(rhs.patch());
 		};
 
+		auto by_patched_symbol_covered = [] (const image_patch_model_context &, const patched_symbol &lhs, const patched_symbol &rhs) {
+			return micro_profiler::compare(is_covered(lhs.patch()), is_covered(rhs.patch()));
+		};
+
 		auto by_patched_symbol_size = [] (const image_patch_model_context &, const patched_symbol &lhs, const patched_symbol &rhs) {
 			return micro_profiler::compare(lhs.symbol().size, rhs.symbol().size);
 		};
@@ -296,6 +399,11 @@ namespace micro_profiler
 			micro_profiler::format_patch_status(text, item.patch());
 		};
 
+		auto patched_symbol_covered = [] (agge::richtext_t &text, const image_patch_model_context &, size_t, const patched_symbol &item) {
+			if (micro_profiler::is_covered(item.patch()))
+				text << "covered";
+		};
+
 		auto patched_symbol_size = [] (agge::richtext_t &text, const image_patch_model_context &, size_t, const patched_symbol &item) {
 			micro_profiler::itoa<10>(text, item.symbol().size);
 		};
@@ -320,6 +428,14 @@ namespace micro_profiler
 		{	"AvgExclusiveTime", "Exclusive\n" + secondary + "average/call", 48, agge::align_far, format_interval2(exclusive_time_avg), by_avg_exclusive_call_time, false, exclusive_time_avg,	},
 		{	"AvgInclusiveTime", "Inclusive\n" + secondary + "average/call", 48, agge::align_far, format_interval2(inclusive_time_avg), by_avg_inclusive_call_time, false, inclusive_time_avg,	},
 		{	"MaxCallTime", "Inclusive\n" + secondary + "maximum/call", 121, agge::align_far, format_interval2(max_call_time), by_max_call_time, false, max_call_time,	},
+		{	"MedianCallTime", "Inclusive\n" + secondary + "median/call", 48, agge::align_far, format_interval2(median_call_time), by_median_call_time, false, median_call_time,	},
+		{	"P99CallTime", "Inclusive\n" + secondary + "p99/call", 48, agge::align_far, format_interval2(p99_call_time), by_p99_call_time, false, p99_call_time,	},
+		{	"InstructionsPerCycle", "IPC\n" + secondary + "inclusive", 48, agge::align_far, format_ratio(instructions_per_cycle), by_instructions_per_cycle, false,	},
+		{	"L1DMissesPKI", "L1D Misses\n" + secondary + "per 1k instructions", 64, agge::align_far, format_ratio(l1d_misses_pki), by_l1d_misses_pki, false,	},
+		{	"LLCMissesPKI", "LLC Misses\n" + secondary + "per 1k instructions", 64, agge::align_far, format_ratio(llc_misses_pki), by_llc_misses_pki, false,	},
+		{	"AvgAllocations", "Allocations\n" + secondary + "average/call", 64, agge::align_far, format_ratio(allocations_avg), by_allocations_avg, false,	},
+		{	"AvgAllocatedBytes", "Allocated\n" + secondary + "bytes/call", 64, agge::align_far, format_ratio(allocated_bytes_avg), by_allocated_bytes_avg, false,	},
+		{	"TimeBlocked", "Time Blocked\n" + secondary + "inclusive", 48, agge::align_far, format_interval2(time_blocked), by_time_blocked, false, time_blocked,	},
 	};
 
 	const column_definition<call_statistics, statistics_model_context> c_caller_statistics_columns[] = {
@@ -332,6 +448,14 @@ namespace micro_profiler
 		c_statistics_columns[6],
 		c_statistics_columns[7],
 		c_statistics_columns[8],
+		c_statistics_columns[9],
+		c_statistics_columns[10],
+		c_statistics_columns[11],
+		c_statistics_columns[12],
+		c_statistics_columns[13],
+		c_statistics_columns[14],
+		c_statistics_columns[15],
+		c_statistics_columns[16],
 	};
 
 	const column_definition<call_statistics, statistics_model_context> c_callee_statistics_columns[] = {
@@ -344,6 +468,14 @@ namespace micro_profiler
 		c_statistics_columns[6],
 		c_statistics_columns[7],
 		c_statistics_columns[8],
+		c_statistics_columns[9],
+		c_statistics_columns[10],
+		c_statistics_columns[11],
+		c_statistics_columns[12],
+		c_statistics_columns[13],
+		c_statistics_columns[14],
+		c_statistics_columns[15],
+		c_statistics_columns[16],
 	};
 
 
@@ -364,5 +496,6 @@ namespace micro_profiler
 		{	"Size", "Size\n" + secondary + "bytes", 64, agge::align_far, patched_symbol_size, by_patched_symbol_size, false,	},
 		{	"ModuleName", "Module\n" + secondary + "name", 120, agge::align_near, patched_symbol_module_name, by_patched_symbol_module_name, true,	},
 		{	"ModulePath", "Module\n" + secondary + "path", 150, agge::align_near, patched_symbol_module_path, by_patched_symbol_path, true,	},
+		{	"Covered", "Coverage\n" + secondary + "executed", 64, agge::align_near, patched_symbol_covered, by_patched_symbol_covered, false,	},
 	};
 }
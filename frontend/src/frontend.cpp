@@ -116,17 +116,98 @@ namespace micro_profiler
 
 			d(_db->mappings, as_map);
 		};
+		auto dropped_callback = [this] (ipc::deserializer &d) {
+			d(_dropped_buffer);
+			update_dropped_records(_dropped_buffer);
+		};
+		auto contention_callback = [this] (ipc::deserializer &d) {
+			d(_contention_buffer);
+			update_lock_contention(_contention_buffer);
+		};
+		auto throttled_callback = [this] (ipc::deserializer &d) {
+			d(_throttled_buffer);
+			update_throttled_patches(_throttled_buffer);
+		};
+		auto covered_callback = [this] (ipc::deserializer &d) {
+			d(_covered_buffer);
+			update_covered_functions(_covered_buffer);
+		};
+		auto exited_callback = [this] (ipc::deserializer &d) {
+			d(_exited_buffer);
+		};
 		auto update_callback = [this, &request_, on_update] (ipc::deserializer &d) {
 			d(_db->statistics, _serialization_context);
+			forget_threads(_exited_buffer);
+			update_threads(_serialization_context.threads);
+			on_update(request_);
+		};
+		auto delta_callback = [this, &request_, on_update] (ipc::deserializer &d) {
+			d(_delta_buffer);
+			update_statistics(_delta_buffer);
+			forget_threads(_exited_buffer);
 			update_threads(_serialization_context.threads);
 			on_update(request_);
 		};
 		pair<int, callback_t> callbacks[] = {
 			make_pair(response_modules_loaded, modules_callback),
+			make_pair(response_dropped_records, dropped_callback),
+			make_pair(response_lock_contention, contention_callback),
+			make_pair(response_patches_throttled, throttled_callback),
+			make_pair(response_functions_covered, covered_callback),
+			make_pair(response_threads_exited, exited_callback),
 			make_pair(response_statistics_update, update_callback),
+			make_pair(response_statistics_delta, delta_callback),
 		};
 
-		request(request_, request_update, 0, callbacks);
+		request(request_, request_update, update_delta, callbacks);
+	}
+
+	void frontend::update_statistics(const statistics_delta &delta)
+	{
+		auto &statistics = _db->statistics;
+		auto &threads = _serialization_context.threads;
+
+		threads.clear();
+		for (auto i = delta.begin(); i != delta.end(); ++i)
+		{
+			auto &nodes = _call_nodes[i->first];
+
+			threads.push_back(i->first);
+			for (auto j = i->second.created.begin(); j != i->second.created.end(); ++j)
+			{
+				if (j->parent > nodes.size())
+					break; // The delta does not follow the nodes known - its remainder cannot be attached.
+
+				auto rec = statistics.create();
+				auto &r = *rec;
+
+				r.thread_id = i->first;
+				r.parent_id = j->parent ? nodes[j->parent - 1]->id : 0;
+				r.address = j->address;
+				static_cast<function_statistics &>(r) = j->statistics;
+				rec.commit();
+				nodes.push_back(rec);
+			}
+			for (auto j = i->second.updated.begin(); j != i->second.updated.end(); ++j)
+			{
+				if (!j->first || j->first > nodes.size())
+					continue;
+
+				auto rec = statistics.modify(nodes[j->first - 1]);
+
+				add(*rec, j->second);
+				rec.commit();
+			}
+		}
+		statistics.invalidate();
+	}
+
+	void frontend::forget_threads(exited_threads &exited)
+	{
+		// The collector has dropped the call nodes of these threads - the indices it sends further start over.
+		for (auto i = exited.begin(); i != exited.end(); ++i)
+			_call_nodes.erase(*i);
+		exited.clear();
 	}
 
 	void frontend::update_threads(vector<id_t> &thread_ids)
@@ -156,6 +237,32 @@ namespace micro_profiler
 		});
 	}
 
+	void frontend::update_dropped_records(const dropped_records &dropped)
+	{
+		auto &idx = sdb::unique_index(_db->threads, keyer::external_id());
+
+		for (auto i = dropped.begin(); i != dropped.end(); ++i)
+		{
+			auto rec = idx[i->first];
+
+			(*rec).dropped_records += i->second;
+			rec.commit();
+		}
+	}
+
+	void frontend::update_lock_contention(const lock_contention &contention)
+	{
+		auto &idx = sdb::unique_index(_db->locks, keyer::address());
+
+		for (auto i = contention.begin(); i != contention.end(); ++i)
+		{
+			auto rec = idx[i->first];
+
+			add(*rec, i->second);
+			rec.commit();
+		}
+	}
+
 	void frontend::finalize()
 	{
 		LOG(PREAMBLE "finalizing...") % A(this);
@@ -103,15 +103,39 @@ namespace micro_profiler
 	template <typename F>
 	void frontend::request_metadata_nw(shared_ptr<void> &request_, id_t module_id, const F &ready)
 	{
-		LOG(PREAMBLE "requesting from remote...") % A(this) % A(module_id);
-		request(request_, request_module_metadata, module_id, response_module_metadata,
-			[this, module_id, ready] (ipc::deserializer &d) {
-
+		const auto symbols = make_shared< vector<symbol_info> >();
+		auto symbols_callback = [this, symbols] (ipc::deserializer &d) {
+			d(_symbols_buffer);
+			append_symbols(*symbols, _symbols_buffer);
+		};
+		auto metadata_callback = [this, module_id, symbols, ready] (ipc::deserializer &d) {
 			auto m = make_shared<module_info_metadata>();
 
 			d(*m);
+			append_symbols(*symbols, m->symbols);
+			m->symbols.swap(*symbols);
 			LOG(PREAMBLE "received...") % A(module_id) % A(m->symbols.size()) % A(m->source_files.size());
 			ready(m);
-		});
+		};
+		pair<int, callback_t> callbacks[] = {
+			make_pair(response_module_metadata_symbols, symbols_callback),
+			make_pair(response_module_metadata, metadata_callback),
+		};
+
+		// The older collectors respond to the chunked request with nothing, sending all the symbols (demangled) at once
+		// upon the original one.
+		const auto chunked = !!(_db->process_info.capabilities & capability_chunked_metadata);
+
+		LOG(PREAMBLE "requesting from remote...") % A(this) % A(module_id);
+		request(request_, chunked ? request_module_metadata_chunked : request_module_metadata, module_id, callbacks);
+	}
+
+	void frontend::append_symbols(vector<symbol_info> &symbols, vector<symbol_info> &chunk)
+	{
+		for (auto i = chunk.begin(); i != chunk.end(); ++i)
+		{
+			_demangler(i->name);
+			symbols.push_back(move(*i));
+		}
 	}
 }
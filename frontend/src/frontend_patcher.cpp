@@ -147,4 +147,51 @@ namespace micro_profiler
 			_requests.erase(req);
 		});
 	}
+
+	void frontend::update_throttled_patches(const throttled_patches &throttled)
+	{
+		if (throttled.empty())
+			return;
+
+		auto &idx = sdb::unique_index<keyer::symbol_id>(_db->patches);
+
+		for (auto i = throttled.begin(); i != throttled.end(); ++i)
+		{
+			const auto symbol_id = symbol_key(i->first, i->second);
+
+			if (idx.find(symbol_id))
+			{
+				auto rec = idx[symbol_id];
+
+				(*rec).state = patch_state::throttled;
+				rec.commit();
+			}
+		}
+		_db->patches.invalidate();
+	}
+
+	void frontend::update_covered_functions(const covered_functions &covered)
+	{
+		if (covered.empty())
+			return;
+
+		auto &idx = sdb::unique_index<keyer::symbol_id>(_db->patches);
+
+		for (auto i = covered.begin(); i != covered.end(); ++i)
+		{
+			const auto symbol_id = symbol_key(i->first, i->second);
+
+			if (idx.find(symbol_id))
+			{
+				auto rec = idx[symbol_id];
+
+				// The collector reverts a coverage patch once it is hit.
+				(*rec).covered = true;
+				if (patch_state::active == (*rec).state)
+					(*rec).state = patch_state::dormant;
+				rec.commit();
+			}
+		}
+		_db->patches.invalidate();
+	}
 }
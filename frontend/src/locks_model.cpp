@@ -0,0 +1,75 @@
+#include <frontend/locks_model.h>
+
+#include <common/formatting.h>
+#include <frontend/trackables_provider.h>
+#include <views/ordered.h>
+
+#pragma warning(disable: 4355)
+
+using namespace std;
+
+namespace micro_profiler
+{
+	template <>
+	struct key_traits<contended_lock>
+	{
+		typedef long_address_t key_type;
+
+		static key_type get_key(const contended_lock &item)
+		{	return item.address;	}
+	};
+
+	namespace
+	{
+		struct trackable : wpl::trackable
+		{
+			template <typename U>
+			trackable(U &u, index_type index)
+				: _underlying(index >= 1u ? u.track(index - 1) : shared_ptr<const wpl::trackable>()),
+					_fixed_index(index)
+			{	}
+
+			virtual index_type index() const override
+			{	return _underlying ? _underlying->index() + 1 : _fixed_index;	}
+
+			shared_ptr<const wpl::trackable> _underlying;
+			const index_type _fixed_index;
+		};
+	}
+
+	locks_model::locks_model(shared_ptr<const tables::locks> locks, double tick_interval)
+		: _underlying(locks), _tick_interval(tick_interval), _view(make_shared<view_type>(*_underlying)),
+			_trackables(make_shared<trackables_type>(*_view))
+	{
+		_invalidation = locks->invalidate += [this] (...) {
+			_view->fetch();
+			_trackables->fetch();
+			invalidate(npos());
+		};
+		_view->set_order([] (const tables::locks::value_type &lhs, const tables::locks::value_type &rhs) {
+			return lhs.time_blocked < rhs.time_blocked;
+		}, false);
+	}
+
+	locks_model::index_type locks_model::get_count() const throw()
+	{	return _view->size() + 1;	}
+
+	void locks_model::get_value(index_type index, string &text) const
+	{
+		if (!index--)
+		{
+			text = "Contended Locks: ", itoa<10>(text, _view->size());
+		}
+		else
+		{
+			const contended_lock &v = (*_view)[index];
+
+			text = "0x", itoa<16>(text, v.address, 12);
+			text += " - contentions: ", itoa<10>(text, v.contentions);
+			text += ", blocked: ", format_interval(text, _tick_interval * v.time_blocked);
+		}
+	}
+
+	shared_ptr<const wpl::trackable> locks_model::track(index_type index) const
+	{	return make_shared<trackable>(*_trackables, index);	}
+}
@@ -90,6 +90,8 @@ namespace micro_profiler
 			text += ", started: +", format_interval(text, to_seconds(v.start_time));
 			if (v.complete)
 				text += ", ended: +", format_interval(text, to_seconds(v.end_time));
+			if (v.dropped_records)
+				text += ", lost records: ", itoa<10>(text, v.dropped_records);
 		}
 	}
 
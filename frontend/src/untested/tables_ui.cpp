@@ -26,6 +26,7 @@
 #include <frontend/derived_statistics.h>
 #include <frontend/function_hint.h>
 #include <frontend/headers_model.h>
+#include <frontend/locks_model.h>
 #include <frontend/models.h>
 #include <frontend/piechart.h>
 #include <frontend/representation.h>
@@ -69,6 +70,7 @@ namespace micro_profiler
 			_hierarchical(true),
 			_thread_id(static_cast<id_t>(threads_model::all)),
 			_filter_selector(factory_.create_control<combobox>("combobox")),
+			_locks_selector(factory_.create_control<combobox>("combobox")),
 			_main_piechart(factory_.create_control<piechart>("piechart")),
 			_callees_piechart(factory_.create_control<piechart>("piechart")),
 			_main_hint(apply_stylesheet(make_shared<function_hint>(*factory_.context.text_engine),
@@ -98,6 +100,9 @@ namespace micro_profiler
 		};
 		_filter_selector->select(0u);
 		_filter_selector->selection_changed(0u);
+
+		_locks_selector->set_model(make_shared<locks_model>(locks(session), 1.0 / session->process_info.ticks_per_second));
+		_locks_selector->select(0u);
 	}
 
 	tables_ui::~tables_ui()
@@ -126,6 +131,7 @@ namespace micro_profiler
 		add(panel[0] = factory_.create_control<stack>("vstack"), percents(60), true);
 			panel[0]->set_spacing(5);
 			panel[0]->add(_filter_selector, pixels(24), false, 4);
+			panel[0]->add(_locks_selector, pixels(24), false, 5);
 			panel[0]->add(panel[1] = factory_.create_control<stack>("hstack"), percents(100), false);
 				panel[1]->set_spacing(5);
 				panel[1]->add(_main_piechart, pixels(150), false);
@@ -73,7 +73,7 @@ namespace micro_profiler
 		bool _initialized, _hierarchical;
 		id_t _thread_id;
 
-		const std::shared_ptr<wpl::combobox> _filter_selector;
+		const std::shared_ptr<wpl::combobox> _filter_selector, _locks_selector;
 		const std::shared_ptr<piechart> _main_piechart, _callees_piechart;
 		const std::shared_ptr<function_hint> _main_hint, _callees_hint;
 		const std::shared_ptr<wpl::listview> _main_view, _callers_view, _callees_view;
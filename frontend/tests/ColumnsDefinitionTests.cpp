@@ -11,6 +11,21 @@ namespace micro_profiler
 {
 	namespace tests
 	{
+		namespace
+		{
+			call_statistics make_counted_statistics(count_t cycles, count_t instructions, count_t l1d_misses,
+				count_t llc_misses)
+			{
+				auto s = make_call_statistics(0, 0, 0, 0, 1, 0, 0, 0, 0);
+
+				s.hw_counters[hw_cycles] = cycles;
+				s.hw_counters[hw_instructions] = instructions;
+				s.hw_counters[hw_l1d_misses] = l1d_misses;
+				s.hw_counters[hw_llc_misses] = llc_misses;
+				return s;
+			}
+		}
+
 		begin_test_suite( ColumnsDefinitionTests )
 			statistics_model_context ctx;
 
@@ -84,6 +99,95 @@ namespace micro_profiler
 				assert_comparison_valid(c_statistics_columns[main_columns::exclusive], data);
 			}
 
+
+			test( CallTimePercentilesAreComparedAsExpected )
+			{
+				// INIT
+				const timestamp_t durations[] = {	10, 30, 1000, 50000,	};
+				call_statistics data[] = {
+					make_call_statistics(0, 0, 0, 0, 0, 0, 0, 0, 0),
+					make_call_statistics(0, 0, 0, 0, 10, 0, 100, 100, 10),
+					make_call_statistics(0, 0, 0, 0, 10, 0, 300, 300, 30),
+					make_call_statistics(0, 0, 0, 0, 10, 0, 10000, 10000, 1000),
+					make_call_statistics(0, 0, 0, 0, 10, 0, 500000, 500000, 50000),
+				};
+
+				for (auto i = 1u; i != 5u; ++i)
+				{
+					data[i].call_times.set_scale(call_times_scale());
+					data[i].call_times.add(durations[i - 1], 10);
+				}
+
+				// ACT / ASSERT
+				assert_comparison_valid(c_statistics_columns[main_columns::median_time], data);
+				assert_comparison_valid(c_statistics_columns[main_columns::p99_time], data);
+			}
+
+
+			test( HardwareCounterRatiosAreComparedAsExpected )
+			{
+				// INIT
+				call_statistics ipc_data[] = {
+					make_counted_statistics(0, 0, 0, 0),
+					make_counted_statistics(1000, 0, 0, 0),
+					make_counted_statistics(1000, 500, 0, 0),
+					make_counted_statistics(3000, 3000, 0, 0),
+					make_counted_statistics(1000, 1500, 0, 0),
+					make_counted_statistics(10000000000, 40000000000, 0, 0),
+				};
+				call_statistics misses_data[] = {
+					make_counted_statistics(0, 0, 7, 7),
+					make_counted_statistics(0, 1000, 0, 0),
+					make_counted_statistics(0, 1000, 1, 1),
+					make_counted_statistics(0, 500, 1, 1),
+					make_counted_statistics(0, 10000000000, 30000000, 30000000),
+				};
+
+				// ACT / ASSERT
+				assert_comparison_valid(c_statistics_columns[main_columns::instructions_per_cycle], ipc_data);
+				assert_comparison_valid(c_statistics_columns[main_columns::l1d_misses_pki], misses_data);
+				assert_comparison_valid(c_statistics_columns[main_columns::llc_misses_pki], misses_data);
+			}
+
+
+			test( AllocationsPerCallAreComparedAsExpected )
+			{
+				// INIT
+				call_statistics data[] = {
+					make_call_statistics(0, 0, 0, 0, 10, 0, 0, 0, 0),
+					make_call_statistics(0, 0, 0, 0, 10, 0, 0, 0, 0),
+					make_call_statistics(0, 0, 0, 0, 3, 0, 0, 0, 0),
+					make_call_statistics(0, 0, 0, 0, 10, 0, 0, 0, 0),
+					make_call_statistics(0, 0, 0, 0, 1, 0, 0, 0, 0),
+				};
+				const count_t allocations[] = {	0, 5, 2, 7, 1000,	};
+
+				for (auto i = 0u; i != 5u; ++i)
+					data[i].allocations = allocations[i], data[i].allocated_bytes = 16 * allocations[i];
+
+				// ACT / ASSERT
+				assert_comparison_valid(c_statistics_columns[main_columns::allocations_avg], data);
+				assert_comparison_valid(c_statistics_columns[main_columns::allocated_bytes_avg], data);
+			}
+
+
+			test( TimeBlockedIsComparedAsExpected )
+			{
+				// INIT
+				call_statistics data[] = {
+					make_call_statistics(0, 0, 0, 0, 1, 0, 0, 0, 0),
+					make_call_statistics(0, 0, 0, 0, 1, 0, 0, 0, 0),
+					make_call_statistics(0, 0, 0, 0, 1, 0, 0, 0, 0),
+					make_call_statistics(0, 0, 0, 0, 1, 0, 0, 0, 0),
+				};
+				const timestamp_t time_blocked[] = {	0, 1000, 7, 100,	};
+
+				for (auto i = 0u; i != 4u; ++i)
+					data[i].time_blocked = time_blocked[i];
+
+				// ACT / ASSERT
+				assert_comparison_valid(c_statistics_columns[main_columns::time_blocked], data);
+			}
 		end_test_suite
 	}
 }
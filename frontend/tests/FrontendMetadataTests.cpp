@@ -49,7 +49,7 @@ namespace micro_profiler
 
 			initialization_data make_initialization_data(const string &executable, timestamp_t ticks_per_second)
 			{
-				initialization_data idata = {	executable, ticks_per_second };
+				initialization_data idata = {	executable, ticks_per_second, 0u, capability_chunked_metadata	};
 				return idata;
 			}
 
@@ -106,7 +106,7 @@ namespace micro_profiler
 						+ make_mapping_pair(5, 191, 0x01100000u, "d", 1));
 				});
 				emulator->message(init, format(make_initialization_data("", 1)));
-				emulator->add_handler(request_module_metadata, [&] (ipc::server_session::response &, unsigned module_id) {
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &, unsigned module_id) {
 					log.push_back(module_id);
 				});
 
@@ -173,7 +173,7 @@ namespace micro_profiler
 						+ make_mapping_pair(3, 19, 0x00100000u, "c", 1));
 				});
 				emulator->message(init, format(make_initialization_data("", 1)));
-				emulator->add_handler(request_module_metadata, [&] (ipc::server_session::response &, unsigned module_id) {
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &, unsigned module_id) {
 					log.push_back(module_id);
 				});
 
@@ -210,7 +210,7 @@ namespace micro_profiler
 			{
 				// INIT
 				auto frontend_ = create_frontend();
-				emulator->add_handler(request_module_metadata, [&] (ipc::server_session::response &resp, unsigned module_id) {
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &resp, unsigned module_id) {
 					symbol_info symbols17[] = {	{	"foo", 0x0100, 1	},	},
 						symbols99[] = { { "FOO", 0x0001, 1 }, { "BAR", 0x0100, 1 }, },
 						symbols1000[] = {	{	"baz", 0x0010, 1	},	};
@@ -266,6 +266,111 @@ namespace micro_profiler
 			}
 
 
+			test( SymbolChunksAreAssembledIntoModuleMetadata )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+				symbol_info symbols1[] = {	{	"foo", 0x0100, 1	}, {	"bar", 0x0200, 3	},	},
+					symbols2[] = {	{	"baz", 0x0010, 1	},	},
+					symbols3[] = {	{	"qux", 0x0300, 7	},	};
+				pair<unsigned, string> files[] = {	make_pair(3, "main.cpp"),	};
+
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &resp, unsigned) {
+					resp(response_module_metadata_symbols, mkvector(symbols1));
+					resp(response_module_metadata_symbols, mkvector(symbols2));
+					resp(response_module_metadata, create_metadata_info(100, symbols3, files));
+				});
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_modules_loaded, plural
+						+ make_mapping_pair(1, 99, 0x00100000u, "b", 100));
+				});
+				emulator->message(init, format(make_initialization_data("", 1)));
+
+				// ACT
+				modules(context)->request_presence(req[0], 99, [] (module_info_metadata) {});
+				worker.run_till_end(), apartment.run_till_end();
+
+				// ASSERT
+				symbol_info reference[] = {
+					{	"foo", 0x0100, 1	}, {	"bar", 0x0200, 3	}, {	"baz", 0x0010, 1	}, {	"qux", 0x0300, 7	},
+				};
+				const auto m = modules_by_id(*context).find(99);
+
+				assert_not_null(m);
+				assert_equal(reference, m->symbols);
+				assert_equal(1u, m->source_files.size());
+			}
+
+			test( MetadataIsRequestedInASingleMessageFromCollectorsNotStreamingIt )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+				symbol_info symbols[] = {	{	"foo", 0x0100, 1	}, {	"bar(int)", 0x0200, 3	},	};
+				pair<unsigned, string> files[] = {	make_pair(3, "main.cpp"),	};
+				initialization_data idata = {	"", 1	};
+				vector<unsigned> log;
+
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &, unsigned) {
+					assert_is_false(true);
+				});
+				emulator->add_handler(request_module_metadata, [&] (ipc::server_session::response &resp, unsigned id) {
+					log.push_back(id);
+					resp(response_module_metadata, create_metadata_info(100, symbols, files));
+				});
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_modules_loaded, plural
+						+ make_mapping_pair(1, 99, 0x00100000u, "b", 100));
+				});
+				emulator->message(init, format(idata));
+
+				// ACT
+				modules(context)->request_presence(req[0], 99, [] (module_info_metadata) {});
+				worker.run_till_end(), apartment.run_till_end();
+
+				// ASSERT
+				const auto m = modules_by_id(*context).find(99);
+
+				assert_equal(plural + 99u, log);
+				assert_not_null(m);
+				assert_equal(symbols, m->symbols);
+				assert_equal(1u, m->source_files.size());
+			}
+
+#ifndef _WIN32
+			test( MangledSymbolNamesAreDemangledOnReception )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+				symbol_info symbols1[] = {	{	"_ZN14micro_profiler3fooEv", 0x0100, 1	},	},
+					symbols2[] = {	{	"bar", 0x0200, 1	}, {	"_Z3bazi", 0x0300, 1	},	};
+				pair<unsigned, string> files[] = {	make_pair(3, "main.cpp"),	};
+
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &resp, unsigned) {
+					resp(response_module_metadata_symbols, mkvector(symbols1));
+					resp(response_module_metadata, create_metadata_info(100, symbols2, files));
+				});
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_modules_loaded, plural
+						+ make_mapping_pair(1, 99, 0x00100000u, "b", 100));
+				});
+				emulator->message(init, format(make_initialization_data("", 1)));
+
+				// ACT
+				modules(context)->request_presence(req[0], 99, [] (module_info_metadata) {});
+				worker.run_till_end(), apartment.run_till_end();
+
+				// ASSERT
+				const auto m = modules_by_id(*context).find(99);
+
+				assert_not_null(m);
+				assert_equal(3u, m->symbols.size());
+				assert_equal("micro_profiler::foo()", m->symbols[0].name);
+				assert_equal("bar", m->symbols[1].name);
+				assert_equal("baz(int)", m->symbols[2].name);
+			}
+#endif
+
+
 			test( ModuleMetadataIsNotRequestFromRemoteIfFoundLocally )
 			{
 				// INIT
@@ -285,7 +390,7 @@ namespace micro_profiler
 						+ make_mapping_pair(3, 1000, 0x00100000u, "/lib64/test/libc.so", 1));
 				});
 				emulator->message(init, format(make_initialization_data("", 1)));
-				emulator->add_handler(request_module_metadata, [&] (ipc::server_session::response &, unsigned) {	assert_is_false(true);	});
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &, unsigned) {	assert_is_false(true);	});
 				preferences_db->on_load_metadata = [&] (unsigned hash) -> unique_ptr<module_info_metadata> {
 					assert_equal(0x00100201u, hash);
 					return unique_ptr<module_info_metadata>(new module_info_metadata(create_metadata_info(0x00100201, symbols17, files17)));
@@ -353,7 +458,7 @@ namespace micro_profiler
 				// ACT
 				modules(context)->request_presence(req[0], 17u, [&] (const module_info_metadata &md) {	log.push_back(&md);	});
 				worker.run_one();
-				emulator->add_handler(request_module_metadata, [&] (ipc::server_session::response &resp, unsigned) {
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &resp, unsigned) {
 					resp(response_module_metadata, create_metadata_info(0x90100201, symbols17, files17));
 				});
 				apartment.run_one();
@@ -380,7 +485,7 @@ namespace micro_profiler
 				// ACT
 				modules(context)->request_presence(req[1], 170u, [&] (const module_info_metadata &md) {	log.push_back(&md);	});
 				worker.run_one();
-				emulator->add_handler(request_module_metadata, [&] (ipc::server_session::response &resp, unsigned) {
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &resp, unsigned) {
 					resp(response_module_metadata, create_metadata_info(1, symbols99, files99));
 				});
 				apartment.run_till_end();
@@ -401,7 +506,7 @@ namespace micro_profiler
 				pair<unsigned, string> files17[] = {	make_pair(0, "handlers.cpp"), make_pair(1, "models.cpp"),	};
 				vector<const module_info_metadata *> log;
 
-				emulator->add_handler(request_module_metadata, [&] (ipc::server_session::response &resp, unsigned) {
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &resp, unsigned) {
 					resp(response_module_metadata, create_metadata_info(17, symbols17, files17));
 				});
 				emulator->message(init, format(make_initialization_data("", 1)));
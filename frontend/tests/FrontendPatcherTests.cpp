@@ -57,6 +57,7 @@ namespace micro_profiler
 			mocks::queue queue, worker_queue;
 			shared_ptr<ipc::server_session> emulator;
 			shared_ptr<frontend> frontend_;
+			shared_ptr<profiling_session> session;
 			shared_ptr<const tables::patches> patches;
 
 			init( Init )
@@ -78,6 +79,7 @@ namespace micro_profiler
 					s(idata);
 				});
 
+				session = context;
 				patches = micro_profiler::patches(context);
 
 				// ASSERT
@@ -686,6 +688,93 @@ namespace micro_profiler
 					+ make_patch(19, 3, 3, false, patch_state::active, patch_change_result::activation_error), log.back());
 			}
 
+
+			test( PatchesThrottledByCollectorAreMarkedSoAndCanBeReapplied )
+			{
+				// INIT
+				vector<patch_apply_request> log;
+
+				emulator->add_handler(request_apply_patches, [&] (ipc::server_session::response &resp, const patch_apply_request &payload) {
+					vector<patch_change_result> results;
+
+					log.push_back(payload);
+					for (auto i = payload.functions.begin(); i != payload.functions.end(); ++i)
+						results.push_back(mkpatch_change(i->first, patch_change_result::ok, i->first));
+					resp(response_patched, results);
+				});
+				emulator->add_handler(request_update, [] (ipc::server_session::response &resp) {
+					resp(response_patches_throttled, plural
+						+ make_pair(19u, 1u)
+						+ make_pair(19u, 3u)
+						+ make_pair(31u, 7u));
+					resp(response_statistics_delta, statistics_delta());
+				});
+				patches->apply(19, mkrange(plural + patch_def(1, 0) + patch_def(2, 0) + patch_def(3, 0)));
+
+				// ACT
+				session->statistics.request_update();
+
+				// ASSERT
+				assert_equivalent(plural
+					+ make_patch(19, 1, 1, false, patch_state::throttled)
+					+ make_patch(19, 2, 2, false, patch_state::active)
+					+ make_patch(19, 3, 3, false, patch_state::throttled), *patches);
+
+				// ACT
+				patches->apply(19, mkrange(plural + patch_def(1, 0) + patch_def(2, 0) + patch_def(3, 0)));
+
+				// ASSERT
+				assert_equal(2u, log.size());
+				assert_equal(plural + patch_def(1, 0) + patch_def(3, 0), log.back().functions);
+				assert_equivalent(plural
+					+ make_patch(19, 1, 1, false, patch_state::active)
+					+ make_patch(19, 2, 2, false, patch_state::active)
+					+ make_patch(19, 3, 3, false, patch_state::active), *patches);
+			}
+
+
+			test( FunctionsCoveredAreMarkedSoAndCanBeReapplied )
+			{
+				// INIT
+				vector<patch_apply_request> log;
+
+				emulator->add_handler(request_apply_patches, [&] (ipc::server_session::response &resp, const patch_apply_request &payload) {
+					vector<patch_change_result> results;
+
+					log.push_back(payload);
+					for (auto i = payload.functions.begin(); i != payload.functions.end(); ++i)
+						results.push_back(mkpatch_change(i->first, patch_change_result::ok, i->first));
+					resp(response_patched, results);
+				});
+				emulator->add_handler(request_update, [] (ipc::server_session::response &resp) {
+					resp(response_functions_covered, plural
+						+ make_pair(19u, 2u)
+						+ make_pair(19u, 3u)
+						+ make_pair(31u, 7u));
+					resp(response_statistics_delta, statistics_delta());
+				});
+				patches->apply(19, mkrange(plural + patch_def(1, 0) + patch_def(2, 0) + patch_def(3, 0)));
+
+				// ACT
+				session->statistics.request_update();
+
+				// ASSERT
+				auto p2 = make_patch(19, 2, 2, false, patch_state::dormant);
+				auto p3 = make_patch(19, 3, 3, false, patch_state::dormant);
+
+				p2.covered = p3.covered = true;
+				assert_equivalent(plural + make_patch(19, 1, 1, false, patch_state::active) + p2 + p3, *patches);
+
+				// ACT
+				patches->apply(19, mkrange(plural + patch_def(1, 0) + patch_def(2, 0) + patch_def(3, 0)));
+
+				// ASSERT
+				p2.state = p3.state = patch_state::active;
+				assert_equal(2u, log.size());
+				assert_equal(plural + patch_def(2, 0) + patch_def(3, 0), log.back().functions);
+				assert_equivalent(plural + make_patch(19, 1, 1, false, patch_state::active) + p2 + p3, *patches);
+			}
+
 		end_test_suite
 	}
 }
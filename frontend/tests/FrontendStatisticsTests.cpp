@@ -42,7 +42,7 @@ namespace micro_profiler
 				ipc::channel *outbound;
 			};
 
-			const initialization_data idata = {	"", 1	};
+			const initialization_data idata = {	"", 1, 0u, capability_chunked_metadata	};
 
 			template <typename T>
 			function<void (ipc::serializer &s)> format(const T &v)
@@ -204,7 +204,7 @@ namespace micro_profiler
 				auto frontend_ = create_frontend();
 				vector<unsigned> persistent_ids;
 
-				emulator->add_handler(request_module_metadata, [&] (ipc::server_session::response &/*resp*/, unsigned id) {
+				emulator->add_handler(request_module_metadata_chunked, [&] (ipc::server_session::response &/*resp*/, unsigned id) {
 					persistent_ids.push_back(id);
 				});
 				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
@@ -289,6 +289,55 @@ namespace micro_profiler
 			}
 
 
+			test( LockContentionIsAccumulatedByTheLockAddress )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+				const lock_statistics s1 = {	3, 100	}, s2 = {	1, 17	}, s3 = {	2, 10	}, s4 = {	5, 1000	};
+
+				emulator->add_handler(request_update, [] (ipc::server_session::response &resp) {	empty_update(resp);	});
+				emulator->message(init, format(idata));
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_lock_contention, plural
+						+ make_pair(long_address_t(0x1000), s1)
+						+ make_pair(long_address_t(0x2000), s2)
+						+ make_pair(long_address_t(0x1000), s3));
+					empty_update(resp);
+				});
+				auto find_lock = [this] (long_address_t address) {
+					return *find_if(session->locks.begin(), session->locks.end(), [address] (const contended_lock &l) {
+						return l.address == address;
+					});
+				};
+
+				// ACT
+				session->statistics.request_update();
+
+				// ASSERT
+				assert_equal(2, distance(session->locks.begin(), session->locks.end()));
+				assert_equal(5u, find_lock(0x1000).contentions);
+				assert_equal(110u, find_lock(0x1000).time_blocked);
+				assert_equal(1u, find_lock(0x2000).contentions);
+				assert_equal(17u, find_lock(0x2000).time_blocked);
+
+				// INIT
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_lock_contention, plural
+						+ make_pair(long_address_t(0x2000), s4));
+					empty_update(resp);
+				});
+
+				// ACT
+				session->statistics.request_update();
+
+				// ASSERT
+				assert_equal(2, distance(session->locks.begin(), session->locks.end()));
+				assert_equal(5u, find_lock(0x1000).contentions);
+				assert_equal(6u, find_lock(0x2000).contentions);
+				assert_equal(1017u, find_lock(0x2000).time_blocked);
+			}
+
+
 			test( SessionIsDisconnectedAfterAllMetadataRequestedIsFinallyResponded )
 			{
 				// INIT
@@ -314,7 +363,7 @@ namespace micro_profiler
 							+ make_statistics(0x01A00091u, 31u, 0, 197999, 91, 13002)));
 				});
 
-				emulator->add_handler(request_module_metadata, [] (ipc::server_session::response &resp, unsigned) {
+				emulator->add_handler(request_module_metadata_chunked, [] (ipc::server_session::response &resp, unsigned) {
 					resp.defer([] (ipc::server_session::response &resp) {
 						resp(response_module_metadata, module_info_metadata());
 					});
@@ -371,7 +420,7 @@ namespace micro_profiler
 							+ make_statistics(0x01A00091u, 31u, 0, 197999, 91, 13002)));
 				});
 
-				emulator->add_handler(request_module_metadata, [] (ipc::server_session::response &resp, unsigned) {
+				emulator->add_handler(request_module_metadata_chunked, [] (ipc::server_session::response &resp, unsigned) {
 					resp(response_module_metadata, module_info_metadata());
 				});
 				session->modules.request_presence(req[0], 19, [] (module_info_metadata) {});
@@ -396,7 +445,7 @@ namespace micro_profiler
 
 				emulator->set_disconnect_handler([&] {	disconnections++;	});
 				emulator->add_handler(request_update, [] (ipc::server_session::response &resp) {	empty_update(resp);	});
-				emulator->add_handler(request_module_metadata, [] (ipc::server_session::response &resp, unsigned) {
+				emulator->add_handler(request_module_metadata_chunked, [] (ipc::server_session::response &resp, unsigned) {
 					resp(response_module_metadata, module_info_metadata());
 				});
 				emulator->message(init, format(idata));
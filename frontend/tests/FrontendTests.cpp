@@ -4,12 +4,14 @@
 #include "helpers.h"
 #include "mock_cache.h"
 #include "mock_channel.h"
+#include "primitive_helpers.h"
 
 #include <collector/serialization.h> // TODO: remove?
 #include <common/serialization.h>
 #include <ipc/server_session.h>
 #include <strmd/serializer.h>
 #include <test-helpers/mock_queue.h>
+#include <test-helpers/primitive_helpers.h>
 #include <ut/assert.h>
 #include <ut/test.h>
 
@@ -54,6 +56,13 @@ namespace micro_profiler
 			template <typename T>
 			function<void (ipc::serializer &s)> format(const T &v)
 			{	return [v] (ipc::serializer &s) {	s(v);	};	}
+
+			call_graph_delta make_call_graph_delta(const vector<call_graph_delta::created_node> &created,
+				const vector< pair<unsigned int, function_statistics> > &updated)
+			{
+				call_graph_delta d = {	created, updated	};
+				return d;
+			}
 		}
 
 
@@ -338,6 +347,138 @@ namespace micro_profiler
 			}
 
 
+			test( StatisticsDeltaIsRequestedAndAppliedToTheCallNodesReferred )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+				vector<update_request_flags> log;
+
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp, update_request_flags flags) {
+					log.push_back(flags);
+					resp(response_statistics_delta, plural
+						+ make_pair(3u, make_call_graph_delta(plural
+							+ make_created_node(0, 0x1000u, 1, 10, 7, 10)
+							+ make_created_node(1, 0x2000u, 2, 3, 3, 2), vector< pair<unsigned int, function_statistics> >()))
+						+ make_pair(5u, make_call_graph_delta(plural
+							+ make_created_node(0, 0x1000u, 1, 4, 4, 4), vector< pair<unsigned int, function_statistics> >())));
+				});
+
+				// ACT
+				emulator->message(init, format(make_initialization_data("/test", 1)));
+
+				// ASSERT
+				call_statistics reference1[] = {
+					make_call_statistics(1, 3, 0, 0x1000u, 1, 0, 10, 7, 10),
+					make_call_statistics(2, 3, 1, 0x2000u, 2, 0, 3, 3, 2),
+					make_call_statistics(3, 5, 0, 0x1000u, 1, 0, 4, 4, 4),
+				};
+
+				assert_equal(plural + update_delta, log);
+				assert_equal_pred(reference1, context->statistics, eq());
+
+				// INIT
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_statistics_delta, plural
+						+ make_pair(3u, make_call_graph_delta(plural
+							+ make_created_node(2, 0x3000u, 1, 1, 1, 1), plural
+							+ make_pair(1u, function_statistics(2, 20, 5, 15))))
+						+ make_pair(5u, make_call_graph_delta(vector<call_graph_delta::created_node>(), plural
+							+ make_pair(1u, function_statistics(1, 1, 1, 1)))));
+				});
+
+				// ACT
+				context->statistics.request_update();
+
+				// ASSERT
+				call_statistics reference2[] = {
+					make_call_statistics(1, 3, 0, 0x1000u, 3, 0, 30, 12, 15),
+					make_call_statistics(2, 3, 1, 0x2000u, 2, 0, 3, 3, 2),
+					make_call_statistics(3, 5, 0, 0x1000u, 2, 0, 5, 5, 4),
+					make_call_statistics(4, 3, 2, 0x3000u, 1, 0, 1, 1, 1),
+				};
+
+				assert_equal_pred(reference2, context->statistics, eq());
+			}
+
+
+			test( CallNodesOfTheThreadsExitedAreForgottenAfterTheirLastDelta )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_statistics_delta, plural
+						+ make_pair(3u, make_call_graph_delta(plural
+							+ make_created_node(0, 0x1000u, 1, 10, 7, 10), vector< pair<unsigned int, function_statistics> >())));
+				});
+				emulator->message(init, format(make_initialization_data("/test", 1)));
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_threads_exited, plural + 3u);
+					resp(response_statistics_delta, plural
+						+ make_pair(3u, make_call_graph_delta(vector<call_graph_delta::created_node>(), plural
+							+ make_pair(1u, function_statistics(2, 20, 5, 15)))));
+				});
+
+				// ACT
+				context->statistics.request_update();
+
+				// INIT
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_threads_exited, vector<unsigned int>());
+					resp(response_statistics_delta, plural
+						+ make_pair(3u, make_call_graph_delta(plural
+							+ make_created_node(0, 0x2000u, 1, 1, 1, 1), plural
+							+ make_pair(1u, function_statistics(1, 1, 1, 1)))));
+				});
+
+				// ACT
+				context->statistics.request_update();
+
+				// ASSERT
+				call_statistics reference[] = {
+					make_call_statistics(1, 3, 0, 0x1000u, 3, 0, 30, 12, 15),
+					make_call_statistics(2, 3, 0, 0x2000u, 2, 0, 2, 2, 1),
+				};
+
+				assert_equal_pred(reference, context->statistics, eq());
+			}
+
+
+			test( DeltaEntriesReferringToUnknownNodesAreIgnored )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_statistics_delta, plural
+						+ make_pair(3u, make_call_graph_delta(plural
+							+ make_created_node(0, 0x1000u, 1, 10, 7, 10), vector< pair<unsigned int, function_statistics> >())));
+				});
+				emulator->message(init, format(make_initialization_data("/test", 1)));
+				emulator->add_handler(request_update, [&] (ipc::server_session::response &resp) {
+					resp(response_statistics_delta, plural
+						+ make_pair(3u, make_call_graph_delta(plural
+							+ make_created_node(1, 0x2000u, 1, 1, 1, 1)
+							+ make_created_node(5, 0x3000u, 1, 1, 1, 1)
+							+ make_created_node(0, 0x4000u, 1, 1, 1, 1), plural
+							+ make_pair(0u, function_statistics(1, 1, 1, 1))
+							+ make_pair(7u, function_statistics(1, 1, 1, 1))
+							+ make_pair(1u, function_statistics(2, 20, 5, 15)))));
+				});
+
+				// ACT
+				context->statistics.request_update();
+
+				// ASSERT
+				call_statistics reference[] = {
+					make_call_statistics(1, 3, 0, 0x1000u, 3, 0, 30, 12, 15),
+					make_call_statistics(2, 3, 1, 0x2000u, 1, 0, 1, 1, 1),
+				};
+
+				assert_equal_pred(reference, context->statistics, eq());
+			}
+
+
 			test( RequestingUpdateDoesNothingAfterTheFrontendIsDestroyed )
 			{
 				// INIT
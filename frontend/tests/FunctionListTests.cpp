@@ -231,6 +231,36 @@ namespace micro_profiler
 			}
 
 
+			test( HardwareCounterRatiosAreFormattedOnlyForFunctionsCounted )
+			{
+				// INIT
+				unsigned columns[] = {	main_columns::name, main_columns::instructions_per_cycle, main_columns::l1d_misses_pki, main_columns::llc_misses_pki,	};
+				auto counted = make_call_statistics(2, 1, 0, 0x2000u, 1, 0, 0, 0, 0);
+
+				counted.hw_counters[hw_cycles] = 4000;
+				counted.hw_counters[hw_instructions] = 5000;
+				counted.hw_counters[hw_l1d_misses] = 61;
+				counted.hw_counters[hw_llc_misses] = 3;
+				add_records(*statistics, plural
+					+ make_call_statistics(1, 1, 0, 0x1000u, 1, 0, 0, 0, 0)
+					+ counted);
+
+				auto fl = make_table<richtext_table_model>(statistics,
+					create_context(statistics, 1, resolver, threads, false), c_statistics_columns);
+
+				// ACT
+				auto text = get_text(*fl, columns);
+
+				// ASSERT
+				string reference[][4] = {
+					{	"00001000", "\xE2\x80\x93", "\xE2\x80\x93", "\xE2\x80\x93",	},
+					{	"00002000", "1.25", "12.20", "0.60",	},
+				};
+
+				assert_equivalent(mkvector(reference), text);
+			}
+
+
 			test( HierarchicalTableIsFormedFromHierarchicalData )
 			{
 				// INIT
@@ -324,6 +324,39 @@ namespace micro_profiler
 			}
 
 
+			test( CoverageIsReflectedInTheModel )
+			{
+				// INIT
+				unsigned columns[] = {	1, 6,	};
+				symbol_info data[] = {
+					{	"malloc", 0x00001234, 150,	},
+					{	"free", 0x00000001, 115,	},
+					{	"realloc", 0x00000031, 15,	},
+				};
+				auto p1 = make_patch(11, 0x00001234, 1, false, patch_state::dormant);
+				auto p2 = make_patch(11, 0x00000031, 2, false, patch_state::active);
+
+				add_metadata(*modules, *symbols, 11, data);
+				p1.covered = true;
+				add_records(*patches, plural + p1 + p2);
+				patches->invalidate();
+
+				auto model = image_patch_model::create(patches, modules, mappings, symbols, source_files);
+
+				// ACT
+				auto text = get_text(*model, columns);
+
+				// ASSERT
+				string reference[][2] = {
+					{	"malloc", "covered", 	},
+					{	"free", "", 	},
+					{	"realloc", "", 	},
+				};
+
+				assert_equivalent(mkvector(reference), text);
+			}
+
+
 			test( ModuleNameAndPathAreReflectedInModel )
 			{
 				// INIT
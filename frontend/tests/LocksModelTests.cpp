@@ -0,0 +1,121 @@
+#include <frontend/locks_model.h>
+
+#include "helpers.h"
+
+#include <frontend/keyer.h>
+#include <test-helpers/helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			contended_lock make_lock(long_address_t address, count_t contentions, timestamp_t time_blocked)
+			{
+				contended_lock l;
+
+				l.address = address, l.contentions = contentions, l.time_blocked = time_blocked;
+				return l;
+			}
+		}
+
+		begin_test_suite( LocksModelTests )
+			test( SummaryIsPresentForEmptyLocksTable )
+			{
+				// INIT
+				auto t = make_shared<tables::locks>();
+
+				// INIT / ACT
+				auto m_ = make_shared<locks_model>(t, 0.001);
+				wpl::list_model<string> &m = *m_;
+
+				// ASSERT
+				assert_equal(1u, m.get_count());
+				assert_equal("Contended Locks: 0", get_value(m, 0));
+			}
+
+
+			test( LockDataIsConvertedToTextOrderedByTimeBlocked )
+			{
+				// INIT
+				auto t = make_shared<tables::locks>();
+
+				add_records(*t, plural
+					+ make_lock(0x1000, 3, 1500)
+					+ make_lock(0x7F12A0, 1, 20000000)
+					+ make_lock(0x2000, 17, 1200), keyer::address());
+
+				// INIT / ACT
+				auto m1 = make_shared<locks_model>(t, 0.000001);
+
+				// ACT
+				auto values = get_values(*m1);
+
+				// ASSERT
+				assert_equal(plural
+					+ (string)"Contended Locks: 3"
+					+ (string)"0x0000007F12A0 - contentions: 1, blocked: 20s"
+					+ (string)"0x000000001000 - contentions: 3, blocked: 1.5ms"
+					+ (string)"0x000000002000 - contentions: 17, blocked: 1.2ms", values);
+
+				// INIT / ACT
+				auto m2 = make_shared<locks_model>(t, 0.00001);
+
+				// ACT
+				values = get_values(*m2);
+
+				// ASSERT
+				assert_equal(plural
+					+ (string)"Contended Locks: 3"
+					+ (string)"0x0000007F12A0 - contentions: 1, blocked: 200s"
+					+ (string)"0x000000001000 - contentions: 3, blocked: 15ms"
+					+ (string)"0x000000002000 - contentions: 17, blocked: 12ms", values);
+			}
+
+
+			test( LockDataIsConvertedToTextOnInvalidation )
+			{
+				// INIT
+				vector< vector<string> > log;
+				auto t = make_shared<tables::locks>();
+				auto m = make_shared<locks_model>(t, 0.001);
+				auto conn = m->invalidate += [&] (locks_model::index_type index) {
+					log.push_back(get_values(*m));
+					assert_equal(locks_model::npos(), index);
+				};
+
+				// ACT
+				add_records(*t, plural
+					+ make_lock(0x100, 2, 30)
+					+ make_lock(0x200, 5, 10), keyer::address());
+				t->invalidate();
+
+				// ASSERT
+				assert_equal(1u, log.size());
+				assert_equal(plural
+					+ (string)"Contended Locks: 2"
+					+ (string)"0x000000000100 - contentions: 2, blocked: 30ms"
+					+ (string)"0x000000000200 - contentions: 5, blocked: 10ms", log.back());
+
+				// ACT
+				add_records(*t, plural
+					+ make_lock(0x200, 7, 100)
+					+ make_lock(0x300, 1, 1), keyer::address());
+				t->invalidate();
+
+				// ASSERT
+				assert_equal(2u, log.size());
+				assert_equal(plural
+					+ (string)"Contended Locks: 3"
+					+ (string)"0x000000000200 - contentions: 7, blocked: 100ms"
+					+ (string)"0x000000000100 - contentions: 2, blocked: 30ms"
+					+ (string)"0x000000000300 - contentions: 1, blocked: 1ms", log.back());
+			}
+		end_test_suite
+	}
+}
@@ -43,7 +43,8 @@ namespace micro_profiler
 			lhs.rva < rhs.rva ? true : rhs.rva < lhs.rva ? false :
 			lhs.state < rhs.state ? true : rhs.state < lhs.state ? false :
 			lhs.in_transit < rhs.in_transit ? true : rhs.in_transit < lhs.in_transit ? false :
-				lhs.last_result < rhs.last_result;
+			lhs.last_result < rhs.last_result ? true : rhs.last_result < lhs.last_result ? false :
+				lhs.covered < rhs.covered;
 	}
 
 	inline bool operator <(const module::mapping_ex &lhs, const module::mapping_ex &rhs)
@@ -26,6 +26,14 @@ namespace micro_profiler
 				exclusive_avg = 6,
 				inclusive_avg = 7,
 				max_time = 8,
+				median_time = 9,
+				p99_time = 10,
+				instructions_per_cycle = 11,
+				l1d_misses_pki = 12,
+				llc_misses_pki = 13,
+				allocations_avg = 14,
+				allocated_bytes_avg = 15,
+				time_blocked = 16,
 			};
 		};
 
@@ -33,6 +33,7 @@ namespace micro_profiler
 					break;
 
 				case request_module_metadata:
+				case request_module_metadata_chunked:
 					requested_metadata.push_back(0), d(requested_metadata.back());
 					break;
 
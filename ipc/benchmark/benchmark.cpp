@@ -0,0 +1,132 @@
+#include <ipc/endpoint.h>
+
+#include <common/time.h>
+#include <cstdio>
+#include <memory>
+#include <mt/event.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		enum {	reply_none, reply_ack, reply_echo,	};
+
+		const size_t c_payload_sizes[] = {	64, 64 * 1024, 4 * 1024 * 1024,	};
+		const size_t c_roundtrip_volume = 256 * 1024 * 1024;
+		const size_t c_stream_volume = 512 * 1024 * 1024;
+		const size_t c_max_roundtrips = 100u;
+		const size_t c_max_messages = 200000u;
+
+		struct endpoint
+		{
+			const char *name, *server_id, *client_id;
+		};
+
+		// Server session replies according to the first byte of a message: echoes it, acknowledges or keeps silent.
+		class replying_session : public ipc::channel
+		{
+		public:
+			replying_session(ipc::channel &outbound)
+				: _outbound(outbound)
+			{	}
+
+			virtual void disconnect() throw()
+			{	}
+
+			virtual void message(const_byte_range payload)
+			{
+				const byte ack[] = {	reply_ack,	};
+
+				switch (*payload.begin())
+				{
+				case reply_echo:
+					_outbound.message(payload);
+					break;
+
+				case reply_ack:
+					_outbound.message(const_byte_range(ack, sizeof(ack)));
+					break;
+				}
+			}
+
+		private:
+			ipc::channel &_outbound;
+		};
+
+		struct replying_server : ipc::server
+		{
+			virtual ipc::channel_ptr_t create_session(ipc::channel &outbound)
+			{	return ipc::channel_ptr_t(new replying_session(outbound));	}
+		};
+
+		class waiting_channel : public ipc::channel
+		{
+		public:
+			void wait()
+			{	_replied.wait();	}
+
+		private:
+			virtual void disconnect() throw()
+			{	}
+
+			virtual void message(const_byte_range /*payload*/)
+			{	_replied.set();	}
+
+		private:
+			mt::event _replied;
+		};
+
+		void measure(const endpoint &e, size_t size)
+		{
+			const auto hserver = ipc::run_server(e.server_id, make_shared<replying_server>());
+			waiting_channel inbound;
+			const auto client = ipc::connect_client(e.client_id, inbound);
+			vector<byte> payload(size, 0x5A);
+			const auto roundtrips = static_cast<unsigned int>((min)(c_roundtrip_volume / size, c_max_roundtrips));
+			const auto messages = static_cast<unsigned int>((min)(c_stream_volume / size, c_max_messages));
+			stopwatch sw;
+
+			payload[0] = reply_echo;
+			sw();
+			for (auto n = roundtrips; n--; )
+				client->message(const_byte_range(payload.data(), size)), inbound.wait();
+
+			const auto latency = sw() / roundtrips;
+
+			payload[0] = reply_none;
+			for (auto n = messages - 1; n--; )
+				client->message(const_byte_range(payload.data(), size));
+			payload[0] = reply_ack;
+			client->message(const_byte_range(payload.data(), size));
+			inbound.wait();
+
+			const auto throughput = static_cast<double>(messages) * size / sw();
+
+			printf("%s, %uB messages: round trip %.1fus, throughput %.1fMB/s\n", e.name, static_cast<unsigned>(size),
+				1e6 * latency, throughput / (1024 * 1024));
+		}
+	}
+}
+
+int main()
+{
+	using namespace micro_profiler;
+
+	const endpoint c_endpoints[] = {
+		{	"sockets", "sockets|6150", "sockets|127.0.0.1:6150"	},
+#ifdef __linux__
+		{	"shm", "shm|micro-profiler.benchmark", "shm|micro-profiler.benchmark"	},
+#endif
+	};
+
+	for (auto s = begin(c_payload_sizes); s != end(c_payload_sizes); ++s)
+	{
+		for (auto e = begin(c_endpoints); e != end(c_endpoints); ++e)
+			measure(*e, *s);
+	}
+	return 0;
+}
@@ -72,7 +72,7 @@ namespace micro_profiler
 			void request_internal(int id, const RequestT &payload, const CallbackConstructorT &callback_ctor);
 
 		private:
-			pod_vector<byte> _buffer;
+			chunked_buffer _buffer;
 			token_t _token;
 			std::shared_ptr<callbacks_t> _callbacks;
 			std::shared_ptr<message_callbacks_t> _message_callbacks;
@@ -137,8 +137,7 @@ namespace micro_profiler
 		inline void client_session::request_internal(int id, const RequestT &payload,
 			const CallbackConstructorT &callback_ctor)
 		{
-			_buffer.clear();
-			buffer_writer< pod_vector<byte> > w(_buffer);
+			buffer_writer<chunked_buffer> w(_buffer);
 			ipc::serializer s(w);
 			auto token = _token++;
 
@@ -146,7 +145,10 @@ namespace micro_profiler
 			s(token);
 			s(payload);
 			callback_ctor(token);
-			_outbound->message(const_byte_range(_buffer.data(), _buffer.size()));
+
+			const auto &parts = _buffer.ranges();
+
+			_outbound->message_gather(parts.data(), parts.size());
 		}
 	}
 }
@@ -24,6 +24,7 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace micro_profiler
 {
@@ -54,6 +55,10 @@ namespace micro_profiler
 		{
 			virtual void disconnect() throw() = 0;
 			virtual void message(const_byte_range payload) = 0;
+
+			// Sends a single message made of consecutive parts. The default implementation joins the parts, while the
+			// transports capable of a gather write override it.
+			virtual void message_gather(const const_byte_range *parts, size_t count);
 		};
 
 		struct server
@@ -67,6 +72,19 @@ namespace micro_profiler
 		std::shared_ptr<void> run_server(const std::string &typed_endpoint_id, const std::shared_ptr<server> &factory);
 
 
+		inline void channel::message_gather(const const_byte_range *parts, size_t count)
+		{
+			if (count == 1)
+				return message(*parts);
+
+			std::vector<byte> joined;
+
+			for (auto i = parts; i != parts + count; ++i)
+				joined.insert(joined.end(), i->begin(), i->end());
+			message(const_byte_range(joined.data(), joined.size()));
+		}
+
+
 		inline initialization_failed::initialization_failed(const char *message)
 			: std::runtime_error(message)
 		{	}
@@ -20,7 +20,7 @@
 
 #pragma once
 
-#include <common/pod_vector.h>
+#include <common/chunked_buffer.h>
 #include <common/stream.h>
 #include <strmd/deserializer.h>
 #include <strmd/packer.h>
@@ -30,7 +30,7 @@ namespace micro_profiler
 {
 	namespace ipc
 	{
-		typedef strmd::serializer<buffer_writer< pod_vector<byte> >, strmd::varint> serializer;
+		typedef strmd::serializer<buffer_writer<chunked_buffer>, strmd::varint> serializer;
 		typedef strmd::deserializer<buffer_reader, strmd::varint> deserializer;
 	}
 }
@@ -64,7 +64,7 @@ namespace micro_profiler
 
 		private:
 			channel &_outbound;
-			pod_vector<byte> _outbound_buffer;
+			chunked_buffer _outbound_buffer;
 			std::function<void ()> _disconnect_handler;
 			std::unordered_map<int /*request_id*/, handler_t> _handlers;
 			std::unique_ptr<tasker::private_queue> _apartment_queue;
@@ -135,13 +135,16 @@ namespace micro_profiler
 		inline void server_session::message(int message_id, const FormatterT &message_formatter)
 		{
 			{
-				buffer_writer< pod_vector<byte> > bw(_outbound_buffer);
+				buffer_writer<chunked_buffer> bw(_outbound_buffer);
 				serializer ser(bw);
 
 				ser(message_id);
 				message_formatter(ser);
 			}
-			_outbound.message(const_byte_range(_outbound_buffer.data(), _outbound_buffer.size()));
+
+			const auto &parts = _outbound_buffer.ranges();
+
+			_outbound.message_gather(parts.data(), parts.size());
 		}
 
 
@@ -19,6 +19,7 @@
 //	THE SOFTWARE.
 
 #include <ipc/endpoint_com.h>
+#include <ipc/endpoint_shm.h>
 #include <ipc/endpoint_sockets.h>
 
 #include "helpers.h"
@@ -41,6 +42,9 @@ namespace micro_profiler
 				{ "com", &com::connect_client },
 #endif
 				{ "sockets", &sockets::connect_client },
+#ifdef __linux__
+				{ "shm", &shm::connect_client },
+#endif
 			};
 
 			string endpoint_id;
@@ -0,0 +1,101 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <ipc/endpoint_shm.h>
+
+#include "shm_connection.h"
+
+#include <functional>
+#include <logger/log.h>
+#include <mt/thread.h>
+
+#define PREAMBLE "IPC shm client: "
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace ipc
+	{
+		namespace shm
+		{
+			class client_session : public channel
+			{
+			public:
+				client_session(sockets::socket_handle &control, channel &inbound);
+				~client_session();
+
+				virtual void disconnect() throw();
+				virtual void message(const_byte_range payload);
+				virtual void message_gather(const const_byte_range *parts, size_t count);
+
+			private:
+				void worker(channel *inbound);
+
+			private:
+				connection _connection;
+				unique_ptr<mt::thread> _thread;
+			};
+
+
+
+			client_session::client_session(sockets::socket_handle &control, channel &inbound)
+				: _connection(control, false)
+			{	_thread.reset(new mt::thread(bind(&client_session::worker, this, &inbound)));	}
+
+			client_session::~client_session()
+			{
+				_connection.close();
+				_thread->join();
+			}
+
+			void client_session::disconnect() throw()
+			{	}
+
+			void client_session::message(const_byte_range payload)
+			{	_connection.write(payload);	}
+
+			void client_session::message_gather(const const_byte_range *parts, size_t count)
+			{	_connection.write(parts, count);	}
+
+			void client_session::worker(channel *inbound)
+			{
+				LOG(PREAMBLE "processing thread started...") % A(inbound);
+				while (_connection.read(*inbound))
+				{	}
+				LOG(PREAMBLE "disconnecting from the server...") % A(inbound);
+				inbound->disconnect();
+				LOG(PREAMBLE "processing thread ended.");
+			}
+
+
+			channel_ptr_t connect_client(const char *destination_endpoint_id, channel &inbound)
+			{
+				socklen_t length;
+				const auto addr = make_sockaddr_un(destination_endpoint_id, length);
+				sockets::socket_handle control(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+
+				if (::connect(control, reinterpret_cast<const sockaddr *>(&addr), length))
+					throw connection_refused(destination_endpoint_id);
+				return channel_ptr_t(new client_session(control, inbound));
+			}
+		}
+	}
+}
@@ -47,6 +47,7 @@ namespace micro_profiler
 
 				virtual void disconnect() throw();
 				virtual void message(const_byte_range payload);
+				virtual void message_gather(const const_byte_range *parts, size_t count);
 
 			private:
 				void worker(channel *inbound);
@@ -55,6 +56,7 @@ namespace micro_profiler
 			private:
 				sockets_initializer _initializer;
 				socket_handle _socket;
+				vector<const_byte_range> _parts;
 				unique_ptr<mt::thread> _thread;
 			};
 
@@ -75,14 +77,21 @@ namespace micro_profiler
 			{	}
 
 			void client_session::message(const_byte_range payload)
+			{	message_gather(&payload, 1);	}
+
+			void client_session::message_gather(const const_byte_range *parts, size_t count)
 			{
-				unsigned int size_ = static_cast<unsigned int>(payload.length());
 				sockets::byte_representation<unsigned int> size;
+				size_t total = 0;
 
-				size.value = size_;
+				for (auto i = parts; i != parts + count; ++i)
+					total += i->length();
+				size.value = static_cast<unsigned int>(total);
 				size.reorder();
-				::send(_socket, size.bytes, sizeof(size.bytes), MSG_NOSIGNAL);
-				::send(_socket, reinterpret_cast<const char *>(payload.begin()), size_, MSG_NOSIGNAL);
+				_parts.assign(1, const_byte_range(reinterpret_cast<const byte *>(size.bytes), sizeof(size.bytes)));
+				_parts.insert(_parts.end(), parts, parts + count);
+				while (!_parts.empty() && send_parts(_socket, _parts))
+				{	}
 			}
 
 			void client_session::worker(channel *inbound)
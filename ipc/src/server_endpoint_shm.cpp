@@ -0,0 +1,188 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <ipc/endpoint_shm.h>
+
+#include "shm_connection.h"
+
+#include <errno.h>
+#include <functional>
+#include <list>
+#include <logger/log.h>
+#include <mt/thread.h>
+#include <sys/eventfd.h>
+
+#define PREAMBLE "IPC shm server: "
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace ipc
+	{
+		namespace shm
+		{
+			class server_session : public /*outbound*/ channel, noncopyable
+			{
+			public:
+				server_session(sockets::socket_handle &control);
+				~server_session() throw();
+
+				virtual void disconnect() throw();
+				virtual void message(const_byte_range payload);
+				virtual void message_gather(const const_byte_range *parts, size_t count);
+
+			public:
+				connection conn;
+				channel_ptr_t inbound;
+			};
+
+			class server : noncopyable
+			{
+			public:
+				server(const char *endpoint_id, const shared_ptr<ipc::server> &factory);
+				~server();
+
+			private:
+				enum {	max_backlog = 5,	};
+
+			private:
+				void worker();
+				void accept();
+
+			private:
+				const shared_ptr<ipc::server> _factory;
+				sockets::socket_handle _socket, _wake;
+				list< unique_ptr<server_session> > _sessions;
+				unique_ptr<mt::thread> _thread;
+			};
+
+
+
+			server_session::server_session(sockets::socket_handle &control)
+				: conn(control, true)
+			{	}
+
+			server_session::~server_session() throw()
+			{	inbound.reset();	}
+
+			void server_session::disconnect() throw()
+			{	conn.close();	}
+
+			void server_session::message(const_byte_range payload)
+			{	conn.write(payload);	}
+
+			void server_session::message_gather(const const_byte_range *parts, size_t count)
+			{	conn.write(parts, count);	}
+
+
+			server::server(const char *endpoint_id, const shared_ptr<ipc::server> &factory)
+				: _factory(factory), _socket(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)),
+					_wake(::eventfd(0, EFD_CLOEXEC))
+			{
+				socklen_t length;
+				const auto addr = make_sockaddr_un(endpoint_id, length);
+
+				if (::bind(_socket, reinterpret_cast<const sockaddr *>(&addr), length))
+					throw initialization_failed("bind() failed");
+				if (::listen(_socket, max_backlog))
+					throw initialization_failed("listen() failed");
+				_thread.reset(new mt::thread(bind(&server::worker, this)));
+			}
+
+			server::~server()
+			{
+				::eventfd_write(_wake, 1);
+				_thread->join();
+			}
+
+			void server::worker()
+			try
+			{
+				vector<pollfd> fds;
+
+				LOG(PREAMBLE "processing thread started.");
+				for (;;)
+				{
+					auto timeout = -1;
+
+					fds.resize(2 + 2 * _sessions.size());
+					fds[0].fd = _socket, fds[0].events = POLLIN, fds[0].revents = 0;
+					fds[1].fd = _wake, fds[1].events = POLLIN, fds[1].revents = 0;
+
+					auto f = fds.data() + 2;
+
+					for (auto i = _sessions.begin(); i != _sessions.end(); ++i, f += 2)
+					{
+						if (!(*i)->conn.prepare_wait(f))
+							timeout = 0; // Some messages are ready already - don't block.
+					}
+					if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout) < 0 && errno != EINTR)
+						break;
+					if (fds[1].revents)
+						break;
+					f = fds.data() + 2;
+					for (auto i = _sessions.begin(); i != _sessions.end(); f += 2)
+					{
+						auto &s = **i;
+
+						if (s.conn.read_available(*s.inbound, f))
+						{
+							++i;
+							continue;
+						}
+						if (!s.conn.closed())
+							s.inbound->disconnect();
+						i = _sessions.erase(i);
+					}
+					if (fds[0].revents & POLLIN)
+						accept();
+				}
+				LOG(PREAMBLE "processing thread ended...") % A(_sessions.size());
+			}
+			catch (exception &e)
+			{
+				LOGE(PREAMBLE "processing failed.") % A(e.what());
+			}
+			catch (...)
+			{
+				LOGE(PREAMBLE "processing failed (unknown reason).");
+			}
+
+			void server::accept()
+			try
+			{
+				sockets::socket_handle control(::accept4(_socket, NULL, NULL, SOCK_CLOEXEC));
+				unique_ptr<server_session> s(new server_session(control));
+
+				s->inbound = _factory->create_session(*s);
+				_sessions.push_back(move(s));
+			}
+			catch (exception &e)
+			{
+				LOGE(PREAMBLE "connection rejected.") % A(e.what());
+			}
+
+
+			shared_ptr<void> run_server(const char *endpoint_id, const shared_ptr<ipc::server> &factory)
+			{	return shared_ptr<void>(new server(endpoint_id, factory));	}
+		}
+	}
+}
@@ -20,14 +20,13 @@
 
 #include "server_endpoint_sockets.h"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <common/noncopyable.h>
-#include <fcntl.h>
 #include <logger/log.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
 #include <stdexcept>
-#include <sys/ioctl.h>
 #include <sys/types.h>
 
 #pragma warning(disable: 4127)
@@ -46,6 +45,11 @@ namespace micro_profiler
 		{
 			namespace
 			{
+				enum {
+					receive_chunk = 64 * 1024,
+					pending_output = 0x80000000u, // A flag in the aux command, requesting to watch for writability.
+				};
+
 				void setup_socket(const socket_handle &s)
 				{
 					linger l = {};
@@ -53,6 +57,7 @@ namespace micro_profiler
 					l.l_onoff = 1;
 					if (::setsockopt(s, SOL_SOCKET, SO_LINGER, (const char*)&l, sizeof(l)) < 0)
 						throw initialization_failed("setsockopt(..., SO_LINGER, ...) failed");
+					set_nonblocking(s);
 				}
 
 				template <typename SocketT, typename T>
@@ -66,18 +71,18 @@ namespace micro_profiler
 				}
 
 				template <typename T>
-				int recv_scalar(const socket_handle &s, T &value, int options)
+				bool read_scalar(vector<byte> &buffer, size_t &offset, T &value)
 				{
 					byte_representation<T> data;
-					int result = ::recv(s, data.bytes, sizeof(data.bytes), options);
 
+					if (buffer.size() - offset < sizeof(data.bytes))
+						return false;
+					copy_n(buffer.data() + offset, sizeof(data.bytes), data.bytes);
 					data.reorder();
 					value = data.value;
-					return result;
+					offset += sizeof(data.bytes);
+					return true;
 				}
-
-				socket_handler::status dummy(socket_handler &, const socket_handle &)
-				{	return socket_handler::proceed;	}
 			}
 
 			socket_handler::socket_handler(unsigned id_, socket_handle &s, const socket_handle &aux_socket,
@@ -91,57 +96,61 @@ namespace micro_profiler
 				_socket.reset(); // ... then - the socket
 			}
 
-			template <typename ContainerT>
-			void socket_handler::run(ContainerT &handlers)
-			try
-			{
-				LOG(PREAMBLE "processing thread started.");
-				for (;;)
-				{
-					fd_set fds;
+			const socket_handle &socket_handler::socket() const throw()
+			{	return _socket;	}
 
-					FD_ZERO(&fds);
-					for (auto i = handlers.begin(); i != handlers.end(); ++i)
-						FD_SET((*i)->_socket, &fds);
-					if (::select(FD_SETSIZE, &fds, NULL, NULL, NULL) < 0)
-						return;
-					for (auto i = handlers.begin(); i != handlers.end(); )
-					{
-						switch(FD_ISSET((*i)->_socket, &fds) ? (*i)->handler(**i, (*i)->_socket) : proceed)
-						{
-						case proceed:
-							++i;
-							break;
-
-						case remove_this:
-							i = handlers.erase(i);
-							break;
+			bool socket_handler::receive()
+			{
+				byte chunk[receive_chunk];
 
-						case exit:
-							LOG(PREAMBLE "processing thread ended...") % A(handlers.size());
-							return;
-						}
-					}
+				for (int received; received = ::recv(_socket, reinterpret_cast<char *>(chunk), sizeof(chunk), 0), received; )
+				{
+					if (received < 0)
+						return would_block();
+					buffer.insert(buffer.end(), chunk, chunk + received);
 				}
+				return false;
 			}
-			catch (exception &e)
-			{
-				LOGE(PREAMBLE "processing failed.") % A(e.what());
-			}
-			catch (...)
+
+			bool socket_handler::flush()
 			{
-				LOGE(PREAMBLE "processing failed (unknown reason).");
+				mt::lock_guard<mt::mutex> l(_mutex);
+
+				if (_pending.empty())
+					return true;
+				_parts.assign(1, const_byte_range(_pending.data(), _pending.size()));
+				if (!send_parts(_socket, _parts))
+					_parts.clear(); // The peer is gone - the output is dropped, the disconnection is handled on reading.
+				_pending.erase(_pending.begin(), _pending.end() - (_parts.empty() ? 0 : _parts[0].length()));
+				return _pending.empty();
 			}
 
 			void socket_handler::disconnect() throw()
 			{	send_scalar(_aux_socket, id);	}
 
 			void socket_handler::message(const_byte_range payload)
-			{
-				unsigned int size = static_cast<unsigned int>(payload.length());
+			{	message_gather(&payload, 1);	}
 
-				send_scalar(_socket, size);
-				::send(_socket, reinterpret_cast<const char *>(payload.begin()), size, MSG_NOSIGNAL);
+			void socket_handler::message_gather(const const_byte_range *parts, size_t count)
+			{
+				byte_representation<unsigned int> size;
+				size_t total = 0;
+				mt::lock_guard<mt::mutex> l(_mutex);
+
+				for (auto i = parts; i != parts + count; ++i)
+					total += i->length();
+				size.value = static_cast<unsigned int>(total);
+				size.reorder();
+				_parts.assign(1, const_byte_range(reinterpret_cast<const byte *>(size.bytes), sizeof(size.bytes)));
+				_parts.insert(_parts.end(), parts, parts + count);
+				if (_pending.empty())
+				{
+					if (!send_parts(_socket, _parts) || _parts.empty())
+						return;
+					send_scalar(_aux_socket, id | pending_output);
+				}
+				for (auto i = _parts.begin(); i != _parts.end(); ++i)
+					_pending.insert(_pending.end(), i->begin(), i->end());
 			}
 
 
@@ -159,9 +168,8 @@ namespace micro_profiler
 					throw initialization_failed("listen() failed");
 
 				_aux_socket.reset(connect_aux(hp.port));
-				_handlers.push_back(socket_handler::ptr_t(new socket_handler(_next_id++, server_socket,
-					_aux_socket, bind(&server::accept_preinit, this, _2))));
-				_server_thread.reset(new mt::thread(bind(&socket_handler::run<handlers_t>, ref(_handlers))));
+				_acceptor = &add_handler(server_socket, bind(&server::accept_preinit, this, _1));
+				_server_thread.reset(new mt::thread(bind(&server::worker, this)));
 			}
 
 			server::~server()
@@ -170,94 +178,193 @@ namespace micro_profiler
 				_server_thread->join();
 			}
 
-			socket_handler::status server::handle_preinit(socket_handler &h, const socket_handle &s)
+			void server::worker()
+			try
+			{
+				vector<poller::event> events;
+
+				LOG(PREAMBLE "processing thread started.");
+				while (_poller.wait(events))
+				{
+					for (auto e = events.begin(); e != events.end(); ++e)
+					{
+						const auto i = _handlers.find(e->id);
+
+						if (i == _handlers.end())
+							continue; // The handler has been removed while processing the previous events.
+
+						const auto h = i->second;
+
+						if ((e->events & poller::writable) && h->flush())
+							_poller.modify(h->socket(), h->id, false);
+						if (e->events & poller::readable)
+						{
+							switch (h->handler(*h))
+							{
+							case socket_handler::proceed:
+								break;
+
+							case socket_handler::remove_this:
+								remove_handler(_handlers.find(h->id));
+								break;
+
+							case socket_handler::exit:
+								LOG(PREAMBLE "processing thread ended...") % A(_handlers.size());
+								return;
+							}
+						}
+					}
+				}
+			}
+			catch (exception &e)
+			{
+				LOGE(PREAMBLE "processing failed.") % A(e.what());
+			}
+			catch (...)
+			{
+				LOGE(PREAMBLE "processing failed (unknown reason).");
+			}
+
+			socket_handler &server::add_handler(socket_handle &s, const socket_handler::handler_t &handler)
+			{
+				const auto id = _next_id++;
+				const socket_handler::ptr_t h(new socket_handler(id, s, _aux_socket, handler));
+
+				_handlers.insert(make_pair(id, h));
+				_poller.add(h->socket(), id);
+				return *h;
+			}
+
+			void server::remove_handler(handlers_t::iterator i)
+			{
+				if (i == _handlers.end())
+					return;
+				_poller.remove(i->second->socket());
+				_handlers.erase(i);
+			}
+
+			socket_handler::status server::handle_preinit(socket_handler &h)
 			{
 				unsigned int magic;
+				size_t offset = 0;
 
-				if (sizeof(magic) == recv_scalar(s, magic, MSG_PEEK) && magic == init_magic)
+				if (!h.receive())
+					return socket_handler::remove_this; // The client is gone before a session has been created.
+				if (read_scalar(h.buffer, offset, magic) && magic == init_magic)
 				{
-					recv_scalar(s, magic, MSG_WAITALL);
+					h.buffer.erase(h.buffer.begin(), h.buffer.begin() + offset);
 					for (auto i = _handlers.begin(); i != _handlers.end(); ++i)
 					{
-						socket_handler::handler_t &handler = (*i)->handler;
+						socket_handler &other = *i->second;
+						socket_handler::handler_t &handler = other.handler;
 
-						if (i == _handlers.begin()) // acceptor, guaranteed to be the first
-							handler = bind(&server::accept_regular, this, _2);
-						else if (i->get() == &h) // aux handler
-							handler = bind(&server::handle_aux, this, _2);
+						if (&other == _acceptor)
+						{
+							handler = bind(&server::accept_regular, this, _1);
+						}
+						else if (&other == &h) // aux handler
+						{
+							handler = bind(&server::handle_aux, this, _1);
+						}
 						else // regular session handler
-							handler = bind(&server::handle_session, this, _2, _factory->create_session(**i));
+						{
+							const auto inbound = _factory->create_session(other);
+
+							handler = bind(&server::handle_session, this, _1, inbound);
+							dispatch(other, *inbound); // Readiness was reported already - process the data received.
+						}
 					}
+					return h.handler(h);
 				}
 				return socket_handler::proceed;
 			}
 
-			socket_handler::status server::accept_preinit(const socket_handle &s)
+			socket_handler::status server::accept_preinit(socket_handler &h)
 			{
-				socket_handle new_connection(::accept(s, NULL, NULL));
+				for (int s; s = static_cast<int>(::accept(h.socket(), NULL, NULL)), s != -1; )
+				{
+					socket_handle new_connection(s);
 
-				setup_socket(new_connection);
-				_handlers.push_back(socket_handler::ptr_t(new socket_handler(_next_id++, new_connection,
-					_aux_socket, bind(&server::handle_preinit, this, _1, _2))));
+					setup_socket(new_connection);
+					add_handler(new_connection, bind(&server::handle_preinit, this, _1));
+				}
 				return socket_handler::proceed;
 			}
 
-			socket_handler::status server::accept_regular(const socket_handle &s)
+			socket_handler::status server::accept_regular(socket_handler &h)
 			{
-				socket_handle new_connection(::accept(s, NULL, NULL));
+				for (int s; s = static_cast<int>(::accept(h.socket(), NULL, NULL)), s != -1; )
+				{
+					socket_handle new_connection(s);
 
-				setup_socket(new_connection);
+					setup_socket(new_connection);
 
-				socket_handler::ptr_t h(new socket_handler(_next_id++, new_connection, _aux_socket, &dummy));
+					auto &session_handler = add_handler(new_connection, socket_handler::handler_t());
 
-				h->handler = bind(&server::handle_session, this, _2, _factory->create_session(*h));
-				_handlers.push_back(h);
+					session_handler.handler = bind(&server::handle_session, this, _1,
+						_factory->create_session(session_handler));
+				}
 				return socket_handler::proceed;
 			}
 
-			socket_handler::status server::handle_session(const socket_handle &s, const channel_ptr_t &inbound)
+			socket_handler::status server::handle_session(socket_handler &h, const channel_ptr_t &inbound)
 			{
-				unsigned int size;
+				const auto connected = h.receive();
 
-				if (recv_scalar(s, size, MSG_WAITALL) > 0)
-				{
-					_buffer.resize(size);
-					::recv(s, reinterpret_cast<char *>(&_buffer[0]), size, MSG_WAITALL);
-					inbound->message(const_byte_range(&_buffer[0], _buffer.size()));
+				dispatch(h, *inbound);
+				if (connected)
 					return socket_handler::proceed;
-				}
-				else
+				inbound->disconnect();
+				return socket_handler::remove_this;
+			}
+
+			socket_handler::status server::handle_aux(socket_handler &h)
+			{
+				size_t offset = 0;
+				const auto connected = h.receive();
+
+				for (unsigned int command; read_scalar(h.buffer, offset, command); )
 				{
-					inbound->disconnect();
+					if (!command)
+						return socket_handler::exit;
+
+					const auto i = _handlers.find(command & ~pending_output);
+
+					if (!(command & pending_output))
+						remove_handler(i);
+					else if (i != _handlers.end())
+						_poller.modify(i->second->socket(), i->first, true);
 				}
-				return socket_handler::remove_this;
+				h.buffer.erase(h.buffer.begin(), h.buffer.begin() + offset);
+				return connected ? socket_handler::proceed : socket_handler::exit;
 			}
 
-			socket_handler::status server::handle_aux(const socket_handle &s)
+			void server::dispatch(socket_handler &h, channel &inbound)
 			{
-				unsigned id;
+				auto &b = h.buffer;
+				size_t offset = 0;
 
-				if (recv_scalar(s, id, MSG_WAITALL) > 0)
-					for (auto i = _handlers.begin(); i != _handlers.end(); ++i)
-						if ((*i)->id == id)
-						{
-							_handlers.erase(i);
-							return socket_handler::proceed;
-						}
-				return socket_handler::exit;
+				for (unsigned int size; ; )
+				{
+					auto next = offset;
+
+					if (!read_scalar(b, next, size) || b.size() - next < size)
+						break;
+					inbound.message(const_byte_range(b.data() + next, size));
+					offset = next + size;
+				}
+				b.erase(b.begin(), b.begin() + offset);
 			}
 
 			int server::connect_aux(unsigned short port)
 			{
 				sockaddr_in service = make_sockaddr_in(c_localhost, port);
 				int s = static_cast<int>(::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
-				u_long arg = 1 /* nonblocking */;
 
 				if (-1 == s)
 					throw initialization_failed("aux socket creation failed");
 				if (::connect(s, (sockaddr *)&service, sizeof(service)))
 					throw (::close(s), initialization_failed("aux socket connection failed"));
-				::ioctl(s, O_NONBLOCK, &arg);
 				send_scalar(s, init_magic);
 				return s;
 			}
@@ -21,11 +21,13 @@
 #pragma once
 
 #include "socket_helpers.h"
+#include "socket_poller.h"
 
 #include <ipc/endpoint_sockets.h>
 
+#include <mt/mutex.h>
 #include <mt/thread.h>
-#include <list>
+#include <unordered_map>
 #include <vector>
 
 namespace micro_profiler
@@ -38,7 +40,7 @@ namespace micro_profiler
 			{
 			public:
 				enum status { proceed, remove_this, exit, };
-				typedef std::function<status (socket_handler &self, const socket_handle &s)> handler_t;
+				typedef std::function<status (socket_handler &self)> handler_t;
 				typedef std::shared_ptr<socket_handler> ptr_t;
 
 			public:
@@ -46,19 +48,29 @@ namespace micro_profiler
 					const handler_t &initial_handler);
 				~socket_handler() throw();
 
-				template <typename ContainerT>
-				static void run(ContainerT &handlers);
+				const socket_handle &socket() const throw();
+
+				// Appends everything available in the socket to the buffer. Returns false if the peer has disconnected.
+				bool receive();
+
+				// Sends the output pending. Returns true if nothing is left.
+				bool flush();
 
 				virtual void disconnect() throw();
 				virtual void message(const_byte_range payload);
+				virtual void message_gather(const const_byte_range *parts, size_t count);
 
 			public:
 				const unsigned id;
 				handler_t handler;
+				std::vector<byte> buffer;
 
 			private:
 				socket_handle _socket;
 				const socket_handle &_aux_socket;
+				mt::mutex _mutex;
+				std::vector<const_byte_range> _parts;
+				std::vector<byte> _pending;
 			};
 
 			class server
@@ -69,19 +81,22 @@ namespace micro_profiler
 
 			private:
 				enum {
-					max_backlog = 5,
+					max_backlog = SOMAXCONN,
 					init_magic = 0xFFFFFFFE,
 				};
 
-				typedef std::list<socket_handler::ptr_t> handlers_t;
+				typedef std::unordered_map<unsigned, socket_handler::ptr_t> handlers_t;
 
 			private:
 				void worker();
-				socket_handler::status handle_preinit(socket_handler &h, const socket_handle &s);
-				socket_handler::status accept_preinit(const socket_handle &s);
-				socket_handler::status accept_regular(const socket_handle &s);
-				socket_handler::status handle_session(const socket_handle &s, const channel_ptr_t &inbound);
-				socket_handler::status handle_aux(const socket_handle &s);
+				socket_handler &add_handler(socket_handle &s, const socket_handler::handler_t &handler);
+				void remove_handler(handlers_t::iterator i);
+				socket_handler::status handle_preinit(socket_handler &h);
+				socket_handler::status accept_preinit(socket_handler &h);
+				socket_handler::status accept_regular(socket_handler &h);
+				socket_handler::status handle_session(socket_handler &h, const channel_ptr_t &inbound);
+				socket_handler::status handle_aux(socket_handler &h);
+				static void dispatch(socket_handler &h, channel &inbound);
 
 				static int connect_aux(unsigned short port);
 
@@ -90,9 +105,10 @@ namespace micro_profiler
 				std::shared_ptr<ipc::server> _factory;
 				socket_handle _aux_socket;
 				unsigned _next_id;
+				const socket_handler *_acceptor;
 				handlers_t _handlers;
+				poller _poller;
 				std::unique_ptr<mt::thread> _server_thread;
-				std::vector<byte> _buffer;
 			};
 		}
 	}
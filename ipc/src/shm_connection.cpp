@@ -0,0 +1,384 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include "shm_connection.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <ipc/endpoint.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace ipc
+	{
+		namespace shm
+		{
+			namespace
+			{
+				const size_t c_block_size = sizeof(ring_header) + connection::ring_size;
+				const size_t c_handles_count = 5; // memory + 2 x (data_ready + space_ready)
+
+				void notify(int event)
+				{
+					const eventfd_t value = 1;
+
+					while (::write(event, &value, sizeof(value)) < 0 && errno == EINTR)
+					{	}
+				}
+
+				void reset(int event)
+				{
+					eventfd_t value;
+
+					while (::read(event, &value, sizeof(value)) < 0 && errno == EINTR)
+					{	}
+				}
+
+				void send_handles(int s, const int (&handles)[c_handles_count])
+				{
+					char dummy = 0;
+					iovec iov = {	&dummy, sizeof(dummy)	};
+					char control[CMSG_SPACE(sizeof(handles))] = {};
+					msghdr msg = {};
+
+					msg.msg_iov = &iov, msg.msg_iovlen = 1;
+					msg.msg_control = control, msg.msg_controllen = sizeof(control);
+
+					const auto cmsg = CMSG_FIRSTHDR(&msg);
+
+					cmsg->cmsg_level = SOL_SOCKET, cmsg->cmsg_type = SCM_RIGHTS;
+					cmsg->cmsg_len = CMSG_LEN(sizeof(handles));
+					memcpy(CMSG_DATA(cmsg), handles, sizeof(handles));
+					if (::sendmsg(s, &msg, MSG_NOSIGNAL) != sizeof(dummy))
+						throw initialization_failed("shared memory handles cannot be sent");
+				}
+
+				void receive_handles(int s, int (&handles)[c_handles_count])
+				{
+					char dummy;
+					iovec iov = {	&dummy, sizeof(dummy)	};
+					char control[CMSG_SPACE(sizeof(handles))] = {};
+					msghdr msg = {};
+
+					msg.msg_iov = &iov, msg.msg_iovlen = 1;
+					msg.msg_control = control, msg.msg_controllen = sizeof(control);
+					if (::recvmsg(s, &msg, MSG_CMSG_CLOEXEC) != sizeof(dummy))
+						throw initialization_failed("shared memory handles were not received");
+
+					const auto cmsg = CMSG_FIRSTHDR(&msg);
+
+					if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+						throw initialization_failed("shared memory handles were not received");
+					if (cmsg->cmsg_len != CMSG_LEN(sizeof(handles)))
+					{
+						const auto n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+
+						for (auto i = 0u; i != n; ++i)
+							::close(reinterpret_cast<const int *>(CMSG_DATA(cmsg))[i]);
+						throw initialization_failed("unexpected shared memory handles received");
+					}
+					memcpy(handles, CMSG_DATA(cmsg), sizeof(handles));
+				}
+			}
+
+			connection::connection(sockets::socket_handle &control, bool accepting)
+				: _control(control), _memory(-1), _mapping(MAP_FAILED), _read(0), _written(0), _closed(false)
+			{
+				fill_n(_events, static_cast<size_t>(events_count), -1);
+				try
+				{
+					accepting ? receive() : create();
+					map(accepting);
+				}
+				catch (...)
+				{
+					release();
+					throw;
+				}
+			}
+
+			connection::~connection()
+			{	release();	}
+
+			bool connection::write(const_byte_range payload)
+			{	return write(&payload, 1);	}
+
+			bool connection::write(const const_byte_range *parts, size_t count)
+			{
+				uint32_t size = 0;
+				auto result = true;
+
+				for (auto i = parts; i != parts + count; ++i)
+					size += static_cast<uint32_t>(i->length());
+				result = write_bytes(reinterpret_cast<const byte *>(&size), sizeof(size));
+				for (auto i = parts; result && i != parts + count; ++i)
+					result = write_bytes(i->begin(), static_cast<uint32_t>(i->length()));
+				publish();
+				return result;
+			}
+
+			bool connection::read(channel &inbound)
+			{
+				uint32_t size;
+
+				if (!read_bytes(reinterpret_cast<byte *>(&size), sizeof(size)))
+					return false;
+
+				const auto offset = _read & ring_mask;
+
+				if (size <= ring_size - offset)
+				{
+					if (size && !wait_readable(size))
+						return false;
+					inbound.message(const_byte_range(_inbound.data + offset, size));
+					consume(size);
+				}
+				else
+				{
+					_buffer.resize(size);
+					if (!read_bytes(_buffer.data(), size))
+						return false;
+					inbound.message(const_byte_range(_buffer.data(), size));
+				}
+				return true;
+			}
+
+			bool connection::prepare_wait(pollfd *fds)
+			{
+				fds[0].fd = _inbound.data_ready, fds[0].events = POLLIN, fds[0].revents = 0;
+				fds[1].fd = _control, fds[1].events = POLLIN, fds[1].revents = 0;
+				_inbound.header->reader_waiting.store(1);
+				return !pending();
+			}
+
+			bool connection::read_available(channel &inbound, const pollfd *fds)
+			{
+				_inbound.header->reader_waiting.store(0);
+				if (fds[0].revents & POLLIN)
+					reset(_inbound.data_ready);
+				while (!_closed.load() && pending())
+				{
+					if (!read(inbound))
+						return false;
+				}
+				return !_closed.load() && !fds[1].revents;
+			}
+
+			void connection::close() throw()
+			{
+				_closed = true;
+				::shutdown(_control, SHUT_RDWR);
+			}
+
+			bool connection::closed() const throw()
+			{	return _closed.load();	}
+
+			void connection::create()
+			{
+				_memory = ::memfd_create("micro-profiler.ipc", MFD_CLOEXEC);
+				if (_memory < 0 || ::ftruncate(_memory, 2 * c_block_size))
+					throw initialization_failed("shared memory creation failed");
+				for (auto i = 0; i != events_count; ++i)
+				{
+					if ((_events[i] = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0)
+						throw initialization_failed("eventfd creation failed");
+				}
+
+				const int handles[c_handles_count] = {	_memory, _events[0], _events[1], _events[2], _events[3],	};
+
+				send_handles(_control, handles);
+			}
+
+			void connection::receive()
+			{
+				int handles[c_handles_count];
+				struct stat s;
+
+				receive_handles(_control, handles);
+				_memory = handles[0];
+				copy(handles + 1, handles + c_handles_count, _events);
+				if (::fstat(_memory, &s) || static_cast<size_t>(s.st_size) < 2 * c_block_size)
+					throw initialization_failed("shared memory received is too small");
+			}
+
+			void connection::map(bool accepting)
+			{
+				ring rings[2];
+
+				_mapping = ::mmap(nullptr, 2 * c_block_size, PROT_READ | PROT_WRITE, MAP_SHARED, _memory, 0);
+				if (MAP_FAILED == _mapping)
+					throw initialization_failed("shared memory mapping failed");
+				for (auto i = 0; i != 2; ++i)
+				{
+					const auto block = static_cast<byte *>(_mapping) + i * c_block_size;
+
+					rings[i].header = reinterpret_cast<ring_header *>(block);
+					rings[i].data = block + sizeof(ring_header);
+					rings[i].data_ready = _events[2 * i], rings[i].space_ready = _events[2 * i + 1];
+				}
+				_outbound = rings[accepting ? 1 : 0];
+				_inbound = rings[accepting ? 0 : 1];
+			}
+
+			void connection::release() throw()
+			{
+				if (MAP_FAILED != _mapping)
+					::munmap(_mapping, 2 * c_block_size);
+				for (auto i = 0; i != events_count; ++i)
+				{
+					if (_events[i] >= 0)
+						::close(_events[i]);
+				}
+				if (_memory >= 0)
+					::close(_memory);
+			}
+
+			bool connection::pending() const
+			{	return _inbound.header->written.load(memory_order_acquire) != _read;	}
+
+			bool connection::write_bytes(const byte *data, uint32_t size)
+			{
+				const auto &h = *_outbound.header;
+
+				while (size)
+				{
+					if (_closed.load())
+						return false;
+
+					const auto available = ring_size - (_written - h.read.load(memory_order_acquire));
+
+					if (!available)
+					{
+						publish();
+						if (!wait_writable())
+							return false;
+						continue;
+					}
+
+					const auto offset = _written & ring_mask;
+					const auto chunk = (min)((min)(size, available), ring_size - offset);
+
+					memcpy(_outbound.data + offset, data, chunk);
+					data += chunk, size -= chunk, _written += chunk;
+				}
+				return true;
+			}
+
+			void connection::publish()
+			{
+				auto &h = *_outbound.header;
+
+				h.written.store(_written);
+				if (h.reader_waiting.load())
+					notify(_outbound.data_ready);
+			}
+
+			bool connection::read_bytes(byte *data, uint32_t size)
+			{
+				while (size)
+				{
+					const auto available = wait_readable(1);
+
+					if (!available)
+						return false;
+
+					const auto offset = _read & ring_mask;
+					const auto chunk = (min)((min)(size, available), ring_size - offset);
+
+					memcpy(data, _inbound.data + offset, chunk);
+					data += chunk, size -= chunk;
+					consume(chunk);
+				}
+				return true;
+			}
+
+			void connection::consume(uint32_t size)
+			{
+				auto &h = *_inbound.header;
+
+				_read += size;
+				h.read.store(_read);
+				if (h.writer_waiting.load())
+					notify(_inbound.space_ready);
+			}
+
+			uint32_t connection::wait_readable(uint32_t size)
+			{
+				auto &h = *_inbound.header;
+
+				for (;;)
+				{
+					if (_closed.load())
+						return 0;
+
+					auto available = h.written.load(memory_order_acquire) - _read;
+
+					if (available >= size)
+						return available;
+					h.reader_waiting.store(1);
+					available = h.written.load() - _read;
+
+					const auto woken = available >= size || wait(_inbound.data_ready);
+
+					h.reader_waiting.store(0);
+					if (!woken)
+						return 0;
+				}
+			}
+
+			bool connection::wait_writable()
+			{
+				auto &h = *_outbound.header;
+
+				h.writer_waiting.store(1);
+
+				const auto woken = _written - h.read.load() != ring_size || wait(_outbound.space_ready);
+
+				h.writer_waiting.store(0);
+				return woken;
+			}
+
+			bool connection::wait(int event) const
+			{
+				pollfd fds[] = {	{	event, POLLIN, 0	}, {	_control, POLLIN, 0	},	};
+
+				while (!_closed.load())
+				{
+					if (::poll(fds, 2, -1) < 0)
+					{
+						if (errno == EINTR)
+							continue;
+						return false;
+					}
+					if (fds[0].revents & POLLIN)
+						return reset(event), true;
+					if (fds[1].revents)
+						return false;
+				}
+				return false;
+			}
+		}
+	}
+}
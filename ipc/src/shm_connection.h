@@ -0,0 +1,136 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include "common.h"
+#include "socket_helpers.h"
+
+#include <atomic>
+#include <common/range.h>
+#include <cstddef>
+#include <cstdint>
+#include <poll.h>
+#include <sys/un.h>
+#include <vector>
+
+namespace micro_profiler
+{
+	namespace ipc
+	{
+		struct channel;
+
+		namespace shm
+		{
+			struct ring_header
+			{
+				std::atomic<std::uint32_t> written, reader_waiting;
+				char padding1[64 - 2 * sizeof(std::uint32_t)];
+				std::atomic<std::uint32_t> read, writer_waiting;
+				char padding2[64 - 2 * sizeof(std::uint32_t)];
+			};
+
+			struct ring
+			{
+				ring_header *header;
+				byte *data;
+				int data_ready, space_ready;
+			};
+
+			// A duplex connection over two single-producer/single-consumer byte rings in a memory shared by the peers.
+			// Messages are framed by their 32-bit length. Read/written positions are free-running counters, and a peer
+			// is woken up (via eventfd) only if it has announced that it waits. The memory and the eventfd-s are
+			// created by the connecting side and passed to the accepting one over the control (unix) socket, which
+			// also serves for disconnection detection.
+			class connection : noncopyable
+			{
+			public:
+				enum {	ring_size = 1 << 20, ring_mask = ring_size - 1,	};
+
+			public:
+				// The connecting side creates the shared objects and passes them over the control socket, the accepting
+				// one receives them.
+				connection(sockets::socket_handle &control, bool accepting);
+
+				~connection();
+
+				// Blocks while there is not enough space in the outbound ring. Returns false if disconnected.
+				bool write(const_byte_range payload);
+				bool write(const const_byte_range *parts, size_t count);
+
+				// Reads a single message and delivers it to the channel: in place, if it is contiguous in the ring,
+				// or through an intermediate buffer otherwise. Blocks until the message is read completely. Returns
+				// false if disconnected.
+				bool read(channel &inbound);
+
+				// A non-blocking counterpart of read() for a reader multiplexing several connections: prepare_wait()
+				// announces the wait and fills in two descriptors to poll (returns false if there are messages already),
+				// read_available() delivers all the messages available. Returns false if disconnected.
+				bool prepare_wait(pollfd *fds);
+				bool read_available(channel &inbound, const pollfd *fds);
+
+				// Makes all pending and subsequent read()/write() of both peers fail.
+				void close() throw();
+				bool closed() const throw();
+
+			private:
+				enum {	events_count = 4,	};
+
+			private:
+				void create();
+				void receive();
+				void map(bool accepting);
+				void release() throw();
+				bool pending() const;
+				bool write_bytes(const byte *data, std::uint32_t size);
+				void publish();
+				bool read_bytes(byte *data, std::uint32_t size);
+				void consume(std::uint32_t size);
+				std::uint32_t wait_readable(std::uint32_t size);
+				bool wait_writable();
+				bool wait(int event) const;
+
+			private:
+				sockets::socket_handle _control;
+				int _memory, _events[events_count];
+				void *_mapping;
+				ring _inbound, _outbound;
+				std::uint32_t _read, _written;
+				std::atomic<bool> _closed;
+				std::vector<byte> _buffer;
+			};
+
+
+
+			inline sockaddr_un make_sockaddr_un(const char *endpoint_id, socklen_t &length)
+			{
+				const auto name = c_prefix + endpoint_id;
+				sockaddr_un addr = {};
+
+				if (name.size() >= sizeof(addr.sun_path))
+					throw std::invalid_argument(endpoint_id);
+				addr.sun_family = AF_UNIX;
+				name.copy(addr.sun_path + 1, name.size()); // Abstract namespace: sun_path starts with '\0'.
+				length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + name.size());
+				return addr;
+			}
+		}
+	}
+}
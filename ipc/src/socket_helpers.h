@@ -22,6 +22,7 @@
 
 #include <arpa/inet.h>
 #include <common/noncopyable.h>
+#include <common/range.h>
 #include <netinet/in.h>
 #include <stdexcept>
 #include <stdlib.h>
@@ -29,6 +30,7 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <vector>
 
 namespace micro_profiler
 {
@@ -52,6 +54,18 @@ namespace micro_profiler
 				unsigned short port;
 			};
 
+			// Switches a socket to the non-blocking mode.
+			void set_nonblocking(int s);
+
+			// Returns true if the last failed operation on a non-blocking socket would have blocked.
+			bool would_block() throw();
+
+			enum {	max_gather_parts = 64,	};
+
+			// Sends the parts in a single gather operation (up to max_gather_parts of them). Returns the number of bytes
+			// sent (may be less than the total) or -1 on failure.
+			long send_gather(int s, const const_byte_range *parts, size_t count) throw();
+
 			class socket_handle : noncopyable
 			{
 			public:
@@ -110,6 +124,30 @@ namespace micro_profiler
 			{	return _socket;	}
 
 
+			// Sends the parts while the socket accepts data. The parts sent are removed and the first one left is trimmed
+			// to its unsent remainder. Returns false if the socket has failed.
+			inline bool send_parts(int s, std::vector<const_byte_range> &parts)
+			{
+				auto i = parts.begin();
+
+				while (i != parts.end())
+				{
+					auto sent = send_gather(s, &*i, parts.end() - i);
+
+					if (sent < 0)
+					{
+						parts.erase(parts.begin(), i);
+						return would_block();
+					}
+					for (; i != parts.end() && static_cast<size_t>(sent) >= i->length(); ++i)
+						sent -= static_cast<long>(i->length());
+					if (i != parts.end())
+						*i = i->suffix(static_cast<size_t>(sent));
+				}
+				parts.clear();
+				return true;
+			}
+
 			inline sockaddr_in make_sockaddr_in(const char *ip_address, unsigned short port)
 			{
 				sockaddr_in addr = {};
@@ -20,6 +20,12 @@
 
 #include "socket_helpers.h"
 
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <ipc/endpoint.h>
+#include <sys/uio.h>
+
 namespace micro_profiler
 {
 	namespace ipc
@@ -31,6 +37,34 @@ namespace micro_profiler
 
 			sockets_initializer::~sockets_initializer()
 			{	}
+
+
+			void set_nonblocking(int s)
+			{
+				const auto flags = ::fcntl(s, F_GETFL);
+
+				if (flags < 0 || ::fcntl(s, F_SETFL, flags | O_NONBLOCK) < 0)
+					throw initialization_failed("cannot set non-blocking mode");
+			}
+
+			bool would_block() throw()
+			{	return errno == EAGAIN || errno == EWOULDBLOCK;	}
+
+			long send_gather(int s, const const_byte_range *parts, size_t count) throw()
+			{
+				iovec buffers[max_gather_parts];
+				msghdr msg = {};
+
+				count = (std::min)(count, static_cast<size_t>(max_gather_parts));
+				for (size_t i = 0; i != count; ++i)
+				{
+					buffers[i].iov_base = const_cast<byte *>(parts[i].begin());
+					buffers[i].iov_len = parts[i].length();
+				}
+				msg.msg_iov = buffers;
+				msg.msg_iovlen = count;
+				return static_cast<long>(::sendmsg(s, &msg, MSG_NOSIGNAL));
+			}
 		}
 	}
 }
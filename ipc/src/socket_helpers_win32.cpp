@@ -20,6 +20,8 @@
 
 #include "socket_helpers.h"
 
+#include <algorithm>
+#include <ipc/endpoint.h>
 #include <windows.h>
 
 namespace micro_profiler
@@ -36,6 +38,32 @@ namespace micro_profiler
 
 			sockets_initializer::~sockets_initializer()
 			{	::WSACleanup();	}
+
+
+			void set_nonblocking(int s)
+			{
+				u_long arg = 1;
+
+				if (::ioctlsocket(s, FIONBIO, &arg))
+					throw initialization_failed("cannot set non-blocking mode");
+			}
+
+			bool would_block() throw()
+			{	return ::WSAGetLastError() == WSAEWOULDBLOCK;	}
+
+			long send_gather(int s, const const_byte_range *parts, size_t count) throw()
+			{
+				WSABUF buffers[max_gather_parts];
+				DWORD sent = 0;
+
+				count = (std::min)(count, static_cast<size_t>(max_gather_parts));
+				for (size_t i = 0; i != count; ++i)
+				{
+					buffers[i].buf = reinterpret_cast<char *>(const_cast<byte *>(parts[i].begin()));
+					buffers[i].len = static_cast<ULONG>(parts[i].length());
+				}
+				return ::WSASend(s, buffers, static_cast<DWORD>(count), &sent, 0, NULL, NULL) ? -1 : static_cast<long>(sent);
+			}
 		}
 	}
 }
@@ -0,0 +1,68 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include <common/noncopyable.h>
+#include <poll.h>
+#include <vector>
+
+namespace micro_profiler
+{
+	namespace ipc
+	{
+		namespace sockets
+		{
+			// Readiness notification for a set of non-blocking sockets, each identified by an id. Notifications are
+			// edge-triggered, so a socket reported is to be read/written until the operation would block. epoll is
+			// used on Linux, poll()-family functions elsewhere.
+			class poller : noncopyable
+			{
+			public:
+				enum {	readable = 1, writable = 2,	};
+
+				struct event
+				{
+					unsigned id;
+					unsigned events;
+				};
+
+			public:
+				poller();
+				~poller();
+
+				void add(int s, unsigned id);
+				void modify(int s, unsigned id, bool watch_writable);
+				void remove(int s);
+
+				// Returns false if waiting has failed.
+				bool wait(std::vector<event> &events);
+
+			private:
+#ifdef __linux__
+				int _epoll;
+#else
+				std::vector<pollfd> _fds;
+				std::vector<unsigned> _ids;
+#endif
+			};
+		}
+	}
+}
@@ -0,0 +1,94 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include "socket_poller.h"
+
+#include <errno.h>
+#include <ipc/endpoint.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace micro_profiler
+{
+	namespace ipc
+	{
+		namespace sockets
+		{
+			namespace
+			{
+				enum {	max_events = 64,	};
+
+				void control(int epoll, int operation, int s, unsigned id, bool watch_writable)
+				{
+					epoll_event e = {};
+
+					e.events = EPOLLIN | EPOLLRDHUP | EPOLLET | (watch_writable ? EPOLLOUT : 0u);
+					e.data.u32 = id;
+					if (::epoll_ctl(epoll, operation, s, &e))
+						throw initialization_failed("epoll_ctl() failed");
+				}
+			}
+
+			poller::poller()
+				: _epoll(::epoll_create1(EPOLL_CLOEXEC))
+			{
+				if (_epoll < 0)
+					throw initialization_failed("epoll_create1() failed");
+			}
+
+			poller::~poller()
+			{	::close(_epoll);	}
+
+			void poller::add(int s, unsigned id)
+			{	control(_epoll, EPOLL_CTL_ADD, s, id, false);	}
+
+			void poller::modify(int s, unsigned id, bool watch_writable)
+			{	control(_epoll, EPOLL_CTL_MOD, s, id, watch_writable);	}
+
+			void poller::remove(int s)
+			{
+				epoll_event dummy = {};
+
+				::epoll_ctl(_epoll, EPOLL_CTL_DEL, s, &dummy);
+			}
+
+			bool poller::wait(std::vector<event> &events)
+			{
+				epoll_event ready[max_events];
+				const auto n = ::epoll_wait(_epoll, ready, max_events, -1);
+
+				events.clear();
+				if (n < 0)
+					return errno == EINTR;
+				for (auto i = 0; i != n; ++i)
+				{
+					const event e = {
+						ready[i].data.u32,
+						(ready[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR) ? readable : 0u)
+							| (ready[i].events & EPOLLOUT ? writable : 0u)
+					};
+
+					events.push_back(e);
+				}
+				return true;
+			}
+		}
+	}
+}
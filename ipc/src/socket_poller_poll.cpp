@@ -0,0 +1,90 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include "socket_poller.h"
+
+#include <algorithm>
+#include <errno.h>
+
+namespace micro_profiler
+{
+	namespace ipc
+	{
+		namespace sockets
+		{
+			poller::poller()
+			{	}
+
+			poller::~poller()
+			{	}
+
+			void poller::add(int s, unsigned id)
+			{
+				pollfd fd = {};
+
+				fd.fd = s, fd.events = POLLIN;
+				_fds.push_back(fd);
+				_ids.push_back(id);
+			}
+
+			void poller::modify(int s, unsigned /*id*/, bool watch_writable)
+			{
+				for (auto i = _fds.begin(); i != _fds.end(); ++i)
+				{
+					if (static_cast<int>(i->fd) == s)
+						i->events = POLLIN | (watch_writable ? POLLOUT : 0);
+				}
+			}
+
+			void poller::remove(int s)
+			{
+				for (auto i = _fds.begin(); i != _fds.end(); ++i)
+				{
+					if (static_cast<int>(i->fd) == s)
+					{
+						const auto j = _ids.begin() + (i - _fds.begin());
+
+						std::swap(*i, _fds.back()), _fds.pop_back();
+						std::swap(*j, _ids.back()), _ids.pop_back();
+						return;
+					}
+				}
+			}
+
+			bool poller::wait(std::vector<event> &events)
+			{
+				events.clear();
+				if (::poll(_fds.data(), static_cast<unsigned>(_fds.size()), -1) < 0)
+					return errno == EINTR;
+				for (auto i = _fds.begin(); i != _fds.end(); ++i)
+				{
+					const event e = {
+						_ids[i - _fds.begin()],
+						(i->revents & (POLLIN | POLLHUP | POLLERR) ? readable : 0u) | (i->revents & POLLOUT ? writable : 0u)
+					};
+
+					if (e.events)
+						events.push_back(e);
+				}
+				return true;
+			}
+		}
+	}
+}
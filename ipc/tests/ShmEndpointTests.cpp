@@ -0,0 +1,256 @@
+#include <ipc/endpoint_shm.h>
+
+#include "mocks.h"
+
+#include <mt/event.h>
+#include <test-helpers/helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace micro_profiler::tests;
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace ipc
+	{
+		namespace tests
+		{
+			namespace
+			{
+				vector<byte> make_payload(size_t size, unsigned seed)
+				{
+					vector<byte> payload(size);
+
+					for (auto i = payload.begin(); i != payload.end(); ++i)
+						*i = static_cast<byte>((seed = seed * 1103515245u + 12345u) >> 16);
+					return payload;
+				}
+			}
+
+			begin_test_suite( ShmEndpointTests )
+				mocks::session inbound;
+
+				test( ConnectionRefusedOnMissingServerEndpoint )
+				{
+					// ACT / ASSERT
+					assert_throws(shm::connect_client("mp-tests-missing", inbound), connection_refused);
+				}
+
+
+				test( CreatingServerAtTheSameEndpointThrowsException )
+				{
+					// INIT
+					shared_ptr<mocks::server> s(new mocks::server);
+					shared_ptr<void> hs = shm::run_server("mp-tests-1", s);
+
+					// ACT / ASSERT
+					assert_throws(shm::run_server("mp-tests-1", s), initialization_failed);
+				}
+
+
+				test( ConnectionIsMadeToExistingServers )
+				{
+					// INIT
+					mt::event ready;
+					shared_ptr<mocks::server> s1(new mocks::server), s2(new mocks::server);
+					shared_ptr<void> hs1 = shm::run_server("mp-tests-1", s1), hs2 = shm::run_server("mp-tests-2", s2);
+
+					s1->session_created = s2->session_created = [&] (shared_ptr<mocks::session>) {
+						ready.set();
+					};
+
+					// ACT
+					channel_ptr_t c1 = shm::connect_client("mp-tests-1", inbound);
+					ready.wait();
+					channel_ptr_t c2 = shm::connect_client("mp-tests-2", inbound);
+					ready.wait();
+					channel_ptr_t c3 = shm::connect_client("mp-tests-2", inbound);
+					ready.wait();
+
+					// ASSERT
+					assert_not_null(c1);
+					assert_not_null(c2);
+					assert_not_null(c3);
+					assert_equal(1u, s1->sessions.size());
+					assert_equal(2u, s2->sessions.size());
+				}
+
+
+				test( MessagesAreDeliveredInBothDirections )
+				{
+					// INIT
+					mt::event ready;
+					shared_ptr<mocks::server> s(new mocks::server);
+					shared_ptr<void> hs = shm::run_server("mp-tests-1", s);
+					byte data1[] = "I celebrate myself, and sing myself,";
+					byte data2[] = "And what I assume you shall assume,";
+					byte data3[] = "For every atom belonging to me as good belongs to you.";
+
+					s->session_created = [&] (shared_ptr<mocks::session> session) {
+						session->received_message = [&] {	ready.set();	};
+						ready.set();
+					};
+					inbound.received_message = [&] {	ready.set();	};
+
+					channel_ptr_t c = shm::connect_client("mp-tests-1", inbound);
+
+					ready.wait();
+
+					// ACT
+					c->message(mkrange(data1));
+					ready.wait();
+					c->message(mkrange(data2));
+					ready.wait();
+					s->sessions[0]->outbound->message(mkrange(data3));
+					ready.wait();
+
+					// ASSERT
+					assert_equal(2u, s->sessions[0]->payloads_log.size());
+					assert_equal(data1, s->sessions[0]->payloads_log[0]);
+					assert_equal(data2, s->sessions[0]->payloads_log[1]);
+					assert_equal(1u, inbound.payloads_log.size());
+					assert_equal(data3, inbound.payloads_log[0]);
+				}
+
+
+				test( MessagesWrappingAroundAndExceedingRingAreDeliveredIntact )
+				{
+					// INIT
+					mt::event ready;
+					shared_ptr<mocks::server> s(new mocks::server);
+					shared_ptr<void> hs = shm::run_server("mp-tests-1", s);
+					vector< vector<byte> > payloads;
+
+					payloads.push_back(make_payload(700000, 1));
+					payloads.push_back(make_payload(700000, 2)); // wraps around the end of the 1MB ring
+					payloads.push_back(make_payload(1, 3));
+					payloads.push_back(make_payload(3500000, 4)); // larger than the ring
+					payloads.push_back(make_payload(13, 5));
+					s->session_created = [&] (shared_ptr<mocks::session> session) {
+						session->received_message = [&] {
+							if (payloads.size() == s->sessions[0]->payloads_log.size())
+								ready.set();
+						};
+					};
+
+					channel_ptr_t c = shm::connect_client("mp-tests-1", inbound);
+
+					// ACT
+					for (auto i = payloads.begin(); i != payloads.end(); ++i)
+						c->message(mkrange(*i));
+					ready.wait();
+
+					// ASSERT
+					assert_equal(payloads, s->sessions[0]->payloads_log);
+
+					// INIT
+					inbound.received_message = [&] {
+						if (payloads.size() == inbound.payloads_log.size())
+							ready.set();
+					};
+
+					// ACT
+					for (auto i = payloads.begin(); i != payloads.end(); ++i)
+						s->sessions[0]->outbound->message(mkrange(*i));
+					ready.wait();
+
+					// ASSERT
+					assert_equal(payloads, inbound.payloads_log);
+				}
+
+
+				test( GatheredPartsAreDeliveredAsASingleMessage )
+				{
+					// INIT
+					mt::event ready;
+					shared_ptr<mocks::server> s(new mocks::server);
+					shared_ptr<void> hs = shm::run_server("mp-tests-1", s);
+					const auto part1 = make_payload(10, 1), part2 = make_payload(1500000, 2), part3 = make_payload(3, 3);
+					const const_byte_range parts[] = {	mkrange(part1), mkrange(part2), mkrange(part3),	};
+					vector<byte> reference(part1);
+
+					reference.insert(reference.end(), part2.begin(), part2.end());
+					reference.insert(reference.end(), part3.begin(), part3.end());
+					s->session_created = [&] (shared_ptr<mocks::session> session) {
+						session->received_message = [&] {	ready.set();	};
+					};
+					inbound.received_message = [&] {	ready.set();	};
+
+					channel_ptr_t c = shm::connect_client("mp-tests-1", inbound);
+
+					// ACT
+					c->message_gather(parts, 3);
+					ready.wait();
+
+					// ASSERT
+					assert_equal(1u, s->sessions[0]->payloads_log.size());
+					assert_equal(reference, s->sessions[0]->payloads_log[0]);
+
+					// ACT
+					s->sessions[0]->outbound->message_gather(parts, 3);
+					ready.wait();
+
+					// ASSERT
+					assert_equal(1u, inbound.payloads_log.size());
+					assert_equal(reference, inbound.payloads_log[0]);
+				}
+
+
+				test( ReleasingClientDisconnectsSession )
+				{
+					// INIT
+					mt::event ready;
+					shared_ptr<mocks::server> s(new mocks::server);
+					shared_ptr<void> hs = shm::run_server("mp-tests-1", s);
+
+					s->session_created = [&] (shared_ptr<mocks::session> session) {
+						session->disconnected = [&] {	ready.set();	};
+						ready.set();
+					};
+
+					channel_ptr_t c = shm::connect_client("mp-tests-1", inbound);
+
+					ready.wait();
+
+					// ACT
+					c.reset();
+					ready.wait();
+
+					// ASSERT
+					assert_equal(1u, s->sessions[0]->disconnections);
+				}
+
+
+				test( DisconnectingSessionDisconnectsClientAndReleasesSession )
+				{
+					// INIT
+					mt::event ready;
+					shared_ptr<mocks::server> s(new mocks::server);
+					shared_ptr<void> hs = shm::run_server("mp-tests-1", s);
+
+					inbound.disconnected = [&] {	ready.set();	};
+					s->session_created = [&] (shared_ptr<mocks::session>) {	ready.set();	};
+
+					channel_ptr_t c = shm::connect_client("mp-tests-1", inbound);
+
+					ready.wait();
+
+					// ACT
+					s->sessions[0]->outbound->disconnect();
+					ready.wait();
+
+					// ASSERT
+					assert_equal(1u, inbound.disconnections);
+
+					// ACT
+					while (!s->sessions[0].unique())
+						mt::this_thread::sleep_for(mt::milliseconds(10));
+
+					// ASSERT
+					assert_equal(0u, s->sessions[0]->disconnections);
+				}
+			end_test_suite
+		}
+	}
+}
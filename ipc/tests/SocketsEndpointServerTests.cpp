@@ -269,6 +269,132 @@ namespace micro_profiler
 					// ASSERT
 					assert_equal(data3, buffer);
 				}
+
+
+				test( HundredsOfConcurrentSessionsAreServed )
+				{
+					// INIT
+					const auto n = 600u;
+					auto remaining = 2 * n;
+					mt::event ready;
+					shared_ptr<mocks::server> f(new mocks::server);
+					shared_ptr<void> h = sockets::run_server("6111", f);
+					vector< unique_ptr<sender> > senders;
+					vector<byte> large(100000);
+
+					f->session_created = [&] (const shared_ptr<mocks::session> &s) {
+						s->received_message = [&] {
+							if (!--remaining)
+								ready.set();
+						};
+					};
+
+					for (auto i = 0u; i != n; ++i)
+						senders.emplace_back(new sender(6111));
+
+					// ACT
+					for (auto i = 0u; i != n; ++i)
+					{
+						large[i % large.size()] = static_cast<byte>(i);
+						assert_is_true((*senders[i])(&i, sizeof(i)));
+						assert_is_true((*senders[i])(large.data(), large.size()));
+						large[i % large.size()] = 0;
+					}
+					ready.wait();
+
+					// ASSERT
+					vector<bool> served(n);
+
+					assert_equal(n, f->sessions.size());
+					for (auto i = f->sessions.begin(); i != f->sessions.end(); ++i)
+					{
+						const auto &log = (*i)->payloads_log;
+						unsigned int index;
+
+						assert_equal(2u, log.size());
+						assert_equal(sizeof(index), log[0].size());
+						index = *reinterpret_cast<const unsigned int *>(log[0].data());
+						assert_is_true(index < n);
+						assert_is_false(served[index]);
+						served[index] = true;
+						large[index % large.size()] = static_cast<byte>(index);
+						assert_equal(large, log[1]);
+						large[index % large.size()] = 0;
+					}
+				}
+
+
+				test( WritingLargeMessagesDoesNotBlockOnClientNotReading )
+				{
+					// INIT
+					mt::event ready;
+					shared_ptr<mocks::server> f(new mocks::server);
+					shared_ptr<void> h = sockets::run_server("6111", f);
+					vector<byte> data1(16 * 1024 * 1024), data2(1000), buffer;
+
+					for (auto i = data1.begin(); i != data1.end(); ++i)
+						*i = static_cast<byte>((i - data1.begin()) * 7);
+					for (auto i = data2.begin(); i != data2.end(); ++i)
+						*i = static_cast<byte>(i - data2.begin());
+					f->session_created = [&] (shared_ptr<void>) {
+						ready.set();
+					};
+
+					reader stream(6111);
+
+					ready.wait();
+
+					// ACT (must not block)
+					f->sessions[0]->outbound->message(mkrange(data1));
+					f->sessions[0]->outbound->message(mkrange(data2));
+					f->sessions[0]->outbound->message(mkrange(data1));
+
+					// ACT / ASSERT
+					assert_is_true(stream(buffer));
+					assert_equal(data1, buffer);
+					assert_is_true(stream(buffer));
+					assert_equal(data2, buffer);
+					assert_is_true(stream(buffer));
+					assert_equal(data1, buffer);
+				}
+
+
+				test( GatheredPartsAreDeliveredToClientAsASingleMessage )
+				{
+					// INIT
+					mt::event ready;
+					shared_ptr<mocks::server> f(new mocks::server);
+					shared_ptr<void> h = sockets::run_server("6111", f);
+					vector<byte> data1(100), data2(3 * 1024 * 1024), data3(7), buffer;
+
+					for (auto i = data2.begin(); i != data2.end(); ++i)
+						*i = static_cast<byte>((i - data2.begin()) * 3);
+					fill(data1.begin(), data1.end(), byte(1));
+					fill(data3.begin(), data3.end(), byte(13));
+					f->session_created = [&] (shared_ptr<void>) {
+						ready.set();
+					};
+
+					reader stream(6111);
+					const const_byte_range parts[] = {	mkrange(data1), mkrange(data2), mkrange(data3),	};
+
+					ready.wait();
+
+					// ACT
+					f->sessions[0]->outbound->message_gather(parts, 3);
+					f->sessions[0]->outbound->message_gather(parts + 2, 1);
+
+					// ASSERT
+					vector<byte> reference(data1);
+
+					reference.insert(reference.end(), data2.begin(), data2.end());
+					reference.insert(reference.end(), data3.begin(), data3.end());
+
+					assert_is_true(stream(buffer));
+					assert_equal(reference, buffer);
+					assert_is_true(stream(buffer));
+					assert_equal(data3, buffer);
+				}
 			end_test_suite
 		}
 	}
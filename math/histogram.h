@@ -53,10 +53,6 @@ namespace math
 
 	private:
 		scale_type _scale;
-
-	private:
-		template <typename ArchiveT, typename ScaleT_, typename Y_>
-		friend void serialize(ArchiveT &archive, histogram<ScaleT_, Y_> &data, unsigned int ver);
 	};
 
 	struct partition_less
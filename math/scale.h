@@ -23,6 +23,10 @@
 #include <cmath>
 #include <stdexcept>
 
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
 namespace math
 {
 	typedef unsigned int index_t;
@@ -79,6 +83,33 @@ namespace math
 		value_type _near, _far;
 	};
 
+	// An integral scale of 2^precision buckets per a power of two, the values below 2^precision are bucketed exactly.
+	// The value to index conversion is branch-free: negative values fall into the first bucket and the values beyond
+	// the last bucket fall into it.
+	template <typename T>
+	class log_linear_scale
+	{
+	public:
+		typedef T value_type;
+
+	public:
+		log_linear_scale();
+		log_linear_scale(unsigned int precision_, unsigned int samples_);
+
+		unsigned int precision() const;
+		value_type near_value() const;
+		value_type far_value() const;
+		index_t samples() const;
+		bool operator ()(index_t &index, value_type value) const;
+		value_type operator [](index_t index) const; // Returns the upper (exclusive) boundary of the bucket.
+
+	private:
+		static unsigned int msb(unsigned long long value);
+
+	private:
+		unsigned int _precision, _samples;
+	};
+
 
 
 	template <typename T>
@@ -177,6 +208,78 @@ namespace math
 	{	return std::log10(static_cast<float>(value));	}
 
 
+	template <typename T>
+	inline log_linear_scale<T>::log_linear_scale()
+		: _precision(0), _samples(0)
+	{	}
+
+	template <typename T>
+	inline log_linear_scale<T>::log_linear_scale(unsigned int precision_, unsigned int samples_)
+		: _precision(precision_), _samples(samples_)
+	{
+		if (precision_ > 16)
+			throw std::invalid_argument("precision is too high");
+	}
+
+	template <typename T>
+	inline unsigned int log_linear_scale<T>::precision() const
+	{	return _precision;	}
+
+	template <typename T>
+	inline T log_linear_scale<T>::near_value() const
+	{	return value_type();	}
+
+	template <typename T>
+	inline T log_linear_scale<T>::far_value() const
+	{	return _samples ? (*this)[_samples - 1] : value_type();	}
+
+	template <typename T>
+	inline index_t log_linear_scale<T>::samples() const
+	{	return _samples;	}
+
+	template <typename T>
+	inline bool log_linear_scale<T>::operator ()(index_t &index, value_type value) const
+	{
+		const auto base = 1ull << _precision;
+		const auto m = static_cast<unsigned long long>(value > value_type() ? value : value_type()) + base;
+		const auto order = msb(m) - _precision;
+		const auto index_ = static_cast<index_t>((order << _precision) + (m >> order) - base);
+		const auto last = _samples - 1;
+
+		index = index_ < last ? index_ : last;
+		return !!_samples;
+	}
+
+	template <typename T>
+	inline T log_linear_scale<T>::operator [](index_t index) const
+	{
+		const auto order = ++index >> _precision;
+		const auto base = 1ull << _precision;
+
+		return static_cast<value_type>(((base + (index & (base - 1))) << order) - base);
+	}
+
+	template <typename T>
+	inline unsigned int log_linear_scale<T>::msb(unsigned long long value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return 63u - __builtin_clzll(value);
+#elif defined(_M_X64) || defined(_M_ARM64)
+		unsigned long index;
+
+		_BitScanReverse64(&index, value);
+		return index;
+#else
+		unsigned long index;
+
+		if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+			return index + 32u;
+		_BitScanReverse(&index, static_cast<unsigned long>(value));
+		return index;
+#endif
+	}
+
+
 
 	template <typename ScaleT>
 	inline bool scale_eq(const ScaleT &lhs, const ScaleT &rhs)
@@ -199,4 +302,13 @@ namespace math
 	template <typename T>
 	inline bool operator !=(const log_scale<T> &lhs, const log_scale<T> &rhs)
 	{	return !(lhs == rhs);	}
+
+
+	template <typename T>
+	inline bool operator ==(const log_linear_scale<T> &lhs, const log_linear_scale<T> &rhs)
+	{	return (lhs.precision() == rhs.precision()) & (lhs.samples() == rhs.samples());	}
+
+	template <typename T>
+	inline bool operator !=(const log_linear_scale<T> &lhs, const log_linear_scale<T> &rhs)
+	{	return !(lhs == rhs);	}
 }
@@ -27,10 +27,17 @@
 
 namespace strmd
 {
+	template <typename StreamT, typename PackerT, int static_version>
+	class serializer;
+
+	template <typename StreamT, typename PackerT, int static_version>
+	class deserializer;
+
 	template <typename T> struct version< math::linear_scale<T> > {	enum {	value = 1	};	};
 	template <typename T> struct version< math::log_scale<T> > {	enum {	value = 1	};	};
+	template <typename T> struct version< math::log_linear_scale<T> > {	enum {	value = 1	};	};
 	template <typename T> struct version< math::variant_scale<T> > {	enum {	value = 1	};	};
-	template <typename S, typename Y> struct version< math::histogram<S, Y> > {	enum {	value = 1	};	};
+	template <typename S, typename Y> struct version< math::histogram<S, Y> > {	enum {	value = 2	};	};
 }
 
 namespace math
@@ -74,15 +81,72 @@ namespace math
 	inline void serialize(ArchiveT &archive, log_scale<T> &data, unsigned int ver)
 	{	serialize_scale(archive, data, ver);	}
 
+	template <typename ArchiveT, typename T>
+	inline void serialize(ArchiveT &archive, log_linear_scale<T> &data, unsigned int /*ver*/)
+	{
+		auto precision = data.precision();
+		auto samples = data.samples();
+
+		archive(precision);
+		archive(samples);
+		if ((precision != data.precision()) | (samples != data.samples()))
+			data = log_linear_scale<T>(precision, samples);
+	}
+
 	template <typename ArchiveT, typename T>
 	inline void serialize(ArchiveT &archive, variant_scale<T> &data, unsigned int /*ver*/)
 	{	archive(static_cast<typename variant_scale<T>::base_t &>(data));	}
 
-	template <typename ArchiveT, typename ScaleT, typename Y>
-	inline void serialize(ArchiveT &archive, histogram<ScaleT, Y> &data, unsigned int /*ver*/)
+	// Only the non-empty bins are written, as (index, value) pairs.
+	template <typename S, typename P, int v, typename ScaleT, typename Y>
+	inline void serialize(strmd::serializer<S, P, v> &archive, histogram<ScaleT, Y> &data, unsigned int /*ver*/)
+	{
+		auto scale = data.get_scale();
+		auto n = static_cast<index_t>(data.size() - std::count(data.begin(), data.end(), Y()));
+
+		archive(scale);
+		archive(n);
+		for (auto i = data.begin(); n; ++i)
+		{
+			if (*i != Y())
+			{
+				auto index = static_cast<index_t>(i - data.begin());
+
+				archive(index);
+				archive(*i);
+				n--;
+			}
+		}
+	}
+
+	template <typename S, typename P, int v, typename ScaleT, typename Y>
+	inline void serialize(strmd::deserializer<S, P, v> &archive, histogram<ScaleT, Y> &data, unsigned int ver)
 	{
-		archive(data._scale);
-		archive(static_cast< std::vector<Y> &>(data));
+		auto scale = data.get_scale();
+
+		archive(scale);
+		data.set_scale(scale);
+		if (ver < 2)
+		{
+			std::vector<Y> values;
+
+			archive(values);
+			std::copy(values.begin(), values.begin() + (std::min)(values.size(), data.size()), data.begin());
+			return;
+		}
+
+		index_t n = 0;
+
+		for (archive(n); n--; )
+		{
+			index_t index = 0;
+			Y value = Y();
+
+			archive(index);
+			archive(value);
+			if (index < data.size())
+				data.begin()[index] = value;
+		}
 	}
 
 	template <typename ArchiveT, typename T>
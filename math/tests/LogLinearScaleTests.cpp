@@ -0,0 +1,129 @@
+#include <math/scale.h>
+
+#include <ut/assert.h>
+#include <ut/test.h>
+
+namespace math
+{
+	namespace tests
+	{
+		namespace
+		{
+			template <typename ScaleT>
+			index_t cvt(const ScaleT &scale_, typename ScaleT::value_type value)
+			{
+				index_t index;
+
+				assert_is_true(scale_(index, value));
+				return index;
+			}
+		}
+
+		begin_test_suite( LogLinearScaleTests )
+			test( DefaultScaleIsEmpty )
+			{
+				// INIT / ACT
+				log_linear_scale<long long> s;
+				index_t index;
+
+				// ACT / ASSERT
+				assert_equal(0u, s.samples());
+				assert_equal(0, s.near_value());
+				assert_equal(0, s.far_value());
+				assert_is_false(s(index, 0));
+				assert_is_false(s(index, 0xFFFFFFF));
+				assert_equal(log_linear_scale<long long>(), s);
+			}
+
+
+			test( ValuesBelowSubBucketsCountAreConvertedExactly )
+			{
+				// INIT
+				log_linear_scale<long long> s1(1, 64);
+				log_linear_scale<long long> s3(3, 64);
+
+				// ACT / ASSERT
+				assert_equal(0u, cvt(s1, 0));
+				assert_equal(1u, cvt(s1, 1));
+				assert_equal(0u, cvt(s3, 0));
+				assert_equal(1u, cvt(s3, 1));
+				assert_equal(5u, cvt(s3, 5));
+				assert_equal(7u, cvt(s3, 7));
+			}
+
+
+			test( EachPowerOfTwoIsSplitIntoSubBuckets )
+			{
+				// INIT
+				log_linear_scale<long long> s(1, 64);
+
+				// ACT / ASSERT
+				assert_equal(2u, cvt(s, 2));
+				assert_equal(2u, cvt(s, 3));
+				assert_equal(3u, cvt(s, 4));
+				assert_equal(3u, cvt(s, 5));
+				assert_equal(4u, cvt(s, 6));
+				assert_equal(4u, cvt(s, 9));
+				assert_equal(5u, cvt(s, 10));
+				assert_equal(5u, cvt(s, 13));
+				assert_equal(6u, cvt(s, 14));
+				assert_equal(6u, cvt(s, 21));
+				assert_equal(7u, cvt(s, 22));
+				assert_equal(11u, cvt(s, 100));
+			}
+
+
+			test( BucketsEndRightBeforeTheValuesReturnedForThem )
+			{
+				// INIT
+				log_linear_scale<long long> s1(1, 64);
+				log_linear_scale<long long> s2(2, 100);
+
+				// ACT / ASSERT
+				assert_equal(1, s1[0]);
+				assert_equal(2, s1[1]);
+				assert_equal(4, s1[2]);
+				assert_equal(6, s1[3]);
+				assert_equal(10, s1[4]);
+				for (index_t i = 0; i != 63; ++i)
+				{
+					assert_equal(i, cvt(s1, s1[i] - 1));
+					assert_equal(i + 1, cvt(s1, s1[i]));
+				}
+				for (index_t i = 0; i != 99; ++i)
+				{
+					assert_equal(i, cvt(s2, s2[i] - 1));
+					assert_equal(i + 1, cvt(s2, s2[i]));
+				}
+				assert_equal(0, s1.near_value());
+				assert_equal(s1[63], s1.far_value());
+				assert_equal(s2[99], s2.far_value());
+			}
+
+
+			test( OutOfRangeValuesAreClampedToTheEdgeBuckets )
+			{
+				// INIT
+				log_linear_scale<long long> s(1, 10);
+
+				// ACT / ASSERT
+				assert_equal(0u, cvt(s, -1));
+				assert_equal(0u, cvt(s, -0x7FFFFFFFFFFFFFFF));
+				assert_equal(9u, cvt(s, s[8]));
+				assert_equal(9u, cvt(s, s[9]));
+				assert_equal(9u, cvt(s, 1000));
+				assert_equal(9u, cvt(s, 0x7FFFFFFFFFFFFFF));
+			}
+
+
+			test( ScalesAreEqualIfPrecisionAndSamplesAreEqual )
+			{
+				// INIT / ACT / ASSERT
+				assert_equal(log_linear_scale<int>(1, 64), log_linear_scale<int>(1, 64));
+				assert_equal(log_linear_scale<int>(2, 17), log_linear_scale<int>(2, 17));
+				assert_not_equal(log_linear_scale<int>(1, 64), log_linear_scale<int>(2, 64));
+				assert_not_equal(log_linear_scale<int>(1, 64), log_linear_scale<int>(1, 63));
+			}
+		end_test_suite
+	}
+}
@@ -197,6 +197,40 @@ namespace math
 				assert_equal(reference2, v);
 			}
 
+
+			test( OnlyNonEmptyBinsOfHistogramAreSerialized )
+			{
+				// INIT
+				vector_adapter buffer;
+				strmd::serializer<vector_adapter, packer> s(buffer);
+				strmd::deserializer<vector_adapter, packer> ds(buffer);
+				histogram<linear_scale<int>, int> h;
+				histogram<linear_scale<int>, int> v;
+
+				h.set_scale(linear_scale<int>(0, 999, 1000));
+				h.add(17, 3);
+				h.add(900);
+
+				// ACT
+				s(h);
+
+				// ASSERT
+				assert_is_true(buffer.buffer.size() < 32);
+
+				// INIT
+				vector<int> reference(1000);
+
+				reference[17] = 3;
+				reference[900] = 1;
+
+				// ACT
+				ds(v);
+
+				// ASSERT
+				assert_equal(linear_scale<int>(0, 999, 1000), v.get_scale());
+				assert_equal(reference, vector<int>(v.begin(), v.end()));
+			}
+
 		end_test_suite
 
 	}
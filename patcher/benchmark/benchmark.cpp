@@ -216,9 +216,77 @@ namespace micro_profiler
 			stack_entry _stack_entries[16];
 		};
 
+#if defined(__linux__) && defined(__x86_64__)
+		__thread fast_cursor t_cursor __attribute__((tls_model("initial-exec")));
+
+		// The fast trampoline only calls it when the records are exhausted, as the calls measured are flat.
+		struct cursor_interceptor
+		{
+			cursor_interceptor()
+				: _records(1 << 16)
+			{
+				fast_cursor::return_entry sentinel = {	reinterpret_cast<const void **>(static_cast<size_t>(-1)), 0	};
+
+				_returns[0] = sentinel;
+				t_cursor.records = _records.data(), t_cursor.records_end = _records.data() + _records.size();
+				t_cursor.returns = _returns + 1, t_cursor.returns_end = _returns + 16;
+			}
+
+			static void CC_(fastcall) on_enter(cursor_interceptor *self, const void **stack_ptr,
+				timestamp_t timestamp, const void *callee) _CC(fastcall)
+			{
+				auto &e = *t_cursor.returns++;
+
+				e.stack_ptr = stack_ptr, e.return_address = *stack_ptr;
+				self->write(timestamp, callee);
+			}
+
+			static const void *CC_(fastcall) on_exit(cursor_interceptor *self, const void ** /*stack_ptr*/,
+				timestamp_t timestamp) _CC(fastcall)
+			{
+				self->write(timestamp, 0);
+				return (--t_cursor.returns)->return_address;
+			}
+
+		private:
+			void write(timestamp_t timestamp, const void *callee)
+			{
+				if (t_cursor.records == t_cursor.records_end)
+					t_cursor.records = _records.data(); // The buffer is handed off.
+				t_cursor.records->timestamp = timestamp;
+				t_cursor.records->callee = callee;
+				t_cursor.records++;
+			}
+
+		private:
+			vector<fast_cursor::record> _records;
+			fast_cursor::return_entry _returns[16];
+		};
+#endif
+
 		void empty_function()
 		{
 		}
+
+		shared_ptr<void> allocate_thunk(size_t trampoline_size)
+		{
+			auto allocator = memory_manager(virtual_memory::granularity())
+				.create_executable_allocator(const_byte_range(tests::address_cast_hack<const byte*>(&empty_function), 1), 32);
+			shared_ptr<void> thunk = allocator->allocate(trampoline_size + c_jump_size);
+
+			jump_initialize(static_cast<byte*>(thunk.get()) + trampoline_size, tests::address_cast_hack<const void*>(&empty_function));
+			return thunk;
+		}
+
+		float measure_cycles(const shared_ptr<void> &thunk, unsigned repetitions)
+		{
+			auto f = tests::address_cast_hack<decltype(&empty_function)>(thunk.get());
+			const auto start = __rdtsc();
+
+			for (auto n = repetitions; n; n--)
+				f();
+			return static_cast<float>(__rdtsc() - start) / repetitions;
+		}
 	}
 
 	float measure_rdtsc(unsigned repetitions)
@@ -251,6 +319,27 @@ namespace micro_profiler
 			f();
 		return static_cast<float>(1e9 * sw() / repetitions);
 	}
+
+	template <typename InterceptorT>
+	float measure_hook_cycles(unsigned repetitions)
+	{
+		InterceptorT interceptor;
+		auto thunk = allocate_thunk(c_trampoline_size);
+
+		initialize_trampoline(thunk.get(), 0, &interceptor);
+		return measure_cycles(thunk, repetitions);
+	}
+
+#if defined(__linux__) && defined(__x86_64__)
+	float measure_fast_hook_cycles(unsigned repetitions)
+	{
+		cursor_interceptor interceptor;
+		auto thunk = allocate_thunk(c_fast_trampoline_size);
+
+		initialize_fast_trampoline(thunk.get(), 0, &interceptor, get_thread_pointer_offset(&t_cursor));
+		return measure_cycles(thunk, repetitions);
+	}
+#endif
 }
 
 int main()
@@ -263,5 +352,9 @@ int main()
 	printf("Hooked call time (VLE queue): %.1fns\n", measure_hook_overhead<queue_interceptor<single_queue_manager<vle_queue>>>(c_repetitions));
 	printf("Hooked call time (tls, flat queue): %.1fns\n", measure_hook_overhead<queue_interceptor<tls_queue_manager<flat_queue>>>(c_repetitions));
 	printf("Hooked call time (tls, VLE queue): %.1fns\n", measure_hook_overhead<queue_interceptor<tls_queue_manager<vle_queue>>>(c_repetitions));
+	printf("Hooked call cycles (tls, flat queue): %.1f\n", measure_hook_cycles<queue_interceptor<tls_queue_manager<flat_queue>>>(c_repetitions));
+#if defined(__linux__) && defined(__x86_64__)
+	printf("Hooked call cycles (fast trampoline): %.1f\n", measure_fast_hook_cycles(c_repetitions));
+#endif
 	return 0;
 }
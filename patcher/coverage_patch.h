@@ -0,0 +1,53 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include "interface.h"
+#include "translated_function_patch.h"
+
+namespace micro_profiler
+{
+	extern const std::size_t c_hit_marker_size;
+
+	// Emits the code setting the bit of the hits bitmap atomically (unless it is set already), that preserves all the
+	// registers but the flags.
+	void hit_marker_initialize(void *at, byte *hits, byte hit_mask);
+
+	// A patch marking the function executed in the hits bitmap, instead of tracing its calls. The function's prologue
+	// is moved past the marker, as it is done for translated_function_patch. Once the hit is seen, the patch is meant to
+	// be reverted by its owner, so that the function runs at full speed afterwards.
+	class coverage_patch : public patch, noncopyable
+	{
+	public:
+		coverage_patch(void *target, std::size_t size, byte *hits, byte hit_mask,
+			executable_memory_allocator &allocator_, const translation_plan &plan);
+
+		bool active() const;
+		virtual bool activate() override;
+		virtual bool revert() override;
+
+	private:
+		std::shared_ptr<const byte> _trampoline;
+		const byte_range _target_function;
+		byte _prologue_backup_offset, _prologue_size;
+		bool _active;
+	};
+}
@@ -53,4 +53,41 @@ namespace micro_profiler
 	template <typename T>
 	inline void initialize_trampoline(void *at, const void *id, T *interceptor)
 	{	initialize_trampoline(at, id, interceptor, hooks<T>::on_enter(), hooks<T>::on_exit());	}
+
+#if defined(__linux__) && defined(__x86_64__)
+	extern const size_t c_fast_trampoline_size;
+
+	// A thread's trace area the fast trampoline writes to directly. Both arrays grow upwards, 'returns' is preceded by
+	// an entry with a stack_ptr above any real one. The interceptor's on_enter()/on_exit() are only called when an area
+	// is exhausted, on a tail call or on the frames being unwound - these must maintain the cursor the same way. A cursor
+	// with no room for records (e.g. a zeroed one) makes all the calls go to the interceptor.
+	struct fast_cursor
+	{
+		struct record
+		{
+			timestamp_t timestamp;
+			const void *callee; // Zero for an exit.
+		};
+
+		struct return_entry
+		{
+			const void **stack_ptr;
+			const void *return_address;
+		};
+
+		record *records, *records_end;
+		return_entry *returns, *returns_end;
+	};
+
+	// Returns the offset of the cursor from the calling thread's thread pointer. The offset of an initial-exec
+	// thread-local cursor is the same for every thread, so it can be fixed in the trampoline at patch time.
+	ptrdiff_t get_thread_pointer_offset(const fast_cursor *cursor);
+
+	void initialize_fast_trampoline(void *at, const void *id, void *interceptor, ptrdiff_t cursor_offset,
+		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit);
+
+	template <typename T>
+	inline void initialize_fast_trampoline(void *at, const void *id, T *interceptor, ptrdiff_t cursor_offset)
+	{	initialize_fast_trampoline(at, id, interceptor, cursor_offset, hooks<T>::on_enter(), hooks<T>::on_exit());	}
+#endif
 }
@@ -34,6 +34,7 @@ namespace micro_profiler
 			dormant,	// Patch was once requested, but is now reverted and not required on load;
 			unrecoverable_error,	// Patch was once requested, but failed to apply. Sticks forever;
 			activation_error, // Patch activation failed, can be retried later.
+			throttled, // Patch was reverted by the collector for its overhead, can be applied again on request.
 		} state;
 		unsigned int size;
 	};
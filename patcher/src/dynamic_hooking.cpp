@@ -29,11 +29,19 @@ using namespace std;
 extern "C" {
 	extern const uint8_t micro_profiler_trampoline_proto;
 	extern const uint8_t micro_profiler_trampoline_proto_end;
+#if defined(__linux__) && defined(__x86_64__)
+	extern const uint8_t micro_profiler_fast_trampoline_proto;
+	extern const uint8_t micro_profiler_fast_trampoline_proto_end;
+#endif
 }
 
 namespace micro_profiler
 {
 	const size_t c_trampoline_size = &micro_profiler_trampoline_proto_end - &micro_profiler_trampoline_proto;
+#if defined(__linux__) && defined(__x86_64__)
+	const size_t c_fast_trampoline_size = &micro_profiler_fast_trampoline_proto_end
+		- &micro_profiler_fast_trampoline_proto;
+#endif
 
 
 	void initialize_trampoline(void *at, const void *id, void *interceptor,
@@ -53,4 +61,27 @@ namespace micro_profiler
 			return reinterpret_cast<ptrdiff_t>(on_exit) - address;
 		});
 	}
+
+#if defined(__linux__) && defined(__x86_64__)
+	ptrdiff_t get_thread_pointer_offset(const fast_cursor *cursor)
+	{
+		const byte *thread_pointer;
+
+		asm("mov %%fs:0, %0" : "=r"(thread_pointer));
+		return reinterpret_cast<const byte *>(cursor) - thread_pointer;
+	}
+
+	void initialize_fast_trampoline(void *at, const void *id, void *interceptor, ptrdiff_t cursor_offset,
+		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit)
+	{
+		byte_range prologue(static_cast<byte *>(at), c_fast_trampoline_size);
+
+		mem_copy(prologue.begin(), &micro_profiler_fast_trampoline_proto, prologue.length());
+		replace(prologue, 1, [interceptor] (...) {	return reinterpret_cast<size_t>(interceptor);	});
+		replace(prologue, 2, [id] (...) {	return reinterpret_cast<size_t>(id);	});
+		replace(prologue, 3, [on_enter] (...) {	return reinterpret_cast<size_t>(on_enter);	});
+		replace(prologue, 4, [on_exit] (...) {	return reinterpret_cast<size_t>(on_exit);	});
+		replace(prologue, 5, [cursor_offset] (...) {	return static_cast<size_t>(cursor_offset);	});
+	}
+#endif
 }
@@ -160,7 +160,7 @@ namespace micro_profiler
 	{
 		prepare(results, targets.length());
 
-		auto locked = lock_module(module_id);
+		auto locked = lock_module(module_id); // Lifts the protection of the executable regions once for the batch.
 		mt::lock_guard<mt::mutex> l(_mtx);
 		auto &patch_idx = sdb::unique_index(_patches, module_rva_keyer());
 
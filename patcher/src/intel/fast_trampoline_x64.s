@@ -0,0 +1,129 @@
+#	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+#
+#	Permission is hereby granted, free of charge, to any person obtaining a copy
+#	of this software and associated documentation files (the "Software"), to deal
+#	in the Software without restriction, including without limitation the rights
+#	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+#	copies of the Software, and to permit persons to whom the Software is
+#	furnished to do so, subject to the following conditions:
+#
+#	The above copyright notice and this permission notice shall be included in
+#	all copies or substantial portions of the Software.
+#
+#	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+#	THE SOFTWARE.
+
+
+# The fast trampoline writes the entry/exit records and the return entries through a per-thread fast_cursor reached at
+# a fixed offset from the thread pointer (%fs), and only calls the interceptor when a cursor's area is exhausted, on a
+# tail call or when the frames are unwound past the one exiting.
+.text
+	.globl micro_profiler_fast_trampoline_proto, micro_profiler_fast_trampoline_proto_end
+
+	micro_profiler_fast_trampoline_proto:	# argument passing: RDI, RSI, RDX, RCX, R8, and R9, <stack>
+		push	%rax
+		push	%rdx
+		push	%rcx
+		mov	$0x3141592600000005, %rcx # cursor offset
+		mov	%fs:0x10(%rcx), %r10 # return stack top
+		cmp	%fs:0x18(%rcx), %r10
+		jae	slow_enter
+		mov	%fs:(%rcx), %r11 # records top
+		cmp	%fs:0x08(%rcx), %r11
+		jae	slow_enter
+		lea	0x18(%rsp), %rax # stack_ptr
+		cmp	%rax, -0x10(%r10)
+		je		slow_enter # tail call
+		mov	%rax, (%r10)
+		mov	(%rax), %rax
+		mov	%rax, 0x08(%r10) # return address
+		add	$0x10, %r10
+		mov	%r10, %fs:0x10(%rcx)
+		rdtsc
+		shl	$0x20, %rdx
+		or		%rax, %rdx
+		mov	%rdx, (%r11) # timestamp
+		mov	$0x3141592600000002, %rax
+		mov	%rax, 0x08(%r11) # callee
+		add	$0x10, %r11
+		mov	%r11, %fs:(%rcx)
+		pop	%rcx
+		pop	%rdx
+		pop	%rax
+
+	enter_done:
+		add	$0x08, %rsp
+		call	fast_trampoline_proto_end
+
+		push	%rax
+		push	%rdx
+		push	%rcx
+		mov	$0x3141592600000005, %rcx # cursor offset
+		mov	%fs:(%rcx), %r11 # records top
+		cmp	%fs:0x08(%rcx), %r11
+		jae	slow_exit # the records are checked first - a cursor with no room may have no return stack behind
+		mov	%fs:0x10(%rcx), %r10 # return stack top
+		lea	0x10(%rsp), %rax # stack_ptr
+		cmp	%rax, -0x20(%r10)
+		jbe	slow_exit # the frames below are unwound
+		sub	$0x10, %r10
+		mov	%r10, %fs:0x10(%rcx)
+		mov	0x08(%r10), %r10 # return address
+		rdtsc
+		shl	$0x20, %rdx
+		or		%rax, %rdx
+		mov	%rdx, (%r11) # timestamp
+		movq	$0, 0x08(%r11) # callee
+		add	$0x10, %r11
+		mov	%r11, %fs:(%rcx)
+		pop	%rcx
+		pop	%rdx
+		pop	%rax
+		jmp	*%r10
+
+	slow_exit:
+		rdtsc
+		mov	$0x3141592600000001, %rdi # 1st argument, interceptor
+		lea	0x10(%rsp), %rsi # 2nd argument, stack_ptr
+		shl	$0x20, %rdx
+		or		%rax, %rdx # 3rd argument, timestamp
+		mov	$0x3141592600000004, %rax # on_exit() address
+		sub	$0x88, %rsp
+		call	*%rax
+		add	$0x88, %rsp
+		mov	%rax, %r10 # restore return address
+		pop	%rcx
+		pop	%rdx
+		pop	%rax
+		jmp	*%r10
+
+	slow_enter:
+		push	%rdi
+		push	%rsi
+		push	%r8
+		push	%r9
+		rdtsc
+		mov	$0x3141592600000001, %rdi # 1st argument, interceptor
+		lea	0x38(%rsp), %rsi # 2nd argument, stack_ptr
+		shl	$0x20, %rdx
+		or		%rax, %rdx # 3rd argument, timestamp
+		mov	$0x3141592600000002, %rcx # 4th argument, callee
+		mov	$0x3141592600000003, %rax # on_enter() address
+		sub	$0x80, %rsp
+		call	*%rax
+		add	$0x80, %rsp
+		pop	%r9
+		pop	%r8
+		pop	%rsi
+		pop	%rdi
+		pop	%rcx
+		pop	%rdx
+		pop	%rax
+		jmp	enter_done
+	fast_trampoline_proto_end:
+	micro_profiler_fast_trampoline_proto_end:
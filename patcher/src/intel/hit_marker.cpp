@@ -0,0 +1,87 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <patcher/coverage_patch.h>
+
+#pragma pack(push, 1)
+
+namespace micro_profiler
+{
+	namespace
+	{
+#if defined(_M_X64) || defined(__x86_64__)
+		struct hit_marker
+		{
+			void init(byte *hits, byte hit_mask)
+			{
+				const hit_marker m = {
+					0x50, // push rax
+					{	0x48, 0xB8,	}, hits, // mov rax, hits
+					{	0xF6, 0x00,	}, hit_mask, // test byte ptr [rax], hit_mask
+					{	0x75, 0x04,	}, // jnz marked
+					{	0xF0, 0x80, 0x08,	}, hit_mask, // lock or byte ptr [rax], hit_mask
+					0x58, // marked: pop rax
+				};
+
+				*this = m;
+			}
+
+			byte push_rax;
+			byte mov_rax[2];
+			byte *hits;
+			byte test[2];
+			byte test_mask;
+			byte jnz[2];
+			byte lock_or[3];
+			byte or_mask;
+			byte pop_rax;
+		};
+#else
+		struct hit_marker
+		{
+			void init(byte *hits, byte hit_mask)
+			{
+				const hit_marker m = {
+					{	0xF6, 0x05,	}, hits, hit_mask, // test byte ptr [hits], hit_mask
+					{	0x75, 0x08,	}, // jnz marked
+					{	0xF0, 0x80, 0x0D,	}, hits, hit_mask, // lock or byte ptr [hits], hit_mask
+				};
+
+				*this = m;
+			}
+
+			byte test[2];
+			byte *test_hits;
+			byte test_mask;
+			byte jnz[2];
+			byte lock_or[3];
+			byte *or_hits;
+			byte or_mask;
+		};
+#endif
+	}
+
+	const size_t c_hit_marker_size = sizeof(hit_marker);
+
+	void hit_marker_initialize(void *at, byte *hits, byte hit_mask)
+	{	static_cast<hit_marker *>(at)->init(hits, hit_mask);	}
+}
+
+#pragma pack(pop)
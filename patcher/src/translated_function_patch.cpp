@@ -27,6 +27,36 @@ using namespace std;
 
 namespace micro_profiler
 {
+	namespace
+	{
+		byte validate(const_byte_range function)
+		{
+			if (function.length() < c_jump_size)
+				throw inconsistent_function_range_exception("function to be patched is too small");
+
+			const auto moved_size = static_cast<byte>(calculate_fragment_length(function, c_jump_size));
+
+			validate_partial_function(function.suffix(moved_size));
+			return moved_size;
+		}
+	}
+
+	translation_plan plan_translation(const_byte_range function)
+	{
+		translation_plan plan = {	0,	};
+
+		try
+		{
+			plan.prologue_size = validate(function);
+		}
+		catch (const exception &e)
+		{
+			plan.error = e.what();
+		}
+		return plan;
+	}
+
+
 	bool translated_function_patch::active() const
 	{	return _active;	}
 
@@ -52,25 +82,37 @@ namespace micro_profiler
 	}
 
 	void translated_function_patch::init(executable_memory_allocator &allocator_, void *interceptor,
-		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit)
+		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit, const translation_plan *plan,
+		const ptrdiff_t *cursor_offset)
 	{
-		if (_target_function.length() < c_jump_size)
-			throw inconsistent_function_range_exception("function to be patched is too small");
+		if (plan && !plan->prologue_size)
+			throw inconsistent_function_range_exception(plan->error.c_str());
 
-		const auto moved_size = static_cast<byte>(calculate_fragment_length(_target_function, c_jump_size));
+		const auto moved_size = plan ? plan->prologue_size : validate(_target_function);
 		const auto continuation = _target_function.suffix(moved_size);
+#if defined(__linux__) && defined(__x86_64__)
+		const auto trampoline_size = cursor_offset ? c_fast_trampoline_size : c_trampoline_size;
+#else
+		const auto trampoline_size = c_trampoline_size;
+#endif
 
-		validate_partial_function(continuation);
-
-		_prologue_backup_offset = static_cast<byte>(c_trampoline_size + moved_size + c_jump_size);
+		_prologue_backup_offset = static_cast<unsigned short>(trampoline_size + moved_size + c_jump_size);
 		const auto trampoline = static_pointer_cast<byte>(allocator_.allocate(_prologue_backup_offset + moved_size));
 		_trampoline = trampoline;
 		_prologue_size = moved_size;
 
 		auto ptr = trampoline.get();
 
-		initialize_trampoline(ptr, _target_function.data() /*id*/, interceptor, on_enter, on_exit);
-		ptr += c_trampoline_size;
+#if defined(__linux__) && defined(__x86_64__)
+		if (cursor_offset)
+		{
+			initialize_fast_trampoline(ptr, _target_function.data() /*id*/, interceptor, *cursor_offset, on_enter,
+				on_exit);
+		}
+		else
+#endif
+			initialize_trampoline(ptr, _target_function.data() /*id*/, interceptor, on_enter, on_exit);
+		ptr += trampoline_size;
 
 		move_function(ptr, _target_function.prefix(moved_size));
 		ptr += moved_size;
@@ -0,0 +1,121 @@
+#include <patcher/coverage_patch.h>
+
+#include "allocator.h"
+#include "guineapigs.h"
+#include "helpers.h"
+
+#include <common/image_info.h>
+#include <common/module.h>
+#include <patcher/binary_translation.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			template <typename F>
+			size_t get_function_size(F *function)
+			{
+				static auto meta = load_image_info(
+					module::platform().locate(address_cast_hack<void *>(function)).path
+				);
+
+				return 123;
+			}
+
+			template <typename F>
+			translation_plan get_plan(F *function)
+			{
+				return plan_translation(const_byte_range(address_cast_hack<const byte *>(function),
+					get_function_size(function)));
+			}
+		}
+
+		begin_test_suite( CoveragePatchTests )
+			this_module_allocator allocator;
+			shared_ptr<void> scope;
+
+			init( Init )
+			{
+				allocator.allocate(1);
+				scope = temporary_unlock_code_at(address_cast_hack<void *>(&recursive_factorial));
+			}
+
+
+			test( PatchCannotBeMadeWithoutAPlan )
+			{
+				// INIT
+				byte hits = 0;
+				translation_plan failed = {	0, "function cannot be patched"	};
+
+				// ACT / ASSERT
+				assert_throws(coverage_patch(address_cast_hack<void *>(&recursive_factorial), 123, &hits, 1, allocator,
+					failed), inconsistent_function_range_exception);
+			}
+
+
+			test( FunctionIsMarkedHitOnlyWhileThePatchIsActive )
+			{
+				// INIT
+				byte hits = 0x10;
+
+				// INIT / ACT
+				coverage_patch patch(address_cast_hack<void *>(&recursive_factorial),
+					get_function_size(&recursive_factorial), &hits, 0x04, allocator, get_plan(&recursive_factorial));
+
+				// ACT
+				assert_equal(2, recursive_factorial(2));
+
+				// ASSERT
+				assert_is_false(patch.active());
+				assert_equal(0x10u, hits);
+
+				// ACT / ASSERT
+				assert_is_true(patch.activate());
+				assert_is_false(patch.activate());
+
+				// ACT
+				assert_equal(6, recursive_factorial(3));
+
+				// ASSERT
+				assert_is_true(patch.active());
+				assert_equal(0x14u, hits);
+
+				// INIT
+				hits = 0x00;
+
+				// ACT
+				assert_equal(24, recursive_factorial(4));
+
+				// ASSERT
+				assert_equal(0x04u, hits);
+			}
+
+
+			test( RevertingStopsMarking )
+			{
+				// INIT
+				byte hits = 0;
+				coverage_patch patch(address_cast_hack<void *>(&recursive_factorial),
+					get_function_size(&recursive_factorial), &hits, 0x80, allocator, get_plan(&recursive_factorial));
+
+				patch.activate();
+
+				// ACT / ASSERT
+				assert_is_true(patch.revert());
+				assert_is_false(patch.revert());
+
+				// ACT
+				assert_equal(120, recursive_factorial(5));
+
+				// ASSERT
+				assert_equal(0u, hits);
+			}
+		end_test_suite
+	}
+}
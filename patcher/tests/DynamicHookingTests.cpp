@@ -192,6 +192,86 @@ namespace micro_profiler
 				self->return_address = 0;
 				return r;
 			}
+
+#if defined(__linux__) && defined(__x86_64__)
+			__thread fast_cursor t_cursor __attribute__((tls_model("initial-exec")));
+
+			struct cursor_tracer
+			{
+				cursor_tracer(size_t records_limit, size_t returns_limit)
+					: slow_enters(0), slow_exits(0), _records(records_limit), _returns(100)
+				{
+					fast_cursor::return_entry sentinel = {	reinterpret_cast<const void **>(static_cast<size_t>(-1)), 0	};
+
+					_returns[0] = sentinel;
+					t_cursor.records = _records.data(), t_cursor.records_end = _records.data() + _records.size();
+					t_cursor.returns = _returns.data() + 1, t_cursor.returns_end = t_cursor.returns + returns_limit;
+				}
+
+				static void CC_(fastcall) on_enter(cursor_tracer *self, const void **stack_ptr,
+					timestamp_t timestamp, const void *callee) _CC(fastcall)
+				{
+					self->slow_enters++;
+					if (t_cursor.returns[-1].stack_ptr == stack_ptr)
+					{
+						self->write(timestamp, 0);
+					}
+					else
+					{
+						if (t_cursor.returns == t_cursor.returns_end)
+							t_cursor.returns_end++;
+						t_cursor.returns->stack_ptr = stack_ptr;
+						t_cursor.returns->return_address = *stack_ptr;
+						t_cursor.returns++;
+					}
+					self->write(timestamp, callee);
+				}
+
+				static const void *CC_(fastcall) on_exit(cursor_tracer *self, const void **stack_ptr,
+					timestamp_t timestamp) _CC(fastcall)
+				{
+					const void *return_address;
+
+					self->slow_exits++;
+					do
+					{
+						return_address = (--t_cursor.returns)->return_address;
+						self->write(timestamp, 0);
+					} while (t_cursor.returns[-1].stack_ptr <= stack_ptr);
+					return return_address;
+				}
+
+				vector<const void *> callees() const
+				{
+					auto result = _flushed;
+
+					for (auto i = _records.data(); i != t_cursor.records; ++i)
+						result.push_back(i->callee);
+					return result;
+				}
+
+				unsigned int slow_enters, slow_exits;
+
+			private:
+				void write(timestamp_t timestamp, const void *callee)
+				{
+					if (t_cursor.records == t_cursor.records_end)
+					{
+						for (auto i = _records.data(); i != t_cursor.records; ++i)
+							_flushed.push_back(i->callee);
+						t_cursor.records = _records.data();
+					}
+					t_cursor.records->timestamp = timestamp;
+					t_cursor.records->callee = callee;
+					t_cursor.records++;
+				}
+
+			private:
+				vector<fast_cursor::record> _records;
+				vector<fast_cursor::return_entry> _returns;
+				vector<const void *> _flushed;
+			};
+#endif
 		}
 
 		begin_test_suite( DynamicHookingTests )
@@ -540,5 +620,119 @@ namespace micro_profiler
 			}
 
 		end_test_suite
+
+#if defined(__linux__) && defined(__x86_64__)
+		begin_test_suite( FastTrampolineTests )
+			this_module_allocator allocator;
+			shared_ptr<void> thunks[2];
+			ptrdiff_t cursor_offset;
+
+			init( AllocateMemory )
+			{
+				thunks[0] = allocator.allocate(c_fast_trampoline_size + c_jump_size);
+				thunks[1] = allocator.allocate(c_fast_trampoline_size + c_jump_size);
+				cursor_offset = get_thread_pointer_offset(&t_cursor);
+			}
+
+			template <typename F>
+			F *make_thunk(unsigned int index, F *target, const void *id, cursor_tracer &tracer)
+			{
+				const auto at = thunks[index].get();
+
+				initialize_fast_trampoline(at, id, &tracer, cursor_offset);
+				jump_initialize(static_cast<byte *>(at) + c_fast_trampoline_size, address_cast_hack<const void *>(target));
+				return address_cast_hack<F *>(at);
+			}
+
+
+			test( RecordsAreWrittenWithoutCallingInterceptorWhenCursorHasRoom )
+			{
+				typedef string (fn1_t)(string value);
+				typedef string (fn2_t)(fn1_t *f, const string &value);
+
+				// INIT
+				cursor_tracer tracer(100, 10);
+				const auto f1 = make_thunk(0, &reverse_string_2, "f1", tracer);
+				const auto f2 = make_thunk(1, &outer_function<fn1_t *>, "f2", tracer);
+				const auto base = t_cursor.returns;
+
+				// ACT / ASSERT
+				assert_equal("alalal", f2(f1, "lalala"));
+				assert_equal("namaremac", f1("cameraman"));
+
+				// ASSERT
+				const void *reference[] = {	"f2", "f1", 0, 0, "f1", 0,	};
+
+				assert_equal(reference, tracer.callees());
+				assert_equal(0u, tracer.slow_enters);
+				assert_equal(0u, tracer.slow_exits);
+				assert_equal(base, t_cursor.returns);
+				assert_is_true(t_cursor.records[-6].timestamp <= t_cursor.records[-3].timestamp);
+				assert_is_true(t_cursor.records[-3].timestamp <= t_cursor.records[-1].timestamp);
+			}
+
+
+			test( InterceptorIsCalledWhenRecordsAreExhausted )
+			{
+				typedef string (fn1_t)(string value);
+				typedef string (fn2_t)(fn1_t *f, const string &value);
+
+				// INIT
+				cursor_tracer tracer(3, 10);
+				const auto f1 = make_thunk(0, &reverse_string_2, "f1", tracer);
+				const auto f2 = make_thunk(1, &outer_function<fn1_t *>, "f2", tracer);
+
+				// ACT
+				f2(f1, "lalala");
+
+				// ASSERT
+				const void *reference1[] = {	"f2", "f1", 0, 0,	};
+
+				assert_equal(reference1, tracer.callees());
+				assert_equal(0u, tracer.slow_enters);
+				assert_equal(1u, tracer.slow_exits);
+
+				// ACT
+				f2(f1, "lalala");
+				f2(f1, "lalala");
+
+				// ASSERT
+				const void *reference2[] = {	"f2", "f1", 0, 0, "f2", "f1", 0, 0, "f2", "f1", 0, 0,	};
+
+				assert_equal(reference2, tracer.callees());
+				assert_equal(1u, tracer.slow_enters);
+				assert_equal(2u, tracer.slow_exits);
+			}
+
+
+			test( InterceptorIsCalledWhenReturnStackIsExhausted )
+			{
+				typedef string (fn1_t)(string value);
+				typedef string (fn2_t)(fn1_t *f, const string &value);
+
+				// INIT
+				cursor_tracer tracer(100, 1);
+				const auto f1 = make_thunk(0, &reverse_string_2, "f1", tracer);
+				const auto f2 = make_thunk(1, &outer_function<fn1_t *>, "f2", tracer);
+
+				// ACT / ASSERT
+				assert_equal("alalal", f2(f1, "lalala"));
+
+				// ASSERT
+				const void *reference1[] = {	"f2", "f1", 0, 0,	};
+
+				assert_equal(reference1, tracer.callees());
+				assert_equal(1u, tracer.slow_enters);
+				assert_equal(0u, tracer.slow_exits);
+
+				// ACT / ASSERT
+				assert_equal("alalal", f2(f1, "lalala"));
+
+				// ASSERT
+				assert_equal(8u, tracer.callees().size());
+				assert_equal(1u, tracer.slow_enters);
+			}
+		end_test_suite
+#endif
 	}
 }
@@ -1123,6 +1123,58 @@ namespace micro_profiler
 			}
 
 
+			test( ProtectionIsChangedOncePerRegionForAllPatchesInABatch )
+			{
+				// INIT
+				vector< pair<int /*act*/, size_t /*locks*/> > actions;
+				image_patch_manager pm([&] (void *target, size_t, id_t, executable_memory_allocator &) {
+					return unique_ptr<patch>(new mocks::patch([&] (void *, int act) {
+						actions.push_back(make_pair(act, memory_manager_.locks().size()));
+					}, target));
+				}, mappings, memory_manager_);
+				patch_manager::apply_request functions[] = {
+					make_pair(0x30001u, 0u), make_pair(0x10002u, 0u), make_pair(0x20001u, 0u), make_pair(0x10005u, 0u),
+				};
+				unsigned int rvas[] = {	0x10005u, 0x30001u, 0x20001u,	};
+
+				mappings.on_lock_mapping = [&] (id_t) {
+					return make_shared_copy(make_mapping((void*)0x10000000, "", plural
+						+ make_mapped_region((byte*)0x10010000, 0x30000, protection::read | protection::execute)
+						+ make_mapped_region((byte*)0x10040000, 0x10000, protection::read)));
+				};
+				mappings.subscription->mapped(1u, 100u, make_mapping((void *)0x10000000, ""));
+				memory_manager_.protections_changed = 0;
+
+				// ACT
+				pm.apply(results, 1u, mkrange(functions));
+
+				// ASSERT
+				assert_equal(1u, memory_manager_.protections_changed);
+				assert_is_empty(memory_manager_.locks());
+				assert_equal(plural
+					+ make_pair(0, (size_t)1) + make_pair(1, (size_t)1) + make_pair(0, (size_t)1) + make_pair(1, (size_t)1)
+					+ make_pair(0, (size_t)1) + make_pair(1, (size_t)1) + make_pair(0, (size_t)1) + make_pair(1, (size_t)1),
+					actions);
+				assert_equal(4u, results.size());
+
+				// INIT
+				actions.clear();
+
+				// ACT
+				pm.revert(results, 1u, mkrange(rvas));
+
+				// ASSERT
+				assert_equal(2u, memory_manager_.protections_changed);
+				assert_is_empty(memory_manager_.locks());
+				assert_equal(plural
+					+ make_pair(2, (size_t)1) + make_pair(2, (size_t)1) + make_pair(2, (size_t)1), actions);
+				assert_equal(plural
+					+ make_patch_apply(0x10005, patch_change_result::ok, 4)
+					+ make_patch_apply(0x30001, patch_change_result::ok, 1)
+					+ make_patch_apply(0x20001, patch_change_result::ok, 3), results);
+			}
+
+
 			test( NoPatchConstructionIsAttemptedAfterUnrecoverableError )
 			{
 				// INIT
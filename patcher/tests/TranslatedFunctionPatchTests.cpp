@@ -31,6 +31,21 @@ namespace micro_profiler
 
 				return 123;
 			}
+
+#if defined(__linux__) && defined(__x86_64__)
+			__thread fast_cursor t_cursor __attribute__((tls_model("initial-exec")));
+
+			// The fast trampoline compares the stack pointer with the two entries below the top of the return stack.
+			void set_cursor(fast_cursor::record *records, size_t records_limit, fast_cursor::return_entry *returns,
+				size_t returns_limit)
+			{
+				const fast_cursor::return_entry sentinel = {	reinterpret_cast<const void **>(static_cast<size_t>(-1)), 0	};
+
+				returns[0] = returns[1] = sentinel;
+				t_cursor.records = records, t_cursor.records_end = records + records_limit;
+				t_cursor.returns = returns + 2, t_cursor.returns_end = t_cursor.returns + returns_limit;
+			}
+#endif
 		}
 
 		begin_test_suite( TranslatedFunctionPatchTests )
@@ -80,6 +95,59 @@ namespace micro_profiler
 			}
 
 
+			test( PlanHoldsPrologueSizeOrValidationError )
+			{
+				// INIT
+				vector<byte> small(c_jump_size - 1);
+				const auto size = 10 * c_jump_size;
+				auto enough = static_pointer_cast<byte>(allocator.allocate(size));
+
+				jump_initialize(enough.get(), enough.get() + 1000u);
+				jump_initialize(enough.get() + c_jump_size, enough.get() + 10 * c_jump_size);
+
+				// ACT
+				const auto plan1 = plan_translation(const_byte_range(small.data(), small.size()));
+				const auto plan2 = plan_translation(const_byte_range(enough.get(), size));
+
+				// ASSERT
+				assert_equal(0u, plan1.prologue_size);
+				assert_is_false(plan1.error.empty());
+				assert_equal(0u, plan2.prologue_size);
+				assert_is_false(plan2.error.empty());
+
+				// INIT
+				jump_initialize(enough.get() + c_jump_size, enough.get() + 10 * c_jump_size - 1);
+
+				// ACT
+				const auto plan3 = plan_translation(const_byte_range(enough.get(), size));
+
+				// ASSERT
+				assert_equal(c_jump_size, plan3.prologue_size);
+				assert_is_empty(plan3.error);
+			}
+
+
+			test( PatchFollowsThePlanGiven )
+			{
+				// INIT
+				const auto size = 10 * c_jump_size;
+				auto enough = static_pointer_cast<byte>(allocator.allocate(size));
+				translation_plan failed = {	0, "function cannot be patched"	};
+				translation_plan succeeded = {	static_cast<byte>(c_jump_size),	};
+
+				jump_initialize(enough.get(), enough.get() + 1000u);
+				jump_initialize(enough.get() + c_jump_size, enough.get() + 10 * c_jump_size);
+
+				// ACT / ASSERT (the function is not validated, since the plan says it is fine)
+				translated_function_patch(enough.get(), size, &trace, allocator, succeeded);
+
+				// ACT / ASSERT
+				assert_throws(translated_function_patch(address_cast_hack<void *>(&recursive_factorial), 123, &trace, allocator,
+					failed),
+					inconsistent_function_range_exception);
+			}
+
+
 			test( PatchIsNotActiveActiveAtConstruction )
 			{
 				// INIT / ACT
@@ -215,6 +283,80 @@ namespace micro_profiler
 				// ASSERT
 				assert_equal("132214 - some random value...", string(buffer));
 			}
+
+#if defined(__linux__) && defined(__x86_64__)
+
+			test( FastPatchedFunctionCallsHookCallbacksWhenCursorHasNoRoom )
+			{
+				// INIT
+				fast_cursor::return_entry returns[2];
+
+				set_cursor(nullptr, 0, returns, 0);
+
+				// INIT / ACT
+				translated_function_patch patch(address_cast_hack<void *>(&recursive_factorial),
+					get_function_size(&recursive_factorial), &trace, allocator,
+					plan_translation(const_byte_range(address_cast_hack<const byte *>(&recursive_factorial), 123)),
+					get_thread_pointer_offset(&t_cursor));
+
+				patch.activate();
+
+				// ACT
+				assert_equal(6, recursive_factorial(3));
+
+				// ASSERT
+				mocks::call_record reference[] = {
+					{ 0, address_cast_hack<const void *>(&recursive_factorial) },
+						{ 0, address_cast_hack<const void *>(&recursive_factorial) },
+							{ 0, address_cast_hack<const void *>(&recursive_factorial) },
+							{ 0, 0 },
+						{ 0, 0 },
+					{ 0, 0 },
+				};
+
+				assert_equal(reference, trace.call_log);
+			}
+
+
+			test( FastPatchedFunctionWritesThroughCursorWhenItHasRoom )
+			{
+				// INIT
+				fast_cursor::record records[10];
+				fast_cursor::return_entry returns[2 + 10];
+
+				set_cursor(records, 10, returns, 10);
+
+				// INIT / ACT
+				translated_function_patch patch(address_cast_hack<void *>(&recursive_factorial),
+					get_function_size(&recursive_factorial), &trace, allocator,
+					plan_translation(const_byte_range(address_cast_hack<const byte *>(&recursive_factorial), 123)),
+					get_thread_pointer_offset(&t_cursor));
+
+				patch.activate();
+
+				// ACT
+				assert_equal(6, recursive_factorial(3));
+
+				// ASSERT
+				assert_is_empty(trace.call_log);
+				assert_equal(records + 6, t_cursor.records);
+				assert_equal(returns + 2, t_cursor.returns);
+				assert_equal(address_cast_hack<const void *>(&recursive_factorial), records[0].callee);
+				assert_equal(address_cast_hack<const void *>(&recursive_factorial), records[1].callee);
+				assert_equal(address_cast_hack<const void *>(&recursive_factorial), records[2].callee);
+				assert_null(records[3].callee);
+				assert_null(records[4].callee);
+				assert_null(records[5].callee);
+				assert_is_true(records[0].timestamp <= records[5].timestamp);
+
+				// ACT
+				patch.revert();
+				recursive_factorial(3);
+
+				// ASSERT
+				assert_equal(records + 6, t_cursor.records);
+			}
+#endif
 		end_test_suite
 	}
 }
@@ -48,6 +48,10 @@ namespace micro_profiler
 			}
 
 
+			memory_manager::memory_manager()
+				: protections_changed(0)
+			{	}
+
 			vector<memory_manager::lock_info> memory_manager::locks() const
 			{	return vector<lock_info>(_locks.begin(), _locks.end());	}
 
@@ -63,6 +67,7 @@ namespace micro_profiler
 			{
 				auto i = _locks.insert(_locks.end(), make_tuple(region, scoped_protection, released_protection));
 
+				protections_changed++;
 				return shared_ptr<void>(&*i, [this, i] (void *) {	_locks.erase(i);	});
 			}
 
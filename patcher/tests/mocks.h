@@ -58,11 +58,14 @@ namespace micro_profiler
 				typedef std::tuple<byte_range, int /*scoped*/, int /*released*/> lock_info;
 
 			public:
+				memory_manager();
+
 				std::vector<lock_info> locks() const;
 
 			public:
 				std::vector< std::tuple<std::shared_ptr<executable_memory_allocator>, const_byte_range, std::size_t> >
 					allocators;
+				unsigned int protections_changed;
 
 			private:
 				virtual std::shared_ptr<executable_memory_allocator> create_executable_allocator(const_byte_range,
@@ -23,26 +23,51 @@
 #include "dynamic_hooking.h"
 #include "interface.h"
 
+#include <string>
+
 namespace micro_profiler
 {
+	// The outcome of validating a function for translation: the length of its prologue to be moved out or the reason it
+	// cannot be patched. It only depends on the function's code, thus holds for any mapping of the same image.
+	struct translation_plan
+	{
+		byte prologue_size; // Zero if the function cannot be patched.
+		std::string error;
+	};
+
 	class translated_function_patch : public patch, noncopyable
 	{
 	public:
 		template <typename T>
 		translated_function_patch(void *target, std::size_t size, T *interceptor, executable_memory_allocator &allocator_);
 
+		// Follows the plan made for the function earlier, without validating it again.
+		template <typename T>
+		translated_function_patch(void *target, std::size_t size, T *interceptor, executable_memory_allocator &allocator_,
+			const translation_plan &plan);
+
+#if defined(__linux__) && defined(__x86_64__)
+		// Uses the fast trampoline writing through the thread-local cursor at the offset specified (see
+		// initialize_fast_trampoline()).
+		template <typename T>
+		translated_function_patch(void *target, std::size_t size, T *interceptor, executable_memory_allocator &allocator_,
+			const translation_plan &plan, ptrdiff_t cursor_offset);
+#endif
+
 		bool active() const;
 		virtual bool activate() override;
 		virtual bool revert() override;
 
 	private:
 		void init(executable_memory_allocator &allocator_, void *interceptor,
-			hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit);
+			hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit, const translation_plan *plan,
+			const ptrdiff_t *cursor_offset = nullptr);
 
 	private:
 		std::shared_ptr<const byte> _trampoline;
 		const byte_range _target_function;
-		byte _prologue_backup_offset, _prologue_size;
+		unsigned short _prologue_backup_offset;
+		byte _prologue_size;
 		bool _active;
 	};
 
@@ -52,5 +77,22 @@ namespace micro_profiler
 	inline translated_function_patch::translated_function_patch(void *target, std::size_t size, T *interceptor,
 			executable_memory_allocator &allocator_)
 		: _target_function(static_cast<byte *>(target), size), _active(false)
-	{	init(allocator_, interceptor, hooks<T>::on_enter(), hooks<T>::on_exit());	}
+	{	init(allocator_, interceptor, hooks<T>::on_enter(), hooks<T>::on_exit(), nullptr);	}
+
+	template <typename T>
+	inline translated_function_patch::translated_function_patch(void *target, std::size_t size, T *interceptor,
+			executable_memory_allocator &allocator_, const translation_plan &plan)
+		: _target_function(static_cast<byte *>(target), size), _active(false)
+	{	init(allocator_, interceptor, hooks<T>::on_enter(), hooks<T>::on_exit(), &plan);	}
+
+#if defined(__linux__) && defined(__x86_64__)
+	template <typename T>
+	inline translated_function_patch::translated_function_patch(void *target, std::size_t size, T *interceptor,
+			executable_memory_allocator &allocator_, const translation_plan &plan, ptrdiff_t cursor_offset)
+		: _target_function(static_cast<byte *>(target), size), _active(false)
+	{	init(allocator_, interceptor, hooks<T>::on_enter(), hooks<T>::on_exit(), &plan, &cursor_offset);	}
+#endif
+
+
+	translation_plan plan_translation(const_byte_range function);
 }
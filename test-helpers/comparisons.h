@@ -4,6 +4,7 @@
 #include <collector/primitives.h>
 #include <common/image_info.h>
 #include <common/module.h>
+#include <common/protocol.h>
 #include <set>
 
 namespace micro_profiler
@@ -37,6 +38,9 @@ namespace micro_profiler
 	inline bool operator ==(const call_graph_node<AddressT> &lhs, const call_graph_node<AddressT> &rhs)
 	{	return !(lhs < rhs) && !(rhs < lhs);	}
 
+	inline bool operator ==(const call_graph_delta::created_node &lhs, const call_graph_delta::created_node &rhs)
+	{	return lhs.parent == rhs.parent && lhs.address == rhs.address && lhs.statistics == rhs.statistics;	}
+
 	inline bool operator ==(const mapped_region &lhs, const mapped_region &rhs)
 	{	return lhs.address == rhs.address && lhs.size == rhs.size && lhs.protection == rhs.protection;	}
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/primitives.h>
+#include <common/protocol.h>
 
 namespace micro_profiler
 {
@@ -25,5 +26,15 @@ namespace micro_profiler
 			r.second.callees = typename call_graph_types<AddressT>::nodes_map(callees.begin(), callees.end());
 			return r;
 		}
+
+		inline call_graph_delta::created_node make_created_node(unsigned int parent, long_address_t address,
+			count_t times_called, timestamp_t inclusive_time, timestamp_t exclusive_time, timestamp_t max_call_time)
+		{
+			call_graph_delta::created_node n = {
+				parent, address, function_statistics(times_called, inclusive_time, exclusive_time, max_call_time)
+			};
+
+			return n;
+		}
 	}
 }